@@ -0,0 +1,1300 @@
+/***************************************************************************
+    AudioMan mixer and channels.
+
+    All voice state lives on the mixer thread. The client side of a
+    channel only posts commands and reads a couple of values the mixer
+    thread publishes, so neither side ever waits for the other except when
+    the command queue overflows, in which case the poster drains the queue
+    itself.
+
+***************************************************************************/
+#include <math.h>
+
+#include "ampriv.h"
+
+AMMIX *AMMIX::_pmixShared;
+
+/***************************************************************************
+    Convert a waveOut style volume word to a 16.16 gain.
+***************************************************************************/
+static long _LwGainFromVol(DWORD luVol)
+{
+    luVol &= 0xFFFF;
+    return (long)(luVol + (luVol >> 15));
+}
+
+/***************************************************************************
+    Channel.
+***************************************************************************/
+AMCHAN::AMCHAN(AMMIX *pmix)
+{
+    _cactRef = 1;
+    _pmix = pmix;
+    InitializeCriticalSection(&_crit);
+    InitializeCriticalSection(&_critNot);
+    _psndCli = NULL;
+    _pnot = NULL;
+    _grfnot = 0;
+    _fPlayingPub = 0;
+    _ismpPub = 0;
+    _luVolCli = 0xFFFFFFFF;
+    _fOneShot = false;
+
+    _psnd = NULL;
+    ZeroMemory(&_wfx, sizeof(_wfx));
+    _csmp = 0;
+    _ismp = 0;
+    _luFrac = 0;
+    _luStep = 0x10000;
+    _lwGainL = _lwGainR = 0x10000;
+    _fPlay = false;
+    _fMute = false;
+    _fEnded = false;
+    _grfgrp = 0;
+    _pchanNote = NULL;
+    _psndNote = NULL;
+    _ismpNote = 0;
+}
+
+AMCHAN::~AMCHAN(void)
+{
+    if (NULL != _psnd)
+        _psnd->Release();
+    if (NULL != _psndCli)
+        _psndCli->Release();
+    DeleteCriticalSection(&_crit);
+    DeleteCriticalSection(&_critNot);
+}
+
+STDMETHODIMP AMCHAN::QueryInterface(REFIID riid, void **ppv)
+{
+    if (IsEqualIID(riid, IID_IUnknown) || IsEqualIID(riid, IID_IAMChannel))
+    {
+        *ppv = (IAMChannel *)this;
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = NULL;
+    return E_NOINTERFACE;
+}
+
+STDMETHODIMP_(ULONG) AMCHAN::AddRef(void)
+{
+    return InterlockedIncrement(&_cactRef);
+}
+
+STDMETHODIMP_(ULONG) AMCHAN::Release(void)
+{
+    LONG cactRef = InterlockedDecrement(&_cactRef);
+
+    if (cactRef == 1)
+    {
+        // Only the mixer's reference is left, so the client is gone and
+        // its notify sink may be too.
+        EnterCriticalSection(&_critNot);
+        _pnot = NULL;
+        LeaveCriticalSection(&_critNot);
+    }
+    else if (cactRef == 0)
+        delete this;
+    return cactRef;
+}
+
+/***************************************************************************
+    Returns whether the voice would make sound if mixed.
+***************************************************************************/
+bool AMCHAN::_FActive(void)
+{
+    return _fPlay && NULL != _psnd && !_fEnded;
+}
+
+STDMETHODIMP AMCHAN::RegisterNotify(LPNOTIFYSINK pNotifySink, DWORD fdwNotifyFlags)
+{
+    // We don't hold a reference: the client's sink may be embedded in
+    // another object. It's dropped when the client releases the channel.
+    EnterCriticalSection(&_critNot);
+    _pnot = pNotifySink;
+    _grfnot = fdwNotifyFlags;
+    LeaveCriticalSection(&_critNot);
+    return S_OK;
+}
+
+STDMETHODIMP AMCHAN::SetSoundSrc(LPSOUND pSound)
+{
+    IAMSound *psndOld;
+
+    if (NULL == _pmix)
+        return E_NOTINITED;
+
+    if (NULL != pSound)
+        pSound->AddRef();
+    EnterCriticalSection(&_crit);
+    psndOld = _psndCli;
+    _psndCli = pSound;
+    LeaveCriticalSection(&_crit);
+    if (NULL != psndOld)
+        psndOld->Release();
+
+    _ismpPub = 0;
+    _pmix->_Post(kcmdSetSrc, this, pSound, 0);
+    return S_OK;
+}
+
+STDMETHODIMP AMCHAN::SetCachedSrc(LPSOUND pSound, LPCACHECONFIG pCacheConfig)
+{
+    // The mixer reads ahead a buffer at a time on its own thread, so there's
+    // nothing extra a cache would buy us.
+    return SetSoundSrc(pSound);
+}
+
+STDMETHODIMP AMCHAN::GetSoundSrc(LPSOUND FAR *ppSound)
+{
+    EnterCriticalSection(&_crit);
+    *ppSound = _psndCli;
+    if (NULL != _psndCli)
+        _psndCli->AddRef();
+    LeaveCriticalSection(&_crit);
+    return S_OK;
+}
+
+STDMETHODIMP AMCHAN::Play(void)
+{
+    if (NULL == _pmix)
+        return E_NOTINITED;
+
+    _fPlayingPub = NULL != _psndCli;
+    _pmix->_Post(kcmdPlay, this, NULL, 0);
+    return S_OK;
+}
+
+STDMETHODIMP AMCHAN::Stop(void)
+{
+    if (NULL == _pmix)
+        return E_NOTINITED;
+
+    _fPlayingPub = 0;
+    _pmix->_Post(kcmdStop, this, NULL, 0);
+    return S_OK;
+}
+
+STDMETHODIMP AMCHAN::Finish(void)
+{
+    // channels stop on their own at the end of the source
+    return S_OK;
+}
+
+STDMETHODIMP_(BOOL) AMCHAN::IsPlaying(void)
+{
+    return _fPlayingPub != 0;
+}
+
+STDMETHODIMP_(DWORD) AMCHAN::Samples(void)
+{
+    DWORD csmp = 0;
+
+    EnterCriticalSection(&_crit);
+    if (NULL != _psndCli)
+        csmp = _psndCli->GetSamples();
+    LeaveCriticalSection(&_crit);
+    return csmp;
+}
+
+STDMETHODIMP AMCHAN::SetPosition(DWORD dwSample)
+{
+    if (NULL == _pmix)
+        return E_NOTINITED;
+
+    _ismpPub = dwSample;
+    _pmix->_Post(kcmdSetPos, this, NULL, dwSample);
+    return S_OK;
+}
+
+STDMETHODIMP AMCHAN::GetPosition(LPDWORD lpdwSample)
+{
+    *lpdwSample = _ismpPub;
+    return S_OK;
+}
+
+STDMETHODIMP AMCHAN::Mute(BOOL fMute)
+{
+    if (NULL == _pmix)
+        return E_NOTINITED;
+
+    _pmix->_Post(kcmdMute, this, NULL, fMute);
+    return S_OK;
+}
+
+STDMETHODIMP AMCHAN::SetVolume(DWORD dwVolume)
+{
+    if (NULL == _pmix)
+        return E_NOTINITED;
+
+    _luVolCli = dwVolume;
+    _pmix->_Post(kcmdSetVol, this, NULL, dwVolume);
+    return S_OK;
+}
+
+STDMETHODIMP AMCHAN::GetVolume(LPDWORD lpdwVolume)
+{
+    *lpdwVolume = _luVolCli;
+    return S_OK;
+}
+
+static WORD _WVolFromDb(float flDb)
+{
+    double dVol = 65535.0 * pow(10.0, flDb / 20.0);
+
+    return (WORD)(dVol <= 0 ? 0 : dVol >= 65535.0 ? 65535 : dVol + 0.5);
+}
+
+static float _FlDbFromVol(WORD wVol)
+{
+    return wVol == 0 ? -100.0f : (float)(20.0 * log10(wVol / 65535.0));
+}
+
+STDMETHODIMP AMCHAN::SetGain(float flLeft, float flRight)
+{
+    return SetVolume(MAKELONG(_WVolFromDb(flLeft), _WVolFromDb(flRight)));
+}
+
+STDMETHODIMP AMCHAN::GetGain(float FAR *lpflLeft, float FAR *lpflRight)
+{
+    *lpflLeft = _FlDbFromVol(LOWORD(_luVolCli));
+    *lpflRight = _FlDbFromVol(HIWORD(_luVolCli));
+    return S_OK;
+}
+
+STDMETHODIMP AMCHAN::GetSMPTEPos(LPSMPTE lpSMPTE)
+{
+    return E_NOTIMPL;
+}
+
+STDMETHODIMP AMCHAN::SetSMPTEPos(LPSMPTE lpSMPTE)
+{
+    return E_NOTIMPL;
+}
+
+/***************************************************************************
+    Sample rate of the client's current sound, or 0.
+***************************************************************************/
+DWORD AMCHAN::_LuRateCli(void)
+{
+    WAVEFORMATEX wfx;
+    DWORD luRate = 0;
+
+    EnterCriticalSection(&_crit);
+    if (NULL != _psndCli && SUCCEEDED(_psndCli->GetFormat(&wfx, sizeof(wfx))))
+        luRate = wfx.nSamplesPerSec;
+    LeaveCriticalSection(&_crit);
+    return luRate;
+}
+
+STDMETHODIMP AMCHAN::GetTimePos(LPDWORD lpdwTime)
+{
+    DWORD luRate = _LuRateCli();
+
+    *lpdwTime = luRate == 0 ? 0 : (DWORD)((ULONGLONG)(DWORD)_ismpPub * 1000 / luRate);
+    return S_OK;
+}
+
+STDMETHODIMP AMCHAN::SetTimePos(DWORD dwTime)
+{
+    return SetPosition((DWORD)((ULONGLONG)dwTime * _LuRateCli() / 1000));
+}
+
+/***************************************************************************
+    Mixer.
+***************************************************************************/
+AMMIX::AMMIX(void)
+{
+    long icell;
+
+    _cactRef = 1;
+    _fInited = _fActive = _fSuspended = _fOpen = false;
+    ZeroMemory(&_amxc, sizeof(_amxc));
+    ZeroMemory(&_wfx, sizeof(_wfx));
+    _pwvo = NULL;
+    _luVol = 0xFFFFFFFF;
+    _lwGain = 0x10000;
+    _luAvgSample = 0;
+    _grfgrpAlloc = 0;
+
+    for (icell = 0; icell < kccmdQueue; icell++)
+        _rgcell[icell].lwSeq = icell;
+    _icellEnq = _icellDeq = 0;
+
+    InitializeCriticalSection(&_critMix);
+    _hth = NULL;
+    _hevt = NULL;
+    _fQuit = 0;
+    _prgpchan = NULL;
+    _cpchan = _cpchanMax = 0;
+    ZeroMemory(_rgwh, sizeof(_rgwh));
+    _cbuf = 0;
+    _iwhNext = 0;
+    _cfrmBuf = 0;
+    _prglAcc = NULL;
+    _prgswScratch = NULL;
+    _prgbScratch = NULL;
+}
+
+AMMIX::~AMMIX(void)
+{
+    Uninit();
+    DeleteCriticalSection(&_critMix);
+    if (_pmixShared == this)
+        _pmixShared = NULL;
+}
+
+/***************************************************************************
+    Everyone shares one mixer.
+***************************************************************************/
+AMMIX *AMMIX::PmixGet(void)
+{
+    if (NULL != _pmixShared)
+        _pmixShared->AddRef();
+    else
+        _pmixShared = new AMMIX;
+    return _pmixShared;
+}
+
+STDMETHODIMP AMMIX::QueryInterface(REFIID riid, void **ppv)
+{
+    if (IsEqualIID(riid, IID_IUnknown) || IsEqualIID(riid, IID_IAMMixer))
+    {
+        *ppv = (IAMMixer *)this;
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = NULL;
+    return E_NOINTERFACE;
+}
+
+STDMETHODIMP_(ULONG) AMMIX::AddRef(void)
+{
+    return InterlockedIncrement(&_cactRef);
+}
+
+STDMETHODIMP_(ULONG) AMMIX::Release(void)
+{
+    LONG cactRef;
+
+    if ((cactRef = InterlockedDecrement(&_cactRef)) == 0)
+        delete this;
+    return cactRef;
+}
+
+/***************************************************************************
+    Get the output format from a MIXERCONFIG.
+***************************************************************************/
+static HRESULT _HrGetFormat(LPMIXERCONFIG pmixc, WAVEFORMATEX *pwfx)
+{
+    if (NULL == pmixc)
+    {
+        AmSetPcmFormat(pwfx, 22050, 1, 16);
+        return S_OK;
+    }
+
+    if (NULL != pmixc->lpFormat)
+    {
+        if (!AmFMixable(pmixc->lpFormat))
+            return E_BADPCMFORMAT;
+        AmSetPcmFormat(pwfx, pmixc->lpFormat->nSamplesPerSec, pmixc->lpFormat->nChannels,
+                       pmixc->lpFormat->wBitsPerSample);
+        return S_OK;
+    }
+
+    return AmFFormatFromFlag(pmixc->dwFormat, pwfx) ? S_OK : E_BADPCMFORMAT;
+}
+
+STDMETHODIMP AMMIX::TestConfig(LPWAVEOUT pWaveOut, LPMIXERCONFIG pMixerConfig, LPADVMIXCONFIG pAdvMixConfig,
+                               BOOL fRecommend)
+{
+    WAVEFORMATEX wfx;
+
+    return _HrGetFormat(pMixerConfig, &wfx);
+}
+
+/***************************************************************************
+    Allocate the output buffers and mixing scratch space for _wfx.
+***************************************************************************/
+HRESULT AMMIX::_HrAllocBuffers(void)
+{
+    long iwh;
+    long cbBuf;
+
+    _cfrmBuf = _wfx.nSamplesPerSec * kdtsMixPeriod / 1000;
+    _cbuf = _amxc.uBufferTime / kdtsMixPeriod;
+    _cbuf = _cbuf < 2 ? 2 : _cbuf > kcbufMixMax ? kcbufMixMax : _cbuf;
+    cbBuf = _cfrmBuf * _wfx.nBlockAlign;
+
+    for (iwh = 0; iwh < _cbuf; iwh++)
+    {
+        ZeroMemory(&_rgwh[iwh], sizeof(WAVEHDR));
+        if (NULL == (_rgwh[iwh].lpData = (LPSTR) new BT[cbBuf]))
+            return E_OUTOFMEMORY;
+        _rgwh[iwh].dwBufferLength = cbBuf;
+    }
+
+    _prglAcc = new long[_cfrmBuf * _wfx.nChannels];
+    _prgswScratch = new SW[(kcfrmScratch + 1) * kcchMax];
+    _prgbScratch = new BT[(kcfrmScratch + 1) * kcchMax * sizeof(SW)];
+    if (NULL == _prglAcc || NULL == _prgswScratch || NULL == _prgbScratch)
+        return E_OUTOFMEMORY;
+    return S_OK;
+}
+
+void AMMIX::_FreeBuffers(void)
+{
+    long iwh;
+
+    for (iwh = 0; iwh < kcbufMixMax; iwh++)
+    {
+        delete[](BT *) _rgwh[iwh].lpData;
+        _rgwh[iwh].lpData = NULL;
+    }
+    delete[] _prglAcc;
+    delete[] _prgswScratch;
+    delete[] _prgbScratch;
+    _prglAcc = NULL;
+    _prgswScratch = NULL;
+    _prgbScratch = NULL;
+    _cbuf = 0;
+}
+
+STDMETHODIMP AMMIX::Init(HINSTANCE hInst, LPWAVEOUT pWaveOut, LPMIXERCONFIG pMixerConfig,
+                         LPADVMIXCONFIG pAdvMixConfig)
+{
+    HRESULT hr;
+
+    if (_fInited)
+        return E_ALREADYINITED;
+    if (FAILED(hr = _HrGetFormat(pMixerConfig, &_wfx)))
+        return hr;
+
+    if (NULL != pAdvMixConfig)
+        _amxc = *pAdvMixConfig;
+    else
+    {
+        _amxc.dwSize = sizeof(_amxc);
+        _amxc.uVoices = 16;
+        _amxc.fRemixEnabled = TRUE;
+        _amxc.uBufferTime = 160;
+    }
+
+    if (NULL != pWaveOut)
+    {
+        _pwvo = pWaveOut;
+        _pwvo->AddRef();
+    }
+    else if (NULL == (_pwvo = new WAVO))
+        return E_OUTOFMEMORY;
+
+    // With no wave device, mix into the void so sounds still sequence
+    // (and complete) in real time.
+    if (_pwvo->GetNumDevs() == 0)
+    {
+        _pwvo->Release();
+        if (NULL == (_pwvo = new AMFSNK(NULL, true)))
+            return E_OUTOFMEMORY;
+    }
+
+    if (NULL == (_hevt = CreateEvent(NULL, FALSE, FALSE, NULL)) || FAILED(hr = _HrAllocBuffers()))
+    {
+        _FreeBuffers();
+        if (NULL != _hevt)
+            CloseHandle(_hevt);
+        _hevt = NULL;
+        _pwvo->Release();
+        _pwvo = NULL;
+        return FAILED(hr) ? hr : E_INITFAILED;
+    }
+
+    _fInited = true;
+    return S_OK;
+}
+
+STDMETHODIMP AMMIX::Uninit(void)
+{
+    long ipchan;
+    AMCHAN *pchan;
+
+    if (!_fInited)
+        return S_OK;
+
+    _Close();
+
+    EnterCriticalSection(&_critMix);
+    _DrainCommands();
+    for (ipchan = 0; ipchan < _cpchan; ipchan++)
+    {
+        pchan = _prgpchan[ipchan];
+        _SetSrc(pchan, NULL);
+        pchan->_pmix = NULL;
+        pchan->Release();
+    }
+    delete[] _prgpchan;
+    _prgpchan = NULL;
+    _cpchan = _cpchanMax = 0;
+    _FreeBuffers();
+    LeaveCriticalSection(&_critMix);
+
+    CloseHandle(_hevt);
+    _hevt = NULL;
+    _pwvo->Release();
+    _pwvo = NULL;
+    _fInited = _fActive = false;
+    return S_OK;
+}
+
+/***************************************************************************
+    Open or close the device to match _fActive and _fSuspended.
+***************************************************************************/
+HRESULT AMMIX::_HrUpdate(void)
+{
+    if (_fActive && !_fSuspended)
+        return _HrOpen();
+    _Close();
+    return S_OK;
+}
+
+STDMETHODIMP AMMIX::Activate(BOOL fActive)
+{
+    if (!_fInited)
+        return E_NOTINITED;
+    _fActive = fActive != FALSE;
+    return _HrUpdate();
+}
+
+STDMETHODIMP AMMIX::Suspend(BOOL fSuspend)
+{
+    if (!_fInited)
+        return E_NOTINITED;
+    _fSuspended = fSuspend != FALSE;
+    return _HrUpdate();
+}
+
+STDMETHODIMP AMMIX::SetConfig(LPMIXERCONFIG pMixerConfig, LPADVMIXCONFIG pAdvMixConfig)
+{
+    WAVEFORMATEX wfx;
+    HRESULT hr;
+
+    if (!_fInited)
+        return E_NOTINITED;
+    if (_fOpen)
+        return E_FAIL;
+    if (FAILED(hr = _HrGetFormat(pMixerConfig, &wfx)))
+        return hr;
+
+    EnterCriticalSection(&_critMix);
+    _FreeBuffers();
+    _wfx = wfx;
+    if (NULL != pAdvMixConfig)
+        _amxc = *pAdvMixConfig;
+    hr = _HrAllocBuffers();
+
+    // voices step through their sources relative to the output rate
+    for (long ipchan = 0; ipchan < _cpchan; ipchan++)
+        _SetStep(_prgpchan[ipchan]);
+    LeaveCriticalSection(&_critMix);
+    return hr;
+}
+
+STDMETHODIMP AMMIX::GetConfig(LPMIXERCONFIG pMixerConfig, LPADVMIXCONFIG pAdvMixConfig)
+{
+    long iwff;
+    WAVEFORMATEX wfx;
+
+    if (!_fInited)
+        return E_NOTINITED;
+
+    if (NULL != pMixerConfig)
+    {
+        if (NULL != pMixerConfig->lpFormat)
+            *pMixerConfig->lpFormat = _wfx;
+
+        pMixerConfig->dwFormat = 0;
+        for (iwff = 1; iwff != 0 && iwff <= WAVE_FORMAT_4S16; iwff <<= 1)
+        {
+            if (AmFFormatFromFlag(iwff, &wfx) && wfx.nSamplesPerSec == _wfx.nSamplesPerSec &&
+                wfx.nChannels == _wfx.nChannels && wfx.wBitsPerSample == _wfx.wBitsPerSample)
+            {
+                pMixerConfig->dwFormat = iwff;
+            }
+        }
+    }
+    if (NULL != pAdvMixConfig)
+        *pAdvMixConfig = _amxc;
+    return S_OK;
+}
+
+STDMETHODIMP AMMIX::SetMixerVolume(DWORD dwVolume)
+{
+    // Applied in the mix rather than to the device, so we never disturb the
+    // system volume.
+    _luVol = dwVolume;
+    InterlockedExchange(&_lwGain, (_LwGainFromVol(dwVolume) + _LwGainFromVol(dwVolume >> 16)) / 2);
+    return S_OK;
+}
+
+STDMETHODIMP AMMIX::GetMixerVolume(LPDWORD lpdwVolume)
+{
+    *lpdwVolume = _luVol;
+    return S_OK;
+}
+
+STDMETHODIMP AMMIX::PlaySound(LPSOUND pSound)
+{
+    AMCHAN *pchan;
+    HRESULT hr;
+
+    if (FAILED(hr = AllocChannel((LPCHANNEL *)&pchan)))
+        return hr;
+
+    // the mixer drops the channel once the sound is done
+    pchan->_fOneShot = true;
+    pchan->SetSoundSrc(pSound);
+    pchan->Play();
+    pchan->Release();
+    return S_OK;
+}
+
+STDMETHODIMP_(BOOL) AMMIX::RemixMode(BOOL fActive)
+{
+    BOOL fOld = _amxc.fRemixEnabled;
+
+    _amxc.fRemixEnabled = fActive;
+    return fOld;
+}
+
+STDMETHODIMP_(DWORD) AMMIX::GetAvgSample(void)
+{
+    return _luAvgSample;
+}
+
+STDMETHODIMP AMMIX::AllocGroup(LPDWORD lpdwGroup)
+{
+    long igrp;
+
+    for (igrp = 0; igrp < kcgrpMax; igrp++)
+    {
+        if (!(_grfgrpAlloc & (1UL << igrp)))
+        {
+            _grfgrpAlloc |= 1UL << igrp;
+            *lpdwGroup = igrp;
+            return S_OK;
+        }
+    }
+    return E_ALLGROUPSALLOCATED;
+}
+
+STDMETHODIMP AMMIX::FreeGroup(DWORD dwGroup)
+{
+    if (dwGroup >= kcgrpMax || !(_grfgrpAlloc & (1UL << dwGroup)))
+        return E_GROUPNOTALLOCATED;
+
+    _grfgrpAlloc &= ~(1UL << dwGroup);
+    _Post(kcmdFreeGroup, NULL, NULL, dwGroup);
+    return S_OK;
+}
+
+/***************************************************************************
+    Get our channel from a client's IUnknown.
+***************************************************************************/
+static AMCHAN *_PchanFromPunk(IUnknown *punk)
+{
+    IAMChannel *pchan;
+
+    if (NULL == punk || FAILED(punk->QueryInterface(IID_IAMChannel, (void **)&pchan)))
+        return NULL;
+    pchan->Release();
+    return (AMCHAN *)pchan;
+}
+
+STDMETHODIMP AMMIX::EnlistGroup(IUnknown FAR *pChannel, DWORD dwGroup)
+{
+    AMCHAN *pchan;
+
+    if (dwGroup >= kcgrpMax || !(_grfgrpAlloc & (1UL << dwGroup)))
+        return E_GROUPNOTALLOCATED;
+    if (NULL == (pchan = _PchanFromPunk(pChannel)))
+        return E_NOINTERFACE;
+
+    pchan->_fPlayingPub = NULL != pchan->_psndCli;
+    _Post(kcmdEnlist, pchan, NULL, dwGroup);
+    return S_OK;
+}
+
+STDMETHODIMP AMMIX::DefectGroup(LPUNKNOWN pUnknown, DWORD dwGroup)
+{
+    AMCHAN *pchan;
+
+    if (dwGroup >= kcgrpMax || !(_grfgrpAlloc & (1UL << dwGroup)))
+        return E_GROUPNOTALLOCATED;
+    if (NULL == (pchan = _PchanFromPunk(pUnknown)))
+        return E_NOINTERFACE;
+
+    _Post(kcmdDefect, pchan, NULL, dwGroup);
+    return S_OK;
+}
+
+STDMETHODIMP AMMIX::StartGroup(DWORD dwGroup, BOOL fStart)
+{
+    if (dwGroup >= kcgrpMax || !(_grfgrpAlloc & (1UL << dwGroup)))
+        return E_GROUPNOTALLOCATED;
+
+    _Post(fStart ? kcmdStartGroup : kcmdStopGroup, NULL, NULL, dwGroup);
+    return S_OK;
+}
+
+STDMETHODIMP AMMIX::ResetGroup(DWORD dwGroup)
+{
+    return E_NOTIMPL;
+}
+
+STDMETHODIMP AMMIX::SetGroupVolume(DWORD dwGroup, DWORD dwVolume)
+{
+    return E_NOTIMPL;
+}
+
+STDMETHODIMP AMMIX::SetGroupGain(DWORD dwGroup, float flDBLeft, float flDBRight, BOOL fAbsolute)
+{
+    return E_NOTIMPL;
+}
+
+STDMETHODIMP AMMIX::SetGroupPosition(DWORD dwGroup, DWORD dwPosition)
+{
+    return E_NOTIMPL;
+}
+
+STDMETHODIMP AMMIX::AllocChannel(LPCHANNEL FAR *ppChannel)
+{
+    AMCHAN *pchan;
+
+    *ppChannel = NULL;
+    if (!_fInited)
+        return E_NOTINITED;
+    if (NULL == (pchan = new AMCHAN(this)))
+        return E_OUTOFMEMORY;
+
+    // this reference belongs to the mixer thread's channel list
+    pchan->AddRef();
+    _Post(kcmdAddChan, pchan, NULL, 0);
+
+    *ppChannel = pchan;
+    return S_OK;
+}
+
+STDMETHODIMP AMMIX::RegisterChannel(LPUNKNOWN pUnknown)
+{
+    return E_NOTIMPL;
+}
+
+STDMETHODIMP AMMIX::UnregisterChannel(LPUNKNOWN pUnknown)
+{
+    return E_NOTIMPL;
+}
+
+STDMETHODIMP AMMIX::SetPriority(LPUNKNOWN pUnknown, DWORD dwPriority)
+{
+    return E_NOTIMPL;
+}
+
+STDMETHODIMP AMMIX::GetPriority(LPUNKNOWN pUnknown, LPDWORD lpdwPriority)
+{
+    return E_NOTIMPL;
+}
+
+STDMETHODIMP_(void) AMMIX::Refresh(void)
+{
+    // the mixer thread does all the work
+}
+
+/***************************************************************************
+    Command queue. This is a bounded multi-producer, single consumer ring:
+    each cell carries a sequence number that tells producers whether it's
+    free and the consumer whether it's filled.
+***************************************************************************/
+bool AMMIX::_FEnqueue(AMCMD *pcmd)
+{
+    LONG icell = _icellEnq;
+    AMCELL *pcell;
+    LONG dlw;
+
+    for (;;)
+    {
+        pcell = &_rgcell[icell & (kccmdQueue - 1)];
+        dlw = pcell->lwSeq - icell;
+        if (dlw == 0)
+        {
+            if (InterlockedCompareExchange(&_icellEnq, icell + 1, icell) == icell)
+            {
+                pcell->cmd = *pcmd;
+                InterlockedExchange(&pcell->lwSeq, icell + 1);
+                return true;
+            }
+        }
+        else if (dlw < 0)
+            return false;
+        icell = _icellEnq;
+    }
+}
+
+bool AMMIX::_FDequeue(AMCMD *pcmd)
+{
+    AMCELL *pcell = &_rgcell[_icellDeq & (kccmdQueue - 1)];
+
+    if (pcell->lwSeq - (_icellDeq + 1) < 0)
+        return false;
+
+    *pcmd = pcell->cmd;
+    InterlockedExchange(&pcell->lwSeq, _icellDeq + kccmdQueue);
+    _icellDeq++;
+    return true;
+}
+
+/***************************************************************************
+    Post a command for the mixer thread. The command holds references to
+    the channel and the sound until it's applied.
+***************************************************************************/
+void AMMIX::_Post(long cmd, AMCHAN *pchan, IAMSound *psnd, DWORD lu)
+{
+    AMCMD amcmd;
+
+    amcmd.cmd = cmd;
+    amcmd.pchan = pchan;
+    amcmd.psnd = psnd;
+    amcmd.lu = lu;
+    if (NULL != pchan)
+        pchan->AddRef();
+    if (NULL != psnd)
+        psnd->AddRef();
+
+    while (!_FEnqueue(&amcmd))
+    {
+        // The queue is full: the mixer thread is behind or not running, so
+        // do its work for it.
+        EnterCriticalSection(&_critMix);
+        _DrainCommands();
+        LeaveCriticalSection(&_critMix);
+    }
+}
+
+void AMMIX::_DrainCommands(void)
+{
+    AMCMD amcmd;
+
+    while (_FDequeue(&amcmd))
+    {
+        _Apply(&amcmd);
+        if (NULL != amcmd.psnd)
+            amcmd.psnd->Release();
+        if (NULL != amcmd.pchan)
+            amcmd.pchan->Release();
+    }
+}
+
+/***************************************************************************
+    Apply a command on the mixer side.
+***************************************************************************/
+void AMMIX::_Apply(AMCMD *pcmd)
+{
+    AMCHAN *pchan = pcmd->pchan;
+    long ipchan;
+    DWORD grfgrp = 1UL << (pcmd->lu & 31);
+
+    switch (pcmd->cmd)
+    {
+    case kcmdAddChan:
+        if (_cpchan == _cpchanMax)
+        {
+            long cpchanMax = max(2 * _cpchanMax, 16);
+            AMCHAN **prgpchan = new AMCHAN *[cpchanMax];
+
+            if (NULL == prgpchan)
+            {
+                // we can't track it, so it'll never play
+                pchan->_pmix = NULL;
+                pchan->Release();
+                break;
+            }
+            if (_cpchan > 0)
+                CopyMemory(prgpchan, _prgpchan, _cpchan * sizeof(AMCHAN *));
+            delete[] _prgpchan;
+            _prgpchan = prgpchan;
+            _cpchanMax = cpchanMax;
+        }
+        // takes over the reference AllocChannel made for us
+        _prgpchan[_cpchan++] = pchan;
+        break;
+
+    case kcmdSetSrc:
+        if (NULL != pcmd->psnd)
+            pcmd->psnd->AddRef();
+        _SetSrc(pchan, pcmd->psnd);
+        break;
+
+    case kcmdPlay:
+        pchan->_fPlay = true;
+        pchan->_grfgrp = 0;
+        pchan->_fPlayingPub = pchan->_FActive();
+        break;
+
+    case kcmdStop:
+        pchan->_fPlay = false;
+        pchan->_grfgrp = 0;
+        pchan->_fPlayingPub = 0;
+        break;
+
+    case kcmdSetPos:
+        pchan->_ismp = min(pcmd->lu, pchan->_csmp);
+        pchan->_luFrac = 0;
+        pchan->_fEnded = false;
+        pchan->_ismpPub = pchan->_ismp;
+        break;
+
+    case kcmdSetVol:
+        pchan->_lwGainL = _LwGainFromVol(pcmd->lu);
+        pchan->_lwGainR = _LwGainFromVol(pcmd->lu >> 16);
+        break;
+
+    case kcmdMute:
+        pchan->_fMute = pcmd->lu != 0;
+        break;
+
+    case kcmdEnlist:
+        pchan->_fPlay = true;
+        pchan->_grfgrp |= grfgrp;
+        break;
+
+    case kcmdDefect:
+        pchan->_grfgrp &= ~grfgrp;
+        break;
+
+    case kcmdStartGroup:
+    case kcmdStopGroup:
+    case kcmdFreeGroup:
+        for (ipchan = 0; ipchan < _cpchan; ipchan++)
+        {
+            pchan = _prgpchan[ipchan];
+            if (!(pchan->_grfgrp & grfgrp))
+                continue;
+            pchan->_grfgrp &= ~grfgrp;
+            if (pcmd->cmd == kcmdStopGroup)
+            {
+                pchan->_fPlay = false;
+                pchan->_fPlayingPub = 0;
+            }
+        }
+        break;
+    }
+}
+
+/***************************************************************************
+    Compute how fast pchan steps through its source at our output rate.
+***************************************************************************/
+void AMMIX::_SetStep(AMCHAN *pchan)
+{
+    if (NULL == pchan->_psnd || _wfx.nSamplesPerSec == 0)
+        return;
+    pchan->_luStep = (DWORD)(((ULONGLONG)pchan->_wfx.nSamplesPerSec << 16) / _wfx.nSamplesPerSec);
+    pchan->_luStep = max(pchan->_luStep, (DWORD)1);
+}
+
+/***************************************************************************
+    Give pchan a new source, taking over the caller's reference to psnd.
+***************************************************************************/
+void AMMIX::_SetSrc(AMCHAN *pchan, IAMSound *psnd)
+{
+    if (NULL != pchan->_psnd)
+        pchan->_psnd->Release();
+
+    pchan->_psnd = psnd;
+    pchan->_ismp = 0;
+    pchan->_luFrac = 0;
+    pchan->_fEnded = false;
+    pchan->_csmp = 0;
+    if (NULL != psnd)
+    {
+        if (SUCCEEDED(psnd->GetFormat(&pchan->_wfx, sizeof(pchan->_wfx))) && AmFMixable(&pchan->_wfx))
+            pchan->_csmp = psnd->GetSamples();
+        _SetStep(pchan);
+    }
+    pchan->_ismpPub = 0;
+    pchan->_fPlayingPub = pchan->_FActive() && pchan->_grfgrp == 0;
+}
+
+/***************************************************************************
+    Open the device and start the mixer thread.
+***************************************************************************/
+HRESULT AMMIX::_HrOpen(void)
+{
+    MMRESULT mmr;
+    DWORD luThread;
+    long iwh;
+
+    if (_fOpen)
+        return S_OK;
+
+    mmr = _pwvo->Open(WAVE_MAPPER, &_wfx, (DWORD)_hevt, 0, CALLBACK_EVENT);
+    if (MMSYSERR_NOERROR != mmr)
+        return mmr == MMSYSERR_ALLOCATED ? E_AUDIODEVICEBUSY : E_OPENDEVICEFAILED;
+
+    for (iwh = 0; iwh < _cbuf; iwh++)
+    {
+        _rgwh[iwh].dwFlags = 0;
+        _pwvo->PrepareHeader(&_rgwh[iwh], sizeof(WAVEHDR));
+    }
+    _iwhNext = 0;
+    _fQuit = 0;
+
+    if (NULL == (_hth = CreateThread(NULL, 0, _LuThread, this, 0, &luThread)))
+    {
+        for (iwh = 0; iwh < _cbuf; iwh++)
+            _pwvo->UnprepareHeader(&_rgwh[iwh], sizeof(WAVEHDR));
+        _pwvo->Close();
+        return E_FAIL;
+    }
+    SetThreadPriority(_hth, THREAD_PRIORITY_HIGHEST);
+
+    _fOpen = true;
+    return S_OK;
+}
+
+/***************************************************************************
+    Stop the mixer thread and close the device. Voices keep their places.
+***************************************************************************/
+void AMMIX::_Close(void)
+{
+    long iwh;
+
+    if (!_fOpen)
+        return;
+
+    InterlockedExchange(&_fQuit, 1);
+    SetEvent(_hevt);
+    WaitForSingleObject(_hth, INFINITE);
+    CloseHandle(_hth);
+    _hth = NULL;
+
+    _pwvo->Reset();
+    for (iwh = 0; iwh < _cbuf; iwh++)
+        _pwvo->UnprepareHeader(&_rgwh[iwh], sizeof(WAVEHDR));
+    _pwvo->Close();
+    _fOpen = false;
+}
+
+DWORD WINAPI AMMIX::_LuThread(LPVOID pv)
+{
+    ((AMMIX *)pv)->_Run();
+    return 0;
+}
+
+/***************************************************************************
+    The mixer thread: keep every buffer the device isn't playing filled.
+***************************************************************************/
+void AMMIX::_Run(void)
+{
+    WAVEHDR *pwh;
+
+    while (!_fQuit)
+    {
+        pwh = &_rgwh[_iwhNext];
+        if (pwh->dwFlags & WHDR_INQUEUE)
+        {
+            // wait for the device to hand one back
+            WaitForSingleObject(_hevt, kdtsMixPeriod);
+            continue;
+        }
+
+        _MixBuffer((BT *)pwh->lpData);
+        _pwvo->Write(pwh, sizeof(WAVEHDR));
+        _iwhNext = (_iwhNext + 1) % _cbuf;
+    }
+}
+
+/***************************************************************************
+    Mix one buffer's worth of every playing voice into pb, then deliver any
+    completion notifications.
+***************************************************************************/
+void AMMIX::_MixBuffer(BT *pb)
+{
+    long cch = _wfx.nChannels;
+    long isw, csw = _cfrmBuf * cch;
+    long ipchan;
+    long lw, lwGain;
+    DWORD luSum;
+    AMCHAN *pchan;
+    AMCHAN *pchanNote = NULL;
+
+    EnterCriticalSection(&_critMix);
+    _DrainCommands();
+
+    ZeroMemory(_prglAcc, csw * sizeof(long));
+    for (ipchan = 0; ipchan < _cpchan;)
+    {
+        pchan = _prgpchan[ipchan];
+        if (_FMixVoice(pchan) && (pchan->_grfnot & NOTIFYSINK_ONCOMPLETION))
+        {
+            // the note holds references to the channel and the sound
+            pchan->AddRef();
+            pchan->_psnd->AddRef();
+            pchan->_psndNote = pchan->_psnd;
+            pchan->_ismpNote = pchan->_ismp;
+            pchan->_pchanNote = pchanNote;
+            pchanNote = pchan;
+        }
+
+        // drop channels the client has let go of (one shots once they're done)
+        if (pchan->_cactRef == 1 && (!pchan->_fOneShot || !pchan->_FActive()))
+        {
+            _SetSrc(pchan, NULL);
+            pchan->_pmix = NULL;
+            pchan->Release();
+            _prgpchan[ipchan] = _prgpchan[--_cpchan];
+            continue;
+        }
+        ipchan++;
+    }
+
+    lwGain = _lwGain;
+    luSum = 0;
+    for (isw = 0; isw < csw; isw++)
+    {
+        lw = (long)(((LONGLONG)_prglAcc[isw] * lwGain) >> 16);
+        lw = lw < -32768 ? -32768 : lw > 32767 ? 32767 : lw;
+        luSum += lw < 0 ? -lw : lw;
+        if (_wfx.wBitsPerSample == 16)
+            ((SW *)pb)[isw] = (SW)lw;
+        else
+            pb[isw] = (BT)((lw >> 8) + 128);
+    }
+    _luAvgSample = csw > 0 ? luSum / csw : 0;
+
+    LeaveCriticalSection(&_critMix);
+
+    // Now that we hold nothing the client might be waiting on, tell it
+    // about finished sounds.
+    while (NULL != (pchan = pchanNote))
+    {
+        pchanNote = pchan->_pchanNote;
+        EnterCriticalSection(&pchan->_critNot);
+        if (NULL != pchan->_pnot)
+            pchan->_pnot->OnCompletion(pchan->_psndNote, pchan->_ismpNote);
+        LeaveCriticalSection(&pchan->_critNot);
+        pchan->_psndNote->Release();
+        pchan->_pchanNote = NULL;
+        pchan->_psndNote = NULL;
+        pchan->Release();
+    }
+}
+
+/***************************************************************************
+    Mix one buffer of pchan into _prglAcc. Sources are read a scratch load
+    at a time, converted to 16 bit in our channel count and resampled
+    (linearly, in 16.16 fixed point) as they're summed. Returns true if the
+    source ran out during this buffer.
+***************************************************************************/
+bool AMMIX::_FMixVoice(AMCHAN *pchan)
+{
+    long cch = _wfx.nChannels;
+    long *plAcc = _prglAcc;
+    long cfrmLeft = _cfrmBuf;
+    long cfrmOut, cfrmSrc;
+    long ifrm;
+    DWORD cfrmGot;
+    DWORD luStep = pchan->_luStep;
+    DWORD lu;
+    const SW *psw;
+    long lwFrac, lwL, lwR;
+    long lwGainL, lwGainR;
+
+    if (!pchan->_FActive() || pchan->_grfgrp != 0)
+        return false;
+
+    lwGainL = pchan->_fMute ? 0 : pchan->_lwGainL;
+    lwGainR = pchan->_fMute ? 0 : pchan->_lwGainR;
+    if (cch == 1)
+        lwGainL = (lwGainL + lwGainR) >> 1;
+
+    while (cfrmLeft > 0 && pchan->_ismp < pchan->_csmp)
+    {
+        // as many output frames as a scratch load of source frames covers
+        cfrmOut = min(cfrmLeft, kcfrmScratch);
+        cfrmOut = (long)min((ULONGLONG)cfrmOut,
+                            (((ULONGLONG)(kcfrmScratch - 1) << 16) - pchan->_luFrac) / luStep + 1);
+        cfrmSrc = ((pchan->_luFrac + (cfrmOut - 1) * luStep) >> 16) + 2;
+
+        cfrmGot = cfrmSrc;
+        if (FAILED(pchan->_psnd->GetSampleData(_prgbScratch, pchan->_ismp, &cfrmGot, NULL)) || cfrmGot == 0)
+        {
+            // treat a broken source as finished
+            pchan->_ismp = pchan->_csmp;
+            break;
+        }
+        cfrmGot = min(cfrmGot, (DWORD)cfrmSrc);
+        AmConvertToSw(_prgbScratch, &pchan->_wfx, cfrmGot, _prgswScratch, cch);
+        if ((long)cfrmGot < cfrmSrc)
+            ZeroMemory(_prgswScratch + cfrmGot * cch, (cfrmSrc - cfrmGot) * cch * sizeof(SW));
+
+        lu = pchan->_luFrac;
+        if (luStep == 0x10000 && lu == 0)
+        {
+            // same rate, nothing to interpolate
+            psw = _prgswScratch;
+            if (cch == 1)
+            {
+                for (ifrm = 0; ifrm < cfrmOut; ifrm++)
+                    plAcc[ifrm] += (psw[ifrm] * lwGainL) >> 16;
+            }
+            else
+            {
+                for (ifrm = 0; ifrm < cfrmOut; ifrm++, psw += 2)
+                {
+                    plAcc[2 * ifrm] += (psw[0] * lwGainL) >> 16;
+                    plAcc[2 * ifrm + 1] += (psw[1] * lwGainR) >> 16;
+                }
+            }
+        }
+        else if (cch == 1)
+        {
+            for (ifrm = 0; ifrm < cfrmOut; ifrm++, lu += luStep)
+            {
+                psw = _prgswScratch + (lu >> 16);
+                lwFrac = (lu & 0xFFFF) >> 1;
+                lwL = psw[0] + (((psw[1] - psw[0]) * lwFrac) >> 15);
+                plAcc[ifrm] += (lwL * lwGainL) >> 16;
+            }
+        }
+        else
+        {
+            for (ifrm = 0; ifrm < cfrmOut; ifrm++, lu += luStep)
+            {
+                psw = _prgswScratch + 2 * (lu >> 16);
+                lwFrac = (lu & 0xFFFF) >> 1;
+                lwL = psw[0] + (((psw[2] - psw[0]) * lwFrac) >> 15);
+                lwR = psw[1] + (((psw[3] - psw[1]) * lwFrac) >> 15);
+                plAcc[2 * ifrm] += (lwL * lwGainL) >> 16;
+                plAcc[2 * ifrm + 1] += (lwR * lwGainR) >> 16;
+            }
+        }
+
+        lu = pchan->_luFrac + cfrmOut * luStep;
+        pchan->_ismp += lu >> 16;
+        pchan->_luFrac = lu & 0xFFFF;
+        plAcc += cfrmOut * cch;
+        cfrmLeft -= cfrmOut;
+    }
+
+    pchan->_ismpPub = min(pchan->_ismp, pchan->_csmp);
+    if (pchan->_ismp < pchan->_csmp)
+        return false;
+
+    // the last load may have run past the end into padding
+    pchan->_ismp = pchan->_csmp;
+    pchan->_fEnded = true;
+    pchan->_fPlayingPub = 0;
+    return true;
+}
@@ -0,0 +1,566 @@
+/***************************************************************************
+    Private declarations for the AudioMan library.
+
+    Sounds are pull sources: the mixer asks a sound for a run of samples
+    at an absolute position and the sound fills them in. Every sound we
+    hand out produces PCM; compressed wave data is decoded by the wave
+    source itself, so filters and the mixer only ever see PCM.
+
+    The mixer runs on its own thread. Channel calls from the client post
+    commands to a lock-free queue that the mixer thread drains at the top
+    of every buffer, so the game never waits on the mixer (and the
+    completion callbacks, which run on the mixer thread, never wait on the
+    game).
+
+***************************************************************************/
+#ifndef AMPRIV_H
+#define AMPRIV_H
+
+#include <Windows.h>
+#include <mmsystem.h>
+#include <mmreg.h>
+
+#include "audioman.h"
+
+typedef short SW;
+typedef unsigned char BT;
+
+const long kcchMax = 2;           // most channels (mono/stereo) we handle
+const long kcfrmScratch = 2048;   // frames per read from a source
+const long kdtsMixPeriod = 20;    // ms of audio per mixer buffer
+const long kcbufMixMax = 8;       // max buffers in flight
+const long kccmdQueue = 256;      // command queue size (power of 2)
+const long kcgrpMax = 32;         // number of channel groups
+const SW kswTrimSilence = 512;    // trim filter threshold (about -36 dB)
+
+// Whether pwfx is PCM we can read (8 or 16 bit, mono or stereo).
+bool AmFMixable(const WAVEFORMATEX *pwfx);
+
+// Fill in a PCM WAVEFORMATEX.
+void AmSetPcmFormat(WAVEFORMATEX *pwfx, DWORD luRate, WORD cch, WORD cbit);
+
+// Expand a WAVE_FORMAT_xxx flag (as in MIXERCONFIG.dwFormat) to a format.
+bool AmFFormatFromFlag(DWORD grfwf, WAVEFORMATEX *pwfx);
+
+// Convert PCM frames to interleaved 16 bit with cchDst channels.
+void AmConvertToSw(const BT *pb, const WAVEFORMATEX *pwfx, long cfrm, SW *psw, long cchDst);
+
+// Convert interleaved 16 bit frames back to the (PCM) format of pwfx.
+void AmConvertFromSw(const SW *psw, long cfrm, long cchSrc, BT *pb, const WAVEFORMATEX *pwfx);
+
+// Write a 44 byte PCM RIFF header at the start of hfile.
+bool AmFWriteWaveHeader(HANDLE hfile, const WAVEFORMATEX *pwfx, DWORD cbData);
+
+// Linearly resample cfrm frames, starting luFrac (16.16) into pswSrc and
+// advancing luStep per frame. pswSrc must hold the frame after the last
+// one touched.
+void AmResample(const SW *pswSrc, long cch, DWORD luFrac, DWORD luStep, SW *pswDst, long cfrm);
+
+/***************************************************************************
+    Base class for all our IAMSound implementations.
+***************************************************************************/
+class AMSND : public IAMSound
+{
+  protected:
+    LONG _cactRef;
+    WAVEFORMATEX _wfx; // PCM format of the samples we hand out
+    DWORD _csmp;       // number of samples (frames)
+
+    AMSND(void);
+    virtual ~AMSND(void);
+
+  public:
+    // IUnknown methods
+    STDMETHODIMP QueryInterface(REFIID riid, void **ppv);
+    STDMETHODIMP_(ULONG) AddRef(void);
+    STDMETHODIMP_(ULONG) Release(void);
+
+    // IAMSound methods
+    STDMETHODIMP GetFormat(LPWAVEFORMATEX pFormat, DWORD cbSize);
+    STDMETHODIMP_(DWORD) GetSamples(void)
+    {
+        return _csmp;
+    }
+    STDMETHODIMP GetAlignment(LPDWORD lpdwLeftAlign, LPDWORD lpdwRightAlign);
+    STDMETHODIMP SetCacheSize(DWORD dwCacheSize)
+    {
+        return S_OK;
+    }
+    STDMETHODIMP SetMode(BOOL fActive, BOOL fRecurse)
+    {
+        return S_OK;
+    }
+
+    WAVEFORMATEX *Pwfx(void)
+    {
+        return &_wfx;
+    }
+};
+
+/***************************************************************************
+    A wave file source: an IStream, a file or a block of memory holding a
+    RIFF WAVE. Handles PCM, MS ADPCM and IMA ADPCM data.
+***************************************************************************/
+class AMWAV : public AMSND
+{
+  protected:
+    CRITICAL_SECTION _crit; // the stream position is shared by all readers
+    IStream *_pstm;         // the stream, if spooled
+    HANDLE _hfile;          // the file, if spooled from a file
+    BT *_pbData;            // the whole file, if in memory
+    DWORD _ibData;          // offset of the wave data
+    DWORD _cbData;          // size of the wave data
+
+    WORD _wtag;            // source format tag
+    WORD _cbBlock;         // source block size
+    DWORD _csmpBlock;      // samples per compressed block
+    long _ccoef;           // MS ADPCM coefficient pairs
+    SW _rgswCoef[2 * 256]; // MS ADPCM coefficients
+    BT *_pbBlock;          // raw compressed block
+    SW *_pswBlock;         // decoded block
+    long _iblkCache;       // which block _pswBlock holds
+    long _csmpCache;       // frames decoded into _pswBlock
+
+    AMWAV(void);
+    ~AMWAV(void);
+
+    bool _FRead(DWORD ib, void *pv, DWORD cb);
+    HRESULT _HrParse(DWORD ibBase, DWORD cbFile);
+    bool _FDecodeBlock(long iblk);
+    long _CsmpDecodeMs(const BT *pb, long cb);
+    long _CsmpDecodeIma(const BT *pb, long cb);
+
+  public:
+    static HRESULT HrNewStream(AMWAV **ppwav, IStream *pstm, BOOL fSpooled);
+    static HRESULT HrNewFile(AMWAV **ppwav, char *pszFile, DWORD ibOffset, BOOL fSpooled);
+    static HRESULT HrNewMemory(AMWAV **ppwav, BT *pb, DWORD cb);
+
+    STDMETHODIMP GetSampleData(LPBYTE lpBuffer, DWORD dwPosition, LPDWORD lpdwSamples, LPREQUESTPARAM lpRequestParams);
+};
+
+/***************************************************************************
+    Base class for filters: sounds that wrap one source sound.
+***************************************************************************/
+class AMFLT : public AMSND
+{
+  protected:
+    IAMSound *_psndSrc;
+    WAVEFORMATEX _wfxSrc;
+
+    AMFLT(void);
+    ~AMFLT(void);
+
+    HRESULT _HrSetSrc(IAMSound *psndSrc);
+    HRESULT _HrScan(void (*pfn)(void *pvCtx, const SW *psw, long cfrm, DWORD ifrm), void *pvCtx);
+};
+
+/***************************************************************************
+    Trim filter: strips leading and trailing silence.
+***************************************************************************/
+class AMTRIM : public AMFLT
+{
+  protected:
+    DWORD _ismpFirst;
+
+  public:
+    static HRESULT HrNew(AMTRIM **pptrim, IAMSound *psndSrc);
+
+    STDMETHODIMP GetSampleData(LPBYTE lpBuffer, DWORD dwPosition, LPDWORD lpdwSamples, LPREQUESTPARAM lpRequestParams);
+};
+
+/***************************************************************************
+    Bias filter: removes any DC offset from the source.
+***************************************************************************/
+class AMBIAS : public AMFLT
+{
+  protected:
+    long _rgdsw[kcchMax]; // per channel offset to add
+
+  public:
+    static HRESULT HrNew(AMBIAS **ppbias, IAMSound *psndSrc);
+
+    STDMETHODIMP GetSampleData(LPBYTE lpBuffer, DWORD dwPosition, LPDWORD lpdwSamples, LPREQUESTPARAM lpRequestParams);
+};
+
+/***************************************************************************
+    Loop filter: plays the source dwLoops + 1 times, sample accurately.
+***************************************************************************/
+class AMLOOP : public AMFLT
+{
+  public:
+    static HRESULT HrNew(AMLOOP **pploop, IAMSound *psndSrc, DWORD cactLoop);
+
+    STDMETHODIMP GetSampleData(LPBYTE lpBuffer, DWORD dwPosition, LPDWORD lpdwSamples, LPREQUESTPARAM lpRequestParams);
+};
+
+/***************************************************************************
+    Convert filter: changes rate, channels and sample size.
+***************************************************************************/
+class AMCONV : public AMFLT
+{
+  protected:
+    DWORD _luStep; // source frames per destination frame, 16.16
+    BT *_pbRaw;    // source frames as read
+    SW *_pswSrc;   // source frames in 16 bit, with our channel count
+    SW *_pswOut;   // resampled frames
+
+  public:
+    static HRESULT HrNew(AMCONV **ppconv, IAMSound *psndSrc, WAVEFORMATEX *pwfx);
+    ~AMCONV(void);
+
+    STDMETHODIMP GetSampleData(LPBYTE lpBuffer, DWORD dwPosition, LPDWORD lpdwSamples, LPREQUESTPARAM lpRequestParams);
+};
+
+/***************************************************************************
+    Output sinks. WAVO goes to the waveOut device; AMFSNK writes to a file
+    (or nowhere) so the mixer can run on a machine without a sound card.
+***************************************************************************/
+class WAVO : public IAMWaveOut
+{
+  protected:
+    LONG _cactRef;
+    HWAVEOUT _hwo;
+
+  public:
+    WAVO(void);
+    ~WAVO(void);
+
+    // IUnknown methods
+    STDMETHODIMP QueryInterface(REFIID riid, void **ppv);
+    STDMETHODIMP_(ULONG) AddRef(void);
+    STDMETHODIMP_(ULONG) Release(void);
+
+    // IAMWaveOut methods
+    STDMETHODIMP_(UINT) GetNumDevs(void);
+    STDMETHODIMP_(MMRESULT) Open(UINT uDeviceID, LPWAVEFORMATEX lpwfx, DWORD dwCallback, DWORD dwCallbackInstance,
+                                 DWORD fdwOpen);
+    STDMETHODIMP_(MMRESULT) Close(void);
+    STDMETHODIMP_(MMRESULT) GetDevCaps(UINT uDeviceID, LPWAVEOUTCAPS lpCaps, UINT cbCaps);
+    STDMETHODIMP_(MMRESULT) GetVolume(LPDWORD lpdwVolume);
+    STDMETHODIMP_(MMRESULT) SetVolume(DWORD dwVolume);
+    STDMETHODIMP_(MMRESULT) PrepareHeader(LPWAVEHDR pwh, UINT cbwh);
+    STDMETHODIMP_(MMRESULT) UnprepareHeader(LPWAVEHDR pwh, UINT cbwh);
+    STDMETHODIMP_(MMRESULT) Write(LPWAVEHDR pwh, UINT cbwh);
+    STDMETHODIMP_(MMRESULT) Pause(void);
+    STDMETHODIMP_(MMRESULT) Restart(void);
+    STDMETHODIMP_(MMRESULT) Reset(void);
+    STDMETHODIMP_(MMRESULT) BreakLoop(void);
+    STDMETHODIMP_(MMRESULT) GetPosition(LPMMTIME lpmmt, UINT cbmmt);
+    STDMETHODIMP_(MMRESULT) GetPitch(LPDWORD lpdwPitch);
+    STDMETHODIMP_(MMRESULT) SetPitch(DWORD dwPitch);
+    STDMETHODIMP_(MMRESULT) GetPlaybackRate(LPDWORD lpdwRate);
+    STDMETHODIMP_(MMRESULT) SetPlaybackRate(DWORD dwRate);
+    STDMETHODIMP_(MMRESULT) GetID(UINT FAR *lpuDeviceID);
+    STDMETHODIMP_(MMRESULT) Message(UINT uMsg, DWORD dw1, DWORD dw2);
+    STDMETHODIMP_(MMRESULT) GetErrorText(MMRESULT err, LPSTR lpText, UINT cchText);
+};
+
+class AMFSNK : public IAMWaveOut
+{
+  protected:
+    LONG _cactRef;
+    char _szFile[MAX_PATH]; // empty for the null sink
+    bool _fRealTime;        // pace writes to the wall clock
+    HANDLE _hfile;
+    WAVEFORMATEX _wfx;
+    DWORD _cbWritten;
+    DWORD _tsOpen;
+    DWORD _luVol;
+
+  public:
+    AMFSNK(char *pszFile, bool fRealTime);
+    ~AMFSNK(void);
+
+    // IUnknown methods
+    STDMETHODIMP QueryInterface(REFIID riid, void **ppv);
+    STDMETHODIMP_(ULONG) AddRef(void);
+    STDMETHODIMP_(ULONG) Release(void);
+
+    // IAMWaveOut methods
+    STDMETHODIMP_(UINT) GetNumDevs(void)
+    {
+        return 1;
+    }
+    STDMETHODIMP_(MMRESULT) Open(UINT uDeviceID, LPWAVEFORMATEX lpwfx, DWORD dwCallback, DWORD dwCallbackInstance,
+                                 DWORD fdwOpen);
+    STDMETHODIMP_(MMRESULT) Close(void);
+    STDMETHODIMP_(MMRESULT) GetDevCaps(UINT uDeviceID, LPWAVEOUTCAPS lpCaps, UINT cbCaps);
+    STDMETHODIMP_(MMRESULT) GetVolume(LPDWORD lpdwVolume)
+    {
+        *lpdwVolume = _luVol;
+        return MMSYSERR_NOERROR;
+    }
+    STDMETHODIMP_(MMRESULT) SetVolume(DWORD dwVolume)
+    {
+        _luVol = dwVolume;
+        return MMSYSERR_NOERROR;
+    }
+    STDMETHODIMP_(MMRESULT) PrepareHeader(LPWAVEHDR pwh, UINT cbwh);
+    STDMETHODIMP_(MMRESULT) UnprepareHeader(LPWAVEHDR pwh, UINT cbwh);
+    STDMETHODIMP_(MMRESULT) Write(LPWAVEHDR pwh, UINT cbwh);
+    STDMETHODIMP_(MMRESULT) Pause(void)
+    {
+        return MMSYSERR_NOERROR;
+    }
+    STDMETHODIMP_(MMRESULT) Restart(void)
+    {
+        return MMSYSERR_NOERROR;
+    }
+    STDMETHODIMP_(MMRESULT) Reset(void)
+    {
+        return MMSYSERR_NOERROR;
+    }
+    STDMETHODIMP_(MMRESULT) BreakLoop(void)
+    {
+        return MMSYSERR_NOERROR;
+    }
+    STDMETHODIMP_(MMRESULT) GetPosition(LPMMTIME lpmmt, UINT cbmmt);
+    STDMETHODIMP_(MMRESULT) GetPitch(LPDWORD lpdwPitch)
+    {
+        return MMSYSERR_NOTSUPPORTED;
+    }
+    STDMETHODIMP_(MMRESULT) SetPitch(DWORD dwPitch)
+    {
+        return MMSYSERR_NOTSUPPORTED;
+    }
+    STDMETHODIMP_(MMRESULT) GetPlaybackRate(LPDWORD lpdwRate)
+    {
+        return MMSYSERR_NOTSUPPORTED;
+    }
+    STDMETHODIMP_(MMRESULT) SetPlaybackRate(DWORD dwRate)
+    {
+        return MMSYSERR_NOTSUPPORTED;
+    }
+    STDMETHODIMP_(MMRESULT) GetID(UINT FAR *lpuDeviceID)
+    {
+        *lpuDeviceID = 0;
+        return MMSYSERR_NOERROR;
+    }
+    STDMETHODIMP_(MMRESULT) Message(UINT uMsg, DWORD dw1, DWORD dw2)
+    {
+        return MMSYSERR_NOTSUPPORTED;
+    }
+    STDMETHODIMP_(MMRESULT) GetErrorText(MMRESULT err, LPSTR lpText, UINT cchText);
+};
+
+/***************************************************************************
+    Mixer commands. Everything the client does to a channel becomes one of
+    these and is applied on the mixer thread.
+***************************************************************************/
+enum
+{
+    kcmdAddChan,
+    kcmdSetSrc,
+    kcmdPlay,
+    kcmdStop,
+    kcmdSetPos,
+    kcmdSetVol,
+    kcmdMute,
+    kcmdEnlist,
+    kcmdDefect,
+    kcmdStartGroup,
+    kcmdStopGroup,
+    kcmdFreeGroup,
+};
+
+class AMCHAN;
+
+struct AMCMD
+{
+    long cmd;
+    AMCHAN *pchan;
+    IAMSound *psnd; // for kcmdSetSrc
+    DWORD lu;
+};
+
+struct AMCELL
+{
+    volatile LONG lwSeq;
+    AMCMD cmd;
+};
+
+class AMMIX;
+
+/***************************************************************************
+    A mixer channel. Client calls post commands; the fields below the
+    voice comment are only touched on the mixer thread.
+***************************************************************************/
+class AMCHAN : public IAMChannel
+{
+    friend class AMMIX;
+
+  protected:
+    LONG _cactRef;
+    AMMIX *_pmix;
+
+    // client side
+    CRITICAL_SECTION _crit;    // protects _psndCli
+    CRITICAL_SECTION _critNot; // protects _pnot against the client leaving
+    IAMSound *_psndCli;        // what the client last set
+    LPNOTIFYSINK _pnot;
+    DWORD _grfnot;
+    volatile LONG _fPlayingPub; // published by the mixer thread
+    volatile LONG _ismpPub;     // published by the mixer thread
+    DWORD _luVolCli;
+    bool _fOneShot; // from PlaySound: no client, drop it when done
+
+    // voice state (mixer thread)
+    IAMSound *_psnd;
+    WAVEFORMATEX _wfx;
+    DWORD _csmp;
+    DWORD _ismp;    // next source frame
+    DWORD _luFrac;  // fraction of a source frame, 16.16
+    DWORD _luStep;  // source frames per output frame, 16.16
+    long _lwGainL;  // 16.16
+    long _lwGainR;  // 16.16
+    bool _fPlay;    // client wants it playing
+    bool _fMute;
+    bool _fEnded;   // source ran out and we've notified
+    DWORD _grfgrp;  // groups we're waiting on
+
+    // completion waiting to be delivered (mixer thread)
+    AMCHAN *_pchanNote; // next channel with a completion
+    IAMSound *_psndNote;
+    DWORD _ismpNote;
+
+    bool _FActive(void);
+    DWORD _LuRateCli(void);
+
+  public:
+    AMCHAN(AMMIX *pmix);
+    ~AMCHAN(void);
+
+    // IUnknown methods
+    STDMETHODIMP QueryInterface(REFIID riid, void **ppv);
+    STDMETHODIMP_(ULONG) AddRef(void);
+    STDMETHODIMP_(ULONG) Release(void);
+
+    // IAMChannel methods
+    STDMETHODIMP RegisterNotify(LPNOTIFYSINK pNotifySink, DWORD fdwNotifyFlags);
+    STDMETHODIMP SetSoundSrc(LPSOUND pSound);
+    STDMETHODIMP SetCachedSrc(LPSOUND pSound, LPCACHECONFIG pCacheConfig);
+    STDMETHODIMP GetSoundSrc(LPSOUND FAR *ppSound);
+    STDMETHODIMP Play(void);
+    STDMETHODIMP Stop(void);
+    STDMETHODIMP Finish(void);
+    STDMETHODIMP_(BOOL) IsPlaying(void);
+    STDMETHODIMP_(DWORD) Samples(void);
+    STDMETHODIMP SetPosition(DWORD dwSample);
+    STDMETHODIMP GetPosition(LPDWORD lpdwSample);
+    STDMETHODIMP Mute(BOOL fMute);
+    STDMETHODIMP SetVolume(DWORD dwVolume);
+    STDMETHODIMP GetVolume(LPDWORD lpdwVolume);
+    STDMETHODIMP SetGain(float flLeft, float flRight);
+    STDMETHODIMP GetGain(float FAR *lpflLeft, float FAR *lpflRight);
+    STDMETHODIMP GetSMPTEPos(LPSMPTE lpSMPTE);
+    STDMETHODIMP SetSMPTEPos(LPSMPTE lpSMPTE);
+    STDMETHODIMP GetTimePos(LPDWORD lpdwTime);
+    STDMETHODIMP SetTimePos(DWORD dwTime);
+};
+
+/***************************************************************************
+    The mixer.
+***************************************************************************/
+class AMMIX : public IAMMixer
+{
+    friend class AMCHAN;
+
+  protected:
+    LONG _cactRef;
+    bool _fInited;
+    bool _fActive;
+    bool _fSuspended;
+    bool _fOpen;
+    ADVMIXCONFIG _amxc;
+    WAVEFORMATEX _wfx;   // output format
+    IAMWaveOut *_pwvo;   // output sink
+    DWORD _luVol;        // master volume, as set by the client
+    volatile LONG _lwGain; // master gain, 16.16
+    DWORD _luAvgSample;    // mean magnitude of the last buffer
+    DWORD _grfgrpAlloc;  // allocated groups
+
+    // command queue: many producers, the mixer thread consumes
+    AMCELL _rgcell[kccmdQueue];
+    volatile LONG _icellEnq;
+    LONG _icellDeq;
+
+    // mixer thread
+    CRITICAL_SECTION _critMix; // held while draining commands and mixing
+    HANDLE _hth;
+    HANDLE _hevt;
+    volatile LONG _fQuit;
+    AMCHAN **_prgpchan; // channels known to the mixer thread
+    long _cpchan;
+    long _cpchanMax;
+    WAVEHDR _rgwh[kcbufMixMax];
+    long _cbuf;
+    long _iwhNext;
+    long _cfrmBuf;
+    long *_prglAcc;
+    SW *_prgswScratch;
+    BT *_prgbScratch;
+
+    static AMMIX *_pmixShared;
+
+    AMMIX(void);
+    ~AMMIX(void);
+
+    bool _FEnqueue(AMCMD *pcmd);
+    bool _FDequeue(AMCMD *pcmd);
+    void _Post(long cmd, AMCHAN *pchan, IAMSound *psnd, DWORD lu);
+    void _DrainCommands(void);
+    void _Apply(AMCMD *pcmd);
+    void _SetSrc(AMCHAN *pchan, IAMSound *psnd);
+    void _SetStep(AMCHAN *pchan);
+
+    HRESULT _HrAllocBuffers(void);
+    void _FreeBuffers(void);
+    HRESULT _HrUpdate(void);
+    HRESULT _HrOpen(void);
+    void _Close(void);
+    void _Run(void);
+    static DWORD WINAPI _LuThread(LPVOID pv);
+    void _MixBuffer(BT *pb);
+    bool _FMixVoice(AMCHAN *pchan);
+
+  public:
+    static AMMIX *PmixGet(void);
+
+    // IUnknown methods
+    STDMETHODIMP QueryInterface(REFIID riid, void **ppv);
+    STDMETHODIMP_(ULONG) AddRef(void);
+    STDMETHODIMP_(ULONG) Release(void);
+
+    // IAMMixer methods
+    STDMETHODIMP TestConfig(LPWAVEOUT pWaveOut, LPMIXERCONFIG pMixerConfig, LPADVMIXCONFIG pAdvMixConfig,
+                            BOOL fRecommend);
+    STDMETHODIMP Init(HINSTANCE hInst, LPWAVEOUT pWaveOut, LPMIXERCONFIG pMixerConfig,
+                      LPADVMIXCONFIG pAdvMixConfig);
+    STDMETHODIMP Uninit(void);
+    STDMETHODIMP Activate(BOOL fActive);
+    STDMETHODIMP Suspend(BOOL fSuspend);
+    STDMETHODIMP SetConfig(LPMIXERCONFIG pMixerConfig, LPADVMIXCONFIG pAdvMixConfig);
+    STDMETHODIMP GetConfig(LPMIXERCONFIG pMixerConfig, LPADVMIXCONFIG pAdvMixConfig);
+    STDMETHODIMP SetMixerVolume(DWORD dwVolume);
+    STDMETHODIMP GetMixerVolume(LPDWORD lpdwVolume);
+    STDMETHODIMP PlaySound(LPSOUND pSound);
+    STDMETHODIMP_(BOOL) RemixMode(BOOL fActive);
+    STDMETHODIMP_(DWORD) GetAvgSample(void);
+    STDMETHODIMP AllocGroup(LPDWORD lpdwGroup);
+    STDMETHODIMP FreeGroup(DWORD dwGroup);
+    STDMETHODIMP EnlistGroup(IUnknown FAR *pChannel, DWORD dwGroup);
+    STDMETHODIMP DefectGroup(LPUNKNOWN pUnknown, DWORD dwGroup);
+    STDMETHODIMP StartGroup(DWORD dwGroup, BOOL fStart);
+    STDMETHODIMP ResetGroup(DWORD dwGroup);
+    STDMETHODIMP SetGroupVolume(DWORD dwGroup, DWORD dwVolume);
+    STDMETHODIMP SetGroupGain(DWORD dwGroup, float flDBLeft, float flDBRight, BOOL fAbsolute);
+    STDMETHODIMP SetGroupPosition(DWORD dwGroup, DWORD dwPosition);
+    STDMETHODIMP AllocChannel(LPCHANNEL FAR *ppChannel);
+    STDMETHODIMP RegisterChannel(LPUNKNOWN pUnknown);
+    STDMETHODIMP UnregisterChannel(LPUNKNOWN pUnknown);
+    STDMETHODIMP SetPriority(LPUNKNOWN pUnknown, DWORD dwPriority);
+    STDMETHODIMP GetPriority(LPUNKNOWN pUnknown, LPDWORD lpdwPriority);
+    STDMETHODIMP_(void) Refresh(void);
+};
+
+#endif //! AMPRIV_H
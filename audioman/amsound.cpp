@@ -0,0 +1,1132 @@
+/***************************************************************************
+    AudioMan sounds: the wave source, the ADPCM decoders and the filters.
+
+***************************************************************************/
+#include "ampriv.h"
+
+/***************************************************************************
+    Format helpers.
+***************************************************************************/
+void AmSetPcmFormat(WAVEFORMATEX *pwfx, DWORD luRate, WORD cch, WORD cbit)
+{
+    pwfx->wFormatTag = WAVE_FORMAT_PCM;
+    pwfx->nChannels = cch;
+    pwfx->nSamplesPerSec = luRate;
+    pwfx->wBitsPerSample = cbit;
+    pwfx->nBlockAlign = (WORD)(cch * cbit / 8);
+    pwfx->nAvgBytesPerSec = luRate * pwfx->nBlockAlign;
+    pwfx->cbSize = 0;
+}
+
+static struct
+{
+    DWORD grfwf;
+    DWORD luRate;
+    WORD cch;
+    WORD cbit;
+} _rgwff[] = {
+    {WAVE_FORMAT_1M08, 11025, 1, 8},  {WAVE_FORMAT_1S08, 11025, 2, 8},  {WAVE_FORMAT_1M16, 11025, 1, 16},
+    {WAVE_FORMAT_1S16, 11025, 2, 16}, {WAVE_FORMAT_2M08, 22050, 1, 8},  {WAVE_FORMAT_2S08, 22050, 2, 8},
+    {WAVE_FORMAT_2M16, 22050, 1, 16}, {WAVE_FORMAT_2S16, 22050, 2, 16}, {WAVE_FORMAT_4M08, 44100, 1, 8},
+    {WAVE_FORMAT_4S08, 44100, 2, 8},  {WAVE_FORMAT_4M16, 44100, 1, 16}, {WAVE_FORMAT_4S16, 44100, 2, 16},
+};
+
+bool AmFFormatFromFlag(DWORD grfwf, WAVEFORMATEX *pwfx)
+{
+    long iwff;
+
+    for (iwff = 0; iwff < sizeof(_rgwff) / sizeof(_rgwff[0]); iwff++)
+    {
+        if (_rgwff[iwff].grfwf == grfwf)
+        {
+            AmSetPcmFormat(pwfx, _rgwff[iwff].luRate, _rgwff[iwff].cch, _rgwff[iwff].cbit);
+            return true;
+        }
+    }
+    return false;
+}
+
+/***************************************************************************
+    Returns whether pwfx is a PCM format we can mix.
+***************************************************************************/
+bool AmFMixable(const WAVEFORMATEX *pwfx)
+{
+    return pwfx->wFormatTag == WAVE_FORMAT_PCM && (pwfx->wBitsPerSample == 8 || pwfx->wBitsPerSample == 16) &&
+           pwfx->nChannels >= 1 && pwfx->nChannels <= kcchMax && pwfx->nSamplesPerSec > 0;
+}
+
+void AmConvertToSw(const BT *pb, const WAVEFORMATEX *pwfx, long cfrm, SW *psw, long cchDst)
+{
+    long cchSrc = pwfx->nChannels;
+    long ifrm;
+    long lw;
+
+    if (pwfx->wBitsPerSample == 16)
+    {
+        const SW *pswSrc = (const SW *)pb;
+
+        if (cchSrc == cchDst)
+            CopyMemory(psw, pswSrc, cfrm * cchSrc * sizeof(SW));
+        else if (cchDst == 1)
+        {
+            for (ifrm = 0; ifrm < cfrm; ifrm++, pswSrc += 2)
+                *psw++ = (SW)(((long)pswSrc[0] + pswSrc[1]) >> 1);
+        }
+        else
+        {
+            for (ifrm = 0; ifrm < cfrm; ifrm++)
+            {
+                psw[0] = psw[1] = *pswSrc++;
+                psw += 2;
+            }
+        }
+        return;
+    }
+
+    if (cchSrc == cchDst)
+    {
+        for (ifrm = cfrm * cchSrc; ifrm > 0; ifrm--)
+            *psw++ = (SW)(((long)*pb++ - 128) * 256);
+    }
+    else if (cchDst == 1)
+    {
+        for (ifrm = 0; ifrm < cfrm; ifrm++, pb += 2)
+            *psw++ = (SW)(((long)pb[0] + pb[1] - 256) * 128);
+    }
+    else
+    {
+        for (ifrm = 0; ifrm < cfrm; ifrm++)
+        {
+            lw = ((long)*pb++ - 128) * 256;
+            psw[0] = psw[1] = (SW)lw;
+            psw += 2;
+        }
+    }
+}
+
+void AmConvertFromSw(const SW *psw, long cfrm, long cchSrc, BT *pb, const WAVEFORMATEX *pwfx)
+{
+    long cchDst = pwfx->nChannels;
+    long csw = cfrm * cchDst;
+    long isw;
+    long lw;
+
+    for (isw = 0; isw < csw; isw++)
+    {
+        if (cchSrc == cchDst)
+            lw = psw[isw];
+        else if (cchDst == 1)
+            lw = ((long)psw[2 * isw] + psw[2 * isw + 1]) >> 1;
+        else
+            lw = psw[isw >> 1];
+
+        if (pwfx->wBitsPerSample == 16)
+            ((SW *)pb)[isw] = (SW)lw;
+        else
+            pb[isw] = (BT)((lw >> 8) + 128);
+    }
+}
+
+void AmResample(const SW *pswSrc, long cch, DWORD luFrac, DWORD luStep, SW *pswDst, long cfrm)
+{
+    const SW *psw;
+    long lwFrac;
+
+    // 15 bits of fraction keeps the products in a long
+    for (; cfrm > 0; cfrm--)
+    {
+        psw = pswSrc + (luFrac >> 16) * cch;
+        lwFrac = (luFrac & 0xFFFF) >> 1;
+        *pswDst++ = (SW)(psw[0] + (((psw[cch] - psw[0]) * lwFrac) >> 15));
+        if (cch == 2)
+            *pswDst++ = (SW)(psw[1] + (((psw[3] - psw[1]) * lwFrac) >> 15));
+        luFrac += luStep;
+    }
+}
+
+/***************************************************************************
+    Sound base class.
+***************************************************************************/
+AMSND::AMSND(void)
+{
+    _cactRef = 1;
+    ZeroMemory(&_wfx, sizeof(_wfx));
+    _csmp = 0;
+}
+
+AMSND::~AMSND(void)
+{
+}
+
+STDMETHODIMP AMSND::QueryInterface(REFIID riid, void **ppv)
+{
+    if (IsEqualIID(riid, IID_IUnknown) || IsEqualIID(riid, IID_IAMSound))
+    {
+        *ppv = (IAMSound *)this;
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = NULL;
+    return E_NOINTERFACE;
+}
+
+STDMETHODIMP_(ULONG) AMSND::AddRef(void)
+{
+    return InterlockedIncrement(&_cactRef);
+}
+
+STDMETHODIMP_(ULONG) AMSND::Release(void)
+{
+    LONG cactRef;
+
+    if ((cactRef = InterlockedDecrement(&_cactRef)) == 0)
+        delete this;
+    return cactRef;
+}
+
+STDMETHODIMP AMSND::GetFormat(LPWAVEFORMATEX pFormat, DWORD cbSize)
+{
+    if (NULL == pFormat)
+        return E_POINTER;
+
+    CopyMemory(pFormat, &_wfx, min(cbSize, sizeof(_wfx)));
+    return S_OK;
+}
+
+STDMETHODIMP AMSND::GetAlignment(LPDWORD lpdwLeftAlign, LPDWORD lpdwRightAlign)
+{
+    if (NULL != lpdwLeftAlign)
+        *lpdwLeftAlign = 1;
+    if (NULL != lpdwRightAlign)
+        *lpdwRightAlign = 1;
+    return S_OK;
+}
+
+/***************************************************************************
+    MS ADPCM tables.
+***************************************************************************/
+static const long _rglwAdaptMs[16] = {230, 230, 230, 230, 307, 409, 512, 614, 768, 614, 512, 409, 307, 230, 230, 230};
+static const SW _rgswCoefMs[2 * 7] = {256, 0, 512, -256, 0, 0, 192, 64, 240, 0, 460, -208, 392, -232};
+
+/***************************************************************************
+    IMA ADPCM tables.
+***************************************************************************/
+static const long _rglwIndexIma[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+static const long _rglwStepIma[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,
+    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,   337,   371,   408,   449,   494,
+    544,   598,   658,   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,
+    9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+static inline SW _SwClip(long lw)
+{
+    return (SW)(lw < -32768 ? -32768 : lw > 32767 ? 32767 : lw);
+}
+
+static inline SW _SwGet(const BT *pb)
+{
+    return (SW)(pb[0] | (pb[1] << 8));
+}
+
+/***************************************************************************
+    Wave source.
+***************************************************************************/
+AMWAV::AMWAV(void)
+{
+    InitializeCriticalSection(&_crit);
+    _pstm = NULL;
+    _hfile = INVALID_HANDLE_VALUE;
+    _pbData = NULL;
+    _ibData = _cbData = 0;
+    _wtag = WAVE_FORMAT_PCM;
+    _cbBlock = 0;
+    _csmpBlock = 0;
+    _ccoef = 0;
+    _pbBlock = NULL;
+    _pswBlock = NULL;
+    _iblkCache = -1;
+    _csmpCache = 0;
+}
+
+AMWAV::~AMWAV(void)
+{
+    if (NULL != _pstm)
+        _pstm->Release();
+    if (INVALID_HANDLE_VALUE != _hfile)
+        CloseHandle(_hfile);
+    delete[] _pbData;
+    delete[] _pbBlock;
+    delete[] _pswBlock;
+    DeleteCriticalSection(&_crit);
+}
+
+/***************************************************************************
+    Create a wave source reading from a stream. If fSpooled is false, the
+    whole stream is read in now.
+***************************************************************************/
+HRESULT AMWAV::HrNewStream(AMWAV **ppwav, IStream *pstm, BOOL fSpooled)
+{
+    AMWAV *pwav;
+    LARGE_INTEGER dlib;
+    ULARGE_INTEGER libBase, libLim;
+    ULONG cbRead;
+    DWORD cbFile;
+    HRESULT hr;
+
+    *ppwav = NULL;
+    if (NULL == pstm)
+        return E_POINTER;
+
+    dlib.QuadPart = 0;
+    if (FAILED(hr = pstm->Seek(dlib, STREAM_SEEK_CUR, &libBase)) ||
+        FAILED(hr = pstm->Seek(dlib, STREAM_SEEK_END, &libLim)))
+    {
+        return hr;
+    }
+    if (libLim.QuadPart < libBase.QuadPart || libLim.QuadPart - libBase.QuadPart > 0x7FFFFFFF)
+        return E_FAIL;
+    cbFile = (DWORD)(libLim.QuadPart - libBase.QuadPart);
+
+    if (NULL == (pwav = new AMWAV))
+        return E_OUTOFMEMORY;
+
+    if (fSpooled)
+    {
+        pwav->_pstm = pstm;
+        pstm->AddRef();
+        hr = pwav->_HrParse(libBase.LowPart, cbFile);
+    }
+    else if (NULL == (pwav->_pbData = new BT[cbFile + 1]))
+        hr = E_OUTOFMEMORY;
+    else
+    {
+        dlib.QuadPart = libBase.QuadPart;
+        if (SUCCEEDED(hr = pstm->Seek(dlib, STREAM_SEEK_SET, NULL)) &&
+            SUCCEEDED(hr = pstm->Read(pwav->_pbData, cbFile, &cbRead)))
+        {
+            hr = cbRead == cbFile ? pwav->_HrParse(0, cbFile) : E_FAIL;
+        }
+    }
+
+    if (FAILED(hr))
+    {
+        pwav->Release();
+        return hr;
+    }
+    *ppwav = pwav;
+    return S_OK;
+}
+
+/***************************************************************************
+    Create a wave source reading from a file, starting at ibOffset.
+***************************************************************************/
+HRESULT AMWAV::HrNewFile(AMWAV **ppwav, char *pszFile, DWORD ibOffset, BOOL fSpooled)
+{
+    AMWAV *pwav;
+    HANDLE hfile;
+    DWORD cbFile;
+    DWORD cbRead;
+    HRESULT hr;
+
+    *ppwav = NULL;
+    hfile = CreateFileA(pszFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (INVALID_HANDLE_VALUE == hfile)
+        return E_FAIL;
+
+    cbFile = GetFileSize(hfile, NULL);
+    if (INVALID_FILE_SIZE == cbFile || cbFile < ibOffset)
+    {
+        CloseHandle(hfile);
+        return E_FAIL;
+    }
+    cbFile -= ibOffset;
+
+    if (NULL == (pwav = new AMWAV))
+    {
+        CloseHandle(hfile);
+        return E_OUTOFMEMORY;
+    }
+
+    if (fSpooled)
+    {
+        pwav->_hfile = hfile;
+        hr = pwav->_HrParse(ibOffset, cbFile);
+    }
+    else
+    {
+        if (NULL == (pwav->_pbData = new BT[cbFile + 1]))
+            hr = E_OUTOFMEMORY;
+        else if (INVALID_SET_FILE_POINTER == SetFilePointer(hfile, ibOffset, NULL, FILE_BEGIN) ||
+                 !ReadFile(hfile, pwav->_pbData, cbFile, &cbRead, NULL) || cbRead != cbFile)
+        {
+            hr = E_FAIL;
+        }
+        else
+            hr = pwav->_HrParse(0, cbFile);
+        CloseHandle(hfile);
+    }
+
+    if (FAILED(hr))
+    {
+        pwav->Release();
+        return hr;
+    }
+    *ppwav = pwav;
+    return S_OK;
+}
+
+/***************************************************************************
+    Create a wave source from a wave file image in memory. The image is
+    copied, so the caller may free it.
+***************************************************************************/
+HRESULT AMWAV::HrNewMemory(AMWAV **ppwav, BT *pb, DWORD cb)
+{
+    AMWAV *pwav;
+    HRESULT hr;
+
+    *ppwav = NULL;
+    if (NULL == pb)
+        return E_POINTER;
+    if (NULL == (pwav = new AMWAV))
+        return E_OUTOFMEMORY;
+
+    if (NULL == (pwav->_pbData = new BT[cb + 1]))
+        hr = E_OUTOFMEMORY;
+    else
+    {
+        CopyMemory(pwav->_pbData, pb, cb);
+        hr = pwav->_HrParse(0, cb);
+    }
+
+    if (FAILED(hr))
+    {
+        pwav->Release();
+        return hr;
+    }
+    *ppwav = pwav;
+    return S_OK;
+}
+
+/***************************************************************************
+    Read cb bytes at absolute offset ib of the stream, file or memory.
+***************************************************************************/
+bool AMWAV::_FRead(DWORD ib, void *pv, DWORD cb)
+{
+    bool fRet = false;
+    LARGE_INTEGER dlib;
+    ULONG cbRead;
+
+    if (NULL != _pbData)
+    {
+        CopyMemory(pv, _pbData + ib, cb);
+        return true;
+    }
+
+    EnterCriticalSection(&_crit);
+    if (NULL != _pstm)
+    {
+        dlib.QuadPart = ib;
+        fRet = SUCCEEDED(_pstm->Seek(dlib, STREAM_SEEK_SET, NULL)) && SUCCEEDED(_pstm->Read(pv, cb, &cbRead)) &&
+               cbRead == cb;
+    }
+    else if (INVALID_HANDLE_VALUE != _hfile)
+    {
+        fRet = INVALID_SET_FILE_POINTER != SetFilePointer(_hfile, ib, NULL, FILE_BEGIN) &&
+               ReadFile(_hfile, pv, cb, &cbRead, NULL) && cbRead == cb;
+    }
+    LeaveCriticalSection(&_crit);
+    return fRet;
+}
+
+/***************************************************************************
+    Find the fmt and data chunks of the RIFF WAVE at ibBase and set up for
+    decoding.
+***************************************************************************/
+HRESULT AMWAV::_HrParse(DWORD ibBase, DWORD cbFile)
+{
+    DWORD rglu[3];
+    DWORD ib, ibLim, cb;
+    BT rgbFmt[sizeof(WAVEFORMATEX) + 4 + 4 * 256];
+    DWORD cbFmt = 0;
+    bool fData = false;
+    WAVEFORMATEX wfx;
+    long cch;
+    long icoef;
+    DWORD cblkFull, cbLast, csmpLast;
+
+    if (cbFile < 12 || !_FRead(ibBase, rglu, 12) || rglu[0] != mmioFOURCC('R', 'I', 'F', 'F') ||
+        rglu[2] != mmioFOURCC('W', 'A', 'V', 'E'))
+    {
+        return E_FAIL;
+    }
+
+    ib = ibBase + 12;
+    ibLim = ibBase + min(cbFile, rglu[1] + 8);
+    while (ib + 8 <= ibLim)
+    {
+        if (!_FRead(ib, rglu, 8))
+            return E_FAIL;
+        cb = min(rglu[1], ibLim - ib - 8);
+
+        if (rglu[0] == mmioFOURCC('f', 'm', 't', ' '))
+        {
+            cbFmt = min(cb, sizeof(rgbFmt));
+            if (!_FRead(ib + 8, rgbFmt, cbFmt))
+                return E_FAIL;
+        }
+        else if (rglu[0] == mmioFOURCC('d', 'a', 't', 'a'))
+        {
+            _ibData = ib + 8;
+            _cbData = cb;
+            fData = true;
+        }
+        ib += 8 + ((cb + 1) & ~1);
+    }
+    if (cbFmt < sizeof(PCMWAVEFORMAT) || !fData)
+        return E_FAIL;
+
+    ZeroMemory(&wfx, sizeof(wfx));
+    CopyMemory(&wfx, rgbFmt, min(cbFmt, sizeof(wfx)));
+    cch = wfx.nChannels;
+    if (cch < 1 || cch > kcchMax || wfx.nSamplesPerSec == 0)
+        return E_BADPCMFORMAT;
+
+    _wtag = wfx.wFormatTag;
+    switch (_wtag)
+    {
+    case WAVE_FORMAT_PCM:
+        wfx.cbSize = 0;
+        if (!AmFMixable(&wfx) || wfx.nBlockAlign != cch * wfx.wBitsPerSample / 8)
+            return E_BADPCMFORMAT;
+        _wfx = wfx;
+        _csmp = _cbData / wfx.nBlockAlign;
+        return S_OK;
+
+    case WAVE_FORMAT_ADPCM:
+        _cbBlock = wfx.nBlockAlign;
+        if (_cbBlock <= 7 * cch)
+            return E_BADPCMFORMAT;
+        _csmpBlock = (_cbBlock - 7 * cch) * 2 / cch + 2;
+
+        // the coefficient table follows the samples per block count
+        _ccoef = 0;
+        if (cbFmt >= sizeof(WAVEFORMATEX) + 4)
+        {
+            _ccoef = _SwGet(rgbFmt + sizeof(WAVEFORMATEX) + 2);
+            if (_ccoef > 256 || cbFmt < sizeof(WAVEFORMATEX) + 4 + 4 * (DWORD)_ccoef)
+                _ccoef = 0;
+        }
+        if (_ccoef <= 0)
+        {
+            _ccoef = 7;
+            CopyMemory(_rgswCoef, _rgswCoefMs, sizeof(_rgswCoefMs));
+        }
+        else
+        {
+            for (icoef = 0; icoef < 2 * _ccoef; icoef++)
+                _rgswCoef[icoef] = _SwGet(rgbFmt + sizeof(WAVEFORMATEX) + 4 + 2 * icoef);
+        }
+        cbLast = _cbData % _cbBlock;
+        csmpLast = cbLast > 7 * (DWORD)cch ? (cbLast - 7 * cch) * 2 / cch + 2 : 0;
+        break;
+
+    case WAVE_FORMAT_IMA_ADPCM:
+        _cbBlock = wfx.nBlockAlign;
+        if (_cbBlock <= 4 * cch || (_cbBlock - 4 * cch) % (4 * cch) != 0)
+            return E_BADPCMFORMAT;
+        _csmpBlock = (_cbBlock - 4 * cch) * 2 / cch + 1;
+        cbLast = _cbData % _cbBlock;
+        csmpLast = cbLast >= 4 * (DWORD)cch ? (cbLast - 4 * cch) / (4 * cch) * 8 + 1 : 0;
+        break;
+
+    default:
+        return E_BADPCMFORMAT;
+    }
+
+    cblkFull = _cbData / _cbBlock;
+    _csmp = cblkFull * _csmpBlock + csmpLast;
+    if (NULL == (_pbBlock = new BT[_cbBlock]) || NULL == (_pswBlock = new SW[_csmpBlock * cch]))
+        return E_OUTOFMEMORY;
+
+    AmSetPcmFormat(&_wfx, wfx.nSamplesPerSec, (WORD)cch, 16);
+    return S_OK;
+}
+
+/***************************************************************************
+    Decode an MS ADPCM block into _pswBlock. Returns the number of frames.
+***************************************************************************/
+long AMWAV::_CsmpDecodeMs(const BT *pb, long cb)
+{
+    long cch = _wfx.nChannels;
+    long ich, inib;
+    long rgicoef[kcchMax], rglwDelta[kcchMax], rglwS1[kcchMax], rglwS2[kcchMax];
+    long lw, nib;
+    SW *psw = _pswBlock;
+    SW *pswLim = _pswBlock + _csmpBlock * cch;
+
+    if (cb < 7 * cch)
+        return 0;
+
+    for (ich = 0; ich < cch; ich++)
+        rgicoef[ich] = min((long)pb[ich], _ccoef - 1);
+    pb += cch;
+    for (ich = 0; ich < cch; ich++, pb += 2)
+        rglwDelta[ich] = _SwGet(pb);
+    for (ich = 0; ich < cch; ich++, pb += 2)
+        rglwS1[ich] = _SwGet(pb);
+    for (ich = 0; ich < cch; ich++, pb += 2)
+        rglwS2[ich] = _SwGet(pb);
+    cb -= 7 * cch;
+
+    // the header samples come out oldest first
+    for (ich = 0; ich < cch; ich++)
+        *psw++ = (SW)rglwS2[ich];
+    for (ich = 0; ich < cch; ich++)
+        *psw++ = (SW)rglwS1[ich];
+
+    // high nibble first; in stereo the high nibble is the left channel
+    ich = 0;
+    for (; cb > 0 && psw < pswLim; cb--, pb++)
+    {
+        for (inib = 0; inib < 2; inib++)
+        {
+            nib = inib == 0 ? *pb >> 4 : *pb & 0x0F;
+            lw = (rglwS1[ich] * _rgswCoef[2 * rgicoef[ich]] + rglwS2[ich] * _rgswCoef[2 * rgicoef[ich] + 1]) / 256;
+            lw += (nib >= 8 ? nib - 16 : nib) * rglwDelta[ich];
+            *psw++ = _SwClip(lw);
+            rglwS2[ich] = rglwS1[ich];
+            rglwS1[ich] = psw[-1];
+            rglwDelta[ich] = (_rglwAdaptMs[nib] * rglwDelta[ich]) / 256;
+            if (rglwDelta[ich] < 16)
+                rglwDelta[ich] = 16;
+            if (++ich == cch)
+                ich = 0;
+        }
+    }
+
+    return (long)(psw - _pswBlock) / cch;
+}
+
+/***************************************************************************
+    Decode an IMA ADPCM block into _pswBlock. Returns the number of frames.
+***************************************************************************/
+long AMWAV::_CsmpDecodeIma(const BT *pb, long cb)
+{
+    long cch = _wfx.nChannels;
+    long ich, ib, inib, ifrm;
+    long rglwPred[kcchMax], rgistep[kcchMax];
+    long lwStep, lwDiff, nib;
+    long cgrp, igrp;
+
+    if (cb < 4 * cch)
+        return 0;
+
+    for (ich = 0; ich < cch; ich++, pb += 4)
+    {
+        rglwPred[ich] = _SwGet(pb);
+        rgistep[ich] = min((long)pb[2], 88);
+        _pswBlock[ich] = (SW)rglwPred[ich];
+    }
+    cb -= 4 * cch;
+
+    // each channel contributes 4 bytes (8 samples, low nibble first) per group
+    cgrp = cb / (4 * cch);
+    for (igrp = 0; igrp < cgrp; igrp++)
+    {
+        for (ich = 0; ich < cch; ich++)
+        {
+            for (ib = 0; ib < 4; ib++, pb++)
+            {
+                for (inib = 0; inib < 2; inib++)
+                {
+                    nib = inib == 0 ? *pb & 0x0F : *pb >> 4;
+                    lwStep = _rglwStepIma[rgistep[ich]];
+                    lwDiff = lwStep >> 3;
+                    if (nib & 4)
+                        lwDiff += lwStep;
+                    if (nib & 2)
+                        lwDiff += lwStep >> 1;
+                    if (nib & 1)
+                        lwDiff += lwStep >> 2;
+                    rglwPred[ich] = _SwClip(nib & 8 ? rglwPred[ich] - lwDiff : rglwPred[ich] + lwDiff);
+                    rgistep[ich] += _rglwIndexIma[nib];
+                    rgistep[ich] = rgistep[ich] < 0 ? 0 : rgistep[ich] > 88 ? 88 : rgistep[ich];
+
+                    ifrm = 1 + igrp * 8 + ib * 2 + inib;
+                    _pswBlock[ifrm * cch + ich] = (SW)rglwPred[ich];
+                }
+            }
+        }
+    }
+
+    return 1 + cgrp * 8;
+}
+
+/***************************************************************************
+    Make sure _pswBlock holds the decoded block iblk.
+***************************************************************************/
+bool AMWAV::_FDecodeBlock(long iblk)
+{
+    DWORD ib, cb;
+
+    if (iblk == _iblkCache)
+        return true;
+
+    _iblkCache = -1;
+    ib = iblk * _cbBlock;
+    if (ib >= _cbData)
+        return false;
+    cb = min((DWORD)_cbBlock, _cbData - ib);
+    if (!_FRead(_ibData + ib, _pbBlock, cb))
+        return false;
+
+    if (_wtag == WAVE_FORMAT_ADPCM)
+        _csmpCache = _CsmpDecodeMs(_pbBlock, cb);
+    else
+        _csmpCache = _CsmpDecodeIma(_pbBlock, cb);
+    _iblkCache = iblk;
+    return _csmpCache > 0;
+}
+
+STDMETHODIMP AMWAV::GetSampleData(LPBYTE lpBuffer, DWORD dwPosition, LPDWORD lpdwSamples,
+                                  LPREQUESTPARAM lpRequestParams)
+{
+    DWORD csmpWant = *lpdwSamples;
+    DWORD csmpDone = 0;
+    DWORD csmp, ismp;
+    long iblk;
+    long cbFrm = _wfx.nBlockAlign;
+
+    if (dwPosition >= _csmp)
+    {
+        *lpdwSamples = 0;
+        return S_ENDOFSOUND;
+    }
+    csmpWant = min(csmpWant, _csmp - dwPosition);
+
+    if (_wtag == WAVE_FORMAT_PCM)
+    {
+        if (!_FRead(_ibData + dwPosition * cbFrm, lpBuffer, csmpWant * cbFrm))
+        {
+            *lpdwSamples = 0;
+            return E_FAIL;
+        }
+        csmpDone = csmpWant;
+    }
+    else
+    {
+        EnterCriticalSection(&_crit);
+        while (csmpDone < csmpWant)
+        {
+            iblk = (dwPosition + csmpDone) / _csmpBlock;
+            ismp = (dwPosition + csmpDone) % _csmpBlock;
+            if (!_FDecodeBlock(iblk) || ismp >= (DWORD)_csmpCache)
+                break;
+            csmp = min(csmpWant - csmpDone, _csmpCache - ismp);
+            CopyMemory(lpBuffer + csmpDone * cbFrm, _pswBlock + ismp * _wfx.nChannels, csmp * cbFrm);
+            csmpDone += csmp;
+        }
+        LeaveCriticalSection(&_crit);
+    }
+
+    *lpdwSamples = csmpDone;
+    return csmpDone < csmpWant || dwPosition + csmpDone >= _csmp ? S_ENDOFSOUND : S_OK;
+}
+
+/***************************************************************************
+    Filter base class.
+***************************************************************************/
+AMFLT::AMFLT(void)
+{
+    _psndSrc = NULL;
+    ZeroMemory(&_wfxSrc, sizeof(_wfxSrc));
+}
+
+AMFLT::~AMFLT(void)
+{
+    if (NULL != _psndSrc)
+        _psndSrc->Release();
+}
+
+/***************************************************************************
+    Attach the source. By default the filter has the source's format and
+    length.
+***************************************************************************/
+HRESULT AMFLT::_HrSetSrc(IAMSound *psndSrc)
+{
+    HRESULT hr;
+
+    if (NULL == psndSrc)
+        return E_POINTER;
+
+    _psndSrc = psndSrc;
+    _psndSrc->AddRef();
+    if (FAILED(hr = _psndSrc->GetFormat(&_wfxSrc, sizeof(_wfxSrc))))
+        return hr;
+    if (!AmFMixable(&_wfxSrc))
+        return E_BADPCMFORMAT;
+
+    _wfx = _wfxSrc;
+    _csmp = _psndSrc->GetSamples();
+    return S_OK;
+}
+
+/***************************************************************************
+    Run the whole source through pfn as 16 bit samples.
+***************************************************************************/
+HRESULT AMFLT::_HrScan(void (*pfn)(void *pvCtx, const SW *psw, long cfrm, DWORD ifrm), void *pvCtx)
+{
+    BT *pb;
+    SW *psw;
+    DWORD csmpSrc = _psndSrc->GetSamples();
+    DWORD ifrm, cfrm;
+    long cch = _wfxSrc.nChannels;
+    HRESULT hr = S_OK;
+
+    pb = new BT[kcfrmScratch * _wfxSrc.nBlockAlign];
+    psw = new SW[kcfrmScratch * cch];
+    if (NULL == pb || NULL == psw)
+        hr = E_OUTOFMEMORY;
+
+    for (ifrm = 0; SUCCEEDED(hr) && ifrm < csmpSrc; ifrm += cfrm)
+    {
+        cfrm = min((DWORD)kcfrmScratch, csmpSrc - ifrm);
+        if (FAILED(hr = _psndSrc->GetSampleData(pb, ifrm, &cfrm, NULL)) || cfrm == 0)
+            break;
+        AmConvertToSw(pb, &_wfxSrc, cfrm, psw, cch);
+        pfn(pvCtx, psw, cfrm, ifrm);
+    }
+
+    delete[] pb;
+    delete[] psw;
+    return FAILED(hr) ? hr : S_OK;
+}
+
+/***************************************************************************
+    Trim filter.
+***************************************************************************/
+struct TRIMS
+{
+    long cch;
+    DWORD ifrmFirst;
+    DWORD ifrmLast;
+    bool fFound;
+};
+
+static void _ScanTrim(void *pvCtx, const SW *psw, long cfrm, DWORD ifrm)
+{
+    TRIMS *ptrims = (TRIMS *)pvCtx;
+    long isw, csw = cfrm * ptrims->cch;
+
+    for (isw = 0; isw < csw; isw++)
+    {
+        if (psw[isw] > kswTrimSilence || psw[isw] < -kswTrimSilence)
+        {
+            if (!ptrims->fFound)
+            {
+                ptrims->ifrmFirst = ifrm + isw / ptrims->cch;
+                ptrims->fFound = true;
+            }
+            ptrims->ifrmLast = ifrm + isw / ptrims->cch;
+        }
+    }
+}
+
+HRESULT AMTRIM::HrNew(AMTRIM **pptrim, IAMSound *psndSrc)
+{
+    AMTRIM *ptrim;
+    TRIMS trims;
+    HRESULT hr;
+
+    *pptrim = NULL;
+    if (NULL == (ptrim = new AMTRIM))
+        return E_OUTOFMEMORY;
+
+    if (SUCCEEDED(hr = ptrim->_HrSetSrc(psndSrc)))
+    {
+        trims.cch = ptrim->_wfxSrc.nChannels;
+        trims.fFound = false;
+        trims.ifrmFirst = trims.ifrmLast = 0;
+        hr = ptrim->_HrScan(_ScanTrim, &trims);
+        ptrim->_ismpFirst = trims.ifrmFirst;
+        ptrim->_csmp = trims.fFound ? trims.ifrmLast - trims.ifrmFirst + 1 : 0;
+    }
+
+    if (FAILED(hr))
+    {
+        ptrim->Release();
+        return hr;
+    }
+    *pptrim = ptrim;
+    return S_OK;
+}
+
+STDMETHODIMP AMTRIM::GetSampleData(LPBYTE lpBuffer, DWORD dwPosition, LPDWORD lpdwSamples,
+                                   LPREQUESTPARAM lpRequestParams)
+{
+    DWORD csmpWant = *lpdwSamples;
+    HRESULT hr;
+
+    if (dwPosition >= _csmp)
+    {
+        *lpdwSamples = 0;
+        return S_ENDOFSOUND;
+    }
+
+    *lpdwSamples = min(csmpWant, _csmp - dwPosition);
+    hr = _psndSrc->GetSampleData(lpBuffer, dwPosition + _ismpFirst, lpdwSamples, lpRequestParams);
+    if (SUCCEEDED(hr))
+        hr = *lpdwSamples < csmpWant || dwPosition + *lpdwSamples >= _csmp ? S_ENDOFSOUND : S_OK;
+    return hr;
+}
+
+/***************************************************************************
+    Bias filter.
+***************************************************************************/
+struct BIASS
+{
+    long cch;
+    LONGLONG rglwSum[kcchMax];
+};
+
+static void _ScanBias(void *pvCtx, const SW *psw, long cfrm, DWORD ifrm)
+{
+    BIASS *pbiass = (BIASS *)pvCtx;
+    long isw, csw = cfrm * pbiass->cch;
+
+    for (isw = 0; isw < csw; isw++)
+        pbiass->rglwSum[isw % pbiass->cch] += psw[isw];
+}
+
+HRESULT AMBIAS::HrNew(AMBIAS **ppbias, IAMSound *psndSrc)
+{
+    AMBIAS *pbias;
+    BIASS biass;
+    long ich;
+    HRESULT hr;
+
+    *ppbias = NULL;
+    if (NULL == (pbias = new AMBIAS))
+        return E_OUTOFMEMORY;
+
+    ZeroMemory(pbias->_rgdsw, sizeof(pbias->_rgdsw));
+    if (SUCCEEDED(hr = pbias->_HrSetSrc(psndSrc)) && pbias->_csmp > 0)
+    {
+        ZeroMemory(&biass, sizeof(biass));
+        biass.cch = pbias->_wfxSrc.nChannels;
+        if (SUCCEEDED(hr = pbias->_HrScan(_ScanBias, &biass)))
+        {
+            for (ich = 0; ich < biass.cch; ich++)
+            {
+                pbias->_rgdsw[ich] = -(long)(biass.rglwSum[ich] / (LONGLONG)pbias->_csmp);
+
+                // 8 bit samples can't move by less than 256
+                if (pbias->_wfx.wBitsPerSample == 8)
+                    pbias->_rgdsw[ich] /= 256;
+            }
+        }
+    }
+
+    if (FAILED(hr))
+    {
+        pbias->Release();
+        return hr;
+    }
+    *ppbias = pbias;
+    return S_OK;
+}
+
+STDMETHODIMP AMBIAS::GetSampleData(LPBYTE lpBuffer, DWORD dwPosition, LPDWORD lpdwSamples,
+                                   LPREQUESTPARAM lpRequestParams)
+{
+    long cch = _wfx.nChannels;
+    long isw, csw;
+    long lw;
+    HRESULT hr;
+
+    hr = _psndSrc->GetSampleData(lpBuffer, dwPosition, lpdwSamples, lpRequestParams);
+    if (FAILED(hr) || (_rgdsw[0] == 0 && (cch == 1 || _rgdsw[1] == 0)))
+        return hr;
+
+    csw = *lpdwSamples * cch;
+    if (_wfx.wBitsPerSample == 16)
+    {
+        SW *psw = (SW *)lpBuffer;
+
+        for (isw = 0; isw < csw; isw++)
+            psw[isw] = _SwClip(psw[isw] + _rgdsw[isw % cch]);
+    }
+    else
+    {
+        for (isw = 0; isw < csw; isw++)
+        {
+            lw = lpBuffer[isw] + _rgdsw[isw % cch];
+            lpBuffer[isw] = (BT)(lw < 0 ? 0 : lw > 255 ? 255 : lw);
+        }
+    }
+    return hr;
+}
+
+/***************************************************************************
+    Loop filter.
+***************************************************************************/
+HRESULT AMLOOP::HrNew(AMLOOP **pploop, IAMSound *psndSrc, DWORD cactLoop)
+{
+    AMLOOP *ploop;
+    ULONGLONG csmp;
+    HRESULT hr;
+
+    *pploop = NULL;
+    if (NULL == (ploop = new AMLOOP))
+        return E_OUTOFMEMORY;
+
+    if (FAILED(hr = ploop->_HrSetSrc(psndSrc)))
+    {
+        ploop->Release();
+        return hr;
+    }
+
+    // a DWORD of samples is over a day at 44kHz, so saturating is "forever"
+    csmp = (ULONGLONG)ploop->_csmp * ((ULONGLONG)cactLoop + 1);
+    ploop->_csmp = csmp > 0xFFFFFFFF ? 0xFFFFFFFF : (DWORD)csmp;
+    *pploop = ploop;
+    return S_OK;
+}
+
+STDMETHODIMP AMLOOP::GetSampleData(LPBYTE lpBuffer, DWORD dwPosition, LPDWORD lpdwSamples,
+                                   LPREQUESTPARAM lpRequestParams)
+{
+    DWORD csmpSrc = _psndSrc->GetSamples();
+    DWORD csmpWant = *lpdwSamples;
+    DWORD csmpDone = 0;
+    DWORD csmp;
+    HRESULT hr = S_OK;
+
+    if (dwPosition < _csmp)
+        csmpWant = min(csmpWant, _csmp - dwPosition);
+    else
+        csmpWant = 0;
+
+    while (csmpDone < csmpWant)
+    {
+        csmp = min(csmpWant - csmpDone, csmpSrc - (dwPosition + csmpDone) % csmpSrc);
+        hr = _psndSrc->GetSampleData(lpBuffer + csmpDone * _wfx.nBlockAlign, (dwPosition + csmpDone) % csmpSrc, &csmp,
+                                     lpRequestParams);
+        if (FAILED(hr) || csmp == 0)
+            break;
+        csmpDone += csmp;
+    }
+
+    *lpdwSamples = csmpDone;
+    if (FAILED(hr))
+        return hr;
+    return dwPosition + csmpDone >= _csmp ? S_ENDOFSOUND : S_OK;
+}
+
+/***************************************************************************
+    Convert filter.
+***************************************************************************/
+AMCONV::~AMCONV(void)
+{
+    delete[] _pswSrc;
+    delete[] _pswOut;
+    delete[] _pbRaw;
+}
+
+HRESULT AMCONV::HrNew(AMCONV **ppconv, IAMSound *psndSrc, WAVEFORMATEX *pwfx)
+{
+    AMCONV *pconv;
+    HRESULT hr;
+
+    *ppconv = NULL;
+    if (NULL == pwfx)
+        return E_POINTER;
+    if (!AmFMixable(pwfx))
+        return E_BADPCMFORMAT;
+    if (NULL == (pconv = new AMCONV))
+        return E_OUTOFMEMORY;
+
+    pconv->_pswSrc = pconv->_pswOut = NULL;
+    pconv->_pbRaw = NULL;
+    if (SUCCEEDED(hr = pconv->_HrSetSrc(psndSrc)))
+    {
+        AmSetPcmFormat(&pconv->_wfx, pwfx->nSamplesPerSec, pwfx->nChannels, pwfx->wBitsPerSample);
+        pconv->_luStep = (DWORD)(((ULONGLONG)pconv->_wfxSrc.nSamplesPerSec << 16) / pwfx->nSamplesPerSec);
+        pconv->_luStep = max(pconv->_luStep, 1);
+        pconv->_csmp =
+            (DWORD)((ULONGLONG)pconv->_csmp * pwfx->nSamplesPerSec / pconv->_wfxSrc.nSamplesPerSec);
+
+        // a scratch load of source frames (plus the one we interpolate
+        // toward) and the output frames it covers
+        pconv->_pbRaw = new BT[(kcfrmScratch + 1) * pconv->_wfxSrc.nBlockAlign];
+        pconv->_pswSrc = new SW[(kcfrmScratch + 1) * kcchMax];
+        pconv->_pswOut = new SW[kcfrmScratch * kcchMax];
+        if (NULL == pconv->_pbRaw || NULL == pconv->_pswSrc || NULL == pconv->_pswOut)
+            hr = E_OUTOFMEMORY;
+    }
+
+    if (FAILED(hr))
+    {
+        pconv->Release();
+        return hr;
+    }
+    *ppconv = pconv;
+    return S_OK;
+}
+
+STDMETHODIMP AMCONV::GetSampleData(LPBYTE lpBuffer, DWORD dwPosition, LPDWORD lpdwSamples,
+                                   LPREQUESTPARAM lpRequestParams)
+{
+    long cch = _wfx.nChannels;
+    DWORD csmpWant = *lpdwSamples;
+    DWORD csmpDone = 0;
+    DWORD cfrmOut, cfrmSrc, cfrmGot;
+    DWORD ismpSrc, luFrac;
+    ULONGLONG luSrc;
+    HRESULT hr = S_OK;
+
+    if (dwPosition >= _csmp)
+    {
+        *lpdwSamples = 0;
+        return S_ENDOFSOUND;
+    }
+    csmpWant = min(csmpWant, _csmp - dwPosition);
+
+    while (csmpDone < csmpWant)
+    {
+        // where the next output frame falls in the source
+        luSrc = (ULONGLONG)(dwPosition + csmpDone) * _luStep;
+        ismpSrc = (DWORD)(luSrc >> 16);
+        luFrac = (DWORD)luSrc & 0xFFFF;
+
+        // as many output frames as a scratch load of source frames covers
+        cfrmOut = min(csmpWant - csmpDone, (DWORD)kcfrmScratch);
+        cfrmOut = (DWORD)min((ULONGLONG)cfrmOut, (((ULONGLONG)(kcfrmScratch - 1) << 16) - luFrac) / _luStep + 1);
+        cfrmSrc = ((luFrac + (cfrmOut - 1) * _luStep) >> 16) + 2;
+
+        cfrmGot = cfrmSrc;
+        hr = _psndSrc->GetSampleData(_pbRaw, ismpSrc, &cfrmGot, lpRequestParams);
+        if (FAILED(hr))
+            break;
+        cfrmGot = min(cfrmGot, cfrmSrc);
+        AmConvertToSw(_pbRaw, &_wfxSrc, cfrmGot, _pswSrc, cch);
+
+        // past the end of the source, ramp to silence
+        if (cfrmGot < cfrmSrc)
+            ZeroMemory(_pswSrc + cfrmGot * cch, (cfrmSrc - cfrmGot) * cch * sizeof(SW));
+
+        AmResample(_pswSrc, cch, luFrac, _luStep, _pswOut, cfrmOut);
+        AmConvertFromSw(_pswOut, cfrmOut, cch, lpBuffer + csmpDone * _wfx.nBlockAlign, &_wfx);
+        csmpDone += cfrmOut;
+        if (cfrmGot == 0)
+            break;
+    }
+
+    *lpdwSamples = csmpDone;
+    if (FAILED(hr))
+        return hr;
+    return dwPosition + csmpDone >= _csmp ? S_ENDOFSOUND : S_OK;
+}
@@ -0,0 +1,353 @@
+/***************************************************************************
+    AudioMan output sinks: the waveOut device and the file/null sink.
+
+***************************************************************************/
+#include "ampriv.h"
+
+/***************************************************************************
+    Write a canonical 44 byte RIFF WAVE header at the start of hfile.
+***************************************************************************/
+bool AmFWriteWaveHeader(HANDLE hfile, const WAVEFORMATEX *pwfx, DWORD cbData)
+{
+    DWORD rglu[11];
+    DWORD cbWritten;
+
+    rglu[0] = mmioFOURCC('R', 'I', 'F', 'F');
+    rglu[1] = 36 + cbData;
+    rglu[2] = mmioFOURCC('W', 'A', 'V', 'E');
+    rglu[3] = mmioFOURCC('f', 'm', 't', ' ');
+    rglu[4] = 16;
+    rglu[5] = MAKELONG(WAVE_FORMAT_PCM, pwfx->nChannels);
+    rglu[6] = pwfx->nSamplesPerSec;
+    rglu[7] = pwfx->nAvgBytesPerSec;
+    rglu[8] = MAKELONG(pwfx->nBlockAlign, pwfx->wBitsPerSample);
+    rglu[9] = mmioFOURCC('d', 'a', 't', 'a');
+    rglu[10] = cbData;
+
+    return SetFilePointer(hfile, 0, NULL, FILE_BEGIN) == 0 && WriteFile(hfile, rglu, sizeof(rglu), &cbWritten, NULL) &&
+           cbWritten == sizeof(rglu);
+}
+
+/***************************************************************************
+    The waveOut device.
+***************************************************************************/
+WAVO::WAVO(void)
+{
+    _cactRef = 1;
+    _hwo = NULL;
+}
+
+WAVO::~WAVO(void)
+{
+    if (NULL != _hwo)
+        waveOutClose(_hwo);
+}
+
+STDMETHODIMP WAVO::QueryInterface(REFIID riid, void **ppv)
+{
+    if (IsEqualIID(riid, IID_IUnknown) || IsEqualIID(riid, IID_IAMWaveOut))
+    {
+        *ppv = (IAMWaveOut *)this;
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = NULL;
+    return E_NOINTERFACE;
+}
+
+STDMETHODIMP_(ULONG) WAVO::AddRef(void)
+{
+    return InterlockedIncrement(&_cactRef);
+}
+
+STDMETHODIMP_(ULONG) WAVO::Release(void)
+{
+    LONG cactRef;
+
+    if ((cactRef = InterlockedDecrement(&_cactRef)) == 0)
+        delete this;
+    return cactRef;
+}
+
+STDMETHODIMP_(UINT) WAVO::GetNumDevs(void)
+{
+    return waveOutGetNumDevs();
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::Open(UINT uDeviceID, LPWAVEFORMATEX lpwfx, DWORD dwCallback, DWORD dwCallbackInstance,
+                                   DWORD fdwOpen)
+{
+    if (NULL != _hwo)
+        return MMSYSERR_ALLOCATED;
+    return waveOutOpen(&_hwo, uDeviceID, lpwfx, dwCallback, dwCallbackInstance, fdwOpen);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::Close(void)
+{
+    MMRESULT mmr;
+
+    if (NULL == _hwo)
+        return MMSYSERR_INVALHANDLE;
+    if (MMSYSERR_NOERROR == (mmr = waveOutClose(_hwo)))
+        _hwo = NULL;
+    return mmr;
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::GetDevCaps(UINT uDeviceID, LPWAVEOUTCAPS lpCaps, UINT cbCaps)
+{
+    return waveOutGetDevCaps(uDeviceID, lpCaps, cbCaps);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::GetVolume(LPDWORD lpdwVolume)
+{
+    return waveOutGetVolume(_hwo, lpdwVolume);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::SetVolume(DWORD dwVolume)
+{
+    return waveOutSetVolume(_hwo, dwVolume);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::PrepareHeader(LPWAVEHDR pwh, UINT cbwh)
+{
+    return waveOutPrepareHeader(_hwo, pwh, cbwh);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::UnprepareHeader(LPWAVEHDR pwh, UINT cbwh)
+{
+    return waveOutUnprepareHeader(_hwo, pwh, cbwh);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::Write(LPWAVEHDR pwh, UINT cbwh)
+{
+    return waveOutWrite(_hwo, pwh, cbwh);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::Pause(void)
+{
+    return waveOutPause(_hwo);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::Restart(void)
+{
+    return waveOutRestart(_hwo);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::Reset(void)
+{
+    return waveOutReset(_hwo);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::BreakLoop(void)
+{
+    return waveOutBreakLoop(_hwo);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::GetPosition(LPMMTIME lpmmt, UINT cbmmt)
+{
+    return waveOutGetPosition(_hwo, lpmmt, cbmmt);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::GetPitch(LPDWORD lpdwPitch)
+{
+    return waveOutGetPitch(_hwo, lpdwPitch);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::SetPitch(DWORD dwPitch)
+{
+    return waveOutSetPitch(_hwo, dwPitch);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::GetPlaybackRate(LPDWORD lpdwRate)
+{
+    return waveOutGetPlaybackRate(_hwo, lpdwRate);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::SetPlaybackRate(DWORD dwRate)
+{
+    return waveOutSetPlaybackRate(_hwo, dwRate);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::GetID(UINT FAR *lpuDeviceID)
+{
+    return waveOutGetID(_hwo, lpuDeviceID);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::Message(UINT uMsg, DWORD dw1, DWORD dw2)
+{
+    return waveOutMessage(_hwo, uMsg, dw1, dw2);
+}
+
+STDMETHODIMP_(MMRESULT) WAVO::GetErrorText(MMRESULT err, LPSTR lpText, UINT cchText)
+{
+    return waveOutGetErrorText(err, lpText, cchText);
+}
+
+/***************************************************************************
+    The file sink. With no file name it's the null sink: the mix is thrown
+    away. Writes complete immediately; in real time mode they're paced to
+    the wall clock so sounds take as long as they would on a device.
+***************************************************************************/
+AMFSNK::AMFSNK(char *pszFile, bool fRealTime)
+{
+    _cactRef = 1;
+    _szFile[0] = 0;
+    if (NULL != pszFile)
+        lstrcpynA(_szFile, pszFile, MAX_PATH);
+    _fRealTime = fRealTime;
+    _hfile = INVALID_HANDLE_VALUE;
+    ZeroMemory(&_wfx, sizeof(_wfx));
+    _cbWritten = 0;
+    _tsOpen = 0;
+    _luVol = 0xFFFFFFFF;
+}
+
+AMFSNK::~AMFSNK(void)
+{
+    Close();
+}
+
+STDMETHODIMP AMFSNK::QueryInterface(REFIID riid, void **ppv)
+{
+    if (IsEqualIID(riid, IID_IUnknown) || IsEqualIID(riid, IID_IAMWaveOut))
+    {
+        *ppv = (IAMWaveOut *)this;
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = NULL;
+    return E_NOINTERFACE;
+}
+
+STDMETHODIMP_(ULONG) AMFSNK::AddRef(void)
+{
+    return InterlockedIncrement(&_cactRef);
+}
+
+STDMETHODIMP_(ULONG) AMFSNK::Release(void)
+{
+    LONG cactRef;
+
+    if ((cactRef = InterlockedDecrement(&_cactRef)) == 0)
+        delete this;
+    return cactRef;
+}
+
+STDMETHODIMP_(MMRESULT) AMFSNK::Open(UINT uDeviceID, LPWAVEFORMATEX lpwfx, DWORD dwCallback,
+                                     DWORD dwCallbackInstance, DWORD fdwOpen)
+{
+    if (lpwfx->wFormatTag != WAVE_FORMAT_PCM || lpwfx->nAvgBytesPerSec == 0)
+        return WAVERR_BADFORMAT;
+    if (fdwOpen & WAVE_FORMAT_QUERY)
+        return MMSYSERR_NOERROR;
+    if (INVALID_HANDLE_VALUE != _hfile)
+        return MMSYSERR_ALLOCATED;
+
+    if (_szFile[0] != 0)
+    {
+        _hfile = CreateFileA(_szFile, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (INVALID_HANDLE_VALUE == _hfile)
+            return MMSYSERR_ERROR;
+        if (!AmFWriteWaveHeader(_hfile, lpwfx, 0))
+        {
+            CloseHandle(_hfile);
+            _hfile = INVALID_HANDLE_VALUE;
+            return MMSYSERR_ERROR;
+        }
+    }
+
+    _wfx = *lpwfx;
+    _cbWritten = 0;
+    _tsOpen = GetTickCount();
+    return MMSYSERR_NOERROR;
+}
+
+STDMETHODIMP_(MMRESULT) AMFSNK::Close(void)
+{
+    if (INVALID_HANDLE_VALUE != _hfile)
+    {
+        AmFWriteWaveHeader(_hfile, &_wfx, _cbWritten);
+        CloseHandle(_hfile);
+        _hfile = INVALID_HANDLE_VALUE;
+    }
+    return MMSYSERR_NOERROR;
+}
+
+STDMETHODIMP_(MMRESULT) AMFSNK::GetDevCaps(UINT uDeviceID, LPWAVEOUTCAPS lpCaps, UINT cbCaps)
+{
+    WAVEOUTCAPS woc;
+
+    ZeroMemory(&woc, sizeof(woc));
+    lstrcpyn(woc.szPname, _szFile[0] != 0 ? TEXT("AudioMan file output") : TEXT("AudioMan null output"), MAXPNAMELEN);
+    woc.dwFormats = 0x0FFF;
+    woc.wChannels = 2;
+    CopyMemory(lpCaps, &woc, min(cbCaps, sizeof(woc)));
+    return MMSYSERR_NOERROR;
+}
+
+STDMETHODIMP_(MMRESULT) AMFSNK::PrepareHeader(LPWAVEHDR pwh, UINT cbwh)
+{
+    pwh->dwFlags |= WHDR_PREPARED;
+    return MMSYSERR_NOERROR;
+}
+
+STDMETHODIMP_(MMRESULT) AMFSNK::UnprepareHeader(LPWAVEHDR pwh, UINT cbwh)
+{
+    pwh->dwFlags &= ~WHDR_PREPARED;
+    return MMSYSERR_NOERROR;
+}
+
+STDMETHODIMP_(MMRESULT) AMFSNK::Write(LPWAVEHDR pwh, UINT cbwh)
+{
+    DWORD cb;
+    DWORD dtsDue;
+    DWORD dtsNow;
+
+    if (INVALID_HANDLE_VALUE != _hfile && !WriteFile(_hfile, pwh->lpData, pwh->dwBufferLength, &cb, NULL))
+        return MMSYSERR_ERROR;
+
+    if (_fRealTime)
+    {
+        // don't get more than a buffer ahead of the clock
+        dtsDue = (DWORD)((ULONGLONG)_cbWritten * 1000 / _wfx.nAvgBytesPerSec);
+        dtsNow = GetTickCount() - _tsOpen;
+        if (dtsDue > dtsNow)
+            Sleep(dtsDue - dtsNow);
+    }
+    _cbWritten += pwh->dwBufferLength;
+
+    pwh->dwFlags = (pwh->dwFlags & ~WHDR_INQUEUE) | WHDR_DONE;
+    return MMSYSERR_NOERROR;
+}
+
+STDMETHODIMP_(MMRESULT) AMFSNK::GetPosition(LPMMTIME lpmmt, UINT cbmmt)
+{
+    DWORD cb = _cbWritten;
+
+    if (_fRealTime)
+        cb = (DWORD)min((ULONGLONG)cb, (ULONGLONG)(GetTickCount() - _tsOpen) * _wfx.nAvgBytesPerSec / 1000);
+
+    switch (lpmmt->wType)
+    {
+    case TIME_SAMPLES:
+        lpmmt->u.sample = _wfx.nBlockAlign == 0 ? 0 : cb / _wfx.nBlockAlign;
+        break;
+    case TIME_MS:
+        lpmmt->u.ms = _wfx.nAvgBytesPerSec == 0 ? 0 : (DWORD)((ULONGLONG)cb * 1000 / _wfx.nAvgBytesPerSec);
+        break;
+    default:
+        lpmmt->wType = TIME_BYTES;
+        lpmmt->u.cb = cb;
+        break;
+    }
+    return MMSYSERR_NOERROR;
+}
+
+STDMETHODIMP_(MMRESULT) AMFSNK::GetErrorText(MMRESULT err, LPSTR lpText, UINT cchText)
+{
+    if (cchText > 0)
+        lstrcpynA(lpText, err == MMSYSERR_NOERROR ? "No error" : "AudioMan file output error", cchText);
+    return MMSYSERR_NOERROR;
+}
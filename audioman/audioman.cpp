@@ -1,56 +1,114 @@
 // Implementation of the AudioMan library.
 // Created for 3DMMForever.
-// FIXME: This is a nonworking stub. The game will still function, but sound effects will be missing.
+//
+// Sound sources and filters are in amsound.cpp, the mixer and its channels
+// in ammixer.cpp and the output sinks in amwave.cpp. This file holds the
+// exported allocation functions.
 
 #include <Windows.h>
 #include <initguid.h>
 
-#include "audioman.h"
+#include "ampriv.h"
 
 STDAPI AllocSoundFromStream(LPSOUND FAR *ppSound, LPSTREAM pStream, BOOL fSpooled, LPCACHECONFIG lpCacheConfig)
 {
-    return E_NOTIMPL;
+    // The mixer reads ahead on its own thread, so we ignore the cache config.
+    return AMWAV::HrNewStream((AMWAV **)ppSound, pStream, fSpooled);
 }
 
 STDAPI AllocSoundFromFile(LPSOUND FAR *ppSound, char FAR *szFileName, DWORD dwOffset, BOOL fSpooled,
                           LPCACHECONFIG lpCacheConfig)
 {
-    return E_NOTIMPL;
+    return AMWAV::HrNewFile((AMWAV **)ppSound, szFileName, dwOffset, fSpooled);
 }
 
 STDAPI AllocSoundFromMemory(LPSOUND FAR *ppSound, LPBYTE lpFileData, DWORD dwSize)
 {
-    return E_NOTIMPL;
+    return AMWAV::HrNewMemory((AMWAV **)ppSound, lpFileData, dwSize);
 }
 
 STDAPI_(LPMIXER) GetAudioManMixer(void)
 {
-    return NULL;
+    return AMMIX::PmixGet();
 }
 
 STDAPI AllocTrimFilter(LPSOUND FAR *ppSound, LPSOUND pSoundSrc)
 {
-    return E_NOTIMPL;
+    return AMTRIM::HrNew((AMTRIM **)ppSound, pSoundSrc);
 }
 
 STDAPI AllocBiasFilter(LPSOUND FAR *ppSound, LPSOUND pSoundSrc)
 {
-    return E_NOTIMPL;
+    return AMBIAS::HrNew((AMBIAS **)ppSound, pSoundSrc);
 }
 
 STDAPI AllocLoopFilter(LPSOUND FAR *ppSound, LPSOUND pSoundSrc, DWORD dwLoops)
 {
-    return E_NOTIMPL;
+    return AMLOOP::HrNew((AMLOOP **)ppSound, pSoundSrc, dwLoops);
 }
 
 STDAPI AllocConvertFilter(LPSOUND FAR *ppSound, LPSOUND pSoundSrc, LPWAVEFORMATEX lpwfx)
 {
-    return E_NOTIMPL;
+    return AMCONV::HrNew((AMCONV **)ppSound, pSoundSrc, lpwfx);
+}
+
+STDAPI AllocWaveOut(LPWAVEOUT FAR *ppWaveOut, LPMIXER pMixer)
+{
+    if (NULL == (*ppWaveOut = new WAVO))
+        return E_OUTOFMEMORY;
+    return S_OK;
+}
+
+STDAPI AllocFileWaveOut(LPWAVEOUT FAR *ppWaveOut, char FAR *pszFile, BOOL fRealTime)
+{
+    if (NULL == (*ppWaveOut = new AMFSNK(pszFile, fRealTime != FALSE)))
+        return E_OUTOFMEMORY;
+    return S_OK;
 }
 
 STDAPI SoundToFileAsWave(LPSOUND pSound, char FAR *pAbsFilePath)
 {
-    return E_NOTIMPL;
+    WAVEFORMATEX wfx;
+    HANDLE hfile;
+    BT *pb;
+    DWORD ismp, csmp, cfrm, cb;
+    DWORD cbData = 0;
+    HRESULT hr;
+
+    if (FAILED(hr = pSound->GetFormat(&wfx, sizeof(wfx))))
+        return hr;
+    if (!AmFMixable(&wfx))
+        return E_BADPCMFORMAT;
+    if (NULL == (pb = new BT[kcfrmScratch * wfx.nBlockAlign]))
+        return E_OUTOFMEMORY;
+
+    hfile = CreateFileA(pAbsFilePath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (INVALID_HANDLE_VALUE == hfile)
+    {
+        delete[] pb;
+        return E_FAIL;
+    }
+
+    hr = AmFWriteWaveHeader(hfile, &wfx, 0) ? S_OK : E_FAIL;
+    csmp = pSound->GetSamples();
+    for (ismp = 0; SUCCEEDED(hr) && ismp < csmp; ismp += cfrm)
+    {
+        cfrm = min(csmp - ismp, (DWORD)kcfrmScratch);
+        if (FAILED(hr = pSound->GetSampleData(pb, ismp, &cfrm, NULL)))
+            break;
+        hr = S_OK;
+        if (cfrm == 0)
+            break;
+        if (!WriteFile(hfile, pb, cfrm * wfx.nBlockAlign, &cb, NULL))
+            hr = E_FAIL;
+        cbData += cfrm * wfx.nBlockAlign;
+    }
+
+    if (SUCCEEDED(hr) && !AmFWriteWaveHeader(hfile, &wfx, cbData))
+        hr = E_FAIL;
+    CloseHandle(hfile);
+    delete[] pb;
+    return hr;
 }
 
 STDAPI_(int) DetectLeaks(BOOL fDebugOut, BOOL fMessageBox)
@@ -16,8 +16,16 @@
     enlarged to _rcView's coordinate system, since the gob will be drawn at
     full view resolution.
 
+    The working buffers can also be restored on more than one thread.  The
+    dirty part of the buffers is split into _crbnd horizontal bands, each
+    clipped to its own rows; band 0 is restored by the thread calling
+    Render and the others by threads started in SetCthRender.  BRender's
+    Z-buffer renderer keeps its state in globals, so the scene itself is
+    still rendered once, on the calling thread.
+
 ***************************************************************************/
 #include "bren.h"
+#include "simd.h"
 
 // REVIEW *****: _pgptStretch is completely unused...remove it!
 
@@ -33,21 +41,95 @@ const long kcbPixelZ = 2;
 
 bool BWLD::_fBRenderInited = fFalse;
 
+// Restores a run of cpix pixels of both Z and RGB from the background
+// buffers to the working buffers
+typedef void (*PFNRESTORE)(byte *pbZSrc, byte *pbZDst, byte *pbSrc, byte *pbDst, long cpix);
+priv PFNRESTORE _pfnrestore;
+
+/***************************************************************************
+    Restore a run of Z and RGB pixels with CopyPb.
+***************************************************************************/
+priv void _RestoreRunScalar(byte *pbZSrc, byte *pbZDst, byte *pbSrc, byte *pbDst, long cpix)
+{
+    CopyPb(pbZSrc, pbZDst, LwMul(cpix, kcbPixelZ));
+    CopyPb(pbSrc, pbDst, LwMul(cpix, kcbPixelRGB));
+}
+
+#ifdef IN_SSE2
+/***************************************************************************
+    Restore a run of Z and RGB pixels 16 at a time, loading and storing
+    the Z and RGB for each group of pixels together.  The last group
+    overlaps the one before it rather than finishing a byte at a time.
+***************************************************************************/
+priv SSE2_FUNC void _RestoreRunSse2(byte *pbZSrc, byte *pbZDst, byte *pbSrc, byte *pbDst, long cpix)
+{
+    long ipix, ipixLast;
+    __m128i xmm, xmmZ0, xmmZ1;
+
+    if (cpix < 16)
+    {
+        _RestoreRunScalar(pbZSrc, pbZDst, pbSrc, pbDst, cpix);
+        return;
+    }
+
+    ipixLast = cpix - 16;
+    for (ipix = 0;; ipix = LwMin(ipix + 16, ipixLast))
+    {
+        xmm = _mm_loadu_si128((__m128i *)(pbSrc + ipix));
+        xmmZ0 = _mm_loadu_si128((__m128i *)(pbZSrc + 2 * ipix));
+        xmmZ1 = _mm_loadu_si128((__m128i *)(pbZSrc + 2 * ipix + 16));
+        _mm_storeu_si128((__m128i *)(pbDst + ipix), xmm);
+        _mm_storeu_si128((__m128i *)(pbZDst + 2 * ipix), xmmZ0);
+        _mm_storeu_si128((__m128i *)(pbZDst + 2 * ipix + 16), xmmZ1);
+        if (ipix == ipixLast)
+            break;
+    }
+}
+#endif // IN_SSE2
+
+#ifdef IN_NEON
+/***************************************************************************
+    Restore a run of Z and RGB pixels 16 at a time.  See _RestoreRunSse2.
+***************************************************************************/
+priv void _RestoreRunNeon(byte *pbZSrc, byte *pbZDst, byte *pbSrc, byte *pbDst, long cpix)
+{
+    long ipix, ipixLast;
+
+    if (cpix < 16)
+    {
+        _RestoreRunScalar(pbZSrc, pbZDst, pbSrc, pbDst, cpix);
+        return;
+    }
+
+    ipixLast = cpix - 16;
+    for (ipix = 0;; ipix = LwMin(ipix + 16, ipixLast))
+    {
+        vst1q_u8(pbDst + ipix, vld1q_u8(pbSrc + ipix));
+        vst1q_u8(pbZDst + 2 * ipix, vld1q_u8(pbZSrc + 2 * ipix));
+        vst1q_u8(pbZDst + 2 * ipix + 16, vld1q_u8(pbZSrc + 2 * ipix + 16));
+        if (ipix == ipixLast)
+            break;
+    }
+}
+#endif // IN_NEON
+
 /***************************************************************************
-    Allocate a new BRender world
+    Allocate a new BRender world.  cthRender is the number of threads to
+    restore the working buffers on; 0 means one per processor.
 ***************************************************************************/
-PBWLD BWLD::PbwldNew(long dxp, long dyp, bool fHalfX, bool fHalfY)
+PBWLD BWLD::PbwldNew(long dxp, long dyp, bool fHalfX, bool fHalfY, long cthRender)
 {
     AssertIn(dxp, 1, ksuMax); // BPMP's width and height are ushorts
     AssertIn(dyp, 1, ksuMax);
     Assert(dxp % 2 == 0, "dxp should be even");
     Assert(dyp % 2 == 0, "dyp should be even");
+    AssertIn(cthRender, 0, kcthRenderMax + 1);
 
     PBWLD pbwld;
 
     pbwld = NewObj BWLD;
 
-    if (pbwld == pvNil || !pbwld->_FInit(dxp, dyp, fHalfX, fHalfY))
+    if (pbwld == pvNil || !pbwld->_FInit(dxp, dyp, fHalfX, fHalfY, cthRender))
     {
         ReleasePpo(&pbwld);
         return pvNil;
@@ -60,7 +142,7 @@ PBWLD BWLD::PbwldNew(long dxp, long dyp, bool fHalfX, bool fHalfY)
 /***************************************************************************
     Initialize the BWLD
 ***************************************************************************/
-bool BWLD::_FInit(long dxp, long dyp, bool fHalfX, bool fHalfY)
+bool BWLD::_FInit(long dxp, long dyp, bool fHalfX, bool fHalfY, long cthRender)
 {
     AssertBaseThis(0);
     AssertIn(dxp, 1, ksuMax); // BPMP's width and height are ushorts
@@ -103,6 +185,8 @@ bool BWLD::_FInit(long dxp, long dyp, bool fHalfX, bool fHalfY)
 
     BrZbSetRenderBoundsCallback(_ActorRendered);
 
+    SetCthRender(cthRender);
+
     return fTrue;
 }
 
@@ -189,6 +273,8 @@ BWLD::~BWLD(void)
 {
     AssertBaseThis(0);
 
+    _StopBands();
+
     if (pvNil != _pgptWorking)
     {
         _pgptWorking->Unlock();
@@ -282,6 +368,108 @@ LFail:
     return fFalse;
 }
 
+/***************************************************************************
+    Set the number of threads the working buffers are restored on.  0
+    means one per processor.  If a thread can't be started, the buffers
+    are split among the threads that could be.
+***************************************************************************/
+void BWLD::SetCthRender(long cthRender)
+{
+    AssertBaseThis(0);
+    AssertIn(cthRender, 0, kcthRenderMax + 1);
+
+#ifdef WIN
+    RBND *prbnd;
+    ulong luThread;
+
+    if (cthRender == 0)
+    {
+        SYSTEM_INFO si;
+
+        GetSystemInfo(&si);
+        cthRender = LwBound(si.dwNumberOfProcessors, 1, kcthRenderMax + 1);
+    }
+#else  //! WIN
+    // no threads, so one band
+    cthRender = 1;
+#endif //! WIN
+
+    if (cthRender == _crbnd)
+        return;
+    _StopBands();
+
+#ifdef WIN
+    for (; _crbnd < cthRender; _crbnd++)
+    {
+        prbnd = &_rgrbnd[_crbnd];
+        prbnd->pbwld = this;
+        if (hNil == (prbnd->hevtGo = CreateEvent(pvNil, fFalse, fFalse, pvNil)) ||
+            hNil == (prbnd->hevtDone = CreateEvent(pvNil, fFalse, fFalse, pvNil)) ||
+            hNil == (prbnd->hth = CreateThread(pvNil, 4096, _LuBandThread, prbnd, 0, &luThread)))
+        {
+            Warn("couldn't start a band thread");
+            if (hNil != prbnd->hevtGo)
+                CloseHandle(prbnd->hevtGo);
+            if (hNil != prbnd->hevtDone)
+                CloseHandle(prbnd->hevtDone);
+            prbnd->hevtGo = prbnd->hevtDone = hNil;
+            break;
+        }
+    }
+#endif // WIN
+}
+
+/***************************************************************************
+    Stop the band threads.  Afterwards, the working buffers are restored
+    as a single band on the calling thread.
+***************************************************************************/
+void BWLD::_StopBands(void)
+{
+    AssertBaseThis(0);
+
+#ifdef WIN
+    RBND *prbnd;
+
+    // tell the threads to end and wait for them to finish
+    _fStopBands = fTrue;
+    for (; _crbnd > 1; _crbnd--)
+    {
+        prbnd = &_rgrbnd[_crbnd - 1];
+        SetEvent(prbnd->hevtGo);
+        WaitForSingleObject(prbnd->hth, INFINITE);
+        CloseHandle(prbnd->hth);
+        CloseHandle(prbnd->hevtGo);
+        CloseHandle(prbnd->hevtDone);
+        prbnd->hth = prbnd->hevtGo = prbnd->hevtDone = hNil;
+    }
+    _fStopBands = fFalse;
+#endif // WIN
+
+    _rgrbnd[0].pbwld = this;
+    _crbnd = 1;
+}
+
+#ifdef WIN
+/***************************************************************************
+    Band thread.  Restores its band each time Render sets hevtGo, until
+    _StopBands tells it to quit.
+***************************************************************************/
+ulong __stdcall BWLD::_LuBandThread(void *pv)
+{
+    RBND *prbnd = (RBND *)pv;
+    PBWLD pbwld = prbnd->pbwld;
+
+    for (;;)
+    {
+        WaitForSingleObject(prbnd->hevtGo, INFINITE);
+        if (pbwld->_fStopBands)
+            return 0;
+        prbnd->cpix = _CpixRestore(&pbwld->_rsj, prbnd);
+        SetEvent(prbnd->hevtDone);
+    }
+}
+#endif // WIN
+
 /***************************************************************************
     Completely close BRender, freeing all data structures that BRender
     knows about.  This invalidates all MODLs and MTRLs in existence.
@@ -471,6 +659,7 @@ void BWLD::Render(void)
 
     PBACT pbact;
     RC rc;
+    ulong tus, tusT;
 
     if (!_fWorldChanged)
         return;
@@ -487,7 +676,11 @@ void BWLD::Render(void)
         }
     }
 
+    tus = TusCurrentSystem();
     _CleanWorkingBuffers();
+    tusT = TusCurrentSystem();
+    _bwct.dtusClean += tusT - tus;
+    tus = tusT;
 
     // Now the working buffer is clean, but we should mark everything that
     // we just cleaned in _CleanWorkingBuffers as dirty in the screen buffer
@@ -501,8 +694,15 @@ void BWLD::Render(void)
     _pregnDirtyScreen->FUnion(_pregnDirtyWorking);
     _pregnDirtyWorking->SetRc(pvNil);
 
+    tusT = TusCurrentSystem();
+    _bwct.dtusUnion += tusT - tus;
+    tus = tusT;
+
     // Render the scene.  This will add stuff to _pregnDirtyWorking
     BrZbSceneRender(&_bactWorld, &_bactCamera, &_bpmpRGB, &_bpmpZ);
+    tusT = TusCurrentSystem();
+    _bwct.dtusScene += tusT - tus;
+    tus = tusT;
 
     for (pbact = _bactWorld.children; pvNil != pbact; pbact = pbact->next)
     {
@@ -516,6 +716,8 @@ void BWLD::Render(void)
 
     // Everything dirty in working buffer is dirty on screen too
     _pregnDirtyScreen->FUnion(_pregnDirtyWorking);
+    _bwct.dtusUnion += TusCurrentSystem() - tus;
+    _bwct.cactRender++;
 
     _fWorldChanged = fFalse;
 }
@@ -562,56 +764,158 @@ void BWLD::Unprerender(void)
 
 /***************************************************************************
     Copy _pregnDirtyWorking from background Z and RGB buffers to working
-    Z and RGB buffers.
+    Z and RGB buffers.  The region's bounds are split into _crbnd bands of
+    rows, which are restored in parallel by the band threads.
 ***************************************************************************/
 void BWLD::_CleanWorkingBuffers(void)
 {
     AssertThis(0);
 
-    REGSC regsc;
-    long yp;
-    long xpLeft;
+    long irbnd, crbnd;
+    RBND *prbnd;
     RC rcRegnBounds;
     RC rcClippedRegnBounds;
-    byte *pbSrc;
-    byte *pbDst;
-    long cbRowCopy;
-    RC rc;
-    long cbRowSrc, cbRowDst;
+    RC rcZ;
+    bool fScan;
 
     if (_pregnDirtyWorking->FEmpty(&rcRegnBounds))
         return;
     if (!rcClippedRegnBounds.FIntersect(&rcRegnBounds, &_rcBuffer))
         return;
 
-    // Clean the Z buffer
-    _pzbmpBackground->Draw((byte *)_bpmpZ.pixels, _bpmpZ.row_bytes, _bpmpZ.height, 0, 0, &rcClippedRegnBounds,
-                           _pregnDirtyWorking);
-
-    // Clean the RGB buffer
-    regsc.Init(_pregnDirtyWorking, &rcClippedRegnBounds);
-    yp = rcClippedRegnBounds.ypTop;
-    cbRowSrc = _pgptBackground->CbRow();
-    pbSrc = _pgptBackground->PrgbLockPixels() + LwMul(yp, cbRowSrc) + rcClippedRegnBounds.xpLeft;
-    cbRowDst = _pgptWorking->CbRow();
-    pbDst = _pgptWorking->PrgbLockPixels() + LwMul(yp, cbRowDst) + rcClippedRegnBounds.xpLeft;
-    for (; yp < rcClippedRegnBounds.ypBottom; yp++)
+    // the background Z buffer should cover the whole buffer
+    _pzbmpBackground->GetRc(&rcZ);
+    Assert(rcZ.FContains(&_rcBuffer), "background Z buffer is too small");
+    if (!rcClippedRegnBounds.FIntersect(&rcZ))
+        return;
+
+    if (pvNil == _pfnrestore)
     {
-        while (regsc.XpCur() < klwMax)
-        {
-            xpLeft = regsc.XpCur();
-            cbRowCopy = regsc.XpFetch() - xpLeft;
-            regsc.XpFetch();
-            CopyPb(pbSrc + xpLeft, pbDst + xpLeft, cbRowCopy);
-        }
-        pbSrc += cbRowSrc;
-        pbDst += cbRowDst;
-        regsc.ScanNext(1);
+        _pfnrestore = _RestoreRunScalar;
+#ifdef IN_SSE2
+        if (FVectorMoves())
+            _pfnrestore = _RestoreRunSse2;
+#elif defined(IN_NEON)
+        _pfnrestore = _RestoreRunNeon;
+#endif
+    }
+
+    // Lock the buffers and set up the bands here, since neither GPT nor
+    // REGSC is safe to set up on the band threads
+    _rsj.cbRowZSrc = _pzbmpBackground->CbRow();
+    _rsj.pbZSrc = _pzbmpBackground->Prgb();
+    _rsj.cbRowZDst = _bpmpZ.row_bytes;
+    _rsj.pbZDst = (byte *)_bpmpZ.pixels;
+    _rsj.cbRowSrc = _pgptBackground->CbRow();
+    _rsj.pbSrc = _pgptBackground->PrgbLockPixels();
+    _rsj.cbRowDst = _pgptWorking->CbRow();
+    _rsj.pbDst = _pgptWorking->PrgbLockPixels();
+
+    fScan = !_pregnDirtyWorking->FIsRc();
+    crbnd = LwMin(_crbnd, rcClippedRegnBounds.Dyp());
+    for (irbnd = 0; irbnd < crbnd; irbnd++)
+    {
+        prbnd = &_rgrbnd[irbnd];
+        prbnd->rc = rcClippedRegnBounds;
+        prbnd->rc.ypTop = rcClippedRegnBounds.ypTop + LwMulDiv(rcClippedRegnBounds.Dyp(), irbnd, crbnd);
+        prbnd->rc.ypBottom = rcClippedRegnBounds.ypTop + LwMulDiv(rcClippedRegnBounds.Dyp(), irbnd + 1, crbnd);
+        prbnd->fScan = fScan;
+        if (fScan)
+            prbnd->regsc.Init(_pregnDirtyWorking, &prbnd->rc);
+    }
+
+#ifdef WIN
+    HANDLE rghevt[kcthRenderMax];
+
+    for (irbnd = 1; irbnd < crbnd; irbnd++)
+    {
+        rghevt[irbnd - 1] = _rgrbnd[irbnd].hevtDone;
+        SetEvent(_rgrbnd[irbnd].hevtGo);
+    }
+#endif // WIN
+    _rgrbnd[0].cpix = _CpixRestore(&_rsj, &_rgrbnd[0]);
+#ifdef WIN
+    if (crbnd > 1)
+        WaitForMultipleObjects(crbnd - 1, rghevt, fTrue, INFINITE);
+#endif // WIN
+
+    for (irbnd = 0; irbnd < crbnd; irbnd++)
+    {
+        _bwct.cpixClean += _rgrbnd[irbnd].cpix;
+        _rgrbnd[irbnd].regsc.Free();
     }
     _pgptWorking->Unlock();
     _pgptBackground->Unlock();
 }
 
+/***************************************************************************
+    Restore a band of the working buffers.  Z and RGB are restored
+    together, a run at a time.  If the whole band is dirty, there's no need
+    to scan it, and if it spans whole rows, the rows are copied as a single
+    run.  This runs on the band threads, so it must not touch anything
+    but the buffers.  Returns the number of pixels restored.
+***************************************************************************/
+long BWLD::_CpixRestore(RSJ *prsj, RBND *prbnd)
+{
+    long yp, dyp;
+    long xpLeft;
+    byte *pbZSrc, *pbZDst;
+    byte *pbSrc, *pbDst;
+    long cpix;
+    long cpixTot = 0;
+
+    yp = prbnd->rc.ypTop;
+    xpLeft = prbnd->rc.xpLeft;
+    pbZSrc = prsj->pbZSrc + LwMul(yp, prsj->cbRowZSrc) + LwMul(xpLeft, kcbPixelZ);
+    pbZDst = prsj->pbZDst + LwMul(yp, prsj->cbRowZDst) + LwMul(xpLeft, kcbPixelZ);
+    pbSrc = prsj->pbSrc + LwMul(yp, prsj->cbRowSrc) + LwMul(xpLeft, kcbPixelRGB);
+    pbDst = prsj->pbDst + LwMul(yp, prsj->cbRowDst) + LwMul(xpLeft, kcbPixelRGB);
+
+    if (!prbnd->fScan)
+    {
+        cpix = prbnd->rc.Dxp();
+        dyp = prbnd->rc.Dyp();
+        cpixTot = LwMul(cpix, dyp);
+        if (LwMul(cpix, kcbPixelZ) == prsj->cbRowZSrc && prsj->cbRowZSrc == prsj->cbRowZDst &&
+            LwMul(cpix, kcbPixelRGB) == prsj->cbRowSrc && prsj->cbRowSrc == prsj->cbRowDst)
+        {
+            // whole rows are contiguous, so copy them as one run
+            (*_pfnrestore)(pbZSrc, pbZDst, pbSrc, pbDst, cpixTot);
+        }
+        else
+        {
+            for (; dyp > 0; dyp--)
+            {
+                (*_pfnrestore)(pbZSrc, pbZDst, pbSrc, pbDst, cpix);
+                pbZSrc += prsj->cbRowZSrc;
+                pbZDst += prsj->cbRowZDst;
+                pbSrc += prsj->cbRowSrc;
+                pbDst += prsj->cbRowDst;
+            }
+        }
+        return cpixTot;
+    }
+
+    for (; yp < prbnd->rc.ypBottom; yp++)
+    {
+        while (prbnd->regsc.XpCur() < klwMax)
+        {
+            xpLeft = prbnd->regsc.XpCur();
+            cpix = prbnd->regsc.XpFetch() - xpLeft;
+            prbnd->regsc.XpFetch();
+            cpixTot += cpix;
+            (*_pfnrestore)(pbZSrc + LwMul(xpLeft, kcbPixelZ), pbZDst + LwMul(xpLeft, kcbPixelZ),
+                           pbSrc + LwMul(xpLeft, kcbPixelRGB), pbDst + LwMul(xpLeft, kcbPixelRGB), cpix);
+        }
+        pbZSrc += prsj->cbRowZSrc;
+        pbZDst += prsj->cbRowZDst;
+        pbSrc += prsj->cbRowSrc;
+        pbDst += prsj->cbRowDst;
+        prbnd->regsc.ScanNext(1);
+    }
+    return cpixTot;
+}
+
 /***************************************************************************
     Callback for when a BACT is rendered.  Need to union with dirty
     region.
@@ -757,6 +1061,7 @@ void BWLD::AssertValid(ulong grf)
     AssertPo(_pregnDirtyWorking, 0);
     AssertPo(_pregnDirtyScreen, 0);
     AssertNilOrPo(_pcrf, 0);
+    AssertIn(_crbnd, 1, kcthRenderMax + 1);
     if (!_fHalfX && _fHalfY)
         AssertPo(_pgptStretch, 0);
     else
@@ -779,6 +1084,7 @@ void BWLD::MarkMem(void)
     MarkMemObj(_pcrf);
     MarkMemObj(_pgptStretch);
 }
+#endif // DEBUG
 
 /******************************************************************************
     FWriteBmp
@@ -796,11 +1102,12 @@ bool BWLD::FWriteBmp(PFNI pfni)
 
     bool fRet;
     RC rc;
+    PGL pglclr;
 
-    fRet = FWriteBitmap(pfni, _pgptWorking->PrgbLockPixels(&rc), GPT::PglclrGetPalette(), _rcBuffer.Dxp(),
-                        _rcBuffer.Dyp());
+    if (pvNil == (pglclr = GPT::PglclrGetPalette()))
+        return fFalse;
+    fRet = FWriteBitmap(pfni, _pgptWorking->PrgbLockPixels(&rc), pglclr, _rcBuffer.Dxp(), _rcBuffer.Dyp());
     _pgptWorking->Unlock();
+    ReleasePpo(&pglclr);
     return fRet;
 }
-
-#endif // DEBUG
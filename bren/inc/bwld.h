@@ -11,6 +11,8 @@
 #ifndef BWLD_H
 #define BWLD_H
 
+typedef class BWLD *PBWLD;
+
 // Callback function per BACT when it's rendered, passing the 2D bounds
 typedef void FNBACTREND(PBACT pbact, RC *prc);
 typedef FNBACTREND *PFNBACTREND;
@@ -23,10 +25,51 @@ typedef FNBEGINREND *PFNBEGINREND;
 typedef void FNGETRECT(PBACT pbact, RC *prc);
 typedef FNGETRECT *PFNGETRECT;
 
+// Render phase counters.  Times are in microseconds.
+struct BWCT
+{
+    long cactRender; // frames rendered
+    long cpixClean;  // pixels restored from the background buffers
+    ulong dtusClean; // restoring the working buffers
+    ulong dtusScene; // BrZbSceneRender
+    ulong dtusUnion; // building the dirty regions
+};
+
+// Most threads a BWLD restores its working buffers on
+const long kcthRenderMax = 8;
+
+// Restore job: the background buffers to copy from and the working
+// buffers to copy to.  The pointers are to pixel (0, 0) of each buffer.
+struct RSJ
+{
+    byte *pbZSrc;
+    byte *pbZDst;
+    byte *pbSrc;
+    byte *pbDst;
+    long cbRowZSrc;
+    long cbRowZDst;
+    long cbRowSrc;
+    long cbRowDst;
+};
+
+// A horizontal band of the working buffers and the thread that restores it
+struct RBND
+{
+    PBWLD pbwld;
+    RC rc;       // the band, in _rcBuffer's coordinates
+    bool fScan;  // whether regsc scans the dirty region, or all of rc is dirty
+    REGSC regsc; // the dirty region within rc
+    long cpix;   // pixels restored by the last Render
+#ifdef WIN
+    HANDLE hevtGo;   // set to start restoring the band
+    HANDLE hevtDone; // set by the thread when the band is restored
+    HANDLE hth;
+#endif // WIN
+};
+
 /****************************************
     The BRender world class
 ****************************************/
-typedef class BWLD *PBWLD;
 #define BWLD_PAR BASE
 #define kclsBWLD 'BWLD'
 class BWLD : public BWLD_PAR
@@ -65,14 +108,26 @@ class BWLD : public BWLD_PAR
     CNO _cnoRGB;
     CTG _ctgZ;
     CNO _cnoZ;
+    BWCT _bwct; // render phase counters
+    // Bands of the working buffers restored in parallel by Render.  Band 0
+    // is restored by the rendering thread, the rest by their own threads.
+    long _crbnd;
+    RBND _rgrbnd[kcthRenderMax];
+    RSJ _rsj;         // what the band threads are restoring
+    bool _fStopBands; // tells the band threads to exit
 
   protected:
     BWLD(void)
     {
     }
-    bool _FInit(long dxp, long dyp, bool fHalfX, bool fHalfY);
+    bool _FInit(long dxp, long dyp, bool fHalfX, bool fHalfY, long cthRender);
     bool _FInitBuffers(long dxp, long dyp, bool fHalfX, bool fHalfY);
     void _CleanWorkingBuffers(void);
+    void _StopBands(void);
+    static long _CpixRestore(RSJ *prsj, RBND *prbnd);
+#ifdef WIN
+    static ulong __stdcall _LuBandThread(void *pv);
+#endif // WIN
     static int BR_CALLBACK _FFilter(BACT *pbact, PBMDL pbmdl, PBMTL pbmtl, BVEC3 *pbvec3RayPos, BVEC3 *pbvec3RayDir,
                                     BRS dzpNear, BRS dzpFar, void *pbwld);
     static void BR_CALLBACK _ActorRendered(PBACT pbact, PBMDL pbmdl, PBMTL pbmtl, br_uint_8 bStyle,
@@ -80,7 +135,7 @@ class BWLD : public BWLD_PAR
 
   public:
     // Constructors and destructors
-    static PBWLD PbwldNew(long dxp, long dyp, bool fHalfX = fFalse, bool fhalfY = fFalse);
+    static PBWLD PbwldNew(long dxp, long dyp, bool fHalfX = fFalse, bool fhalfY = fFalse, long cthRender = 1);
     ~BWLD();
     static void CloseBRender(void);
 
@@ -123,14 +178,24 @@ class BWLD : public BWLD_PAR
     {
         return _fHalfY;
     }
+    void SetCthRender(long cthRender);
+    long CthRender(void)
+    {
+        return _crbnd;
+    }
     void Render(void);
     void Prerender(void);
     void Unprerender(void);
     void Draw(PGNV pgnv, RC *prcClip, long dxp, long dyp);
-
-#ifdef DEBUG
+    void GetBwct(BWCT *pbwct)
+    {
+        *pbwct = _bwct;
+    }
+    void ResetBwct(void)
+    {
+        ClearPb(&_bwct, size(BWCT));
+    }
     bool FWriteBmp(PFNI pfni);
-#endif // DEBUG
 };
 
 #endif BWLD_H
@@ -56,6 +56,7 @@ class TMAP : public TMAP_PAR
     BPMP _bpmp;
     bool _fImported; // if fTrue, BRender allocated the pixels
                      // if fFalse, we allocated the pixels
+    PFIL _pfilMap;   // if not nil, the pixels are in this mapped file
   protected:
     TMAP(void)
     {
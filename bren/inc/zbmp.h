@@ -43,6 +43,7 @@ class ZBMP : public ZBMP_PAR
     long _cbRow; // bytes per row
     long _cb;    // count of bytes in Z buffer
     byte *_prgb; // Z buffer
+    PFIL _pfilMap; // if not nil, _prgb points into this mapped file
     ZBMP(void)
     {
     }
@@ -62,6 +63,10 @@ class ZBMP : public ZBMP_PAR
     {
         return _cbRow;
     }
+    void GetRc(RC *prc)
+    {
+        *prc = _rc;
+    }
 
     void Draw(byte *prgbPixels, long cbRow, long dyp, long xpRef, long ypRef, RC *prcClip = pvNil,
               PREGN pregnClip = pvNil);
@@ -37,13 +37,15 @@ bool TMAP::FReadTmap(PCRF pcrf, CTG ctg, CNO cno, PBLCK pblck, PBACO *ppbaco, lo
 }
 
 /***************************************************************************
-    Read a TMAP from a chunk
+    Read a TMAP from a chunk. If the chunk is in a memory mapped file, the
+    pixels are referenced in place.
 ***************************************************************************/
 PTMAP TMAP::PtmapRead(PCFL pcfl, CTG ctg, CNO cno)
 {
     TMAPF tmapf;
     BLCK blck;
     TMAP *ptmap;
+    byte *pbMap;
 
     ptmap = NewObj TMAP;
     if (pvNil == ptmap)
@@ -59,7 +61,12 @@ PTMAP TMAP::PtmapRead(PCFL pcfl, CTG ctg, CNO cno)
     Assert(kboCur == tmapf.bo, "bad TMAPF");
 
     ptmap->_bpmp.identifier = (char *)ptmap; // to get TMAP from a (BPMP *)
-    if (!FAllocPv((void **)&ptmap->_bpmp.pixels, LwMul(tmapf.cbRow, tmapf.dyp), fmemClear, mprNormal))
+    if (blck.Cb() >= size(TMAPF) + LwMul(tmapf.cbRow, tmapf.dyp) &&
+        pvNil != (pbMap = (byte *)blck.PvMapped(&ptmap->_pfilMap)))
+    {
+        ptmap->_bpmp.pixels = pbMap + size(TMAPF);
+    }
+    else if (!FAllocPv((void **)&ptmap->_bpmp.pixels, LwMul(tmapf.cbRow, tmapf.dyp), fmemClear, mprNormal))
     {
         goto LFail;
     }
@@ -74,7 +81,8 @@ PTMAP TMAP::PtmapRead(PCFL pcfl, CTG ctg, CNO cno)
     ptmap->_bpmp.origin_x = tmapf.xpOrigin;
     ptmap->_bpmp.origin_y = tmapf.ypOrigin;
 
-    if (!blck.FReadRgb(ptmap->_bpmp.pixels, LwMul(tmapf.cbRow, tmapf.dyp), size(TMAPF)))
+    if (pvNil == ptmap->_pfilMap &&
+        !blck.FReadRgb(ptmap->_bpmp.pixels, LwMul(tmapf.cbRow, tmapf.dyp), size(TMAPF)))
     {
         goto LFail;
     }
@@ -111,8 +119,9 @@ TMAP::~TMAP(void)
         // REVIEW *****: this crashes BRender...why?
         //		BrMemFree(_bpmp.pixels);
     }
-    else
+    else if (pvNil == _pfilMap)
         FreePpv((void **)&_bpmp.pixels);
+    ReleasePpo(&_pfilMap);
 }
 
 /***************************************************************************
@@ -449,6 +458,7 @@ void TMAP::AssertValid(ulong grf)
     TMAP_PAR::AssertValid(fobjAllocated);
     if (!_fImported)
         AssertPvCb(_bpmp.pixels, LwMul(_bpmp.row_bytes, _bpmp.height));
+    AssertNilOrPo(_pfilMap, 0);
 }
 
 /***************************************************************************
@@ -458,7 +468,7 @@ void TMAP::MarkMem(void)
 {
     AssertThis(0);
     TMAP_PAR::MarkMem();
-    if (!_fImported)
+    if (!_fImported && pvNil == _pfilMap)
         MarkPv(_bpmp.pixels);
 }
 #endif // DEBUG
@@ -88,7 +88,8 @@ bool ZBMP::FReadZbmp(PCRF pcrf, CTG ctg, CNO cno, PBLCK pblck, PBACO *ppbaco, lo
 }
 
 /***************************************************************************
-    Read a ZBMP from a BLCK.
+    Read a ZBMP from a BLCK. If the block is in a memory mapped file, the
+    Z buffer references the data in place.
 ***************************************************************************/
 PZBMP ZBMP::PzbmpRead(PBLCK pblck)
 {
@@ -96,6 +97,7 @@ PZBMP ZBMP::PzbmpRead(PBLCK pblck)
 
     PZBMP pzbmp;
     ZBMPF zbmpf;
+    byte *pbMap;
 
     if (!pblck->FUnpackData())
         return pvNil;
@@ -112,6 +114,12 @@ PZBMP ZBMP::PzbmpRead(PBLCK pblck)
     pzbmp->_cb = LwMul(pzbmp->_rc.Dyp(), pzbmp->_cbRow);
     if (pblck->Cb() != size(ZBMPF) + pzbmp->_cb)
         goto LFail;
+    if (pvNil != (pbMap = (byte *)pblck->PvMapped(&pzbmp->_pfilMap)))
+    {
+        pzbmp->_prgb = pbMap + size(ZBMPF);
+        AssertPo(pzbmp, 0);
+        return pzbmp;
+    }
     if (!FAllocPv((void **)&pzbmp->_prgb, pzbmp->_cb, fmemNil, mprNormal))
         goto LFail;
     if (!pblck->FReadRgb(pzbmp->_prgb, pzbmp->_cb, size(ZBMPF)))
@@ -131,7 +139,9 @@ LFail:
 ZBMP::~ZBMP(void)
 {
     AssertBaseThis(0);
-    FreePpv((void **)&_prgb);
+    if (pvNil == _pfilMap)
+        FreePpv((void **)&_prgb);
+    ReleasePpo(&_pfilMap);
 }
 
 /***************************************************************************
@@ -176,6 +186,15 @@ void ZBMP::Draw(byte *prgbPixels, long cbRow, long dyp, long xpRef, long ypRef,
         regsc.Init(pregnClip, &rcClippedRegnBounds);
     }
 
+    if (pvNil == pregnClip && rcClippedRegnBounds.xpLeft == 0 &&
+        LwMul(kcbPixelZbmp, rcClippedRegnBounds.xpRight) == _cbRow && cbRow == _cbRow)
+    {
+        // whole rows are contiguous, so copy them as one block
+        yp = rcClippedRegnBounds.ypTop;
+        CopyPb(_prgb + LwMul(yp, _cbRow), prgbPixels + LwMul(yp, cbRow), LwMul(rcClippedRegnBounds.Dyp(), _cbRow));
+        return;
+    }
+
     for (yp = rcClippedRegnBounds.ypTop; yp < rcClippedRegnBounds.ypBottom; yp++)
     {
         while (regsc.XpCur() < klwMax)
@@ -293,6 +312,7 @@ void ZBMP::AssertValid(ulong grf)
 {
     ZBMP_PAR::AssertValid(fobjAllocated);
     AssertPvCb(_prgb, _cb);
+    AssertNilOrPo(_pfilMap, 0);
     Assert(_cbRow == LwMul(_rc.Dxp(), kcbPixelZbmp), "bad _cbRow");
     Assert(_cb == LwMul(_rc.Dyp(), _cbRow), "bad _cb");
 }
@@ -304,6 +324,7 @@ void ZBMP::MarkMem(void)
 {
     AssertThis(0);
     ZBMP_PAR::MarkMem();
-    MarkPv(_prgb);
+    if (pvNil == _pfilMap)
+        MarkPv(_prgb);
 }
 #endif // DEBUG
@@ -54,6 +54,23 @@ struct RPT
 };
 const BOM kbomRpt = 0xff000000;
 
+//
+//	An undo snapshot can be turned into a delta against a base actor
+//	(ACTR::FMakeDelta).  It then keeps only the events and route points
+//	between the leading and trailing runs it shares with the base; the runs
+//	are copied back from the base when the snapshot is needed again.
+//
+struct ADLT
+{
+    long caevHead; // Events shared with the start of the base
+    long caevTail; // Events shared with the end of the base
+    long crptHead; // Route points shared with the start of the base
+    long crptTail; // Route points shared with the end of the base
+    long caevBase; // Event count of the base
+    long crptBase; // Route point count of the base
+    ulong luCheck; // Checksum of the base's shared runs
+};
+
 const long knfrmInvalid = klwMax;                                  // invalid frame state.  Regenerate correct state
 const long kcrptGrow = 32;                                         // quantum growth for rpt
 const long kcsmmGrow = 2;                                          // quantum growth for smm
@@ -310,6 +327,41 @@ struct SMM
     AEVSND aevsnd;
 };
 
+//
+// Actor state snapshot, taken every kdnfrmAkf frames as the actor plays.
+// FGotoFrame resumes from the nearest snapshot rather than replaying every
+// frame from the subroute's add event.  Any edit to the actor invalidates
+// all of its snapshots.
+// The variable part of the gg holds the SMMs current at the snapshot.
+// Not to be saved with a movie
+//
+struct AKF
+{
+    long nfrm;   // Frame the snapshot was taken at
+    PCOST pcost; // Body costume
+
+    // The frame dependent ACTR state variables of the same names
+    XYZ dxyzRte;
+    XYZ dxyzSubRte;
+    XYZ xyzCur;
+    RTEL rtelCur;
+    XFRM xfrm;
+    BRS dwrStep;
+    ulong grfactn;
+    long anidCur;
+    long ccelCur;
+    long celnCur;
+    long iaevCur;
+    long iaevFrmMin;
+    long iaevActnCur;
+    long iaevAddCur;
+    bool fOnStage;
+    bool fFrozen;
+    bool fUseBmat34Cur;
+};
+
+const long kdnfrmAkf = 32; // frames between actor state snapshots
+
 //
 // Default hilite colors
 //
@@ -335,6 +387,7 @@ class ACTR : public ACTR_PAR
     // Note: _tagTmpl cannot be derived from _ptmpl
     PGG _pggaev;      // GG pointer to Actor EVent list
     PGL _pglrpt;      // GL pointer to actor's route
+    HQ _hqRte;        // Compact route from file, not yet decoded into _pglrpt
     TMPL *_ptmpl;     // Actor body & action list template
     BODY *_pbody;     // Actor's body
     TAG _tagTmpl;     // Note: The sid cannot be queried at save time
@@ -367,6 +420,10 @@ class ACTR : public ACTR_PAR
     XYZ _xyzCur;             // Last point displayed (may be tweak modified)
     XFRM _xfrm;              // Current transformation
     PGL _pglsmm;             // Current action motion match sounds
+    PGG _pggakf;             // State snapshots, sorted by frame (may be nil)
+    bool _fNoAkf : 1;        // Don't seek using snapshots (for benchmarking)
+    bool _fDelta : 1;        // Undo snapshot holding only a delta (see ADLT)
+    ADLT _adlt;              // Runs shared with the base, if _fDelta
 
     // Path Recording State Information
     RTEL _rtelInsert;        // Joining information
@@ -391,6 +448,10 @@ class ACTR : public ACTR_PAR
     void _SetStateRewound(void);
 
     bool _FQuickBackupToFrm(long nfrm, bool *pfQuickMethodValid);
+    bool _FFindAkf(long nfrm, long *piakf);
+    void _SaveAkf(void);
+    bool _FRestoreAkf(long iakf);
+    void _InvalAkf(void);
     bool _FGetRtelBack(RTEL *prtel, bool fUpdateStateVar);
     bool _FDoFrm(bool fPositionBody, bool *pfPositionDirty, bool *pfSoundInFrame = pvNil);
     bool _FGetStatic(long anid, bool *pfStatic);
@@ -451,11 +512,15 @@ class ACTR : public ACTR_PAR
 
     void _RestoreFromUndo(PACTR pactrRestore);
     bool _FDupCopy(PACTR pactrSrc, PACTR pactrDest);
+    static bool _FEqualAev(PGG pggaev1, long iaev1, PGG pggaev2, long iaev2);
+    static ulong _LuCheckRuns(PACTR pactrBase, ADLT *padlt);
 
     bool _FWriteTmpl(PCFL pcfl, CNO cno);
     bool _FReadActor(PCFL pcfl, CNO cno);
     bool _FReadRoute(PCFL pcfl, CNO cno);
     bool _FReadEvents(PCFL pcfl, CNO cno);
+    bool _FEnsureRte(void);
+    static PGG _PggaevRead(PBLCK pblck);
     static void _SwapBytesPggaev(PGG pggaev);
     bool _FOpenTags(PCRF pcrf);
     static bool _FIsIaevTag(PGG pggaev, long iaev, PTAG *pptag, PAEV *pqaev = pvNil);
@@ -486,6 +551,10 @@ class ACTR : public ACTR_PAR
     bool FWrite(PCFL pcfl, CNO cno, CNO cnoScene); // Write to a document
     static PGL PgltagFetch(PCFL pcfl, CNO cno, bool *pfError);
     static bool FAdjustAridOnFile(PCFL pcfl, CNO cno, long darid);
+#ifdef DEBUG
+    static bool FBenchLoad(PCFL pcfl, long cact, long *pcactr, long *pcbOld, long *pcbNew, ulong *pdtsOld,
+                           ulong *pdtsNew);
+#endif // DEBUG
 
     // Visibility
     void Hilite(void);
@@ -617,6 +686,9 @@ class ACTR : public ACTR_PAR
     // Animation
     bool FGotoFrame(long nfrm, bool *pfSoundInFrame = pvNil); // Prepare for display at frame nfrm
     bool FReplayFrame(long grfscen);                          // Replay a frame.
+#ifdef DEBUG
+    static bool FBenchSeek(PSCEN pscen, PTAG ptagTmpl, long cfrm, long cseek, ulong *pdtsAkf, ulong *pdtsReplay);
+#endif // DEBUG
 
     // Event Editing
     bool FAddOnStageCore(void);
@@ -636,6 +708,13 @@ class ACTR : public ACTR_PAR
     // ActrEdit Routines
     bool FDup(PACTR *ppactr, bool fReset = fFalse); // Duplicate everything
     void Restore(PACTR pactr);
+    bool FMakeDelta(PACTR pactrBase);  // Keep only what differs from pactrBase
+    bool FApplyDelta(PACTR pactrBase); // Rebuild a delta from pactrBase
+    bool FDelta(void)
+    {
+        return _fDelta;
+    }
+    long CbMem(void); // Memory held by the actor's groups
 
     bool FCreateUndo(PACTR pactr, bool fSndUndo = fFalse, PSTN pstn = pvNil); // Create undo object
     void Reset(void);
@@ -290,6 +290,65 @@ struct THD
                    // retrieve proper STN for the BRWN-derived browsers)
 };
 
+/* Thumbnail Index Entry -- what one thumbnail file contributed to one BCL
+    query, as of the file's last modification time.  The variable part of
+    the entry holds the file's path, then cthd THDs, then (if the query
+    wanted names) one STN per THD, as written by STN::GetData. */
+struct TIXE
+{
+    CTG ctgRoot;
+    CNO cnoRoot;
+    CTG ctgContent;
+    long fNames;
+    ulong tim;   // modification time of the file
+    long cbPath; // bytes of path at the start of the entry
+    long cthd;   // number of THDs following the path
+    long cbNames;
+    long fUsed; // seen during the current build (not meaningful on disk)
+};
+
+/* Thumbnail Index -- a persistent record, kept in the users directory, of
+    the THDs each thumbnail file yields for each query.  Files that haven't
+    changed since they were indexed aren't walked again, and files with
+    nothing for a query aren't even opened. */
+#define TIDX_PAR BASE
+typedef class TIDX *PTIDX;
+#define kclsTIDX 'TIDX'
+class TIDX : public TIDX_PAR
+{
+    RTCLASS_DEC
+    ASSERT
+    MARKMEM
+
+  protected:
+    PGG _pggtixe; // TIXEs sorted by query, then path
+    bool _fDirty;
+
+  protected:
+    TIDX(void)
+    {
+        _pggtixe = pvNil;
+        _fDirty = fFalse;
+    }
+    ~TIDX(void)
+    {
+        ReleasePpo(&_pggtixe);
+    }
+
+    static bool _FGetFni(FNI *pfni);
+    bool _FFind(TIXE *ptixe, PSTN pstnPath, long *pitixe);
+
+  public:
+    static PTIDX PtidxRead(void);
+    bool FSave(void);
+
+    bool FLookup(TIXE *ptixe, PSTN pstnPath, long *pitixe);
+    long Cthd(long itixe);
+    bool FGetThds(long itixe, long sid, PGL pglthd, PGST pgst);
+    bool FPutThds(TIXE *ptixe, PSTN pstnPath, PGL pglthd, long ithdMin, PGST pgst, long istnMin);
+    void PruneUnused(TIXE *ptixe);
+};
+
 /* Browser Content List Base --  create one of these when you want a list of a
     specific kind of content and you don't care about the names. */
 #define BCL_PAR BASE
@@ -324,6 +383,10 @@ class BCL : public BCL_PAR
     bool _FBuildThd(PCRM pcrm);
 
     virtual bool _FAddGokdToThd(PCFL pcfl, long sid, KID *pkid);
+    virtual PGST _PgstNames(void)
+    {
+        return pvNil;
+    }
 
   public:
     static PBCL PbclNew(PCRM pcrm, CKI *pckiRoot, CTG ctgContent, PGL pglthd = pvNil, bool fOnlineOnly = fFalse);
@@ -370,6 +433,10 @@ class BCLS : public BCLS_PAR
     bool _FSetNameGst(PCFL pcfl, CTG ctg, CNO cno);
 
     virtual bool _FAddGokdToThd(PCFL pcfl, long sid, KID *pkid);
+    virtual PGST _PgstNames(void)
+    {
+        return _pgst;
+    }
 
   public:
     static PBCLS PbclsNew(PCRM pcrm, CKI *pckiRoot, CTG ctgContent, PGL pglthd = pvNil, PGST pgst = pvNil,
@@ -43,7 +43,8 @@ class MODL : public MODL_PAR
     MARKMEM
 
   protected:
-    BMDL *_pbmdl; // BRender model data
+    BMDL *_pbmdl;  // BRender model data
+    PFIL _pfilMap; // if not nil, prepared data is in this mapped file
   protected:
     MODL(void)
     {
@@ -538,6 +538,20 @@ typedef struct _cmvi
 //
 
 const long kccamMax = 9;
+const long kcundbMaxMvie = 64;          // Undo levels a movie keeps
+const long kcbUndoMaxMvie = 0x00400000; // Memory the undo levels may hold before the oldest go
+
+//
+// Undo memory counters
+//
+struct UNCT
+{
+    long cundb;      // Levels held, undo and redo
+    long cbTot;      // Memory held by all levels
+    long cbLevelMax; // Memory held by the largest level
+    long cbPeak;     // Largest cbTot since the counters were reset
+    long cundbTrim;  // Levels dropped to stay under the memory limit
+};
 
 typedef class MVIE *PMVIE;
 
@@ -598,19 +612,27 @@ class MVIE : public MVIE_PAR
 
     PGL _pglclrThumbPalette; // Palette to use for thumbnail rendering.
 
+    long _cbUndoMax;  // Memory the undo levels may hold
+    long _cbUndoPeak; // Most memory the undo levels have held
+    long _cundbTrim;  // Undo levels dropped to stay under _cbUndoMax
+
   private:
     MVIE(void);
     PTAGL _PtaglFetch(void);                      // Returns a list of all tags used in movie
     bool _FCloseCurrentScene(void);               // Closes and releases current scene, if any
+    void _PrefetchScen(long iscen);               // Queues a scene's content to be read ahead
     bool _FMakeCrfValid(void);                    // Makes sure there is a file to work with.
     bool _FUseTempFile(void);                     // Switches to using a temp file.
     void _MoveChids(CHID chid, bool fDown);       // Move the chids of scenes in the movie.
     bool _FDoGarbageCollection(PCFL pcfl);        // Remove unused chunks from movie.
+    void _PackEventChunks(PCFL pcfl);             // Compress event and path chunks before a save
     void _DoSndGarbageCollection(bool fPurgeAll); // Remove unused user sounds from movie
     bool _FDoMtrlTmplGC(PCFL pcfl);               // Material and template garbage collection
     CHID _ChidScenNewSnd(void);                   // Choose an unused chid for a new scene child user sound
     CHID _ChidMvieNewSnd(void);                   // Choose an unused chid for a new movie child user sound
     void _SetTitle(PFNI pfni = pvNil);            // Set the title of the movie based on given file name.
+    long _CbUndo(long *pcbLevelMax = pvNil);      // Memory held by the undo levels
+    void _TrimUndo(void);                         // Drop the oldest undo levels to fit in _cbUndoMax
     bool _FIsChild(PCFL pcfl, CTG ctg, CNO cno);
     bool _FSetPfilSave(PFNI pfni);
 
@@ -632,6 +654,9 @@ class MVIE : public MVIE_PAR
     }
 #endif // DEBUG
 
+    // Render scenes to bitmaps, without the clock
+    bool FWriteFrames(PFNI pfniDir, long iscenFirst, long iscenLim, long *pcfrm);
+
     //
     // Getting views
     //
@@ -901,6 +926,14 @@ class MVIE : public MVIE_PAR
     bool FAddUndo(PMUNB pmunb); // Add an item to the undo list
     void ClearUndo(void);
 
+    //
+    // Undo memory
+    //
+    void SetCbUndoMax(long cbUndoMax); // Memory the undo levels may hold
+    long CbUndoLevel(long iundb);      // Memory held by one undo level
+    void GetUnct(UNCT *punct);
+    void ResetUnct(void);
+
     //
     // Accessors for MVUs only.
     //
@@ -63,6 +63,9 @@ class SUNA : public SUNA_PAR
 
     virtual bool FDo(PDOCB pdocb);
     virtual bool FUndo(PDOCB pdocb);
+    virtual long CbMem(void);
+    virtual PACTR PactrUndo(void);
+    virtual void Bury(PMUNB pmunbNext);
 };
 
 //
@@ -133,6 +136,7 @@ class SCEN : public SCEN_PAR
     //
     PGG _pggsevFrm;   // List of events that occur in frames.
     long _isevFrmLim; // Next event to process.
+    PGL _pglsevx;     // Per event skip list into _pggsevFrm (pvNil when stale).
 
     //
     // Global information
@@ -166,6 +170,13 @@ class SCEN : public SCEN_PAR
     bool _FAddSev(PSEV psev, long cbVar, void *pvVar);     // Adds scene event to the current frame.
     void _MoveBackFirstFrame(long nfrm);
 
+    //
+    // Event index stuff
+    //
+    bool _FEnsureSevx(void);                                   // Builds _pglsevx if it is stale.
+    void _InvalSevx(void);                                     // Marks _pglsevx stale.
+    long _IsevFirstFrm(long nfrm, long isevMin, long isevLim); // First sev at or after nfrm.
+
     //
     // Dirtying stuff
     //
@@ -96,8 +96,10 @@
 #define kftgChunky MacWin('chnk', 'CHK')
 #define kftgContent MacWin('3con', '3CN')
 #define kftgThumbDesc MacWin('3thd', '3TH')
+#define kftgThumbIndex MacWin('3thx', '3TX')
 #define kftg3mm MacWin('3mm', '3MM')
 #define kftgSocTemp MacWin('3tmp', '3TP')
+#define kftgTagCache MacWin('3tgc', '3TC')
 
 #define ksz3mm PszLit("3mm")
 
@@ -79,6 +79,21 @@ class MUNB : public MUNB_PAR
     {
         return _nfrm;
     }
+
+    // Undo list bookkeeping.  CbMem is roughly the memory the undo holds.
+    // PactrUndo is the whole actor this undo puts back, if any.  Bury is
+    // called when pmunbNext is pushed on top of this undo.
+    virtual long CbMem(void)
+    {
+        return size(MUNB);
+    }
+    virtual PACTR PactrUndo(void)
+    {
+        return pvNil;
+    }
+    virtual void Bury(PMUNB pmunbNext)
+    {
+    }
 };
 
 //
@@ -142,6 +157,9 @@ class AUND : public AUND_PAR
 
     virtual bool FDo(PDOCB pdocb);
     virtual bool FUndo(PDOCB pdocb);
+    virtual long CbMem(void);
+    virtual PACTR PactrUndo(void);
+    virtual void Bury(PMUNB pmunbNext);
 };
 
 //
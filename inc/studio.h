@@ -126,6 +126,12 @@ class STDIO : public STDIO_PAR
 
 #ifdef DEBUG
     bool FCmdWriteBmps(PCMD pcmd);
+    bool FCmdBenchSeek(PCMD pcmd);
+    bool FCmdBenchRender(PCMD pcmd);
+    bool FCmdBenchLoad(PCMD pcmd);
+    bool FCmdCmdStats(PCMD pcmd);
+    bool FCmdScriptProfile(PCMD pcmd);
+    bool FCmdUndoStats(PCMD pcmd);
 #endif // DEBUG
 
     //
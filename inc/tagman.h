@@ -31,6 +31,13 @@
     HD copy is used.  This reduces headaches about dealing with a missing
     CD all over the place.
 
+    The HD cache is a directory of chunky files, one per source file,
+    named for the source's sid, path and modification time.  A changed
+    source file gets a new cache file rather than a stale one.  Cache
+    files outlive the session, are checked against the source file's
+    index when first opened, and the least recently used ones are
+    deleted when the directory grows past kcbCacheHDMax.
+
     If a tag has ksidUseCrf for its sid, the chunk is read from the tag's
     pcrf rather than a source or a source's cache.  Use this
     functionality for things like content chunks embedded in user
@@ -70,10 +77,12 @@ typedef FNINSCD *PFNINSCD;
 enum
 {
     ftagmNil = 0x0000,
-    ftagmFile = 0x0001,   // for ClearCache: clear HD cache
+    ftagmFile = 0x0001,   // for ClearCache: save and trim HD cache
     ftagmMemory = 0x0002, // for ClearCache: clear CRF RAM cache
 };
 
+const long kcbCacheHDMax = 0x04000000; // HD cache directory size bound
+
 /****************************************
     Tag Manager class
 ****************************************/
@@ -92,6 +101,8 @@ class TAGM : public TAGM_PAR
     PGL _pglsfs;        // GL of source file structs
     PGST _pgstSource;   // String table of source descriptions
     PFNINSCD _pfninscd; // Function to call when source is not found
+    PGL _pgltcf;        // GL of HD cache files
+    FNI _fniCache;      // HD cache directory (nil until first needed)
 
   protected:
     TAGM(void)
@@ -114,6 +125,14 @@ class TAGM : public TAGM_PAR
     PCRM _PcrmSourceGet(long sid, bool fDontHitCD = fFalse);
     PCFL _PcflFindTag(PTAG ptag);
 
+    bool _FUseCacheHD(long sid, bool *pfUseCache);
+    bool _FEnsureCacheDir(void);
+    bool _FGetFniCache(long sid, PCFL pcflSource, PFNI pfni);
+    PCRF _PcrfCacheGet(long sid, PCFL pcflSource, bool fCreate, long *pitcf);
+    bool _FCacheChunk(long itcf, CTG ctg, CNO cno, bool fCacheChildChunks);
+    void _SaveCacheHD(long sid);
+    void _TrimCacheHD(void);
+
   public:
     static PTAGM PtagmNew(PFNI pfniHDRoot, PFNINSCD pfninscd, long cbCache);
     ~TAGM(void);
@@ -130,6 +149,7 @@ class TAGM : public TAGM_PAR
     bool FBuildChildTag(PTAG ptagPar, CHID chid, CTG ctgChild, PTAG ptagChild);
     bool FCacheTagToHD(PTAG ptag, bool fCacheChildChunks = fTrue);
     PBACO PbacoFetch(PTAG ptag, PFNRPO pfnrpo, bool fUseCD = fFalse);
+    void PrefetchTag(PTAG ptag, bool fPrefetchChildren = fTrue, long crep = crepNormal);
     void ClearCache(long sid = sidNil,
                     ulong grftagm = ftagmFile | ftagmMemory); // sidNil clears all caches
 
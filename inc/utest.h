@@ -101,7 +101,8 @@ class APP : public APP_PAR
         _fMainWindowCreated : 1, _fMinimized : 1,
         _fRunInWindow : 1, // run in a window (as opposed to fullscreen)
         _fFontError : 1,   // Have we already seen a font error?
-        _fInPortfolio : 1; // Is the portfolio active?
+        _fInPortfolio : 1, // Is the portfolio active?
+        _fRender : 1;      // "/R" command-line switch: render the movie and quit
     PCEX _pcex;            // Pointer to suspended cex.
     FNI _fniPortfolioDoc;  // document last opened in portfolio
     PMVIE _pmvieHandoff;   // Stores movie for studio to use
@@ -125,6 +126,12 @@ class APP : public APP_PAR
     FNI _fni3DMovieDir; // e.g., \mskids\3dMovie
     long _dypTextDef;   // Default text height
 
+    // batch rendering
+    FNI _fniRender;         // "/R": directory to render the movie's frames into
+    long _cprocRender;      // "/J": number of processes to render with
+    long _iscenFirstRender; // "/C": first scene to render
+    long _iscenLimRender;   // "/C": scene after the last one to render, 0 for all
+
     long _cactDisable; // disable count for keyboard accelerators
 #ifdef BUG1085
     long _cactCursHide; // hide count for cursor
@@ -187,6 +194,8 @@ class APP : public APP_PAR
     bool _FDisplayIs640480(void);
     bool _FShowSplashScreen(void);
     bool _FPlaySplashSound(void);
+    bool _FRenderMovie(void);
+    bool _FRenderProcs(PFNI pfniMovie, long iscenFirst, long iscenLim);
     PMVIE _Pmvie(void);
     void _CleanupTemp(void);
 #ifdef WIN
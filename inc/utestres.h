@@ -55,6 +55,12 @@
 #define cidHelpBook 40040
 #define cidToggleXY 40041
 #define cidMap 40042
+#define cidBenchSeek 40045
+#define cidBenchRender 40046
+#define cidCmdStats 40047
+#define cidScriptProfile 40048
+#define cidUndoStats 40049
+#define cidBenchLoad 40050
 #define IDC_STATIC -1
 
 // Next default values for new objects
@@ -62,7 +68,7 @@
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE 226
-#define _APS_NEXT_COMMAND_VALUE 40045
+#define _APS_NEXT_COMMAND_VALUE 40051
 #define _APS_NEXT_CONTROL_VALUE 1026
 #define _APS_NEXT_SYMED_VALUE 128
 #endif
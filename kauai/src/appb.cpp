@@ -693,6 +693,8 @@ void APPB::_CleanUp(void)
 #endif // WIN
 
     GOB::ShutDown();
+    SCEB::FreeProfile();
+    vcrpqUtil.ShutDown();
     FIL::ShutDown();
 #ifdef WIN
     _ShutDownViewer();
@@ -1758,6 +1760,7 @@ void APPB::MarkMem(void)
     }
 
     GPT::MarkStaticMem();
+    REGN::MarkScratch();
     CLOK::MarkAllCloks();
     if ((pgob = GOB::PgobScreen()) != pvNil)
         pgob->MarkGobTree();
@@ -42,6 +42,7 @@ struct WIG
     HACCEL haccel;       // main accelerator table
     HWND hwndNextViewer; // next clipboard viewer
     long lwThreadMain;   // main thread
+    int wExitCode;       // returned by WinMain
 };
 extern WIG vwig;
 #endif // WIN
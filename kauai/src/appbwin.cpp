@@ -34,7 +34,7 @@ int WINAPI WinMain(HINSTANCE hinst, HINSTANCE hinstPrev, LPSTR pszs, int wShow)
     APPB::CreateConsole();
 #endif
     FrameMain();
-    return 0;
+    return vwig.wExitCode;
 }
 
 /*
@@ -800,6 +800,7 @@ STDAPI AllocFaderFilter(LPSOUND FAR *ppSound, LPSOUND pSoundSrc, DWORD dwFadeTim
 STDAPI AllocScheduleFilter(LPSOUND FAR *ppSound, LPSCHEDULERCONFIG pSchedulerConfig);
 STDAPI AllocRandomizeFilter(LPSOUND FAR *ppSound, LPRANDOMIZECONFIG pRandomizeConfig);
 STDAPI AllocWaveOut(LPWAVEOUT FAR *ppWaveOut, LPMIXER pMixer);
+STDAPI AllocFileWaveOut(LPWAVEOUT FAR *ppWaveOut, char FAR *pszFile, BOOL fRealTime);
 
 STDAPI_(DWORD) TimeToSamples(LPSOUND pSound, DWORD dwTime);
 STDAPI_(DWORD) SamplesToTime(LPSOUND pSound, DWORD dwSamples);
@@ -73,6 +73,7 @@ CHCM::CHCM(void)
     _pcfl = pvNil;
     _pchlx = pvNil;
     _pglckiLoner = pvNil;
+    _pglckiPack = pvNil;
     _pmsnkError = pvNil;
     _cactError = 0;
     AssertThis(0);
@@ -90,13 +91,16 @@ CHCM::~CHCM(void)
         while (_pglcsfc->FPop(&csfc))
         {
             ReleasePpo(&_pcfl);
+            ReleasePpo(&_pglckiPack);
             _pcfl = csfc.pcfl;
+            _pglckiPack = csfc.pglckiPack;
         }
         ReleasePpo(&_pglcsfc);
     }
     ReleasePpo(&_pcfl);
     ReleasePpo(&_pchlx);
     ReleasePpo(&_pglckiLoner);
+    ReleasePpo(&_pglckiPack);
 }
 
 #ifdef DEBUG
@@ -110,6 +114,7 @@ void CHCM::AssertValid(ulong grf)
     AssertPo(&_bsf, 0);
     AssertNilOrPo(_pchlx, 0);
     AssertNilOrPo(_pglckiLoner, 0);
+    AssertNilOrPo(_pglckiPack, 0);
     AssertNilOrPo(_pmsnkError, 0);
 }
 
@@ -126,6 +131,7 @@ void CHCM::MarkMem(void)
     MarkMemObj(&_bsf);
     MarkMemObj(_pchlx);
     MarkMemObj(_pglckiLoner);
+    MarkMemObj(_pglckiPack);
 }
 #endif // DEBUG
 
@@ -684,15 +690,39 @@ bool CHCM::_FEndWrite(bool fPack, CTG ctg, CNO cno, PBLCK pblck)
 
     if (fPack)
     {
-        // we don't fail if we can't compress it
-        pblck->FPackData();
-        return _pcfl->FPutBlck(pblck, ctg, cno);
+        CKI cki;
+
+        // the data is packed along with the other chunks in the sub file
+        // by _PackPending - we don't fail if we can't compress it
+        if (!_pcfl->FPutBlck(pblck, ctg, cno))
+            return fFalse;
+        if (pvNil == _pglckiPack && pvNil == (_pglckiPack = GL::PglNew(size(CKI))))
+            return fFalse;
+        cki.ctg = ctg;
+        cki.cno = cno;
+        return _pglckiPack->FAdd(&cki);
     }
 
     AssertPo(pblck, fblckFile);
     return fTrue;
 }
 
+/***************************************************************************
+    Pack the chunks of the current sub file that _FEndWrite put off
+    packing. Packing them together lets the compression run in parallel.
+***************************************************************************/
+void CHCM::_PackPending(void)
+{
+    AssertThis(0);
+
+    if (pvNil == _pglckiPack)
+        return;
+
+    if (!FError() && !_pcfl->FPackDataBatch(_pglckiPack))
+        _Error(ertOom);
+    ReleasePpo(&_pglckiPack);
+}
+
 /***************************************************************************
     Parse a metafile import command from the source file.
 ***************************************************************************/
@@ -1666,6 +1696,7 @@ void CHCM::_StartSubFile(bool fPack, CTG ctg, CNO cno)
     csfc.ctg = ctg;
     csfc.cno = cno;
     csfc.fPack = FPure(fPack);
+    csfc.pglckiPack = _pglckiPack;
 
     if (!_pglcsfc->FPush(&csfc))
         goto LFail;
@@ -1676,7 +1707,9 @@ void CHCM::_StartSubFile(bool fPack, CTG ctg, CNO cno)
         _pcfl = csfc.pcfl;
     LFail:
         _Error(ertOom);
+        return;
     }
+    _pglckiPack = pvNil;
 }
 
 /***************************************************************************
@@ -1695,6 +1728,7 @@ void CHCM::_EndSubFile(void)
 
     AssertPo(csfc.pcfl, 0);
 
+    _PackPending();
     if (!FError())
     {
         long icki;
@@ -1769,6 +1803,7 @@ void CHCM::_EndSubFile(void)
 
     ReleasePpo(&_pcfl);
     _pcfl = csfc.pcfl;
+    _pglckiPack = csfc.pglckiPack;
 }
 
 /***************************************************************************
@@ -2101,10 +2136,14 @@ PCFL CHCM::PcflCompile(PBSF pbsfSrc, PSTN pstnFile, PFNI pfniDst, PMSNK pmsnk)
         while (_pglcsfc->FPop(&csfc))
         {
             ReleasePpo(&_pcfl);
+            ReleasePpo(&_pglckiPack);
             _pcfl = csfc.pcfl;
+            _pglckiPack = csfc.pglckiPack;
         }
     }
 
+    _PackPending();
+
     if (!FError() && pvNil != _pglckiLoner)
     {
         CKI cki;
@@ -2127,6 +2166,7 @@ PCFL CHCM::PcflCompile(PBSF pbsfSrc, PSTN pstnFile, PFNI pfniDst, PMSNK pmsnk)
     }
     ReleasePpo(&_pchlx);
     ReleasePpo(&_pglckiLoner);
+    ReleasePpo(&_pglckiPack);
 
     pcfl = _pcfl;
     _pcfl = pvNil;
@@ -187,12 +187,14 @@ class CHCM : public CHCM_PAR
         CTG ctg;
         CNO cno;
         bool fPack;
+        PGL pglckiPack;
     };
 
     PGL _pglcsfc; // the stack of CSFCs for sub files
 
     PCFL _pcfl;       // current sub file
     PGL _pglckiLoner; // the chunks that must be loners
+    PGL _pglckiPack;  // the chunks in _pcfl waiting to be packed
 
     BSF _bsf;     // temporary buffer for the chunk data
     PCHLX _pchlx; // lexer for compiling
@@ -244,6 +246,7 @@ class CHCM : public CHCM_PAR
 
     bool _FPrepWrite(bool fPack, long cb, CTG ctg, CNO cno, PBLCK pblck);
     bool _FEndWrite(bool fPack, CTG ctg, CNO cno, PBLCK pblck);
+    void _PackPending(void);
 
   public:
     CHCM(void);
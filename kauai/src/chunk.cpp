@@ -43,6 +43,14 @@
     index and free map. The heap contains only the raw chunk data.
     The index is not updated on disk until FSave is called.
 
+    When new data goes to the extra file (fcflAddToExtra), FSave can
+    usually save in place: the data on the extra file is copied into
+    space that the file's free map says is unused or past the end of the
+    file's index, the new index is written past that, and the header is
+    rewritten last to point at it. Until the header is written, the file
+    still holds the old index and everything it points to. When too much
+    of the file would be unused, FSave rewrites the whole file instead.
+
     The index is implemented as a general group (GG). The fixed portion
     of each entry is a CRP (defined below). The variable portion contains
     the list of children of the chunk (including CHID values) and the
@@ -280,6 +288,22 @@ const BOM kbomCrp = kbomCrpsm;
 
 #define _BvKid(ikid) LwMul(ikid, size(KID))
 
+/***************************************************************************
+    Besides the sorted index (_pggcrp), a CFL keeps a hash side index:
+    an open addressed (linear probing) table of icrp values, keyed on
+    (ctg, cno). It lets _FFindCtgCno find an existing chunk without doing
+    a binary search. The sorted index is still the real thing - it's what
+    gets written to disk and what FGetCki/FGetCkiCtg enumerate.
+
+    The table is built lazily the first time a lookup is done on an index
+    with at least kccrpMinHash entries (so not during _FReadIndex itself).
+    _FAdd, _DeleteCore and Move keep it in sync, since those are the only
+    places where CRPs get inserted, removed, renamed or reordered.
+    SwapData only swaps the data, so it doesn't need to touch the table.
+    When the table gets too full, it's freed and rebuilt on the next lookup.
+***************************************************************************/
+const long kccrpMinHash = 64;
+
 const long rtiNil = 0; // no rti assigned
 long CFL::_rtiLast = rtiNil;
 PCFL CFL::_pcflFirst;
@@ -343,6 +367,7 @@ CFL::~CFL(void)
     ReleasePpo(&_cstoExtra.pfil);
     ReleasePpo(&_cstoExtra.pglfsm);
     ReleasePpo(&_pggcrp);
+    ReleasePpo(&_pglicrpHash);
 #ifndef CHUNK_BIG_INDEX
     ReleasePpo(&_pglrtie);
 #endif //! CHUNK_BIG_INDEX
@@ -399,6 +424,7 @@ bool CFL::FReopen(void)
     AssertThis(0);
     CSTO csto, cstoExtra;
     PGG pggcrp;
+    PGL pglicrpHash;
 #ifndef CHUNK_BIG_INDEX
     PGL pglrtie;
 #endif // CHUNK_BIG_INDEX
@@ -410,6 +436,8 @@ bool CFL::FReopen(void)
 
     pggcrp = _pggcrp;
     _pggcrp = pvNil;
+    pglicrpHash = _pglicrpHash;
+    _pglicrpHash = pvNil;
 
 #ifndef CHUNK_BIG_INDEX
     pglrtie = _pglrtie;
@@ -431,6 +459,7 @@ bool CFL::FReopen(void)
     if (!fRet)
     {
         SwapVars(&_pggcrp, &pggcrp);
+        SwapVars(&_pglicrpHash, &pglicrpHash);
 #ifndef CHUNK_BIG_INDEX
         SwapVars(&_pglrtie, &pglrtie);
 #endif // CHUNK_BIG_INDEX
@@ -439,6 +468,7 @@ bool CFL::FReopen(void)
         _fFreeMapNotRead = FPure(fFreeMapNotRead);
     }
     ReleasePpo(&pggcrp);
+    ReleasePpo(&pglicrpHash);
 #ifndef CHUNK_BIG_INDEX
     ReleasePpo(&pglrtie);
 #endif // CHUNK_BIG_INDEX
@@ -447,10 +477,26 @@ bool CFL::FReopen(void)
     ReleasePpo(&cstoExtra.pfil);
     ReleasePpo(&cstoExtra.pglfsm);
 
+    _fNoHashIndex = fFalse;
     AssertThis(0);
     return fRet;
 }
 
+/***************************************************************************
+    Turn the hash side index on or off.  It's on by default.  When it's on,
+    the index is built the next time a chunk is looked up (assuming the
+    file has enough chunks to make it worthwhile).
+***************************************************************************/
+void CFL::SetHashIndex(bool fHash)
+{
+    AssertThis(0);
+
+    _fNoHashIndex = !fHash;
+    if (!fHash)
+        ReleasePpo(&_pglicrpHash);
+    AssertThis(0);
+}
+
 /***************************************************************************
     Static method to get file options corresponding to the given chunky
     file options.
@@ -906,6 +952,13 @@ bool CFL::FSetGrfcfl(ulong grfcfl, ulong grfcflMask)
     grffil = _GrffilFromGrfcfl(grfcfl);
     grffilMask = _GrffilFromGrfcfl(grfcflMask);
 
+    // the view of a mapped file must never change under its clients
+    if ((grfcfl & fcflWriteEnable) && _csto.pfil->FMapped())
+    {
+        Bug("can't write enable a mapped chunky file");
+        return fFalse;
+    }
+
     if ((grffil ^ _csto.pfil->GrffilCur()) & grffilMask)
     {
         // need to change some file properties
@@ -929,6 +982,13 @@ bool CFL::FSetGrfcfl(ulong grfcfl, ulong grfcflMask)
     if (grfcfl & fcflReadFromExtra)
         _fReadFromExtra = fTrue;
 
+    // Mapping is non-critical - if it fails, chunk data is just read
+    // from the file as usual.
+    if ((grfcfl & fcflMapped) && !_fInvalidMainFile && !(_csto.pfil->GrffilCur() & ffilWriteEnable))
+    {
+        _csto.pfil->FMap();
+    }
+
     return fTrue;
 }
 
@@ -1024,6 +1084,7 @@ void CFL::AssertValid(ulong grfcfl)
 #ifndef CHUNK_BIG_INDEX
     AssertNilOrPo(_pglrtie, 0);
 #endif //! CHUNK_BIG_INDEX
+    AssertNilOrPo(_pglicrpHash, 0);
 
     if (!(grfcfl & (fcflFull | fcflGraph)))
         return;
@@ -1078,6 +1139,10 @@ void CFL::AssertValid(ulong grfcfl)
         ckiOld = ckiNew;
         fFirstCrp = fFalse;
 
+        // assert that the hash index (if there is one) agrees
+        Assert(pvNil == _pglicrpHash || _FFindHash(ckiNew.ctg, ckiNew.cno, &icrpT) && icrpT == icrp,
+               "hash index is wrong");
+
         fFirstKid = fTrue;
         for (ikid = 0; ikid < crp.ckid; ikid++)
         {
@@ -1167,6 +1232,7 @@ void CFL::MarkMem(void)
     AssertThis(0);
     CFL_PAR::MarkMem();
     MarkMemObj(_pggcrp);
+    MarkMemObj(_pglicrpHash);
     MarkMemObj(_csto.pglfsm);
     MarkMemObj(_cstoExtra.pglfsm);
 #ifndef CHUNK_BIG_INDEX
@@ -1577,10 +1643,6 @@ void CFL::_ReadFreeMap(void)
     Assert(_fFreeMapNotRead, "free map already read");
     Assert(!_fInvalidMainFile, 0);
 
-    short bo;
-    short osk;
-    long cfsm;
-
     // clear this even if reading the free map fails - so we don't try to
     // read again
     _fFreeMapNotRead = fFalse;
@@ -1591,28 +1653,50 @@ void CFL::_ReadFreeMap(void)
         return;
     }
 
-    if (_cbFreeMap > 0)
+    // if it fails, so what
+    _csto.pglfsm = _PglfsmRead(_fpFreeMap, _cbFreeMap);
+}
+
+/***************************************************************************
+    Read a free map from the main file.  Returns pvNil if there isn't one
+    (cb is zero) or reading it fails.
+***************************************************************************/
+PGL CFL::_PglfsmRead(FP fp, long cb)
+{
+    AssertBaseThis(0);
+    short bo;
+    short osk;
+    long cfsm;
+    PGL pglfsm;
+
+    if (cb <= 0)
+        return pvNil;
+
+    if ((pglfsm = GL::PglRead(_csto.pfil, fp, cb, &bo, &osk)) == pvNil || pglfsm->CbEntry() != size(FSM))
     {
-        if ((_csto.pglfsm = GL::PglRead(_csto.pfil, _fpFreeMap, _cbFreeMap, &bo, &osk)) == pvNil ||
-            _csto.pglfsm->CbEntry() != size(FSM))
-        {
-            // it failed, but so what
-            ReleasePpo(&_csto.pglfsm);
-            return;
-        }
-        // swap bytes
-        AssertBomRglw(kbomFsm, size(FSM));
-        if (bo != kboCur && (cfsm = _csto.pglfsm->IvMac()) > 0)
-        {
-            SwapBytesRglw(_csto.pglfsm->QvGet(0), cfsm * (size(FSM) / size(long)));
-        }
+        ReleasePpo(&pglfsm);
+        return pvNil;
     }
+
+    // swap bytes
+    AssertBomRglw(kbomFsm, size(FSM));
+    if (bo != kboCur && (cfsm = pglfsm->IvMac()) > 0)
+        SwapBytesRglw(pglfsm->QvGet(0), cfsm * (size(FSM) / size(long)));
+    return pglfsm;
 }
 
+// FSave rewrites the whole file rather than saving in place when more
+// than this percent of the file would be unused
+const long kpctFreeMaxInPlace = 25;
+
+// the most data FSave copies with one FLO::FCopy (which allocates a
+// buffer the size of the copy)
+const long kcbMaxCopyRun = 0x00100000;
+
 /***************************************************************************
     If we have don't have write permission or there's an extra file,
-    write out a new file and do the rename stuff.  If not, just write
-    the index and free map.
+    write out a new file and do the rename stuff (unless we can save in
+    place, see _TSaveInPlace).  If not, just write the index and free map.
 ***************************************************************************/
 bool CFL::FSave(CTG ctgCreator, FNI *pfni)
 {
@@ -1621,9 +1705,11 @@ bool CFL::FSave(CTG ctgCreator, FNI *pfni)
 
     FNI fni;
     FLO floSrc, floDst;
-    long ccrp, icrp;
+    long ccrp, icrp, icrpLim;
     CRP *qcrp;
     PFIL pfilOld;
+    FP fpFreeMapOld;
+    long cbFreeMapOld;
 
     if (_fInvalidMainFile)
     {
@@ -1650,11 +1736,25 @@ bool CFL::FSave(CTG ctgCreator, FNI *pfni)
     {
         // just write the index
         Assert(!_fFreeMapNotRead, "why hasn't the free map been read?");
-        if (!_FWriteIndex(ctgCreator))
+        if (!_FWriteIndex(ctgCreator, _csto.fpMac))
             goto LError;
         return fTrue;
     }
 
+    if (pfni == pvNil)
+    {
+        switch (_TSaveInPlace(ctgCreator))
+        {
+        case tYes:
+            AssertThis(fcflFull | fcflGraph);
+            return fTrue;
+        case tMaybe:
+            goto LError;
+        case tNo:
+            break; // fall back to a full rewrite
+        }
+    }
+
     // get a temp name in the same directory as the target
     if ((floDst.pfil = FIL::PfilCreateTemp(&fni)) == pvNil)
         goto LError;
@@ -1663,12 +1763,10 @@ bool CFL::FSave(CTG ctgCreator, FNI *pfni)
 
     floDst.fp = size(CFP);
     ccrp = _pggcrp->IvMac();
-    for (icrp = 0; icrp < ccrp; icrp++)
+    for (icrp = 0; icrp < ccrp; icrp = icrpLim)
     {
-        qcrp = (CRP *)_pggcrp->QvFixedGet(icrp);
-        floSrc.pfil = qcrp->Grfcrp(fcrpOnExtra) ? _cstoExtra.pfil : _csto.pfil;
-        floSrc.fp = qcrp->fp;
-        floSrc.cb = floDst.cb = qcrp->Cb();
+        icrpLim = _IcrpLimRun(icrp, &floSrc);
+        floDst.cb = floSrc.cb;
 
         if (floSrc.cb > 0 && !floSrc.FCopy(&floDst))
         {
@@ -1693,6 +1791,8 @@ bool CFL::FSave(CTG ctgCreator, FNI *pfni)
 
     // update the csto's and write the index
     pfilOld = _csto.pfil;
+    fpFreeMapOld = _fpFreeMap;
+    cbFreeMapOld = _cbFreeMap;
     ReleasePpo(&_csto.pglfsm);
     _fFreeMapNotRead = fFalse;
     _csto.pfil = floDst.pfil;
@@ -1707,7 +1807,7 @@ bool CFL::FSave(CTG ctgCreator, FNI *pfni)
     }
 
     // write the index
-    if (!_FWriteIndex(ctgCreator))
+    if (!_FWriteIndex(ctgCreator, _csto.fpMac))
         goto LIndexFail;
 
     if (pfni != pvNil)
@@ -1733,6 +1833,8 @@ bool CFL::FSave(CTG ctgCreator, FNI *pfni)
             // restore the original csto and make floDst.pfil the extra file
             _csto.pfil = pfilOld;
             _csto.fpMac = size(CFP);
+            _fpFreeMap = fpFreeMapOld;
+            _cbFreeMap = cbFreeMapOld;
             for (icrp = 0; icrp < ccrp; icrp++)
             {
                 qcrp = (CRP *)_pggcrp->QvFixedGet(icrp);
@@ -1759,9 +1861,177 @@ bool CFL::FSave(CTG ctgCreator, FNI *pfni)
 }
 
 /***************************************************************************
-    Write the chunky index and free map to the end of the file.
+    The chunks are written in index order when the whole file is copied,
+    so when the data for the chunks following the icrp'th comes next in
+    the same file, they can be copied with a single FCopy.  Fills *pfloSrc
+    with the data for the run of chunks starting at icrp and returns the
+    end of the run.
 ***************************************************************************/
-bool CFL::_FWriteIndex(CTG ctgCreator)
+long CFL::_IcrpLimRun(long icrp, PFLO pfloSrc)
+{
+    AssertBaseThis(0);
+    AssertIn(icrp, 0, _pggcrp->IvMac());
+    AssertVarMem(pfloSrc);
+    long icrpLim, ccrp;
+    CRP *qcrp;
+
+    qcrp = (CRP *)_pggcrp->QvFixedGet(icrp);
+    pfloSrc->pfil = qcrp->Grfcrp(fcrpOnExtra) ? _cstoExtra.pfil : _csto.pfil;
+    pfloSrc->fp = qcrp->fp;
+    pfloSrc->cb = qcrp->Cb();
+
+    ccrp = _pggcrp->IvMac();
+    for (icrpLim = icrp + 1; icrpLim < ccrp && pfloSrc->cb < kcbMaxCopyRun; icrpLim++)
+    {
+        qcrp = (CRP *)_pggcrp->QvFixedGet(icrpLim);
+        if (qcrp->Cb() == 0)
+            continue;
+        if ((qcrp->Grfcrp(fcrpOnExtra) ? _cstoExtra.pfil : _csto.pfil) != pfloSrc->pfil ||
+            qcrp->fp != pfloSrc->fp + pfloSrc->cb)
+        {
+            break;
+        }
+        pfloSrc->cb += qcrp->Cb();
+    }
+    return icrpLim;
+}
+
+/***************************************************************************
+    Save in place: copy the data on the extra file to the main file, then
+    write the index and free map past everything the file's current index
+    uses, then the header.  The file stays valid until the header is
+    written.  Returns tNo if we shouldn't save in place, tMaybe if there
+    was an error and tYes on success.
+***************************************************************************/
+tribool CFL::_TSaveInPlace(CTG ctgCreator)
+{
+    AssertThis(0);
+    long ccrp, icrp, ifsm, cfsm;
+    long cb, cbLive, cbExtra;
+    FP fpData, fpLimIndex, fpAppend, fpAppendMin, fp;
+    CRP *qcrp;
+    FSM *qfsm;
+    FLO floSrc, floDst;
+    PGL pglfsmFile = pvNil;
+    PGL pglfp = pvNil;
+    tribool tRet = tMaybe;
+
+    // we only know that nothing has written over space the file's index
+    // still uses if all new data has been going to the extra file
+    if (_fNoSaveInPlace || !_fAddToExtra || _fInvalidMainFile || !(_csto.pfil->GrffilCur() & ffilWriteEnable))
+    {
+        return tNo;
+    }
+    if (_fFreeMapNotRead)
+        _ReadFreeMap();
+
+    // fpData is the end of the chunk data, fpLimIndex the end of the
+    // file's index and free map
+    fpData = _csto.fpMac;
+    fpLimIndex = _fpFreeMap + _cbFreeMap;
+    fpAppendMin = LwMax(fpData, fpLimIndex);
+
+    // if too much of the file would be unused, compact it instead
+    ccrp = _pggcrp->IvMac();
+    cbLive = cbExtra = 0;
+    for (icrp = 0; icrp < ccrp; icrp++)
+    {
+        qcrp = (CRP *)_pggcrp->QvFixedGet(icrp);
+        cbLive += qcrp->Cb();
+        if (qcrp->Grfcrp(fcrpOnExtra))
+            cbExtra += qcrp->Cb();
+    }
+    if (fpAppendMin + cbExtra - size(CFP) - cbLive > LwMulDiv(fpAppendMin + cbExtra, kpctFreeMaxInPlace, 100))
+        return tNo;
+
+    // the space that's free in the file's free map (and hasn't been used
+    // since) can be written now
+    pglfsmFile = _PglfsmRead(_fpFreeMap, _cbFreeMap);
+    cfsm = pvNil == pglfsmFile ? 0 : pglfsmFile->IvMac();
+
+    // copy the data, remembering where each chunk went
+    if (pvNil == (pglfp = GL::PglNew(size(FP), ccrp)) || !pglfp->FSetIvMac(ccrp))
+        goto LFail;
+    floDst.pfil = _csto.pfil;
+    fpAppend = fpAppendMin;
+    for (icrp = 0; icrp < ccrp; icrp++)
+    {
+        qcrp = (CRP *)_pggcrp->QvFixedGet(icrp);
+        if (!qcrp->Grfcrp(fcrpOnExtra) || (cb = qcrp->Cb()) == 0)
+            continue;
+        floSrc.pfil = _cstoExtra.pfil;
+        floSrc.fp = qcrp->fp;
+        floSrc.cb = floDst.cb = cb;
+
+        for (ifsm = 0; ifsm < cfsm; ifsm++)
+        {
+            qfsm = (FSM *)pglfsmFile->QvGet(ifsm);
+            if (qfsm->cb >= cb && qfsm->fp + cb <= fpData && _FFindFree(qfsm->fp, cb, pvNil))
+                break;
+        }
+        if (ifsm < cfsm)
+        {
+            qfsm = (FSM *)pglfsmFile->QvGet(ifsm);
+            floDst.fp = qfsm->fp;
+            qfsm->fp += cb;
+            qfsm->cb -= cb;
+        }
+        else
+        {
+            floDst.fp = fpAppend;
+            fpAppend += cb;
+            if (fpAppend > _csto.pfil->FpMac() && !_csto.pfil->FSetFpMac(fpAppend))
+                goto LFail;
+        }
+
+        if (!floSrc.FCopy(&floDst))
+            goto LFail;
+        pglfp->Put(icrp, &floDst.fp);
+    }
+
+    // All the data has been copied.  Take the space we used out of the
+    // free map and point the index at the main file.
+    if (fpAppend > fpAppendMin)
+    {
+        _csto.fpMac = fpAppend;
+        if (fpData < fpAppendMin)
+            _FreeFpCb(fFalse, fpData, fpAppendMin - fpData);
+    }
+    for (icrp = 0; icrp < ccrp; icrp++)
+    {
+        qcrp = (CRP *)_pggcrp->QvFixedGet(icrp);
+        if (!qcrp->Grfcrp(fcrpOnExtra))
+            continue;
+        qcrp->ClearGrfcrp(fcrpOnExtra);
+        if ((cb = qcrp->Cb()) == 0)
+            continue;
+        pglfp->Get(icrp, &fp);
+        qcrp->fp = fp;
+        if (fp < fpAppendMin)
+            _TakeFpCb(fp, cb);
+    }
+
+    if (_cstoExtra.pfil != pvNil)
+    {
+        _cstoExtra.fpMac = 0;
+        ReleasePpo(&_cstoExtra.pfil);
+        ReleasePpo(&_cstoExtra.pglfsm);
+    }
+
+    // write the index where it won't overwrite the current one
+    tRet = _FWriteIndex(ctgCreator, LwMax(_csto.fpMac, fpLimIndex)) ? tYes : tMaybe;
+
+LFail:
+    ReleasePpo(&pglfsmFile);
+    ReleasePpo(&pglfp);
+    return tRet;
+}
+
+/***************************************************************************
+    Write the chunky index and free map at fpIndex, which should be at or
+    past the end of the chunk data, then the header.
+***************************************************************************/
+bool CFL::_FWriteIndex(CTG ctgCreator, FP fpIndex)
 {
     AssertBaseThis(0);
     AssertPo(_pggcrp, 0);
@@ -1777,7 +2047,8 @@ bool CFL::_FWriteIndex(CTG ctgCreator)
     cfp.bo = kboCur;
     cfp.osk = koskCur;
 
-    blck.Set(_csto.pfil, cfp.fpIndex = _csto.fpMac, cfp.cbIndex = _pggcrp->CbOnFile());
+    Assert(fpIndex >= _csto.fpMac, "index would overwrite chunk data");
+    blck.Set(_csto.pfil, cfp.fpIndex = fpIndex, cfp.cbIndex = _pggcrp->CbOnFile());
     if (!_pggcrp->FWrite(&blck))
         return fFalse;
     cfp.fpMap = cfp.fpIndex + cfp.cbIndex;
@@ -1792,7 +2063,12 @@ bool CFL::_FWriteIndex(CTG ctgCreator)
         cfp.cbMap = 0;
 
     cfp.fpMac = cfp.fpMap + cfp.cbMap;
-    return _csto.pfil->FWriteRgb(&cfp, size(cfp), 0);
+    if (!_csto.pfil->FWriteRgb(&cfp, size(cfp), 0))
+        return fFalse;
+
+    _fpFreeMap = cfp.fpMap;
+    _cbFreeMap = cfp.cbMap;
+    return fTrue;
 }
 
 /***************************************************************************
@@ -1804,10 +2080,11 @@ bool CFL::FSaveACopy(CTG ctgCreator, FNI *pfni)
     AssertThis(fcflFull | fcflGraph);
     AssertPo(pfni, ffniFile);
     PCFL pcflDst;
-    long icrp, ccrp;
+    long icrp, icrpLim, ccrp;
     CRP *pcrp;
     CRP crp;
     FLO floSrc, floDst;
+    FP fp;
 
     if (pvNil == (pcflDst = CFL::PcflCreate(pfni, fcflWriteEnable)))
         goto LError;
@@ -1816,31 +2093,27 @@ bool CFL::FSaveACopy(CTG ctgCreator, FNI *pfni)
     floDst.pfil = pcflDst->_csto.pfil;
     floDst.fp = size(CFP);
 
-    // need to lock the _pggcrp for the FInsert operations below
+    // copy the data
     ccrp = _pggcrp->IvMac();
+    for (icrp = 0; icrp < ccrp; icrp = icrpLim, floDst.fp += floDst.cb)
+    {
+        icrpLim = _IcrpLimRun(icrp, &floSrc);
+        floDst.cb = floSrc.cb;
+        if (floSrc.cb > 0 && !floSrc.FCopy(&floDst))
+            goto LFail;
+    }
+
+    // need to lock the _pggcrp for the FInsert operations below
     _pggcrp->Lock();
 
-    for (icrp = 0; icrp < ccrp; icrp++, floDst.fp += floDst.cb)
+    for (icrp = 0, fp = size(CFP); icrp < ccrp; icrp++, fp += crp.Cb())
     {
         pcrp = (CRP *)_pggcrp->QvFixedGet(icrp);
         crp = *pcrp;
 
-        // get the source and destination FLOs
-        floSrc.pfil = pcrp->Grfcrp(fcrpOnExtra) ? _cstoExtra.pfil : _csto.pfil;
-        floSrc.fp = pcrp->fp;
-        floDst.cb = floSrc.cb = pcrp->Cb();
-
-        // copy the data
-        if (!floSrc.FCopy(&floDst))
-        {
-            _pggcrp->Unlock();
-            goto LFail;
-        }
-
         // create the index entry - the only things that change are the
-        // (fp, cb) and the fcrpOnExtra flag.
-        crp.fp = floDst.fp;
-        crp.SetCb(floDst.cb);
+        // fp and the fcrpOnExtra flag.
+        crp.fp = crp.Cb() > 0 ? fp : 0;
         crp.ClearGrfcrp(fcrpOnExtra);
         if (!pcflDst->_pggcrp->FInsert(icrp, _pggcrp->Cb(icrp), _pggcrp->QvGet(icrp), &crp))
         {
@@ -1849,10 +2122,14 @@ bool CFL::FSaveACopy(CTG ctgCreator, FNI *pfni)
         }
     }
     _pggcrp->Unlock();
+    Assert(fp == floDst.fp, "what happened? - file messed up");
 
     // set the fpMac of the destination CFL
     pcflDst->_csto.fpMac = floDst.fp;
 
+    // we filled in the index directly, so there better not be a hash index
+    Assert(pvNil == pcflDst->_pglicrpHash, "stale hash index");
+
     if (!pcflDst->FSave(ctgCreator))
     {
     LFail:
@@ -2156,6 +2433,209 @@ bool CFL::FPackData(CTG ctg, CNO cno)
     return FPutBlck(&blck, ctg, cno);
 }
 
+// packing entry for FPackDataBatch
+struct PKE
+{
+    CKI cki;
+    HQ hq;        // the chunk's data
+    bool fPacked; // whether hq has been packed
+};
+
+// packing job shared by the threads in FPackDataBatch
+struct PKJ
+{
+    MUTX mutx;
+    PGL pglpke;
+    long ipkeNext; // next entry to pack
+    long ipkeLim;
+};
+
+// maximum amount of unpacked data read in at once by FPackDataBatch
+const long kcbMaxPackBatch = 0x01000000;
+
+/***************************************************************************
+    AT: Pack entries of the job until there aren't any left. Called on the
+    packing threads and on the thread that called FPackDataBatch.
+***************************************************************************/
+static void _PackPkj(PKJ *ppkj)
+{
+    PKE pke;
+    long ipke;
+
+    for (;;)
+    {
+        ppkj->mutx.Enter();
+        ipke = ppkj->ipkeNext;
+        if (ipke < ppkj->ipkeLim)
+        {
+            ppkj->ipkeNext++;
+            ppkj->pglpke->Get(ipke, &pke);
+        }
+        ppkj->mutx.Leave();
+
+        if (ipke >= ppkj->ipkeLim)
+            return;
+
+        // if it can't be packed, it's stored unpacked
+        pke.fPacked = vpcodmUtil->FCompressPhq(&pke.hq);
+
+        ppkj->mutx.Enter();
+        ppkj->pglpke->Put(ipke, &pke);
+        ppkj->mutx.Leave();
+    }
+}
+
+#ifdef WIN
+/***************************************************************************
+    AT: Thread function for FPackDataBatch.
+***************************************************************************/
+static ulong __stdcall _LuPackThread(void *pv)
+{
+    _PackPkj((PKJ *)pv);
+    return 0;
+}
+#endif // WIN
+
+/***************************************************************************
+    Pack the chunks in pglcki (a list of CKIs). Chunks that are already
+    packed or don't exist are skipped, and chunks that don't compress are
+    left unpacked. The data is read and written on this thread, but is
+    compressed on up to cth threads at once. If cth is zero, one thread
+    per processor is used. Returns false only if reading or writing
+    chunk data fails.
+***************************************************************************/
+bool CFL::FPackDataBatch(PGL pglcki, long cth)
+{
+    AssertThis(0);
+    AssertPo(pglcki, 0);
+    Assert(pglcki->CbEntry() == size(CKI), "bad CKI list");
+    AssertIn(cth, 0, kcthMaxPack + 1);
+
+    PKJ pkj;
+    PKE pke;
+    BLCK blck;
+    long icki, ipke, cb;
+    bool fRet = fFalse;
+#ifdef WIN
+    HANDLE rghth[kcthMaxPack];
+    long ith, cthStarted;
+    ulong luThread;
+
+    if (cth == 0)
+    {
+        SYSTEM_INFO si;
+
+        GetSystemInfo(&si);
+        cth = LwBound(si.dwNumberOfProcessors, 1, kcthMaxPack + 1);
+    }
+#endif // WIN
+
+    if (pvNil == (pkj.pglpke = GL::PglNew(size(PKE))))
+        return fFalse;
+
+    for (icki = 0; icki < pglcki->IvMac();)
+    {
+        // read in the next batch of unpacked chunks
+        for (cb = 0; icki < pglcki->IvMac() && cb < kcbMaxPackBatch; icki++)
+        {
+            pglcki->Get(icki, &pke.cki);
+            if (!FFind(pke.cki.ctg, pke.cki.cno, &blck) || blck.FPacked() || blck.Cb() == 0)
+                continue;
+            if (!blck.FReadHq(&pke.hq))
+                goto LFail;
+            pke.fPacked = fFalse;
+            if (!pkj.pglpke->FAdd(&pke))
+            {
+                FreePhq(&pke.hq);
+                goto LFail;
+            }
+            cb += blck.Cb();
+        }
+
+        // pack them
+        pkj.ipkeNext = 0;
+        pkj.ipkeLim = pkj.pglpke->IvMac();
+#ifdef WIN
+        cthStarted = 0;
+        for (ith = LwMin(cth, pkj.ipkeLim) - 1; ith > 0; ith--)
+        {
+            if (hNil == (rghth[cthStarted] = CreateThread(pvNil, 4096, _LuPackThread, &pkj, 0, &luThread)))
+                break;
+            cthStarted++;
+        }
+        _PackPkj(&pkj);
+        if (cthStarted > 0)
+        {
+            WaitForMultipleObjects(cthStarted, rghth, fTrue, INFINITE);
+            for (ith = 0; ith < cthStarted; ith++)
+                CloseHandle(rghth[ith]);
+        }
+#else  //! WIN
+        _PackPkj(&pkj);
+#endif //! WIN
+
+        // write the packed data
+        for (ipke = 0; ipke < pkj.ipkeLim; ipke++)
+        {
+            pkj.pglpke->Get(ipke, &pke);
+            if (pke.fPacked)
+            {
+                // blck owns the hq now, so the list mustn't free it too
+                blck.SetHq(&pke.hq, fTrue);
+                pkj.pglpke->Put(ipke, &pke);
+                if (!FPutBlck(&blck, pke.cki.ctg, pke.cki.cno))
+                    goto LFail;
+                blck.Free();
+            }
+            else
+                FreePhq(&pke.hq);
+            pkj.pglpke->Put(ipke, &pke);
+        }
+        pkj.pglpke->FSetIvMac(0);
+    }
+    fRet = fTrue;
+
+LFail:
+    for (ipke = pkj.pglpke->IvMac(); ipke-- > 0;)
+    {
+        pkj.pglpke->Get(ipke, &pke);
+        FreePhq(&pke.hq);
+    }
+    ReleasePpo(&pkj.pglpke);
+    blck.Free();
+    return fRet;
+}
+
+/***************************************************************************
+    Pack all the chunks of the given type. See FPackDataBatch.
+***************************************************************************/
+bool CFL::FPackDataCtg(CTG ctg, long cth)
+{
+    AssertThis(0);
+    AssertIn(cth, 0, kcthMaxPack + 1);
+
+    CKI cki;
+    long icki;
+    PGL pglcki;
+    bool fRet;
+
+    if (pvNil == (pglcki = GL::PglNew(size(CKI))))
+        return fFalse;
+
+    for (icki = 0; FGetCkiCtg(ctg, icki, &cki); icki++)
+    {
+        if (!pglcki->FAdd(&cki))
+        {
+            ReleasePpo(&pglcki);
+            return fFalse;
+        }
+    }
+
+    fRet = FPackDataBatch(pglcki, cth);
+    ReleasePpo(&pglcki);
+    return fRet;
+}
+
 /***************************************************************************
     Create the extra file.  Note: the extra file doesn't have a CFP -
     just raw data.
@@ -2256,7 +2736,8 @@ bool CFL::_FAllocFlo(long cb, PFLO pflo, bool fForceOnExtra)
 /***************************************************************************
     Look for the (ctg, cno) pair.  Fills *picrp with where it should be.
     Returns whether or not it was found.  Assumes the _pggcrp is sorted
-    by (ctg, cno).  Does a binary search.
+    by (ctg, cno).  Uses the hash index if there is one, otherwise (or if
+    the chunk isn't there) does a binary search.
 ***************************************************************************/
 bool CFL::_FFindCtgCno(CTG ctg, CNO cno, long *picrp)
 {
@@ -2275,6 +2756,11 @@ bool CFL::_FFindCtgCno(CTG ctg, CNO cno, long *picrp)
         return fFalse;
     }
 
+    if (pvNil == _pglicrpHash && ccrp >= kccrpMinHash && !_fNoHashIndex)
+        _FBuildHashIndex();
+    if (pvNil != _pglicrpHash && _FFindHash(ctg, cno, picrp))
+        return fTrue;
+
     for (icrpMin = 0, icrpLim = ccrp; icrpMin < icrpLim;)
     {
         icrp = (icrpMin + icrpLim) / 2;
@@ -2299,6 +2785,186 @@ bool CFL::_FFindCtgCno(CTG ctg, CNO cno, long *picrp)
     return fFalse;
 }
 
+/***************************************************************************
+    Build the hash side index from _pggcrp.  If this fails, we don't try
+    again until the file is reopened or SetHashIndex(fTrue) is called.
+***************************************************************************/
+bool CFL::_FBuildHashIndex(void)
+{
+    AssertBaseThis(0);
+    Assert(pvNil == _pglicrpHash, "already have a hash index");
+    long ccrp, cslot, icrp;
+
+    // keep the load factor at or below 1/2 when we build the table
+    ccrp = _pggcrp->IvMac();
+    for (cslot = kccrpMinHash; cslot < LwMul(ccrp, 2); cslot <<= 1)
+        ;
+
+    if (pvNil == (_pglicrpHash = GL::PglNew(size(long), cslot)) || !_pglicrpHash->FSetIvMac(cslot))
+    {
+        ReleasePpo(&_pglicrpHash);
+        _fNoHashIndex = fTrue;
+        return fFalse;
+    }
+
+    // ivNil is -1, so this marks every slot as empty
+    FillPb(_pglicrpHash->QvGet(0), LwMul(cslot, size(long)), 0xFF);
+    for (icrp = 0; icrp < ccrp; icrp++)
+        _HashAdd(icrp);
+
+    return fTrue;
+}
+
+/***************************************************************************
+    Return the home slot in the hash index for the (ctg, cno).
+***************************************************************************/
+long CFL::_IslotHash(CTG ctg, CNO cno)
+{
+    AssertBaseThis(0);
+    AssertPo(_pglicrpHash, 0);
+    ulong luHash;
+
+    luHash = (ctg * 0x9E3779B1L) ^ cno;
+    luHash ^= luHash >> 15;
+    luHash *= 0x85EBCA6BL;
+    luHash ^= luHash >> 13;
+
+    // the table size is always a power of 2
+    return (long)(luHash & (_pglicrpHash->IvMac() - 1));
+}
+
+/***************************************************************************
+    Look for the (ctg, cno) in the hash index.  If it's there, fills in
+    *picrp and returns true.  Unlike _FFindCtgCno, doesn't tell you where
+    the chunk should go if it's not there.
+***************************************************************************/
+bool CFL::_FFindHash(CTG ctg, CNO cno, long *picrp)
+{
+    // WARNING:  this is called by CFL::AssertValid, so be careful about
+    // asserting stuff in here
+    AssertBaseThis(0);
+    AssertVarMem(picrp);
+    AssertPo(_pglicrpHash, 0);
+
+    long islot, icrp, islotMask;
+    long *qrgicrp;
+    CRP *qcrp;
+
+    islotMask = _pglicrpHash->IvMac() - 1;
+    qrgicrp = (long *)_pglicrpHash->QvGet(0);
+    for (islot = _IslotHash(ctg, cno); ivNil != (icrp = qrgicrp[islot]); islot = (islot + 1) & islotMask)
+    {
+        qcrp = (CRP *)_pggcrp->QvFixedGet(icrp);
+        if (qcrp->cki.ctg == ctg && qcrp->cki.cno == cno)
+        {
+            *picrp = icrp;
+            return fTrue;
+        }
+    }
+
+    return fFalse;
+}
+
+/***************************************************************************
+    Add the CRP at icrp to the hash index.  The cki in the CRP must already
+    be set and must not already be in the hash index.  The caller is
+    responsible for making sure there's an empty slot.
+***************************************************************************/
+void CFL::_HashAdd(long icrp)
+{
+    AssertBaseThis(0);
+    AssertPo(_pglicrpHash, 0);
+    AssertIn(icrp, 0, _pggcrp->IvMac());
+
+    long islot, islotMask;
+    long *qrgicrp;
+    CRP *qcrp;
+
+    qcrp = (CRP *)_pggcrp->QvFixedGet(icrp);
+    islotMask = _pglicrpHash->IvMac() - 1;
+    qrgicrp = (long *)_pglicrpHash->QvGet(0);
+    for (islot = _IslotHash(qcrp->cki.ctg, qcrp->cki.cno); ivNil != qrgicrp[islot]; islot = (islot + 1) & islotMask)
+    {
+        Assert(qrgicrp[islot] != icrp, "icrp already in hash index");
+    }
+    qrgicrp[islot] = icrp;
+}
+
+/***************************************************************************
+    Remove the CRP at icrp from the hash index.  All the icrp values in the
+    hash index must still be correct, since we have to rehash the entries
+    following the one we remove.
+***************************************************************************/
+void CFL::_HashRemove(long icrp)
+{
+    AssertBaseThis(0);
+    AssertPo(_pglicrpHash, 0);
+    AssertIn(icrp, 0, _pggcrp->IvMac());
+
+    long islot, islotT, islotHome, islotMask, icrpT;
+    long *qrgicrp;
+    CRP *qcrp;
+
+    qcrp = (CRP *)_pggcrp->QvFixedGet(icrp);
+    islotMask = _pglicrpHash->IvMac() - 1;
+    qrgicrp = (long *)_pglicrpHash->QvGet(0);
+    for (islot = _IslotHash(qcrp->cki.ctg, qcrp->cki.cno); qrgicrp[islot] != icrp; islot = (islot + 1) & islotMask)
+    {
+        if (ivNil == qrgicrp[islot])
+        {
+            Bug("icrp not in hash index");
+            return;
+        }
+    }
+
+    // Empty the slot, then shift back any following entries that can't
+    // be found anymore because of the hole.
+    for (;;)
+    {
+        qrgicrp[islot] = ivNil;
+        for (islotT = islot;;)
+        {
+            islotT = (islotT + 1) & islotMask;
+            if (ivNil == (icrpT = qrgicrp[islotT]))
+                return;
+
+            qcrp = (CRP *)_pggcrp->QvFixedGet(icrpT);
+            islotHome = _IslotHash(qcrp->cki.ctg, qcrp->cki.cno);
+
+            // if islotHome is cyclically in (islot, islotT], the entry
+            // can stay where it is
+            if (islot <= islotT ? (islot < islotHome && islotHome <= islotT)
+                                : (islot < islotHome || islotHome <= islotT))
+            {
+                continue;
+            }
+            break;
+        }
+        qrgicrp[islot] = icrpT;
+        islot = islotT;
+    }
+}
+
+/***************************************************************************
+    Add dicrp to all icrp values in the hash index that are in
+    [icrpMin, icrpLim).  Used when CRPs are inserted, deleted or moved.
+***************************************************************************/
+void CFL::_HashShift(long icrpMin, long icrpLim, long dicrp)
+{
+    AssertBaseThis(0);
+    AssertPo(_pglicrpHash, 0);
+
+    long islot;
+    long *qicrp;
+
+    qicrp = (long *)_pglicrpHash->QvGet(0);
+    for (islot = _pglicrpHash->IvMac(); islot-- > 0; qicrp++)
+    {
+        if (*qicrp >= icrpMin && *qicrp < icrpLim)
+            *qicrp += dicrp;
+    }
+}
+
 /***************************************************************************
     Find an unused cno for the given ctg.  Fill in *picrp and *pcno.
 ***************************************************************************/
@@ -2519,6 +3185,19 @@ bool CFL::_FAdd(long cb, CTG ctg, CNO cno, long icrp, PBLCK pblck)
         qcrp->SetGrfcrp(fcrpOnExtra);
     qcrp->SetGrfcrp(fcrpLoner);
 
+    if (pvNil != _pglicrpHash)
+    {
+        // if the table is getting too full, toss it and rebuild it
+        // (bigger) on the next lookup
+        if (LwMul(_pggcrp->IvMac(), 4) > LwMul(_pglicrpHash->IvMac(), 3))
+            ReleasePpo(&_pglicrpHash);
+        else
+        {
+            _HashShift(icrp, klwMax, 1);
+            _HashAdd(icrp);
+        }
+    }
+
     if (pvNil != pblck)
         pblck->Set(&flo);
     AssertThis(0);
@@ -2777,12 +3456,30 @@ void CFL::Move(CTG ctg, CNO cno, CTG ctgNew, CNO cnoNew)
     if (rtiNil != rti)
         _FSetRti(ctg, cno, rtiNil);
 
+    if (pvNil != _pglicrpHash)
+        _HashRemove(icrpCur);
+
     qcrp = (CRP *)_pggcrp->QvFixedGet(icrpCur);
     ccrpRef = qcrp->ccrpRef;
     qcrp->cki.ctg = ctgNew;
     qcrp->cki.cno = cnoNew;
     _pggcrp->Move(icrpCur, icrpTarget);
 
+    if (pvNil != _pglicrpHash)
+    {
+        // see GG::Move for where things end up
+        if (icrpTarget > icrpCur)
+        {
+            _HashShift(icrpCur + 1, icrpTarget, -1);
+            _HashAdd(icrpTarget - 1);
+        }
+        else
+        {
+            _HashShift(icrpTarget, icrpCur, 1);
+            _HashAdd(icrpTarget);
+        }
+    }
+
     if (ccrpRef > 0)
     {
         // chunk has some parents
@@ -3048,6 +3745,11 @@ void CFL::_DeleteCore(long icrp)
     cki = qcrp->cki;
     _FreeFpCb(qcrp->Grfcrp(fcrpOnExtra), qcrp->fp, qcrp->Cb());
     _FSetRti(cki.ctg, cki.cno, rtiNil);
+    if (pvNil != _pglicrpHash)
+    {
+        _HashRemove(icrp);
+        _HashShift(icrp + 1, klwMax, -1);
+    }
     _pggcrp->Delete(icrp);
 }
 
@@ -3166,6 +3868,78 @@ void CFL::_FreeFpCb(bool fOnExtra, FP fp, long cb)
     pglfsm->FInsert(ifsmMin, &fsm);
 }
 
+/***************************************************************************
+    Return whether (fp, cb) is free space in the main file's free map.
+    If so and pifsm isn't nil, fills *pifsm with the free block holding it.
+***************************************************************************/
+bool CFL::_FFindFree(FP fp, long cb, long *pifsm)
+{
+    AssertBaseThis(0);
+    AssertIn(cb, 1, kcbMax);
+    AssertNilOrVarMem(pifsm);
+    long ifsm, ifsmMin, ifsmLim;
+    FSM *qrgfsm;
+
+    Assert(!_fFreeMapNotRead, "free map not read yet");
+    if (pvNil == _csto.pglfsm)
+        return fFalse;
+
+    // find the last block that starts at or before fp
+    qrgfsm = (FSM *)_csto.pglfsm->QvGet(0);
+    for (ifsmMin = 0, ifsmLim = _csto.pglfsm->IvMac(); ifsmMin < ifsmLim;)
+    {
+        ifsm = (ifsmMin + ifsmLim) / 2;
+        if (qrgfsm[ifsm].fp <= fp)
+            ifsmMin = ifsm + 1;
+        else
+            ifsmLim = ifsm;
+    }
+    if (ifsmMin-- == 0 || qrgfsm[ifsmMin].fp + qrgfsm[ifsmMin].cb < fp + cb)
+        return fFalse;
+
+    if (pvNil != pifsm)
+        *pifsm = ifsmMin;
+    return fTrue;
+}
+
+/***************************************************************************
+    Remove (fp, cb) from the main file's free map.  The space must be free.
+***************************************************************************/
+void CFL::_TakeFpCb(FP fp, long cb)
+{
+    AssertBaseThis(0);
+    long ifsm;
+    FSM fsm, fsmT;
+
+    if (!_FFindFree(fp, cb, &ifsm))
+    {
+        Bug("taking space that isn't free");
+        return;
+    }
+
+    _csto.pglfsm->Get(ifsm, &fsm);
+    if (fsm.fp == fp && fsm.cb == cb)
+    {
+        _csto.pglfsm->Delete(ifsm);
+        return;
+    }
+
+    // keep the space before (fp, cb), then the space after it
+    fsmT.fp = fp + cb;
+    fsmT.cb = fsm.fp + fsm.cb - fsmT.fp;
+    fsm.cb = fp - fsm.fp;
+    if (fsm.cb == 0)
+    {
+        _csto.pglfsm->Put(ifsm, &fsmT);
+        return;
+    }
+    _csto.pglfsm->Put(ifsm, &fsm);
+
+    // if it fails, we lose some space - so what
+    if (fsmT.cb > 0)
+        _csto.pglfsm->FInsert(ifsm + 1, &fsmT);
+}
+
 /***************************************************************************
     Set the name of the chunk.
 ***************************************************************************/
@@ -38,6 +38,11 @@ enum
     // to the hard drive.
     fcflReadFromExtra = 0x0010,
 
+    // This flag indicates that the (read-only) main file should be mapped
+    // into memory, so unpacked chunk data can be accessed in place (see
+    // BLCK::PvMapped). A mapped file can't be made write enabled.
+    fcflMapped = 0x0020,
+
 #ifdef DEBUG
     // for AssertValid
     fcflGraph = 0x4000, // check the graph structure for cycles
@@ -61,6 +66,9 @@ struct KID
 };
 const BOM kbomKid = 0xFC000000;
 
+// maximum number of threads CFL::FPackDataBatch packs chunks on
+const long kcthMaxPack = 32;
+
 /***************************************************************************
     Chunky file class.
 ***************************************************************************/
@@ -92,8 +100,11 @@ class CFL : public CFL_PAR
     bool _fFreeMapNotRead : 1;
     bool _fReadFromExtra : 1;
     bool _fInvalidMainFile : 1;
+    bool _fNoHashIndex : 1;
+    bool _fNoSaveInPlace : 1;
 
-    // for deferred reading of the free map
+    // where the free map is on file - for deferred reading of the free map
+    // and so in place saves know what space the file's index still uses
     FP _fpFreeMap;
     long _cbFreeMap;
 
@@ -110,6 +121,16 @@ class CFL : public CFL_PAR
     bool _FFindRtie(CTG ctg, CNO cno, RTIE *prtie = pvNil, long *pirtie = pvNil);
 #endif //! CHUNK_BIG_INDEX
 
+    // hash side index mapping (ctg, cno) to icrp - see chunk.cpp
+    PGL _pglicrpHash;
+
+    bool _FBuildHashIndex(void);
+    long _IslotHash(CTG ctg, CNO cno);
+    bool _FFindHash(CTG ctg, CNO cno, long *picrp);
+    void _HashAdd(long icrp);
+    void _HashRemove(long icrp);
+    void _HashShift(long icrpMin, long icrpLim, long dicrp);
+
     // static member variables
     static long _rtiLast;
     static PCFL _pcflFirst;
@@ -123,12 +144,16 @@ class CFL : public CFL_PAR
 
     bool _FReadIndex(void);
     tribool _TValidIndex(void);
-    bool _FWriteIndex(CTG ctgCreator);
+    bool _FWriteIndex(CTG ctgCreator, FP fpIndex);
+    tribool _TSaveInPlace(CTG ctgCreator);
+    long _IcrpLimRun(long icrp, PFLO pfloSrc);
     bool _FCreateExtra(void);
     bool _FAllocFlo(long cb, PFLO pflo, bool fForceOnExtra = fFalse);
     bool _FFindCtgCno(CTG ctg, CNO cno, long *picrp);
     void _GetUniqueCno(CTG ctg, long *picrp, CNO *pcno);
     void _FreeFpCb(bool fOnExtra, FP fp, long cb);
+    bool _FFindFree(FP fp, long cb, long *pifsm);
+    void _TakeFpCb(FP fp, long cb);
     bool _FAdd(long cb, CTG ctg, CNO cno, long icrp, PBLCK pblck);
     bool _FPut(long cb, CTG ctg, CNO cno, PBLCK pblck, PBLCK pblckSrc, void *pv);
     bool _FCopy(CTG ctgSrc, CNO cnoSrc, PCFL pcflDst, CNO *pcnoDst, bool fClone);
@@ -139,6 +164,7 @@ class CFL : public CFL_PAR
     bool _FFindChild(long icrpPar, CTG ctgChild, CNO cnoChild, CHID chid, long *pikid);
     bool _FAdoptChild(long icrpPar, long ikid, CTG ctgChild, CNO cnoChild, CHID chid, bool fClearLoner);
     void _ReadFreeMap(void);
+    PGL _PglfsmRead(FP fp, long cb);
     bool _FFindChidCtg(CTG ctgPar, CNO cnoPar, CHID chid, CTG ctg, KID *pkid);
     bool _FSetName(long icrp, PSTN pstn);
     bool _FGetName(long icrp, PSTN pstn);
@@ -191,6 +217,11 @@ class CFL : public CFL_PAR
     long ElError(void);
     void ResetEl(long el = elNil);
     bool FReopen(void);
+    void SetHashIndex(bool fHash);
+    void SetSaveInPlace(bool fInPlace)
+    {
+        _fNoSaveInPlace = !fInPlace;
+    }
 
     // finding and reading chunks
     bool FOnExtra(CTG ctg, CNO cno);
@@ -202,6 +233,8 @@ class CFL : public CFL_PAR
     bool FPacked(CTG ctg, CNO cno);
     bool FUnpackData(CTG ctg, CNO cno);
     bool FPackData(CTG ctg, CNO cno);
+    bool FPackDataBatch(PGL pglcki, long cth = 0);
+    bool FPackDataCtg(CTG ctg, long cth = 0);
 
     // creating and replacing chunks
     bool FAdd(long cb, CTG ctg, CNO *pcno, PBLCK pblck = pvNil);
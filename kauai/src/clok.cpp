@@ -69,6 +69,10 @@
     a 1/10 second gap between then end of handling one alarm and starting
     to handle the next alarm.
 
+    The alarms are kept in a binary heap, so setting one is O(log n) and
+    the next one due is always at the root. Each clock also keeps jitter
+    counters (see GetAljt) recording how late its alarms went off.
+
 ***************************************************************************/
 #include "frame.h"
 ASSERTNAME
@@ -95,6 +99,8 @@ CLOK::CLOK(long hid, ulong grfclok) : CMH(hid)
     _tsBase = 0;
     _grfclok = grfclok;
     _pglalad = pvNil;
+    _naladNext = 0;
+    ClearPb(&_aljt, size(ALJT));
     AssertThis(0);
 }
 
@@ -150,18 +156,86 @@ void CLOK::BuryCmh(PCMH pcmh)
 void CLOK::RemoveCmh(PCMH pcmh)
 {
     AssertThis(0);
-    ALAD *qalad;
-    long ialad;
+    ALAD *qrgalad;
+    long ialad, ialadDst, ialadMac;
 
     if (pvNil == _pglalad)
         return;
 
-    for (ialad = _pglalad->IvMac(); ialad-- > 0;)
+    // squeeze out the CMH's alarms, then rebuild the heap if any went
+    qrgalad = (ALAD *)_pglalad->QvGet(0);
+    ialadMac = _pglalad->IvMac();
+    for (ialad = ialadDst = 0; ialad < ialadMac; ialad++)
     {
-        qalad = (ALAD *)_pglalad->QvGet(ialad);
-        if (qalad->pcmh == pcmh)
-            _pglalad->Delete(ialad);
+        if (qrgalad[ialad].pcmh != pcmh)
+            qrgalad[ialadDst++] = qrgalad[ialad];
+    }
+    if (ialadDst == ialadMac)
+        return;
+
+    AssertDo(_pglalad->FSetIvMac(ialadDst), 0);
+    for (ialad = ialadDst / 2; ialad-- > 0;)
+        _SiftDown(ialad);
+}
+
+/***************************************************************************
+    Return whether the first alarm should go off before the second. Alarms
+    set for the same time go off most recently set first.
+***************************************************************************/
+bool CLOK::_FAladBefore(ALAD *palad1, ALAD *palad2)
+{
+    AssertVarMem(palad1);
+    AssertVarMem(palad2);
+
+    if (palad1->tim != palad2->tim)
+        return palad1->tim < palad2->tim;
+    return palad1->nalad > palad2->nalad;
+}
+
+/***************************************************************************
+    Move the ialad'th alarm toward the root of the heap until it's after
+    its parent.
+***************************************************************************/
+void CLOK::_SiftUp(long ialad)
+{
+    AssertPo(_pglalad, 0);
+    AssertIn(ialad, 0, _pglalad->IvMac());
+    ALAD *qrgalad = (ALAD *)_pglalad->QvGet(0);
+    ALAD alad = qrgalad[ialad];
+    long ialadPar;
+
+    for (; ialad > 0; ialad = ialadPar)
+    {
+        ialadPar = (ialad - 1) / 2;
+        if (!_FAladBefore(&alad, &qrgalad[ialadPar]))
+            break;
+        qrgalad[ialad] = qrgalad[ialadPar];
+    }
+    qrgalad[ialad] = alad;
+}
+
+/***************************************************************************
+    Move the ialad'th alarm away from the root of the heap until it's
+    before its children.
+***************************************************************************/
+void CLOK::_SiftDown(long ialad)
+{
+    AssertPo(_pglalad, 0);
+    AssertIn(ialad, 0, _pglalad->IvMac());
+    ALAD *qrgalad = (ALAD *)_pglalad->QvGet(0);
+    ALAD alad = qrgalad[ialad];
+    long ialadMac = _pglalad->IvMac();
+    long ialadKid;
+
+    for (; (ialadKid = 2 * ialad + 1) < ialadMac; ialad = ialadKid)
+    {
+        if (ialadKid + 1 < ialadMac && _FAladBefore(&qrgalad[ialadKid + 1], &qrgalad[ialadKid]))
+            ialadKid++;
+        if (!_FAladBefore(&qrgalad[ialadKid], &alad))
+            break;
+        qrgalad[ialad] = qrgalad[ialadKid];
     }
+    qrgalad[ialad] = alad;
 }
 
 /***************************************************************************
@@ -206,7 +280,6 @@ ulong CLOK::TimCur(bool fAdjustForDelay)
 
 /***************************************************************************
     Set an alarm for the given time and for the given command handler.
-    Alarms are sorted in _decreasing_ order.
 ***************************************************************************/
 bool CLOK::FSetAlarm(long dtim, PCMH pcmhNotify, long lwUser, bool fAdjustForDelay)
 {
@@ -214,25 +287,16 @@ bool CLOK::FSetAlarm(long dtim, PCMH pcmhNotify, long lwUser, bool fAdjustForDel
     AssertIn(dtim, 0, kcbMax);
     AssertNilOrPo(pcmhNotify, 0);
     ALAD alad;
-    ALAD *qalad;
-    long ialad, ialadMin, ialadLim;
 
     alad.pcmh = pcmhNotify;
     alad.tim = TimCur(fAdjustForDelay) + LwMax(dtim, 1);
     alad.lw = lwUser;
+    alad.nalad = _naladNext++;
     if (pvNil == _pglalad && pvNil == (_pglalad = GL::PglNew(size(ALAD), 1)))
         return fFalse;
-    for (ialadMin = 0, ialadLim = _pglalad->IvMac(); ialadMin < ialadLim;)
-    {
-        ialad = (ialadMin + ialadLim) / 2;
-        qalad = (ALAD *)_pglalad->QvGet(ialad);
-        if (qalad->tim < alad.tim)
-            ialadLim = ialad;
-        else
-            ialadMin = ialad + 1;
-    }
-    if (!_pglalad->FInsert(ialadMin, &alad))
+    if (!_pglalad->FAdd(&alad))
         return fFalse;
+    _SiftUp(_pglalad->IvMac() - 1);
     if (_timNext > alad.tim)
         _timNext = alad.tim;
     return fTrue;
@@ -250,7 +314,7 @@ bool CLOK::FCmdAll(PCMD pcmd)
     CMD cmd;
     long ialad;
     ALAD alad;
-    ulong tsCur, timCur;
+    ulong tsCur, timCur, timNow, dtimLate;
 
     _dtimAlarm = 0;
     if (pcmd->cid == cidAlarm)
@@ -287,6 +351,7 @@ bool CLOK::FCmdAll(PCMD pcmd)
     }
 
     // sound any alarms
+    timNow = timCur;
     for (;;)
     {
         if (pvNil == _pglalad || 0 > (ialad = _pglalad->IvMac() - 1))
@@ -294,13 +359,29 @@ bool CLOK::FCmdAll(PCMD pcmd)
             _timNext = kluMax;
             break;
         }
-        _pglalad->Get(ialad, &alad);
+        _pglalad->Get(0, &alad);
         if (alad.tim > timCur)
         {
             _timNext = alad.tim;
             break;
         }
-        _pglalad->Delete(ialad);
+
+        // take it off the heap, filling the root from the end
+        if (ialad > 0)
+        {
+            _pglalad->Put(0, _pglalad->QvGet(ialad));
+            _pglalad->Delete(ialad);
+            _SiftDown(0);
+        }
+        else
+            _pglalad->Delete(0);
+
+        // record how late it is
+        dtimLate = timNow - alad.tim;
+        _aljt.calad++;
+        _aljt.dtimLate += dtimLate;
+        if (_aljt.dtimLateMax < dtimLate)
+            _aljt.dtimLateMax = dtimLate;
 
         // adjust the current time
         _timCur = alad.tim;
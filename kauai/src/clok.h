@@ -23,6 +23,14 @@ enum
     fclokNoSlip = 2,
 };
 
+// Alarm jitter counters - how late alarms went off, in clock time.
+struct ALJT
+{
+    long calad;        // alarms sounded
+    ulong dtimLate;    // total lateness
+    ulong dtimLateMax; // worst lateness
+};
+
 typedef class CLOK *PCLOK;
 #define CLOK_PAR CMH
 #define kclsCLOK 'CLOK'
@@ -40,6 +48,7 @@ class CLOK : public CLOK_PAR
         PCMH pcmh;
         ulong tim;
         long lw;
+        ulong nalad; // breaks ties between alarms set for the same tim
     };
 
     static PCLOK _pclokFirst;
@@ -51,7 +60,13 @@ class CLOK : public CLOK_PAR
     ulong _dtimAlarm; // processing alarms up to _timCur + _dtimAlarm
     ulong _timNext;   // next alarm time to process (for speed)
     ulong _grfclok;
-    PGL _pglalad; // the registered alarms
+    PGL _pglalad; // the registered alarms, a heap with the next one first
+    ulong _naladNext;
+    ALJT _aljt; // alarm jitter counters
+
+    static bool _FAladBefore(ALAD *palad1, ALAD *palad2);
+    void _SiftUp(long ialad);
+    void _SiftDown(long ialad);
 
   public:
     CLOK(long hid, ulong grfclok = fclokNil);
@@ -70,6 +85,15 @@ class CLOK : public CLOK_PAR
 
     bool FSetAlarm(long dtim, PCMH pcmhNotify = pvNil, long lwUser = 0, bool fAdjustForDelay = fFalse);
 
+    void GetAljt(ALJT *paljt)
+    {
+        *paljt = _aljt;
+    }
+    void ResetAljt(void)
+    {
+        ClearPb(&_aljt, size(ALJT));
+    }
+
     // idle handling
     virtual bool FCmdAll(PCMD pcmd);
 
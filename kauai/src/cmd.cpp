@@ -23,6 +23,11 @@
 
     The CEX class supports command stream recording and playback.
 
+    Each command map chain gets a dispatch cache the first time a handler
+    using it is offered a command: a table, sorted by cid, of the CMME to
+    use for each of fcmmThis, fcmmNobody and fcmmOthers. The command maps
+    are static, so the caches live until the CEX goes away.
+
 ***************************************************************************/
 #include "frame.h"
 ASSERTNAME
@@ -34,7 +39,14 @@ END_CMD_MAP_NIL()
 RTCLASS(CMH)
 RTCLASS(CEX)
 
+// how many commands to grow the command queue by when it fills up
+const long kccmdQueueGrow = 16;
+
 long CMH::_hidLast;
+PGL CMH::_pglpcmm;
+
+// the grfcmm values a dispatch cache entry covers, in CMMC::rgpcmme order
+priv const ulong _rggrfcmmCache[] = {fcmmThis, fcmmNobody, fcmmOthers};
 
 #ifdef DEBUG
 /***************************************************************************
@@ -123,19 +135,51 @@ bool CMH::_FGetCmme(long cid, ulong grfcmmWanted, CMME *pcmme)
     AssertThis(0);
     AssertVarMem(pcmme);
     Assert(cid != cidNil, "why is the cid nil?");
-    CMM *pcmm;
+    CMM *pcmm = Pcmm();
+    CMME *pcmmeT;
+    CMMC *qcmmc;
+    long icmm, icmmc;
+
+    // the cache only covers a single target kind
+    for (icmm = 0; icmm < CvFromRgv(_rggrfcmmCache); icmm++)
+    {
+        if (_rggrfcmmCache[icmm] == grfcmmWanted)
+            break;
+    }
+
+    if (icmm >= CvFromRgv(_rggrfcmmCache) || (pvNil == pcmm->pglcmmc && !_FBuildCmmc(pcmm)))
+        pcmmeT = _PcmmeSearch(pcmm, cid, grfcmmWanted);
+    else
+    {
+        // entry 0 holds the defaults
+        if (!_FFindCmmc(pcmm->pglcmmc, cid, &icmmc))
+            icmmc = 0;
+        qcmmc = (CMMC *)pcmm->pglcmmc->QvGet(icmmc);
+        pcmmeT = qcmmc->rgpcmme[icmm];
+    }
+
+    if (pvNil == pcmmeT)
+        return fFalse;
+    *pcmme = *pcmmeT;
+    return fTrue;
+}
+
+/***************************************************************************
+    Walk the command map chain for the CMME to use for the given cid. If
+    cid is cidNil, this just finds the default.
+***************************************************************************/
+CMH::CMME *CMH::_PcmmeSearch(CMM *pcmm, long cid, ulong grfcmmWanted)
+{
+    AssertVarMem(pcmm);
     CMME *pcmmeT;
     CMME *pcmmeDef = pvNil;
 
-    for (pcmm = Pcmm(); pcmm != pvNil; pcmm = pcmm->pcmmBase)
+    for (; pcmm != pvNil; pcmm = pcmm->pcmmBase)
     {
         for (pcmmeT = pcmm->prgcmme; pcmmeT->cid != cidNil; pcmmeT++)
         {
             if (pcmmeT->cid == cid && (pcmmeT->grfcmm & grfcmmWanted))
-            {
-                *pcmme = *pcmmeT;
-                return fTrue;
-            }
+                return pcmmeT;
         }
 
         // check for a default function
@@ -146,14 +190,128 @@ bool CMH::_FGetCmme(long cid, ulong grfcmmWanted, CMME *pcmme)
     }
 
     // no specific one found, return the default one
-    if (pcmmeDef != pvNil)
+    return pcmmeDef;
+}
+
+/***************************************************************************
+    Build the dispatch cache for the command map chain starting at pcmm.
+    Entry 0 of the cache holds the defaults and the rest are sorted by cid.
+***************************************************************************/
+bool CMH::_FBuildCmmc(CMM *pcmm)
+{
+    AssertVarMem(pcmm);
+    Assert(pvNil == pcmm->pglcmmc, "dispatch cache already built");
+    PGL pglcmmc;
+    CMM *pcmmT;
+    CMME *pcmmeT;
+    CMMC cmmc;
+    long icmmc, icmm;
+
+    if (pvNil == _pglpcmm && pvNil == (_pglpcmm = GL::PglNew(size(CMM *))))
+        return fFalse;
+    if (pvNil == (pglcmmc = GL::PglNew(size(CMMC))))
+        return fFalse;
+
+    cmmc.cid = cidNil;
+    if (!pglcmmc->FAdd(&cmmc))
+        goto LFail;
+
+    for (pcmmT = pcmm; pcmmT != pvNil; pcmmT = pcmmT->pcmmBase)
     {
-        *pcmme = *pcmmeDef;
-        return fTrue;
+        for (pcmmeT = pcmmT->prgcmme; pcmmeT->cid != cidNil; pcmmeT++)
+        {
+            if (_FFindCmmc(pglcmmc, pcmmeT->cid, &icmmc))
+                continue;
+            cmmc.cid = pcmmeT->cid;
+            if (!pglcmmc->FInsert(icmmc, &cmmc))
+                goto LFail;
+        }
     }
+
+    for (icmmc = 0; icmmc < pglcmmc->IvMac(); icmmc++)
+    {
+        pglcmmc->Get(icmmc, &cmmc);
+        for (icmm = 0; icmm < CvFromRgv(_rggrfcmmCache); icmm++)
+            cmmc.rgpcmme[icmm] = _PcmmeSearch(pcmm, cmmc.cid, _rggrfcmmCache[icmm]);
+        pglcmmc->Put(icmmc, &cmmc);
+    }
+
+    if (!_pglpcmm->FAdd(&pcmm))
+        goto LFail;
+    pcmm->pglcmmc = pglcmmc;
+    return fTrue;
+
+LFail:
+    ReleasePpo(&pglcmmc);
     return fFalse;
 }
 
+/***************************************************************************
+    Binary search a dispatch cache for the cid. If it isn't there, still
+    sets *picmmc to where it would go.
+***************************************************************************/
+bool CMH::_FFindCmmc(PGL pglcmmc, long cid, long *picmmc)
+{
+    AssertPo(pglcmmc, 0);
+    AssertVarMem(picmmc);
+    long icmmc, icmmcMin, icmmcLim;
+    CMMC *qrgcmmc;
+
+    qrgcmmc = (CMMC *)pglcmmc->QvGet(0);
+    for (icmmcMin = 1, icmmcLim = pglcmmc->IvMac(); icmmcMin < icmmcLim;)
+    {
+        icmmc = (icmmcMin + icmmcLim) / 2;
+        if (qrgcmmc[icmmc].cid < cid)
+            icmmcMin = icmmc + 1;
+        else
+            icmmcLim = icmmc;
+    }
+
+    *picmmc = icmmcMin;
+    return icmmcMin < pglcmmc->IvMac() && qrgcmmc[icmmcMin].cid == cid;
+}
+
+/***************************************************************************
+    Static method to free all the dispatch caches. They are rebuilt if
+    any more commands are dispatched.
+***************************************************************************/
+void CMH::FreeCmmCaches(void)
+{
+    long ipcmm;
+    CMM *pcmm;
+
+    if (pvNil == _pglpcmm)
+        return;
+
+    for (ipcmm = _pglpcmm->IvMac(); ipcmm-- > 0;)
+    {
+        _pglpcmm->Get(ipcmm, &pcmm);
+        ReleasePpo(&pcmm->pglcmmc);
+    }
+    ReleasePpo(&_pglpcmm);
+}
+
+#ifdef DEBUG
+/***************************************************************************
+    Static method to mark the dispatch caches.
+***************************************************************************/
+void CMH::MarkCmmCaches(void)
+{
+    long ipcmm;
+    CMM *pcmm;
+
+    if (pvNil == _pglpcmm)
+        return;
+
+    MarkMemObj(_pglpcmm);
+    for (ipcmm = _pglpcmm->IvMac(); ipcmm-- > 0;)
+    {
+        _pglpcmm->Get(ipcmm, &pcmm);
+        MarkMemObj(pcmm->pglcmmc);
+    }
+}
+#endif // DEBUG
+
 /***************************************************************************
     Determines whether this command handler can handle the given command. If
     not, returns false (and does nothing else). If so, executes the command
@@ -238,14 +396,16 @@ CEX::~CEX(void)
 
     if (pvNil != _pglcmd)
     {
-        for (icmd = _pglcmd->IvMac(); icmd-- != 0;)
+        for (icmd = _ccmd; icmd-- != 0;)
         {
-            _pglcmd->Get(icmd, &cmd);
+            _pglcmd->Get(_IcmdRing(icmd), &cmd);
             ReleasePpo(&cmd.pgg);
         }
         ReleasePpo(&_pglcmd);
     }
 
+    ReleasePpo(&_pglcidt);
+    CMH::FreeCmmCaches();
     ReleasePpo(&_pglcmhe);
     ReleasePpo(&_pcfl);
     ReleasePpo(&_pglcmdf);
@@ -280,10 +440,12 @@ bool CEX::_FInit(long ccmdInit, long ccmhInit)
     AssertIn(ccmdInit, 0, kcbMax);
     AssertIn(ccmhInit, 0, kcbMax);
 
-    if (pvNil == (_pglcmd = GL::PglNew(size(CMD), ccmdInit)) || pvNil == (_pglcmhe = GL::PglNew(size(CMHE), ccmhInit)))
+    if (pvNil == (_pglcmd = GL::PglNew(size(CMD), ccmdInit)) || !_pglcmd->FSetIvMac(LwMax(1, ccmdInit)) ||
+        pvNil == (_pglcmhe = GL::PglNew(size(CMHE), ccmhInit)))
     {
         return fFalse;
     }
+    _tsCxct = TsCurrentSystem();
 
     AssertThis(0);
     return fTrue;
@@ -712,12 +874,12 @@ void CEX::BuryCmh(PCMH pcmh)
         }
     }
 
-    for (icmd = _pglcmd->IvMac(); icmd-- != 0;)
+    for (icmd = _ccmd; icmd-- != 0;)
     {
-        _pglcmd->Get(icmd, &cmd);
+        _pglcmd->Get(_IcmdRing(icmd), &cmd);
         if (cmd.pcmh == pcmh)
         {
-            _pglcmd->Delete(icmd);
+            _DeleteCmd(icmd);
             ReleasePpo(&cmd.pgg);
         }
     }
@@ -799,14 +961,16 @@ void CEX::EnqueueCmd(PCMD pcmd)
     AssertPo(pcmd, 0);
     Assert(pcmd->cid != cidNil, "why enqueue a nil command?");
 
-    if (!_pglcmd->FEnqueue(pcmd))
+    if (!_FEnsureCmdSpace())
     {
         Bug("event queue not big enough");
         ReleasePpo(&pcmd->pgg);
+        return;
     }
+    _pglcmd->Put(_IcmdRing(_ccmd++), pcmd);
 #ifdef DEBUG
-    if (_ccmdMax < _pglcmd->IvMac())
-        _ccmdMax = _pglcmd->IvMac();
+    if (_ccmdMax < _ccmd)
+        _ccmdMax = _ccmd;
 #endif // DEBUG
 }
 
@@ -821,17 +985,81 @@ void CEX::PushCmd(PCMD pcmd)
     AssertPo(pcmd, 0);
     Assert(pcmd->cid != cidNil, "why enqueue a nil command?");
 
-    if (!_pglcmd->FPush(pcmd))
+    if (!_FEnsureCmdSpace())
     {
         Bug("event queue not big enough");
         ReleasePpo(&pcmd->pgg);
+        return;
     }
+    _icmdFirst = _IcmdRing(_pglcmd->IvMac() - 1);
+    _ccmd++;
+    _pglcmd->Put(_icmdFirst, pcmd);
 #ifdef DEBUG
-    if (_ccmdMax < _pglcmd->IvMac())
-        _ccmdMax = _pglcmd->IvMac();
+    if (_ccmdMax < _ccmd)
+        _ccmdMax = _ccmd;
 #endif // DEBUG
 }
 
+/***************************************************************************
+    Make sure there's room in the command queue for another command. The
+    queue only grows when it's full, so queueing doesn't normally allocate.
+***************************************************************************/
+bool CEX::_FEnsureCmdSpace(void)
+{
+    AssertThis(0);
+    long ccmdOld, dccmd;
+    CMD *qrgcmd;
+
+    if (_ccmd < (ccmdOld = _pglcmd->IvMac()))
+        return fTrue;
+
+    // open the gap at the end of the ring, after the last command
+    dccmd = LwMax(ccmdOld, kccmdQueueGrow);
+    if (!_pglcmd->FSetIvMac(ccmdOld + dccmd))
+        return fFalse;
+    if (_icmdFirst > 0)
+    {
+        qrgcmd = (CMD *)_pglcmd->QvGet(0);
+        BltPb(qrgcmd + _icmdFirst, qrgcmd + _icmdFirst + dccmd, LwMul(ccmdOld - _icmdFirst, size(CMD)));
+        _icmdFirst += dccmd;
+    }
+    return fTrue;
+}
+
+/***************************************************************************
+    Take the command at the head of the queue. pcmd may be nil.
+***************************************************************************/
+bool CEX::_FPopCmd(PCMD pcmd)
+{
+    AssertThis(0);
+    AssertNilOrVarMem(pcmd);
+
+    if (_ccmd == 0)
+        return fFalse;
+
+    if (pvNil != pcmd)
+        _pglcmd->Get(_icmdFirst, pcmd);
+    _icmdFirst = _IcmdRing(1);
+    _ccmd--;
+    return fTrue;
+}
+
+/***************************************************************************
+    Remove the icmd'th command from the queue. Doesn't release its pgg.
+***************************************************************************/
+void CEX::_DeleteCmd(long icmd)
+{
+    AssertThis(0);
+    AssertIn(icmd, 0, _ccmd);
+    CMD cmd;
+
+    for (_ccmd--; icmd < _ccmd; icmd++)
+    {
+        _pglcmd->Get(_IcmdRing(icmd + 1), &cmd);
+        _pglcmd->Put(_IcmdRing(icmd), &cmd);
+    }
+}
+
 /***************************************************************************
     Checks if a cid is in the queue.
 ***************************************************************************/
@@ -843,9 +1071,9 @@ bool CEX::FCidIn(long cid)
     long icmd;
     CMD cmd;
 
-    for (icmd = _pglcmd->IvMac(); icmd-- > 0;)
+    for (icmd = _ccmd; icmd-- > 0;)
     {
-        _pglcmd->Get(icmd, &cmd);
+        _pglcmd->Get(_IcmdRing(icmd), &cmd);
         if (cmd.cid == cid)
             return fTrue;
     }
@@ -864,12 +1092,12 @@ void CEX::FlushCid(long cid)
     long icmd;
     CMD cmd;
 
-    for (icmd = _pglcmd->IvMac(); icmd-- > 0;)
+    for (icmd = _ccmd; icmd-- > 0;)
     {
-        _pglcmd->Get(icmd, &cmd);
+        _pglcmd->Get(_IcmdRing(icmd), &cmd);
         if (cmd.cid == cid)
         {
-            _pglcmd->Delete(icmd);
+            _DeleteCmd(icmd);
             ReleasePpo(&cmd.pgg);
         }
     }
@@ -887,7 +1115,7 @@ tribool CEX::_TGetNextCmd(void)
     AssertThis(0);
 
     // get the next command from the command stream
-    if (!_pglcmd->FPop(&_cmdCur))
+    if (!_FPopCmd(&_cmdCur))
     {
         ClearPb(&_cmdCur, size(_cmdCur));
         if (pvNil == _pgobTrack)
@@ -1006,6 +1234,8 @@ bool CEX::FDispatchNextCmd(void)
     CMHE cmhe;
     bool fHandled;
     bool tRet;
+    long cid;
+    ulong tus;
 
     if (_fDispatching)
     {
@@ -1021,6 +1251,10 @@ bool CEX::FDispatchNextCmd(void)
         return tRet != tNo;
     }
 
+    // handlers may change or nil out the cid, so count it as it came in
+    cid = _cmdCur.cid;
+    tus = TusCurrentSystem();
+
     // pipe it through the command handlers, then to the target
     fHandled = fFalse;
     for (_icmheNext = 0; _icmheNext < _pglcmhe->IvMac() && !fHandled;)
@@ -1049,11 +1283,91 @@ bool CEX::FDispatchNextCmd(void)
     }
 
     _CleanUpCmd();
+    _CountCmd(cid, TusCurrentSystem() - tus);
 
     _fDispatching = fFalse;
     return fTrue;
 }
 
+/***************************************************************************
+    Add a dispatched command to the counters. The per cid counters only
+    allocate the first time a cid is seen.
+***************************************************************************/
+void CEX::_CountCmd(long cid, ulong dtus)
+{
+    AssertThis(0);
+    long icidt, icidtMin, icidtLim;
+    CIDT *qrgcidt;
+    CIDT cidt;
+
+    _cxct.ccmd++;
+    _cxct.dtusDispatch += dtus;
+
+    if (pvNil == _pglcidt && pvNil == (_pglcidt = GL::PglNew(size(CIDT))))
+        return;
+
+    qrgcidt = (CIDT *)_pglcidt->QvGet(0);
+    for (icidtMin = 0, icidtLim = _pglcidt->IvMac(); icidtMin < icidtLim;)
+    {
+        icidt = (icidtMin + icidtLim) / 2;
+        if (qrgcidt[icidt].cid < cid)
+            icidtMin = icidt + 1;
+        else
+            icidtLim = icidt;
+    }
+
+    if (icidtMin < _pglcidt->IvMac() && qrgcidt[icidtMin].cid == cid)
+    {
+        qrgcidt[icidtMin].ccmd++;
+        qrgcidt[icidtMin].dtus += dtus;
+        return;
+    }
+
+    cidt.cid = cid;
+    cidt.ccmd = 1;
+    cidt.dtus = dtus;
+    _pglcidt->FInsert(icidtMin, &cidt);
+}
+
+/***************************************************************************
+    Get the dispatch counters. Commands per second is
+    ccmd * kdtsSecond / dtsElapsed.
+***************************************************************************/
+void CEX::GetCxct(CXCT *pcxct)
+{
+    AssertThis(0);
+    AssertVarMem(pcxct);
+
+    *pcxct = _cxct;
+    pcxct->dtsElapsed = TsCurrentSystem() - _tsCxct;
+}
+
+/***************************************************************************
+    Reset the dispatch counters, including the per cid ones.
+***************************************************************************/
+void CEX::ResetCxct(void)
+{
+    AssertThis(0);
+
+    ClearPb(&_cxct, size(CXCT));
+    _tsCxct = TsCurrentSystem();
+    if (pvNil != _pglcidt)
+        _pglcidt->FSetIvMac(0);
+}
+
+/***************************************************************************
+    Get the counters for the icidt'th cid dispatched since the counters
+    were reset. These are sorted by cid.
+***************************************************************************/
+void CEX::GetCidt(long icidt, CIDT *pcidt)
+{
+    AssertThis(0);
+    AssertIn(icidt, 0, Ccidt());
+    AssertVarMem(pcidt);
+
+    _pglcidt->Get(icidt, pcidt);
+}
+
 /***************************************************************************
     Give the handler a crack at enabling/disabling the command.
 ***************************************************************************/
@@ -1147,17 +1461,16 @@ bool CEX::FGetNextKey(PCMD pcmd)
 {
     AssertThis(0);
     AssertVarMem(pcmd);
-    long iv;
 
     if (_rs != rsNormal)
         goto LFail;
-    if ((iv = _pglcmd->IvMac()) > 0)
+    if (_ccmd > 0)
     {
         // get next cmd
-        _pglcmd->Get(iv - 1, pcmd);
+        _pglcmd->Get(_icmdFirst, pcmd);
         if (pcmd->cid == cidKey)
         {
-            AssertDo(_pglcmd->FPop(pvNil), 0);
+            AssertDo(_FPopCmd(pvNil), 0);
             return fTrue;
         }
     LFail:
@@ -1251,6 +1564,9 @@ void CEX::AssertValid(ulong grf)
     CEX_PAR::AssertValid(fobjAllocated);
     AssertPo(_pglcmhe, 0);
     AssertPo(_pglcmd, 0);
+    AssertIn(_ccmd, 0, _pglcmd->IvMac() + 1);
+    AssertIn(_icmdFirst, 0, _pglcmd->IvMac());
+    AssertNilOrPo(_pglcidt, 0);
     AssertNilOrPo(_pglcmdf, 0);
     AssertNilOrPo(_pcfl, 0);
     AssertNilOrPo(_cmdCur.pgg, 0);
@@ -1268,12 +1584,14 @@ void CEX::MarkMem(void)
     CEX_PAR::MarkMem();
     MarkMemObj(_pglcmhe);
     MarkMemObj(_pglcmd);
+    MarkMemObj(_pglcidt);
     MarkMemObj(_pglcmdf);
     MarkMemObj(_cmdCur.pgg);
+    CMH::MarkCmmCaches();
 
-    for (icmd = _pglcmd->IvMac(); icmd-- != 0;)
+    for (icmd = _ccmd; icmd-- != 0;)
     {
-        _pglcmd->Get(icmd, &cmd);
+        _pglcmd->Get(_IcmdRing(icmd), &cmd);
         if (cmd.pgg != pvNil)
             MarkMemObj(cmd.pgg);
     }
@@ -143,6 +143,7 @@ class CMH : public CMH_PAR
 
   private:
     static long _hidLast; // for HidUnique
+    static PGL _pglpcmm;  // command maps that have a dispatch cache
     long _hid;            // handler id
 
   protected:
@@ -166,6 +167,15 @@ class CMH : public CMH_PAR
     {
         CMM *pcmmBase;
         CMME *prgcmme;
+        PGL pglcmmc; // dispatch cache, built the first time the map is searched
+    };
+
+    // dispatch cache entry - the CMME that handles the cid when the wanted
+    // grfcmm is fcmmThis, fcmmNobody and fcmmOthers respectively
+    struct CMMC
+    {
+        long cid;
+        CMME *rgpcmme[3];
     };
 
     CMD_MAP_DEC(CMH)
@@ -173,6 +183,10 @@ class CMH : public CMH_PAR
   protected:
     virtual bool _FGetCmme(long cid, ulong grfcmmWanted, CMME *pcmme);
 
+    static CMME *_PcmmeSearch(CMM *pcmm, long cid, ulong grfcmmWanted);
+    static bool _FBuildCmmc(CMM *pcmm);
+    static bool _FFindCmmc(PGL pglcmmc, long cid, long *picmmc);
+
   public:
     CMH(long hid);
     ~CMH(void);
@@ -187,6 +201,12 @@ class CMH : public CMH_PAR
     }
 
     static long HidUnique(long ccmh = 1);
+
+    // dispatch caches
+    static void FreeCmmCaches(void);
+#ifdef DEBUG
+    static void MarkCmmCaches(void);
+#endif // DEBUG
 };
 
 /***************************************************************************
@@ -203,6 +223,22 @@ enum
     recLim
 };
 
+// Command dispatch counters.  Times are in microseconds.
+struct CXCT
+{
+    long ccmd;          // commands dispatched
+    ulong dtusDispatch; // time spent dispatching them
+    ulong dtsElapsed;   // time since the counters were reset
+};
+
+// dispatch counters for a single cid
+struct CIDT
+{
+    long cid;
+    long ccmd;  // times dispatched
+    ulong dtus; // time spent dispatching it
+};
+
 typedef class CEX *PCEX;
 #define CEX_PAR BASE
 #define kclsCEX 'CEX'
@@ -252,9 +288,16 @@ class CEX : public CEX_PAR
 
     // filter list and command queue
     PGL _pglcmhe;       // the command filter list
-    PGL _pglcmd;        // the command queue
+    PGL _pglcmd;        // the command queue - a ring of _ccmd CMDs from _icmdFirst
+    long _icmdFirst;    // next command to dispatch
+    long _ccmd;         // number of commands in the queue
     bool _fDispatching; // whether we're currently in FDispatchNextCmd
 
+    // dispatch counters
+    CXCT _cxct;
+    ulong _tsCxct; // when the counters were reset
+    PGL _pglcidt;  // per cid counters, sorted by cid
+
     // Modal filtering
     PGOB _pgobModal;
 
@@ -276,6 +319,17 @@ class CEX : public CEX_PAR
     // command recording and playback
     bool _FReadCmd(PCMD pcmd);
 
+    // the command queue
+    long _IcmdRing(long icmd)
+    {
+        return (_icmdFirst + icmd) % _pglcmd->IvMac();
+    }
+    bool _FEnsureCmdSpace(void);
+    bool _FPopCmd(PCMD pcmd);
+    void _DeleteCmd(long icmd);
+
+    void _CountCmd(long cid, ulong dtus);
+
   public:
     static PCEX PcexNew(long ccmdInit, long ccmhInit);
     ~CEX(void);
@@ -325,6 +379,15 @@ class CEX : public CEX_PAR
 
     virtual void Suspend(bool fSuspend = fTrue);
     virtual void SetModalGob(PGOB pgob);
+
+    // dispatch counters
+    void GetCxct(CXCT *pcxct);
+    void ResetCxct(void);
+    long Ccidt(void)
+    {
+        return pvNil == _pglcidt ? 0 : _pglcidt->IvMac();
+    }
+    void GetCidt(long icidt, CIDT *pcidt);
 };
 
 #endif //! CMD_H
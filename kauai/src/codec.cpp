@@ -32,6 +32,7 @@ CODM::CODM(PCODC pcodc, long cfmt)
     Assert(cfmtNil != cfmt, "nil default compression format");
 
     _cfmtDef = cfmt;
+    _ceffDef = kceffMax;
     _pcodcDef = pcodc;
     if (pvNil != _pcodcDef)
         _pcodcDef->AddRef();
@@ -70,6 +71,7 @@ void CODM::AssertValid(ulong grf)
 {
     CODM_PAR::AssertValid(0);
     Assert(cfmtNil != _cfmtDef, "nil default compression");
+    AssertIn(_ceffDef, kceffMin, kceffMax + 1);
     AssertNilOrPo(_pcodcDef, 0);
     AssertNilOrPo(_pglpcodc, 0);
 }
@@ -114,6 +116,22 @@ void CODM::SetCfmtDefault(long cfmt)
     _cfmtDef = cfmt;
 }
 
+/***************************************************************************
+    Set the default encoding effort level.
+***************************************************************************/
+void CODM::SetCeffDefault(long ceff)
+{
+    AssertThis(0);
+
+    if (!FIn(ceff, kceffMin, kceffMax + 1))
+    {
+        Bug("bad effort level");
+        return;
+    }
+
+    _ceffDef = ceff;
+}
+
 /***************************************************************************
     Add a codec to the compression manager.
 ***************************************************************************/
@@ -205,9 +223,10 @@ bool CODM::_FFindCodec(bool fEncode, long cfmt, PCODC *ppcodc)
 
 /***************************************************************************
     Compress or decompress an hq of data. Note that the value of *phq
-    may change. cfmt should be cfmtNil to decompress.
+    may change. cfmt should be cfmtNil to decompress. ceff is the
+    encoding effort level.
 ***************************************************************************/
-bool CODM::_FCodePhq(long cfmt, HQ *phq)
+bool CODM::_FCodePhq(long cfmt, long ceff, HQ *phq)
 {
     AssertThis(0);
     AssertVarMem(phq);
@@ -221,7 +240,7 @@ bool CODM::_FCodePhq(long cfmt, HQ *phq)
 
     pvSrc = PvLockHq(*phq);
     cbSrc = CbOfHq(*phq);
-    fRet = _FCode(cfmt, pvSrc, cbSrc, pvNil, 0, &cbDst);
+    fRet = _FCode(cfmt, ceff, pvSrc, cbSrc, pvNil, 0, &cbDst);
     UnlockHq(*phq);
     if (!fRet)
         return fFalse;
@@ -230,7 +249,7 @@ bool CODM::_FCodePhq(long cfmt, HQ *phq)
         return fFalse;
 
     pvSrc = PvLockHq(*phq);
-    fRet = _FCode(cfmt, pvSrc, cbSrc, PvLockHq(hqDst), cbDst, &cbDst);
+    fRet = _FCode(cfmt, ceff, pvSrc, cbSrc, PvLockHq(hqDst), cbDst, &cbDst);
     UnlockHq(hqDst);
     UnlockHq(*phq);
     if (!fRet)
@@ -250,9 +269,9 @@ bool CODM::_FCodePhq(long cfmt, HQ *phq)
 /***************************************************************************
     Compress or decompress a block of data. If pvDst is nil, just fill
     *pcbDst with the required destination buffer size. This is just an
-    estimate in the compress case.
+    estimate in the compress case. ceff is the encoding effort level.
 ***************************************************************************/
-bool CODM::_FCode(long cfmt, void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst)
+bool CODM::_FCode(long cfmt, long ceff, void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst)
 {
     AssertIn(cbSrc, 1, kcbMax);
     AssertPvCb(pvSrc, cbSrc);
@@ -288,7 +307,8 @@ bool CODM::_FCode(long cfmt, void *pvSrc, long cbSrc, void *pvDst, long cbDst, l
         }
 
         prgb = (byte *)pvDst;
-        if (!pcodc->FConvert(fTrue, cfmt, pvSrc, cbSrc, prgb + kcbCodecHeader, cbDst - kcbCodecHeader, pcbDst))
+        AssertIn(ceff, kceffMin, kceffMax + 1);
+        if (!pcodc->FConvert(fTrue, cfmt, pvSrc, cbSrc, prgb + kcbCodecHeader, cbDst - kcbCodecHeader, pcbDst, ceff))
         {
             return fFalse;
         }
@@ -326,7 +346,7 @@ bool CODM::_FCode(long cfmt, void *pvSrc, long cbSrc, void *pvDst, long cbDst, l
             return fTrue;
 
         cbDst = *pcbDst;
-        if (!pcodc->FConvert(fFalse, cfmt, prgb + kcbCodecHeader, cbSrc, pvDst, cbDst, pcbDst))
+        if (!pcodc->FConvert(fFalse, cfmt, prgb + kcbCodecHeader, cbSrc, pvDst, cbDst, pcbDst, ceffNil))
         {
             return fFalse;
         }
@@ -15,6 +15,15 @@
 #ifndef CODEC_H
 #define CODEC_H
 
+/***************************************************************************
+    Encoding effort levels. Higher levels take longer and (usually) give
+    smaller output; codecs without a speed/size trade-off ignore the level.
+    ceffNil means use the codec manager's default level.
+***************************************************************************/
+#define ceffNil 0
+const long kceffMin = 1;
+const long kceffMax = 9;
+
 /***************************************************************************
     Codec object.
 ***************************************************************************/
@@ -30,8 +39,10 @@ class CODC : public CODC_PAR
     virtual bool FCanDo(bool fEncode, long cfmt) = 0;
 
     // Decompression should be extremely fast. Compression may be
-    // (painfully) slow.
-    virtual bool FConvert(bool fEncode, long cfmt, void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst) = 0;
+    // (painfully) slow. ceff is the encoding effort level in
+    // [kceffMin, kceffMax] and is ignored when decoding.
+    virtual bool FConvert(bool fEncode, long cfmt, void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst,
+                          long ceff) = 0;
 };
 
 /***************************************************************************
@@ -48,12 +59,13 @@ class CODM : public CODM_PAR
 
   protected:
     long _cfmtDef;
+    long _ceffDef;
     PCODC _pcodcDef;
     PGL _pglpcodc;
 
     virtual bool _FFindCodec(bool fEncode, long cfmt, PCODC *ppcodc);
-    virtual bool _FCodePhq(long cfmt, HQ *phq);
-    virtual bool _FCode(long cfmt, void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst);
+    virtual bool _FCodePhq(long cfmt, long ceff, HQ *phq);
+    virtual bool _FCode(long cfmt, long ceff, void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst);
 
   public:
     CODM(PCODC pcodc, long cfmt);
@@ -64,6 +76,11 @@ class CODM : public CODM_PAR
         return _cfmtDef;
     }
     void SetCfmtDefault(long cfmt);
+    long CeffDefault(void)
+    {
+        return _ceffDef;
+    }
+    void SetCeffDefault(long ceff);
     virtual bool FRegisterCodec(PCODC pcodc);
     virtual bool FCanDo(long cfmt, bool fEncode);
 
@@ -74,23 +91,26 @@ class CODM : public CODM_PAR
     // FDecompress allows pvDst to be nil (in which case *pcbDst is filled
     // in with the buffer size required).
     // FCompress also allows pvDst to be nil, but the value returned in
-    // *pcbDst will just be cbSrc - 1.
+    // *pcbDst will just be cbSrc - 1. ceffNil means use the default
+    // effort level.
     bool FDecompressPhq(HQ *phq)
     {
-        return _FCodePhq(cfmtNil, phq);
+        return _FCodePhq(cfmtNil, ceffNil, phq);
     }
-    bool FCompressPhq(HQ *phq, long cfmt = cfmtNil)
+    bool FCompressPhq(HQ *phq, long cfmt = cfmtNil, long ceff = ceffNil)
     {
-        return _FCodePhq(cfmtNil == cfmt ? _cfmtDef : cfmt, phq);
+        return _FCodePhq(cfmtNil == cfmt ? _cfmtDef : cfmt, ceffNil == ceff ? _ceffDef : ceff, phq);
     }
 
     bool FDecompress(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst)
     {
-        return _FCode(cfmtNil, pvSrc, cbSrc, pvDst, cbDst, pcbDst);
+        return _FCode(cfmtNil, ceffNil, pvSrc, cbSrc, pvDst, cbDst, pcbDst);
     }
-    bool FCompress(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst, long cfmt = cfmtNil)
+    bool FCompress(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst, long cfmt = cfmtNil,
+                   long ceff = ceffNil)
     {
-        return _FCode(cfmtNil == cfmt ? _cfmtDef : cfmt, pvSrc, cbSrc, pvDst, cbDst, pcbDst);
+        return _FCode(cfmtNil == cfmt ? _cfmtDef : cfmt, ceffNil == ceff ? _ceffDef : ceff, pvSrc, cbSrc, pvDst, cbDst,
+                      pcbDst);
     }
 };
 
@@ -105,9 +125,9 @@ class KCDC : public KCDC_PAR
     RTCLASS_DEC
 
   protected:
-    bool _FEncode(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst);
+    bool _FEncode(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst, long ceff);
     bool _FDecode(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst);
-    bool _FEncode2(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst);
+    bool _FEncode2(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst, long ceff);
     bool _FDecode2(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst);
 
   public:
@@ -115,7 +135,8 @@ class KCDC : public KCDC_PAR
     {
         return kcfmtKauai2 == cfmt || kcfmtKauai == cfmt;
     }
-    virtual bool FConvert(bool fEncode, long cfmt, void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst);
+    virtual bool FConvert(bool fEncode, long cfmt, void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst,
+                          long ceff);
 };
 
 #endif //! CODEC_H
@@ -117,7 +117,8 @@ RTCLASS(KCDC)
 /***************************************************************************
     Encode or decode a block.
 ***************************************************************************/
-bool KCDC::FConvert(bool fEncode, long cfmt, void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst)
+bool KCDC::FConvert(bool fEncode, long cfmt, void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst,
+                    long ceff)
 {
     AssertThis(0);
     AssertIn(cbSrc, 1, kcbMax);
@@ -125,6 +126,10 @@ bool KCDC::FConvert(bool fEncode, long cfmt, void *pvSrc, long cbSrc, void *pvDs
     AssertIn(cbDst, 1, kcbMax);
     AssertPvCb(pvDst, cbDst);
     AssertVarMem(pcbDst);
+    AssertIn(ceff, ceffNil, kceffMax + 1);
+
+    if (ceffNil == ceff)
+        ceff = kceffMax;
 
     switch (cfmt)
     {
@@ -133,12 +138,12 @@ bool KCDC::FConvert(bool fEncode, long cfmt, void *pvSrc, long cbSrc, void *pvDs
 
     case kcfmtKauai2:
         if (fEncode)
-            return _FEncode2(pvSrc, cbSrc, pvDst, cbDst, pcbDst);
+            return _FEncode2(pvSrc, cbSrc, pvDst, cbDst, pcbDst, ceff);
         return _FDecode2(pvSrc, cbSrc, pvDst, cbDst, pcbDst);
 
     case kcfmtKauai:
         if (fEncode)
-            return _FEncode(pvSrc, cbSrc, pvDst, cbDst, pcbDst);
+            return _FEncode(pvSrc, cbSrc, pvDst, cbDst, pcbDst, ceff);
         return _FDecode(pvSrc, cbSrc, pvDst, cbDst, pcbDst);
     }
 }
@@ -245,11 +250,222 @@ bool BITA::FWriteLogEncoded(ulong lu)
     return FWriteBits(lu << 1, cbit + 1);
 }
 
+/***************************************************************************
+    Match finder - for finding runs to encode. Byte pairs are hashed and
+    each position is linked to the previous position with the same hash.
+    The links live in a ring buffer, so only the last _dibWindow positions
+    are remembered. At kceffMax the window covers the whole source and the
+    chains aren't limited, so the search is exhaustive.
+***************************************************************************/
+class KCMF
+{
+  protected:
+    byte *_prgbSrc;
+    long _cbSrc;
+    long _ibLink;     // positions before this are linked in
+    long _dibWindow;  // how far back to look
+    long _ibMask;     // maps a position to its slot in _prgibNext
+    long _cactChain;  // maximum number of candidates to try
+    long _cbitHash;   // number of bits in the hash
+    long *_prgibHead; // most recent position for each hash value
+    long *_prgibNext; // previous position with the same hash
+
+    long _IibHead(long ib);
+    void _Link(long ib);
+
+  public:
+    KCMF(void);
+    ~KCMF(void);
+
+    bool FInit(void *pvSrc, long cbSrc, long ceff);
+    long CbMatch(long ibSrc, long *pibMatch);
+};
+
+// search parameters for the effort levels
+struct KCEF
+{
+    long cbitWindow; // 0 means the window isn't bounded
+    long cactChain;  // klwMax means the chains aren't bounded
+};
+
+static const KCEF _rgkcef[kceffMax - kceffMin + 1] = {
+    {16, 1}, {16, 4}, {17, 8}, {18, 16}, {19, 32}, {20, 64}, {20, 256}, {20, 1024}, {0, klwMax},
+};
+
+/***************************************************************************
+    Constructor for the match finder.
+***************************************************************************/
+KCMF::KCMF(void)
+{
+    _prgibHead = pvNil;
+    _prgibNext = pvNil;
+}
+
+/***************************************************************************
+    Destructor for the match finder.
+***************************************************************************/
+KCMF::~KCMF(void)
+{
+    FreePpv((void **)&_prgibHead);
+    FreePpv((void **)&_prgibNext);
+}
+
+/***************************************************************************
+    Get ready to find matches in the given source. ceff is the effort
+    level.
+***************************************************************************/
+bool KCMF::FInit(void *pvSrc, long cbSrc, long ceff)
+{
+    AssertIn(cbSrc, 1, kcbMax);
+    AssertPvCb(pvSrc, cbSrc);
+    AssertIn(ceff, kceffMin, kceffMax + 1);
+    const KCEF *pkcef = &_rgkcef[ceff - kceffMin];
+    long cibNext;
+
+    _prgbSrc = (byte *)pvSrc;
+    _cbSrc = cbSrc;
+    _ibLink = 0;
+    _cactChain = pkcef->cactChain;
+
+    // hash byte pairs directly at full effort, otherwise scale the head
+    // table to the source so small blocks don't pay for a big table
+    if (ceff == kceffMax)
+        _cbitHash = 16;
+    else
+    {
+        for (_cbitHash = 10; _cbitHash < 16 && (1L << _cbitHash) < cbSrc; _cbitHash++)
+            ;
+    }
+
+    if (0 == pkcef->cbitWindow || cbSrc <= (1L << pkcef->cbitWindow))
+    {
+        // the window covers the entire source, so the ring never wraps
+        _dibWindow = kdibMinKcdc4;
+        _ibMask = -1;
+        cibNext = cbSrc;
+    }
+    else
+    {
+        _dibWindow = 1L << pkcef->cbitWindow;
+        _ibMask = _dibWindow - 1;
+        cibNext = _dibWindow;
+    }
+
+    if (!FAllocPv((void **)&_prgibNext, LwMul(size(long), cibNext), fmemNil, mprNormal) ||
+        !FAllocPv((void **)&_prgibHead, LwMul(size(long), 1L << _cbitHash), fmemNil, mprNormal))
+    {
+        return fFalse;
+    }
+
+    // we need to set each entry of _prgibHead to a big negative number,
+    // but not too big, or we risk overflow below.
+    FillPb(_prgibHead, LwMul(size(long), 1L << _cbitHash), 0xCC);
+    return fTrue;
+}
+
+/***************************************************************************
+    Return the index into the head table for the byte pair at ib.
+***************************************************************************/
+inline long KCMF::_IibHead(long ib)
+{
+    ulong lu = ((ulong)_prgbSrc[ib]) << 8 | (ulong)_prgbSrc[ib + 1];
+
+    if (_cbitHash == 16)
+        return lu;
+    return (long)(((lu * 40503) & 0xFFFF) >> (16 - _cbitHash));
+}
+
+/***************************************************************************
+    Add the position ib to its hash chain.
+***************************************************************************/
+inline void KCMF::_Link(long ib)
+{
+    long iibHead;
+
+    if (ib >= _cbSrc - 1)
+        return;
+
+    iibHead = _IibHead(ib);
+    _prgibNext[ib & _ibMask] = _prgibHead[iibHead];
+    _prgibHead[iibHead] = ib;
+}
+
+/***************************************************************************
+    Find the best match for the bytes at ibSrc. Returns the length of the
+    match and fills in *pibMatch. A return of 1 means there is no match
+    and the byte should be stored as a literal. Calls must be made with
+    increasing values of ibSrc.
+***************************************************************************/
+long KCMF::CbMatch(long ibSrc, long *pibMatch)
+{
+    AssertIn(ibSrc, _ibLink, _cbSrc);
+    AssertVarMem(pibMatch);
+
+    long ibMatch, ibTest, cbMatch, ibMin, cbT;
+    long cactChain;
+    byte bMatchNew, bMatchLast;
+    byte *pbMatch;
+    long cbMaxMatch;
+
+    // link in everything we've skipped over
+    for (; _ibLink < ibSrc; _ibLink++)
+        _Link(_ibLink);
+
+    // assume we'll store a literal
+    cbMatch = 1;
+    ibMatch = ibSrc;
+
+    if (ibSrc >= _cbSrc - 1)
+        goto LDone;
+
+    ibTest = _prgibHead[_IibHead(ibSrc)];
+    Assert(ibTest < ibSrc, 0);
+    if (ibTest <= (ibMin = ibSrc - LwMin(_dibWindow, kdibMinKcdc4)))
+        goto LDone;
+
+    // we've seen this byte pair before - look for the longest match
+    cbMaxMatch = LwMin(kcbMaxLenKcdc, _cbSrc - ibSrc);
+    pbMatch = _prgbSrc + ibSrc;
+    bMatchNew = _prgbSrc[ibSrc + 1];
+    bMatchLast = _prgbSrc[ibSrc];
+    for (cactChain = _cactChain; ibTest > ibMin && cactChain-- > 0; ibTest = _prgibNext[ibTest & _ibMask])
+    {
+        Assert(_cbitHash < 16 || _prgbSrc[ibTest + 1] == _prgbSrc[ibSrc + 1], "links are wrong");
+        if (_prgbSrc[ibTest + cbMatch] != bMatchNew || _prgbSrc[ibTest + cbMatch - 1] != bMatchLast ||
+            cbMatch >= (cbT = CbEqualRgb(_prgbSrc + ibTest, pbMatch, cbMaxMatch)))
+        {
+            Assert(_prgibNext[ibTest & _ibMask] < ibTest, 0);
+            continue;
+        }
+
+        AssertIn(cbT, cbMatch + 1, kcbMaxLenKcdc + 1);
+
+        // if this run requires a 20 bit offset, we need to beat a
+        // 9 or 6 bit offset by 2 bytes
+        if (ibSrc - ibTest < kdibMinKcdc3 || cbT - cbMatch > 1 || ibSrc - ibMatch >= kdibMinKcdc2)
+        {
+            cbMatch = cbT;
+            ibMatch = ibTest;
+            if (cbMatch == cbMaxMatch)
+                break;
+            bMatchNew = _prgbSrc[ibSrc + cbMatch];
+            bMatchLast = _prgbSrc[ibSrc + cbMatch - 1];
+        }
+
+        Assert(_prgibNext[ibTest & _ibMask] < ibTest, 0);
+    }
+
+LDone:
+    *pibMatch = ibMatch;
+    return cbMatch;
+}
+
 /***************************************************************************
     Compress the data in pvSrc using the KCDC encoding.  Returns false if
-    the data can't be compressed. This is not optimized (ie, it's slow).
+    the data can't be compressed. ceff is the effort level - at kceffMax
+    this does an exhaustive search (ie, it's slow).
 ***************************************************************************/
-bool KCDC::_FEncode(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst)
+bool KCDC::_FEncode(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst, long ceff)
 {
     AssertThis(0);
     AssertIn(cbSrc, 1, kcbMax);
@@ -257,95 +473,35 @@ bool KCDC::_FEncode(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbD
     AssertIn(cbDst, 1, kcbMax);
     AssertPvCb(pvDst, cbDst);
     AssertVarMem(pcbDst);
+    AssertIn(ceff, kceffMin, kceffMax + 1);
 
     long ibSrc;
-    long ibMatch, ibTest, cbMatch, ibMin, cbT;
-    byte bMatchNew, bMatchLast;
+    long ibMatch, cbMatch, cbT;
     BITA bita;
-    long *pmpsuibStart = pvNil;
+    KCMF kcmf;
     byte *prgbSrc = (byte *)pvSrc;
-    long *pmpibibNext = pvNil;
 
     TrashVar(pcbDst);
     if (cbDst - kcbTailKcdc <= 1)
         return fFalse;
 
     // allocate the links
-    if (!FAllocPv((void **)&pmpibibNext, LwMul(size(long), cbSrc), fmemNil, mprNormal) ||
-        !FAllocPv((void **)&pmpsuibStart, LwMul(size(long), 0x10000), fmemNil, mprNormal))
+    if (!kcmf.FInit(pvSrc, cbSrc, ceff))
     {
         Warn("failed to allocate memory for links");
         goto LFail;
     }
 
-    // write the links
-    // we need to set each entry of pmpsuibStart to a big negative number,
-    // but not too big, or we risk overflow below.
-    FillPb(pmpsuibStart, LwMul(size(long), 0x10000), 0xCC);
-    for (ibSrc = 0; ibSrc < cbSrc - 1; ibSrc++)
-    {
-        ushort suCur = ((ushort)prgbSrc[ibSrc]) << 8 | (ushort)prgbSrc[ibSrc + 1];
-        ibTest = pmpsuibStart[suCur];
-        pmpsuibStart[suCur] = ibSrc;
-        pmpibibNext[ibSrc] = ibTest;
-    }
-    pmpibibNext[cbSrc - 1] = 0xCCCCCCCCL;
-    FreePpv((void **)&pmpsuibStart);
-
     // write flags byte
     bita.Set(pvDst, cbDst);
     AssertDo(bita.FWriteBits(0, 8), 0);
 
     for (ibSrc = 0; ibSrc < cbSrc; ibSrc += cbMatch)
     {
-        byte *pbMatch;
-        long cbMaxMatch;
-
-        // get the new byte and the link
-        ibTest = pmpibibNext[ibSrc];
-        Assert(ibTest < ibSrc, 0);
-
-        // assume we'll store a literal
-        cbMatch = 1;
-        ibMatch = ibSrc;
-
-        if (ibTest <= (ibMin = ibSrc - kdibMinKcdc4))
-            goto LStore;
-
-        // we've seen this byte pair before - look for the longest match
-        cbMaxMatch = LwMin(kcbMaxLenKcdc, cbSrc - ibSrc);
-        pbMatch = prgbSrc + ibSrc;
-        bMatchNew = prgbSrc[ibSrc + 1];
-        bMatchLast = prgbSrc[ibSrc];
-        for (; ibTest > ibMin; ibTest = pmpibibNext[ibTest])
-        {
-            Assert(prgbSrc[ibTest + 1] == prgbSrc[ibSrc + 1], "links are wrong");
-            if (prgbSrc[ibTest + cbMatch] != bMatchNew || prgbSrc[ibTest + cbMatch - 1] != bMatchLast ||
-                cbMatch >= (cbT = CbEqualRgb(prgbSrc + ibTest, pbMatch, cbMaxMatch)))
-            {
-                Assert(pmpibibNext[ibTest] < ibTest, 0);
-                continue;
-            }
-
-            AssertIn(cbT, cbMatch + 1, kcbMaxLenKcdc + 1);
-
-            // if this run requires a 20 bit offset, we need to beat a
-            // 9 or 6 bit offset by 2 bytes
-            if (ibSrc - ibTest < kdibMinKcdc3 || cbT - cbMatch > 1 || ibSrc - ibMatch >= kdibMinKcdc2)
-            {
-                cbMatch = cbT;
-                ibMatch = ibTest;
-                if (cbMatch == cbMaxMatch)
-                    break;
-                bMatchNew = prgbSrc[ibSrc + cbMatch];
-                bMatchLast = prgbSrc[ibSrc + cbMatch - 1];
-            }
-
-            Assert(pmpibibNext[ibTest] < ibTest, 0);
-        }
+        // find the longest match (or a literal)
+        cbMatch = kcmf.CbMatch(ibSrc, &ibMatch);
 
         // write out the bits
-    LStore:
         AssertIn(ibMatch, 0, ibSrc + (cbMatch == 1));
         AssertIn(cbMatch, 1 + (ibMatch < ibSrc) + (ibSrc - ibMatch >= kdibMinKcdc3), kcbMaxLenKcdc + 1);
 
@@ -414,16 +570,108 @@ bool KCDC::_FEncode(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbD
     }
 
     *pcbDst = bita.Ib();
-
-    FreePpv((void **)&pmpibibNext);
     return fTrue;
 
 LFail:
     // can't compress the source
-    FreePpv((void **)&pmpibibNext);
     return fFalse;
 }
 
+/***************************************************************************
+    Decoding tables. Both encodings use the same offset sizes, so these
+    serve for both.
+***************************************************************************/
+// number of trailing 1 bits in a byte
+static const byte _mpbcbitOne[256] = {
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4,
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 5,
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4,
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 6,
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4,
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 5,
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4,
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 7,
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4,
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 5,
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4,
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 6,
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4,
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 5,
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 4,
+    0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0, 8,
+};
+
+// offset decoding information, indexed by the three bits following the
+// leading 1 bit of a run
+struct KCDO
+{
+    long cbitPrefix; // number of bits before the offset, including the leading 1
+    long cbitOffset; // number of bits in the offset
+    long dibMin;     // add to the binary offset
+    long cbExtra;    // add to the run length
+};
+
+static const KCDO _rgkcdo[8] = {
+    {2, kcbitKcdc0, kdibMinKcdc0, 0}, // xx0
+    {3, kcbitKcdc1, kdibMinKcdc1, 0}, // x01
+    {2, kcbitKcdc0, kdibMinKcdc0, 0}, // xx0
+    {4, kcbitKcdc2, kdibMinKcdc2, 0}, // 011
+    {2, kcbitKcdc0, kdibMinKcdc0, 0}, // xx0
+    {3, kcbitKcdc1, kdibMinKcdc1, 0}, // x01
+    {2, kcbitKcdc0, kdibMinKcdc0, 0}, // xx0
+    {4, kcbitKcdc3, kdibMinKcdc3, 1}, // 111
+};
+
+/***************************************************************************
+    Return the number of consecutive 1 bits at the bottom of lu, looking
+    at no more than 16 bits.
+***************************************************************************/
+inline long _CbitOne(ulong lu)
+{
+    long cbit = _mpbcbitOne[lu & 0xFF];
+
+    if (cbit == 8)
+        cbit += _mpbcbitOne[(lu >> 8) & 0xFF];
+    return cbit;
+}
+
+/***************************************************************************
+    Copy a run of cb bytes from dib bytes back in the destination. The
+    source and destination overlap when dib < cb, so words can only be
+    moved when dib is at least a word.
+***************************************************************************/
+inline byte *_PbCopyRun(byte *pbDst, long dib, long cb)
+{
+    byte *pbT = pbDst - dib;
+
+    if (dib >= cb)
+    {
+        // no overlap
+        CopyPb(pbT, pbDst, cb);
+        return pbDst + cb;
+    }
+
+    if (dib == 1)
+    {
+        FillPb(pbDst, cb, *pbT);
+        return pbDst + cb;
+    }
+
+    if (dib >= size(ulong))
+    {
+        for (; cb >= size(ulong); cb -= size(ulong))
+        {
+            *(ulong *)pbDst = *(ulong *)pbT;
+            pbDst += size(ulong);
+            pbT += size(ulong);
+        }
+    }
+
+    while (cb-- > 0)
+        *pbDst++ = *pbT++;
+    return pbDst;
+}
+
 /***************************************************************************
     Decompress a compressed KCDC stream.
 ***************************************************************************/
@@ -464,22 +712,17 @@ bool KCDC::_FDecode(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbD
         return fFalse;
     }
 
-#ifdef IN_80386
-
-#include "kcdc_386.h"
-
-    *pcbDst = cbTot;
-    return fTrue;
-
-#else //! IN_80386
-
     long cb, dib, ibit, cbit;
-    register ulong luCur;
-    byte *pbT;
-    register byte *pbDst = (byte *)pvDst;
+    ulong luCur;
+    const KCDO *pkcdo;
+    byte *pbDst = (byte *)pvDst;
     byte *pbLimDst = (byte *)pvDst + cbDst;
-    register byte *pbSrc = (byte *)pvSrc + 1;
+    byte *pbSrc = (byte *)pvSrc + 1;
 
+    // luCur holds the 32 bits starting at pbSrc - 4. ibit is the next bit
+    // to decode and is always less than 8 at the top of the loop, so
+    // luCur holds an entire literal or offset, and after refilling, an
+    // entire length.
 #define _FTest(ibit) (luCur & (1L << (ibit)))
 #ifdef LITTLE_ENDIAN
 #define _Advance(cb) ((pbSrc += (cb)), (luCur = *(ulong *)(pbSrc - 4)))
@@ -498,58 +741,34 @@ bool KCDC::_FDecode(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbD
             if (pbDst >= pbLimDst)
                 goto LFail;
 #endif // SAFETY
-            *pbDst++ = (byte)(luCur >> ibit + 1);
+            *pbDst++ = (byte)(luCur >> (ibit + 1));
             ibit += 9;
         }
         else
         {
             // get the offset
-            cb = 1;
-            if (!_FTest(ibit + 1))
-            {
-                dib = ((luCur >> (ibit + 2)) & ((1 << kcbitKcdc0) - 1)) + kdibMinKcdc0;
-                ibit += 2 + kcbitKcdc0;
-            }
-            else if (!_FTest(ibit + 2))
-            {
-                dib = ((luCur >> (ibit + 3)) & ((1 << kcbitKcdc1) - 1)) + kdibMinKcdc1;
-                ibit += 3 + kcbitKcdc1;
-            }
-            else if (!_FTest(ibit + 3))
-            {
-                dib = ((luCur >> (ibit + 4)) & ((1 << kcbitKcdc2) - 1)) + kdibMinKcdc2;
-                ibit += 4 + kcbitKcdc2;
-            }
-            else
-            {
-                dib = (luCur >> (ibit + 4)) & ((1 << kcbitKcdc3) - 1);
-                if (dib == ((1 << kcbitKcdc3) - 1))
-                    break;
-                dib += kdibMinKcdc3;
-                ibit += 4 + kcbitKcdc3;
-                cb++;
-            }
+            pkcdo = &_rgkcdo[(luCur >> (ibit + 1)) & 0x07];
+            dib = (luCur >> (ibit + pkcdo->cbitPrefix)) & ((1L << pkcdo->cbitOffset) - 1);
+            if (pkcdo->cbExtra > 0 && dib == ((1L << kcbitKcdc3) - 1))
+                break;
+            dib += pkcdo->dibMin;
+            cb = 1 + pkcdo->cbExtra;
+            ibit += pkcdo->cbitPrefix + pkcdo->cbitOffset;
             _Advance(ibit >> 3);
             ibit &= 0x07;
 
             // get the length
-            for (cbit = 0;;)
-            {
-                if (!_FTest(ibit + cbit))
-                    break;
-                if (++cbit > kcbitMaxLenKcdc)
-                    goto LFail;
-            }
-
-            cb += (1 << cbit) + ((luCur >> (cbit + 1)) & ((1 << cbit) - 1));
+            cbit = _CbitOne(luCur >> ibit);
+            if (cbit > kcbitMaxLenKcdc)
+                goto LFail;
+            cb += (1L << cbit) + ((luCur >> (ibit + cbit + 1)) & ((1L << cbit) - 1));
             ibit += cbit + cbit + 1;
 
 #ifdef SAFETY
             if (pbLimDst - pbDst < cb || pbDst - (byte *)pvDst < dib)
                 goto LFail;
 #endif // SAFETY
-            for (pbT = pbDst - dib; cb-- > 0;)
-                *pbDst++ = *pbT++;
+            pbDst = _PbCopyRun(pbDst, dib, cb);
         }
         _Advance(ibit >> 3);
         ibit &= 0x07;
@@ -561,8 +780,6 @@ bool KCDC::_FDecode(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbD
 #undef _FTest
 #undef _Advance
 
-#endif //! IN_80386
-
 LFail:
     Bug("bad compressed data");
     return fFalse;
@@ -570,9 +787,10 @@ LFail:
 
 /***************************************************************************
     Compress the data in pvSrc using the KCD2 encoding.  Returns false if
-    the data can't be compressed. This is not optimized (ie, it's slow).
+    the data can't be compressed. ceff is the effort level - at kceffMax
+    this does an exhaustive search (ie, it's slow).
 ***************************************************************************/
-bool KCDC::_FEncode2(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst)
+bool KCDC::_FEncode2(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcbDst, long ceff)
 {
     AssertThis(0);
     AssertIn(cbSrc, 1, kcbMax);
@@ -580,42 +798,26 @@ bool KCDC::_FEncode2(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcb
     AssertIn(cbDst, 1, kcbMax);
     AssertPvCb(pvDst, cbDst);
     AssertVarMem(pcbDst);
+    AssertIn(ceff, kceffMin, kceffMax + 1);
 
     long ibSrc;
-    long ibMatch, ibTest, cbMatch, ibMin, cbT;
-    byte bMatchNew, bMatchLast;
+    long ibMatch, cbMatch, cbT;
     BITA bita;
+    KCMF kcmf;
     long cbRun;
-    long *pmpsuibStart = pvNil;
     byte *prgbSrc = (byte *)pvSrc;
-    long *pmpibibNext = pvNil;
 
     TrashVar(pcbDst);
     if (cbDst - kcbTailKcdc <= 1)
         return fFalse;
 
     // allocate the links
-    if (!FAllocPv((void **)&pmpibibNext, LwMul(size(long), cbSrc), fmemNil, mprNormal) ||
-        !FAllocPv((void **)&pmpsuibStart, LwMul(size(long), 0x10000), fmemNil, mprNormal))
+    if (!kcmf.FInit(pvSrc, cbSrc, ceff))
     {
         Warn("failed to allocate memory for links");
         goto LFail;
     }
 
-    // write the links
-    // we need to set each entry of pmpsuibStart to a big negative number,
-    // but not too big, or we risk overflow below.
-    FillPb(pmpsuibStart, LwMul(size(long), 0x10000), 0xCC);
-    for (ibSrc = 0; ibSrc < cbSrc - 1; ibSrc++)
-    {
-        ushort suCur = ((ushort)prgbSrc[ibSrc]) << 8 | (ushort)prgbSrc[ibSrc + 1];
-        ibTest = pmpsuibStart[suCur];
-        pmpsuibStart[suCur] = ibSrc;
-        pmpibibNext[ibSrc] = ibTest;
-    }
-    pmpibibNext[cbSrc - 1] = 0xCCCCCCCCL;
-    FreePpv((void **)&pmpsuibStart);
-
     // write flags byte
     bita.Set(pvDst, cbDst);
     AssertDo(bita.FWriteBits(0, 8), 0);
@@ -623,57 +825,14 @@ bool KCDC::_FEncode2(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcb
     cbRun = 0;
     for (ibSrc = 0;; ibSrc += cbMatch)
     {
-        byte *pbMatch;
-        long cbMaxMatch;
-
         if (ibSrc >= cbSrc)
         {
             cbMatch = 0;
             goto LStore;
         }
 
-        // get the new byte and the link
-        ibTest = pmpibibNext[ibSrc];
-        Assert(ibTest < ibSrc, 0);
-
-        // assume we'll store a literal
-        cbMatch = 1;
-        ibMatch = ibSrc;
-
-        if (ibTest <= (ibMin = ibSrc - kdibMinKcdc4))
-            goto LStore;
-
-        // we've seen this byte pair before - look for the longest match
-        cbMaxMatch = LwMin(kcbMaxLenKcdc, cbSrc - ibSrc);
-        pbMatch = prgbSrc + ibSrc;
-        bMatchNew = prgbSrc[ibSrc + 1];
-        bMatchLast = prgbSrc[ibSrc];
-        for (; ibTest > ibMin; ibTest = pmpibibNext[ibTest])
-        {
-            Assert(prgbSrc[ibTest + 1] == prgbSrc[ibSrc + 1], "links are wrong");
-            if (prgbSrc[ibTest + cbMatch] != bMatchNew || prgbSrc[ibTest + cbMatch - 1] != bMatchLast ||
-                cbMatch >= (cbT = CbEqualRgb(prgbSrc + ibTest, pbMatch, cbMaxMatch)))
-            {
-                Assert(pmpibibNext[ibTest] < ibTest, 0);
-                continue;
-            }
-
-            AssertIn(cbT, cbMatch + 1, kcbMaxLenKcdc + 1);
-
-            // if this run requires a 20 bit offset, we need to beat a
-            // 9 or 6 bit offset by 2 bytes
-            if (ibSrc - ibTest < kdibMinKcdc3 || cbT - cbMatch > 1 || ibSrc - ibMatch >= kdibMinKcdc2)
-            {
-                cbMatch = cbT;
-                ibMatch = ibTest;
-                if (cbMatch == cbMaxMatch)
-                    break;
-                bMatchNew = prgbSrc[ibSrc + cbMatch];
-                bMatchLast = prgbSrc[ibSrc + cbMatch - 1];
-            }
-
-            Assert(pmpibibNext[ibTest] < ibTest, 0);
-        }
+        // find the longest match (or a literal)
+        cbMatch = kcmf.CbMatch(ibSrc, &ibMatch);
 
         // write out the bits
     LStore:
@@ -776,13 +935,10 @@ bool KCDC::_FEncode2(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcb
     }
 
     *pcbDst = bita.Ib();
-
-    FreePpv((void **)&pmpibibNext);
     return fTrue;
 
 LFail:
     // can't compress the source
-    FreePpv((void **)&pmpibibNext);
     return fFalse;
 }
 
@@ -826,24 +982,18 @@ bool KCDC::_FDecode2(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcb
         return fFalse;
     }
 
-#ifdef IN_80386
-
-#include "kcd2_386.h"
-
-    *pcbDst = cbTot;
-    return fTrue;
-
-#else //! IN_80386
-
     long cb, dib, ibit, cbit;
-    register ulong luCur;
-    byte bT;
+    ulong luCur;
+    const KCDO *pkcdo;
     byte *pbT;
-    register byte *pbDst = (byte *)pvDst;
+    byte *pbDst = (byte *)pvDst;
     byte *pbLimDst = (byte *)pvDst + cbDst;
-    register byte *pbSrc = (byte *)pvSrc + 1;
+    byte *pbSrc = (byte *)pvSrc + 1;
     byte *pbLimSrc = (byte *)pvSrc + cbSrc - kcbTailKcd2;
 
+    // luCur holds the 32 bits starting at pbSrc - 4. ibit is the next bit
+    // to decode and is always less than 8 at the top of the loop, so
+    // luCur holds an entire length, and after refilling, an entire offset.
 #define _FTest(ibit) (luCur & (1L << (ibit)))
 #ifdef LITTLE_ENDIAN
 #define _Advance(cb) ((pbSrc += (cb)), (luCur = *(ulong *)(pbSrc - 4)))
@@ -856,88 +1006,56 @@ bool KCDC::_FDecode2(void *pvSrc, long cbSrc, void *pvDst, long cbDst, long *pcb
     for (ibit = 0;;)
     {
         // get the length
-        for (cbit = 0;;)
-        {
-            if (!_FTest(ibit + cbit))
-                break;
-            if (++cbit > kcbitMaxLenKcd2)
-                goto LDone;
-        }
-
-        cb = (1 << cbit) + ((luCur >> (cbit + 1)) & ((1 << cbit) - 1));
+        cbit = _CbitOne(luCur >> ibit);
+        if (cbit > kcbitMaxLenKcd2)
+            break;
+        cb = (1L << cbit) + ((luCur >> (ibit + cbit + 1)) & ((1L << cbit) - 1));
         ibit += cbit + cbit + 1;
         _Advance(ibit >> 3);
         ibit &= 0x07;
 
         if (!_FTest(ibit))
         {
-            // literal
+            // literal run - the low bits of the last byte fill out the
+            // current source byte, then come the other bytes, then the
+            // high bits of the last byte. When the run starts on a byte
+            // boundary (ibit == 8), this is just the bytes in order.
+            ibit++;
+            pbT = pbSrc - 4;
 #ifdef SAFETY
-            if (pbDst + cb > pbLimDst)
-                goto LFail;
-            if (pbSrc - 3 + cb > pbLimSrc)
+            if (pbLimDst - pbDst < cb || pbLimSrc - pbT <= cb)
                 goto LFail;
 #endif // SAFETY
-            ibit++;
-            bT = (byte) ~(luCur & ((1 << ibit) - 1));
-            if (cb > 1)
-            {
-                CopyPb(pbSrc - 3, pbDst, cb - 1);
-                pbDst += cb - 1;
-                _Advance(cb);
-            }
-            else
-                _Advance(1);
-            bT |= luCur & ((1 << ibit) - 1);
-            *pbDst++ = bT;
+            CopyPb(pbT + 1, pbDst, cb - 1);
+            pbDst += cb - 1;
+            *pbDst++ = (byte)((pbT[0] >> ibit) | (pbT[cb] << (8 - ibit)));
+            _Advance(cb);
         }
         else
         {
             // get the offset
-            cb++;
-            if (!_FTest(ibit + 1))
-            {
-                dib = ((luCur >> (ibit + 2)) & ((1 << kcbitKcd2_0) - 1)) + kdibMinKcd2_0;
-                ibit += 2 + kcbitKcd2_0;
-            }
-            else if (!_FTest(ibit + 2))
-            {
-                dib = ((luCur >> (ibit + 3)) & ((1 << kcbitKcd2_1) - 1)) + kdibMinKcd2_1;
-                ibit += 3 + kcbitKcd2_1;
-            }
-            else if (!_FTest(ibit + 3))
-            {
-                dib = ((luCur >> (ibit + 4)) & ((1 << kcbitKcd2_2) - 1)) + kdibMinKcd2_2;
-                ibit += 4 + kcbitKcd2_2;
-            }
-            else
-            {
-                dib = (luCur >> (ibit + 4)) & ((1 << kcbitKcd2_3) - 1) + kdibMinKcd2_3;
-                ibit += 4 + kcbitKcd2_3;
-                cb++;
-            }
+            pkcdo = &_rgkcdo[(luCur >> (ibit + 1)) & 0x07];
+            dib = ((luCur >> (ibit + pkcdo->cbitPrefix)) & ((1L << pkcdo->cbitOffset) - 1)) + pkcdo->dibMin;
+            cb += 1 + pkcdo->cbExtra;
+            ibit += pkcdo->cbitPrefix + pkcdo->cbitOffset;
 
 #ifdef SAFETY
             if (pbLimDst - pbDst < cb || pbDst - (byte *)pvDst < dib)
                 goto LFail;
 #endif // SAFETY
-            for (pbT = pbDst - dib; cb-- > 0;)
-                *pbDst++ = *pbT++;
+            pbDst = _PbCopyRun(pbDst, dib, cb);
         }
 
         _Advance(ibit >> 3);
         ibit &= 0x07;
     }
 
-LDone:
     *pcbDst = pbDst - (byte *)pvDst;
     return fTrue;
 
 #undef _FTest
 #undef _Advance
 
-#endif //! IN_80386
-
 LFail:
     Bug("bad compressed data");
     return fFalse;
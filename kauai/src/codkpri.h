@@ -17,8 +17,7 @@
 #define CODKPRI_H
 
 /***************************************************************************
-    Constants for the KCDC encoding. Note: these should be #defines and
-    not consts because they are used in inline asm.
+    Constants for the KCDC encoding.
 ***************************************************************************/
 #define kcbTailKcdc 6      // number of FF bytes required at the end
 #define kcbMaxLenKcdc 4096 // maximum run length
@@ -34,8 +33,7 @@
 #define kdibMinKcdc4 0x101240 // used as a lim for 20 bit offsets
 
 /***************************************************************************
-    Constants for the KCD2 encoding. Note: these should be #defines and
-    not consts because they are used in inline asm.
+    Constants for the KCD2 encoding.
 ***************************************************************************/
 #define kcbTailKcd2 6      // number of FF bytes required at the end
 #define kcbMaxLenKcd2 4096 // maximum run length
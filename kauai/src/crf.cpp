@@ -14,6 +14,16 @@
     detached from the CRF (in the main thread), then later released
     in a different thread.
 
+    Purging: every time an attached BACO's reference count goes to zero,
+    a purge candidate (CRPE) is pushed onto a min-heap keyed by (crep,
+    cactRelease), so the best candidates to purge are at the top. The
+    heap is not updated when a BACO is fetched again or detached. Instead
+    a popped CRPE is checked against the CRE, and discarded if the object
+    is gone, in use, or has been released again since the CRPE was
+    pushed. When stale entries make the heap too big, it is rebuilt from
+    the CRE list. Space for the heap is reserved whenever a CRE is added,
+    so pushing never fails.
+
 ***************************************************************************/
 #include "util.h"
 ASSERTNAME
@@ -23,6 +33,7 @@ RTCLASS(GHQ)
 RTCLASS(RCA)
 RTCLASS(CRF)
 RTCLASS(CRM)
+RTCLASS(CRPQ)
 RTCLASS(CABO)
 
 /***************************************************************************
@@ -179,6 +190,9 @@ CRF::~CRF(void)
     AssertBaseThis(fobjAllocated);
     CRE cre;
 
+    // toss any prefetch requests for us
+    vcrpqUtil.Cancel(this);
+
     _cactRef++; // so we don't get "deleted" while detaching the BACOs
     if (pvNil != _pglcre)
     {
@@ -192,6 +206,7 @@ CRF::~CRF(void)
         }
         ReleasePpo(&_pglcre);
     }
+    ReleasePpo(&_pglcrpe);
     Assert(_cactRef == 1, "someone still refers to this CRF");
     ReleasePpo(&_pcfl);
 }
@@ -205,7 +220,8 @@ PCRF CRF::PcrfNew(PCFL pcfl, long cbMax)
     AssertIn(cbMax, 0, kcbMax);
     PCRF pcrf;
 
-    if (pvNil != (pcrf = NewObj CRF(pcfl, cbMax)) && pvNil == (pcrf->_pglcre = GL::PglNew(size(CRE), 5)))
+    if (pvNil != (pcrf = NewObj CRF(pcfl, cbMax)) && (pvNil == (pcrf->_pglcre = GL::PglNew(size(CRE), 5)) ||
+                                                      pvNil == (pcrf->_pglcrpe = GL::PglNew(size(CRPE), 5))))
     {
         ReleasePpo(&pcrf);
     }
@@ -261,6 +277,7 @@ tribool CRF::TLoad(CTG ctg, CNO cno, PFNRPO pfnrpo, RSC rsc, long crep)
     Assert(crep > crepToss, "crep too small");
     CRE cre;
     long icre;
+    long crepQueued;
     BLCK blck;
 
     // see if this CRF contains this resource type
@@ -270,16 +287,25 @@ tribool CRF::TLoad(CTG ctg, CNO cno, PFNRPO pfnrpo, RSC rsc, long crep)
     // see if it's in the cache
     if (_FFindCre(ctg, cno, pfnrpo, &icre))
     {
+        _crct.cactHit++;
         _pglcre->Get(icre, &cre);
+
+        // If the BACO isn't in use, SetCrep goes through BacoReleased,
+        // which marks it as recently used. Note that the BACO may be
+        // tossed if the cache is over full, so don't touch the cre after
+        // this.
         cre.pbaco->SetCrep(LwMax(cre.pbaco->_crep, crep));
-        cre.cactRelease = _cactRelease++;
-        _pglcre->Put(icre, &cre);
         return tYes;
     }
 
     // see if it's in the chunky file
     if (!_pcfl->FFind(ctg, cno, &blck))
         return tNo;
+    _crct.cactMiss++;
+
+    // if the data was prefetched, use it
+    if (vcrpqUtil.FTake(this, ctg, cno, &blck, &crepQueued))
+        crep = LwMax(crep, crepQueued);
 
     // get the approximate size of the object
     if (!(*pfnrpo)(this, ctg, cno, &blck, pvNil, &cre.cb))
@@ -316,7 +342,7 @@ tribool CRF::TLoad(CTG ctg, CNO cno, PFNRPO pfnrpo, RSC rsc, long crep)
     // indexes may have changed, get the location to insert again
     AssertDo(!_FFindCre(ctg, cno, pfnrpo, &icre), "how did this happen?");
 
-    if (!_pglcre->FInsert(icre, &cre))
+    if (!_FEnsureCrpe() || !_pglcre->FInsert(icre, &cre))
     {
         // can't keep it loaded
         ReleasePpo(&cre.pbaco);
@@ -342,6 +368,8 @@ PBACO CRF::PbacoFetch(CTG ctg, CNO cno, PFNRPO pfnrpo, bool *pfError, RSC rsc)
     AssertNilOrVarMem(pfError);
     CRE cre;
     long icre;
+    long crepQueued;
+    long crep = crepNormal;
     BLCK blck;
 
     if (pvNil != pfError)
@@ -354,6 +382,7 @@ PBACO CRF::PbacoFetch(CTG ctg, CNO cno, PFNRPO pfnrpo, bool *pfError, RSC rsc)
     // see if it's in the cache
     if (_FFindCre(ctg, cno, pfnrpo, &icre))
     {
+        _crct.cactHit++;
         _pglcre->Get(icre, &cre);
         AssertPo(cre.pbaco, 0);
         cre.pbaco->AddRef();
@@ -363,6 +392,11 @@ PBACO CRF::PbacoFetch(CTG ctg, CNO cno, PFNRPO pfnrpo, bool *pfError, RSC rsc)
     // see if it's in the chunky file
     if (!_pcfl->FFind(ctg, cno, &blck))
         return pvNil;
+    _crct.cactMiss++;
+
+    // if the data was prefetched, use it
+    if (vcrpqUtil.FTake(this, ctg, cno, &blck, &crepQueued))
+        crep = LwMax(crep, crepQueued);
 
     // get the object and its size
     if (!(*pfnrpo)(this, ctg, cno, &blck, &cre.pbaco, &cre.cb))
@@ -379,7 +413,7 @@ PBACO CRF::PbacoFetch(CTG ctg, CNO cno, PFNRPO pfnrpo, bool *pfError, RSC rsc)
     cre.pbaco->_pcrf = this;
     cre.pbaco->_ctg = ctg;
     cre.pbaco->_cno = cno;
-    cre.pbaco->_crep = crepNormal;
+    cre.pbaco->_crep = crep;
 
     AddRef();
     cre.pbaco->_fAttached = fFalse;
@@ -388,7 +422,7 @@ PBACO CRF::PbacoFetch(CTG ctg, CNO cno, PFNRPO pfnrpo, bool *pfError, RSC rsc)
     // indexes may have changed, get the location to insert again
     AssertDo(!_FFindCre(ctg, cno, pfnrpo, &icre), "how did this happen?");
 
-    if (!_pglcre->FInsert(icre, &cre))
+    if (!_FEnsureCrpe() || !_pglcre->FInsert(icre, &cre))
     {
         // return the pbaco anyway.  when it's released it will go away
         if (pvNil != pfError)
@@ -427,6 +461,7 @@ PBACO CRF::PbacoFind(CTG ctg, CNO cno, PFNRPO pfnrpo, RSC rsc)
         return pvNil;
     }
 
+    _crct.cactHit++;
     _pglcre->Get(icre, &cre);
     AssertPo(cre.pbaco, 0);
     cre.pbaco->AddRef();
@@ -473,6 +508,55 @@ PCRF CRF::PcrfFindChunk(CTG ctg, CNO cno, RSC rsc)
     return this;
 }
 
+/***************************************************************************
+    Start reading the chunk's data on the prefetch thread. The next TLoad
+    or PbacoFetch of the chunk uses the data and gives the object the
+    given crep (at least). pfnrpo may be nil if the caller doesn't know
+    which reader the chunk will be loaded with. Returns false if the chunk
+    isn't in the CRF or couldn't be queued.
+***************************************************************************/
+bool CRF::FPrefetchAsync(CTG ctg, CNO cno, PFNRPO pfnrpo, RSC rsc, long crep)
+{
+    AssertThis(0);
+    Assert(crep > crepToss, "crep too small");
+    CRE cre;
+    long icre;
+    BLCK blck;
+
+    // see if this CRF contains this resource type
+    if (rscNil != rsc && !_pcfl->FFind(kctgRsc, rsc))
+        return fFalse;
+
+    // if it's already cached, just bump its priority
+    if (_FFindCre(ctg, cno, pfnrpo, &icre))
+    {
+        _pglcre->Get(icre, &cre);
+        cre.pbaco->SetCrep(LwMax(cre.pbaco->_crep, crep));
+        return fTrue;
+    }
+
+    // with no reader, any cached object for the chunk sorts just after
+    // where a nil reader would go. Its data would never be taken.
+    if (pvNil == pfnrpo && icre < _pglcre->IvMac())
+    {
+        _pglcre->Get(icre, &cre);
+        if (cre.pbaco->_ctg == ctg && cre.pbaco->_cno == cno)
+            return fTrue;
+    }
+
+    if (vcrpqUtil.FQueued(this, ctg, cno))
+        return fTrue;
+
+    if (!_pcfl->FFind(ctg, cno, &blck))
+        return fFalse;
+
+    // data in a memory mapped file doesn't need to be read
+    if (pvNil != blck.PvMapped())
+        return fTrue;
+
+    return vcrpqUtil.FEnqueue(this, ctg, cno, &blck, crep);
+}
+
 /***************************************************************************
     Check the _fAttached flag.  If it's false, make sure the BACO is not
     in the CRF.
@@ -530,8 +614,15 @@ void CRF::BacoReleased(PBACO pbaco)
     if (pbaco->_crep <= crepToss || _cbCur > _cbMax)
     {
         // toss it
+        if (pbaco->_crep > crepToss)
+        {
+            _crct.cactEvict++;
+            _crct.cbEvict += cre.cb;
+        }
         pbaco->Detach();
     }
+    else
+        _PushCrpe(&cre);
 }
 
 /***************************************************************************
@@ -657,65 +748,249 @@ bool CRF::_FPurgeCb(long cbPurge, long crepLast)
     if (crepLast <= crepToss)
         return fFalse;
 
+    // We want to find the "best" element to free.  Elements with a smaller
+    // crep are always better, so the best crep is at the top of the heap.
+    // Among the first kccrpeWindow candidates with that crep, we score them
+    // based on when the cre was last released (how many releases have
+    // happened since the cre was last used) and how different the cb is
+    // from cbPurge.  Each release is worth kcbRelease bytes.  Bytes short
+    // of cbPurge are considered worse (by a factor of 3) than bytes beyond
+    // cbPurge, so we favor elements that are larger than cbPurge.
+    // REVIEW shonk: tune kcbRelease and the weighting factor...
+    const long kcbRelease = 256;
+    const long kccrpeWindow = 8;
+    CRPE rgcrpe[kccrpeWindow];
+    long rgicre[kccrpeWindow];
     CRE cre;
-    long icreMac;
+    long ccrpe, icrpe;
+    long lw, dcb;
+    long lwBest, icrpeBest;
 
-    while (0 < (icreMac = _pglcre->IvMac()))
+    for (;;)
     {
-        // We want to find the "best" element to free.  This is determined by
-        // keeping a "best so far" element, which we compare each element to.
-        // If the cre has a larger crep, it is worse, so just continue.
-        // If the cre has a smaller crep, it is better.  When the crep values
-        // are the same, we score it based on when the cre was last released
-        // (how many releases have happened since the cre was last used) and
-        // how different the cb is from cbPurge.  Each release is worth
-        // kcbRelease bytes.  Bytes short of cbPurge are considered worse
-        // (by a factor of 3) than bytes beyond cbPurge, so we favor elements
-        // that are larger than cbPurge.
-        // REVIEW shonk: tune kcbRelease and the weighting factor...
-        const long kcbRelease = 256;
-        long icre, crep;
-        long lw, dcb;
-        long lwBest = klwMax;
-        long icreBest = ivNil;
-        long crepBest = crepLast;
-
-        for (icre = 0; icre < icreMac; icre++)
+        // get the candidates
+        for (ccrpe = 0; ccrpe < kccrpeWindow; ccrpe++)
         {
-            _pglcre->Get(icre, &cre);
-            AssertPo(cre.pbaco, 0);
-            if (cre.pbaco->CactRef() > 0 || (crep = cre.pbaco->_crep) > crepBest)
+            if (!_FPopCrpe(&rgcrpe[ccrpe], &rgicre[ccrpe]))
+                break;
+            if (rgcrpe[ccrpe].crep > crepLast || (ccrpe > 0 && rgcrpe[ccrpe].crep != rgcrpe[0].crep))
             {
-                continue;
+                // not a candidate this time around
+                _PushCrpeCore(&rgcrpe[ccrpe]);
+                break;
             }
-            Assert(crep <= crepBest, 0);
-            AssertIn(cre.cactRelease, 0, _cactRelease);
+        }
+        if (ccrpe == 0)
+            return fFalse;
 
+        lwBest = klwMax;
+        icrpeBest = 0;
+        for (icrpe = 0; icrpe < ccrpe; icrpe++)
+        {
+            _pglcre->Get(rgicre[icrpe], &cre);
+            AssertIn(cre.cactRelease, 0, _cactRelease);
             dcb = cre.cb - cbPurge;
             lw = -LwMul(kcbRelease, LwMin(kcbMax / kcbRelease, _cactRelease - cre.cactRelease)) + LwMul(2, LwAbs(dcb)) -
                  dcb;
-            if (crep < crepBest || lw < lwBest)
+            if (lw < lwBest)
             {
-                icreBest = icre;
-                crepBest = crep;
+                icrpeBest = icrpe;
                 lwBest = lw;
             }
         }
 
-        if (ivNil == icreBest)
-            return fFalse;
+        // put back the ones we're not purging
+        for (icrpe = 0; icrpe < ccrpe; icrpe++)
+        {
+            if (icrpe != icrpeBest)
+                _PushCrpeCore(&rgcrpe[icrpe]);
+        }
 
-        _pglcre->Get(icreBest, &cre);
+        _pglcre->Get(rgicre[icrpeBest], &cre);
+        AssertPo(cre.pbaco, 0);
         Assert(cre.pbaco->_fAttached, "BACO not attached!");
+        _crct.cactEvict++;
+        _crct.cbEvict += cre.cb;
         cre.pbaco->Detach();
 
         if (0 >= (cbPurge -= cre.cb))
             return fTrue;
     }
+}
+
+/***************************************************************************
+    Return whether *pcrpe1 should be purged before *pcrpe2.
+***************************************************************************/
+bool CRF::_FLessCrpe(CRPE *pcrpe1, CRPE *pcrpe2)
+{
+    if (pcrpe1->crep != pcrpe2->crep)
+        return pcrpe1->crep < pcrpe2->crep;
+    return pcrpe1->cactRelease < pcrpe2->cactRelease;
+}
+
+// slop in the size of the purge heap, beyond two entries per cre
+const long kccrpeSlop = 16;
+
+/***************************************************************************
+    Make sure the purge heap has room for the entries of one more cre.
+    Call this before adding a cre.
+***************************************************************************/
+bool CRF::_FEnsureCrpe(void)
+{
+    AssertThis(0);
+    long ccrpe = LwMul(2, _pglcre->IvMac() + 1) + kccrpeSlop;
+
+    return _pglcrpe->FEnsureSpace(LwMax(0, ccrpe - _pglcrpe->IvMac()));
+}
+
+/***************************************************************************
+    The object for the cre has just been released, so add it to the purge
+    heap. If the heap has too many stale entries, rebuild it instead.
+***************************************************************************/
+void CRF::_PushCrpe(CRE *pcre)
+{
+    AssertThis(0);
+    AssertVarMem(pcre);
+    AssertPo(pcre->pbaco, 0);
+    CRPE crpe;
+
+    if (_pglcrpe->IvMac() >= LwMul(2, _pglcre->IvMac()) + kccrpeSlop)
+    {
+        // this picks up pcre as well
+        _RebuildCrpe();
+        return;
+    }
+
+    crpe.crep = pcre->pbaco->_crep;
+    crpe.cactRelease = pcre->cactRelease;
+    crpe.ctg = pcre->pbaco->_ctg;
+    crpe.cno = pcre->pbaco->_cno;
+    crpe.pfnrpo = pcre->pfnrpo;
+    _PushCrpeCore(&crpe);
+}
 
+/***************************************************************************
+    Add the entry to the purge heap. There must be room for it (see
+    _FEnsureCrpe).
+***************************************************************************/
+void CRF::_PushCrpeCore(CRPE *pcrpe)
+{
+    AssertThis(0);
+    AssertVarMem(pcrpe);
+    CRPE *qrgcrpe;
+    CRPE crpe;
+    long icrpe, icrpeParent;
+
+    crpe = *pcrpe;
+    AssertDo(_pglcrpe->FAdd(&crpe, &icrpe), "purge heap should have room");
+
+    // sift up
+    qrgcrpe = (CRPE *)_pglcrpe->QvGet(0);
+    for (; icrpe > 0; icrpe = icrpeParent)
+    {
+        icrpeParent = (icrpe - 1) / 2;
+        if (!_FLessCrpe(&crpe, &qrgcrpe[icrpeParent]))
+            break;
+        qrgcrpe[icrpe] = qrgcrpe[icrpeParent];
+    }
+    qrgcrpe[icrpe] = crpe;
+}
+
+/***************************************************************************
+    Pop the best purge candidate off the heap. Stale entries are discarded.
+    Fills in *pcrpe and the index of the corresponding cre. Returns false
+    iff there are no candidates.
+***************************************************************************/
+bool CRF::_FPopCrpe(CRPE *pcrpe, long *picre)
+{
+    AssertThis(0);
+    AssertVarMem(pcrpe);
+    AssertVarMem(picre);
+    CRPE *qrgcrpe;
+    CRPE crpe;
+    CRE cre;
+    long icrpe, icrpeChild, icrpeMac;
+
+    while (0 < (icrpeMac = _pglcrpe->IvMac()))
+    {
+        qrgcrpe = (CRPE *)_pglcrpe->QvGet(0);
+        *pcrpe = qrgcrpe[0];
+
+        // move the last entry to the top and sift it down
+        crpe = qrgcrpe[--icrpeMac];
+        for (icrpe = 0; (icrpeChild = 2 * icrpe + 1) < icrpeMac; icrpe = icrpeChild)
+        {
+            if (icrpeChild + 1 < icrpeMac && _FLessCrpe(&qrgcrpe[icrpeChild + 1], &qrgcrpe[icrpeChild]))
+                icrpeChild++;
+            if (!_FLessCrpe(&qrgcrpe[icrpeChild], &crpe))
+                break;
+            qrgcrpe[icrpe] = qrgcrpe[icrpeChild];
+        }
+        qrgcrpe[icrpe] = crpe;
+        AssertDo(_pglcrpe->FSetIvMac(icrpeMac), 0);
+
+        // make sure it's still a valid candidate
+        if (!_FFindCre(pcrpe->ctg, pcrpe->cno, pcrpe->pfnrpo, picre))
+            continue;
+        _pglcre->Get(*picre, &cre);
+        AssertPo(cre.pbaco, 0);
+        if (cre.cactRelease == pcrpe->cactRelease && cre.pbaco->CactRef() == 0 && cre.pbaco->_crep == pcrpe->crep)
+        {
+            return fTrue;
+        }
+    }
+
+    TrashVar(pcrpe);
+    TrashVar(picre);
     return fFalse;
 }
 
+/***************************************************************************
+    Rebuild the purge heap from the cre list, tossing stale entries.
+***************************************************************************/
+void CRF::_RebuildCrpe(void)
+{
+    AssertThis(0);
+    CRE cre;
+    CRPE crpe;
+    long icre;
+
+    AssertDo(_pglcrpe->FSetIvMac(0), 0);
+    for (icre = _pglcre->IvMac(); icre-- > 0;)
+    {
+        _pglcre->Get(icre, &cre);
+        AssertPo(cre.pbaco, 0);
+        if (cre.pbaco->CactRef() > 0 || !cre.pbaco->_fAttached)
+            continue;
+        crpe.crep = cre.pbaco->_crep;
+        crpe.cactRelease = cre.cactRelease;
+        crpe.ctg = cre.pbaco->_ctg;
+        crpe.cno = cre.pbaco->_cno;
+        crpe.pfnrpo = cre.pfnrpo;
+        _PushCrpeCore(&crpe);
+    }
+}
+
+/***************************************************************************
+    Get the cache counters.
+***************************************************************************/
+void CRF::GetCrct(CRCT *pcrct)
+{
+    AssertThis(0);
+    AssertVarMem(pcrct);
+
+    *pcrct = _crct;
+}
+
+/***************************************************************************
+    Reset the cache counters.
+***************************************************************************/
+void CRF::ResetCrct(void)
+{
+    AssertThis(0);
+    ClearPb(&_crct, size(_crct));
+}
+
 #ifdef DEBUG
 /***************************************************************************
     Assert the validity of a CRF (chunky resource file).
@@ -724,6 +999,7 @@ void CRF::AssertValid(ulong grf)
 {
     CRF_PAR::AssertValid(fobjAllocated);
     AssertPo(_pglcre, 0);
+    AssertPo(_pglcrpe, 0);
     AssertPo(_pcfl, 0);
     AssertIn(_cbMax, 0, kcbMax);
     AssertIn(_cbCur, 0, kcbMax);
@@ -741,6 +1017,7 @@ void CRF::MarkMem(void)
 
     CRF_PAR::MarkMem();
     MarkMemObj(_pglcre);
+    MarkMemObj(_pglcrpe);
     MarkMemObj(_pcfl);
 
     for (icre = _pglcre->IvMac(); icre-- > 0;)
@@ -913,6 +1190,64 @@ PCRF CRM::PcrfFindChunk(CTG ctg, CNO cno, RSC rsc)
     return pvNil;
 }
 
+/***************************************************************************
+    Start reading the chunk's data on the prefetch thread. See
+    CRF::FPrefetchAsync.
+***************************************************************************/
+bool CRM::FPrefetchAsync(CTG ctg, CNO cno, PFNRPO pfnrpo, RSC rsc, long crep)
+{
+    AssertThis(0);
+    PCRF pcrf;
+
+    if (pvNil == (pcrf = PcrfFindChunk(ctg, cno, rsc)))
+        return fFalse;
+
+    return pcrf->FPrefetchAsync(ctg, cno, pfnrpo, rscNil, crep);
+}
+
+/***************************************************************************
+    Get the cache counters, summed over all the CRFs.
+***************************************************************************/
+void CRM::GetCrct(CRCT *pcrct)
+{
+    AssertThis(0);
+    AssertVarMem(pcrct);
+    PCRF pcrf;
+    CRCT crct;
+    long ipcrf;
+    long cpcrf = _pglpcrf->IvMac();
+
+    ClearPb(pcrct, size(*pcrct));
+    for (ipcrf = 0; ipcrf < cpcrf; ipcrf++)
+    {
+        _pglpcrf->Get(ipcrf, &pcrf);
+        AssertPo(pcrf, 0);
+        pcrf->GetCrct(&crct);
+        pcrct->cactHit += crct.cactHit;
+        pcrct->cactMiss += crct.cactMiss;
+        pcrct->cactEvict += crct.cactEvict;
+        pcrct->cbEvict += crct.cbEvict;
+    }
+}
+
+/***************************************************************************
+    Reset the cache counters of all the CRFs.
+***************************************************************************/
+void CRM::ResetCrct(void)
+{
+    AssertThis(0);
+    PCRF pcrf;
+    long ipcrf;
+    long cpcrf = _pglpcrf->IvMac();
+
+    for (ipcrf = 0; ipcrf < cpcrf; ipcrf++)
+    {
+        _pglpcrf->Get(ipcrf, &pcrf);
+        AssertPo(pcrf, 0);
+        pcrf->ResetCrct();
+    }
+}
+
 /***************************************************************************
     Add a chunky file to the list of chunky resource files, by
     creating the chunky resource file object and adding it to the GL
@@ -988,6 +1323,478 @@ void CRM::MarkMem(void)
 }
 #endif // DEBUG
 
+// prefetch request states
+enum
+{
+    crpsQueued,  // waiting for the thread
+    crpsReading, // the thread is reading it
+    crpsRead,    // the data has been read
+    crpsFailed,  // the read failed
+};
+
+// limit on the amount of data in the prefetch queue
+const long kcbMaxCrpq = 0x00400000;
+
+/***************************************************************************
+    Constructor for the prefetch queue. This is a global, so doesn't
+    allocate anything or start the thread - that's done by _FInit when the
+    first request is queued.
+***************************************************************************/
+CRPQ::CRPQ(void)
+{
+    _pglcrpr = pvNil;
+    _cbQueued = 0;
+    _fInited = fFalse;
+    _fDone = fFalse;
+#ifdef WIN
+    _hevt = hNil;
+    _hevtRead = hNil;
+    _hth = hNil;
+#endif // WIN
+}
+
+/***************************************************************************
+    Destructor for the prefetch queue.
+***************************************************************************/
+CRPQ::~CRPQ(void)
+{
+    ShutDown();
+}
+
+/***************************************************************************
+    Allocate the request list and start the thread. If the thread can't be
+    started, requests are read synchronously by FEnqueue.
+***************************************************************************/
+bool CRPQ::_FInit(void)
+{
+    AssertBaseThis(0);
+#ifdef WIN
+    ulong luThread;
+#endif // WIN
+
+    if (_fInited)
+        return pvNil != _pglcrpr;
+    if (_fDone)
+        return fFalse;
+    _fInited = fTrue;
+
+    if (pvNil == (_pglcrpr = GL::PglNew(size(CRPR))))
+        return fFalse;
+
+#ifdef WIN
+    if (hNil == (_hevt = CreateEvent(pvNil, fFalse, fFalse, pvNil)) ||
+        hNil == (_hevtRead = CreateEvent(pvNil, fFalse, fFalse, pvNil)) ||
+        hNil == (_hth = CreateThread(pvNil, 4096, CRPQ::_ThreadProc, this, 0, &luThread)))
+    {
+        Warn("couldn't start the prefetch thread");
+    }
+    else
+        SetThreadPriority(_hth, THREAD_PRIORITY_BELOW_NORMAL);
+#endif // WIN
+
+    return fTrue;
+}
+
+/***************************************************************************
+    Stop the thread and toss all requests. Should be called before
+    FIL::ShutDown, since requests hold files open.
+***************************************************************************/
+void CRPQ::ShutDown(void)
+{
+    AssertBaseThis(0);
+
+    _fDone = fTrue;
+#ifdef WIN
+    if (hNil != _hth)
+    {
+        // tell the thread to end and wait for it to finish
+        SetEvent(_hevt);
+        WaitForSingleObject(_hth, INFINITE);
+        CloseHandle(_hth);
+        _hth = hNil;
+    }
+    if (hNil != _hevt)
+    {
+        CloseHandle(_hevt);
+        _hevt = hNil;
+    }
+    if (hNil != _hevtRead)
+    {
+        CloseHandle(_hevtRead);
+        _hevtRead = hNil;
+    }
+#endif // WIN
+
+    if (pvNil != _pglcrpr)
+    {
+        while (_pglcrpr->IvMac() > 0)
+            _FreeCrpr(0);
+        ReleasePpo(&_pglcrpr);
+    }
+    _cbQueued = 0;
+}
+
+/***************************************************************************
+    Find the request for the given chunk. Assumes the mutx is entered.
+***************************************************************************/
+bool CRPQ::_FFindCrpr(PCRF pcrf, CTG ctg, CNO cno, long *picrpr)
+{
+    AssertVarMem(picrpr);
+    CRPR *qcrpr;
+    long icrpr;
+
+    if (pvNil == _pglcrpr)
+        return fFalse;
+
+    for (icrpr = _pglcrpr->IvMac(); icrpr-- > 0;)
+    {
+        qcrpr = (CRPR *)_pglcrpr->QvGet(icrpr);
+        if (qcrpr->pcrf == pcrf && qcrpr->ctg == ctg && qcrpr->cno == cno)
+        {
+            *picrpr = icrpr;
+            return fTrue;
+        }
+    }
+    return fFalse;
+}
+
+/***************************************************************************
+    Free the request's data and remove it from the list. Assumes the mutx
+    is entered (or the thread is gone) and that the request isn't being
+    read.
+***************************************************************************/
+void CRPQ::_FreeCrpr(long icrpr)
+{
+    CRPR crpr;
+
+    _pglcrpr->Get(icrpr, &crpr);
+    Assert(crpsReading != crpr.crps, "freeing a request that's being read");
+    _cbQueued -= crpr.flo.cb;
+    FreePhq(&crpr.hq);
+    ReleasePpo(&crpr.flo.pfil);
+    _pglcrpr->Delete(icrpr);
+}
+
+/***************************************************************************
+    Free the requests that were cancelled while the thread was reading
+    them and that it has since finished. The thread never frees requests
+    itself, since releasing the request's FIL isn't synchronized with the
+    main thread. Assumes the mutx is entered.
+***************************************************************************/
+void CRPQ::_FreeCancelled(void)
+{
+    CRPR *qcrpr;
+    long icrpr;
+
+    if (pvNil == _pglcrpr)
+        return;
+
+    for (icrpr = _pglcrpr->IvMac(); icrpr-- > 0;)
+    {
+        qcrpr = (CRPR *)_pglcrpr->QvGet(icrpr);
+        if (pvNil == qcrpr->pcrf && crpsReading != qcrpr->crps)
+            _FreeCrpr(icrpr);
+    }
+}
+
+/***************************************************************************
+    Static method to read and unpack the data for a request. This doesn't
+    touch the CRF or the request list, so can be called without the mutx.
+***************************************************************************/
+bool CRPQ::_FReadCrpr(CRPR *pcrpr, HQ *phq)
+{
+    if (!pcrpr->flo.FReadHq(phq))
+        return fFalse;
+    if (pcrpr->fPacked && !vpcodmUtil->FDecompressPhq(phq))
+    {
+        FreePhq(phq);
+        return fFalse;
+    }
+    return fTrue;
+}
+
+/***************************************************************************
+    Queue a request to read the data for the given block, which must be on
+    file. Returns false if the request couldn't be queued.
+***************************************************************************/
+bool CRPQ::FEnqueue(PCRF pcrf, CTG ctg, CNO cno, PBLCK pblck, long crep)
+{
+    AssertThis(0);
+    AssertPo(pcrf, 0);
+    AssertPo(pblck, fblckReadable);
+    CRPR crpr;
+    long icrpr;
+    bool fRet = fFalse;
+
+    _mutx.Enter();
+
+    if (!_FInit())
+        goto LRet;
+    _FreeCancelled();
+
+    if (_FFindCrpr(pcrf, ctg, cno, &icrpr))
+    {
+        fRet = fTrue;
+        goto LRet;
+    }
+
+    ClearPb(&crpr, size(crpr));
+    if (_cbQueued + pblck->Cb(fTrue) > kcbMaxCrpq || !pblck->FGetFlo(&crpr.flo, fTrue))
+        goto LRet;
+    crpr.pcrf = pcrf;
+    crpr.ctg = ctg;
+    crpr.cno = cno;
+    crpr.crep = crep;
+    crpr.crps = crpsQueued;
+    crpr.fPacked = pblck->FPacked();
+    crpr.hq = hqNil;
+
+#ifdef WIN
+    if (hNil == _hth)
+#endif // WIN
+    {
+        // no thread, so read it now
+        crpr.crps = _FReadCrpr(&crpr, &crpr.hq) ? crpsRead : crpsFailed;
+    }
+
+    if (!_pglcrpr->FAdd(&crpr))
+    {
+        FreePhq(&crpr.hq);
+        ReleasePpo(&crpr.flo.pfil);
+        goto LRet;
+    }
+    _cbQueued += crpr.flo.cb;
+    fRet = fTrue;
+
+#ifdef WIN
+    if (hNil != _hth)
+        SetEvent(_hevt);
+#endif // WIN
+
+LRet:
+    _mutx.Leave();
+    return fRet;
+}
+
+/***************************************************************************
+    Return whether there is a request for the chunk.
+***************************************************************************/
+bool CRPQ::FQueued(PCRF pcrf, CTG ctg, CNO cno)
+{
+    AssertThis(0);
+    long icrpr;
+    bool fRet;
+
+    _mutx.Enter();
+    fRet = _FFindCrpr(pcrf, ctg, cno, &icrpr);
+    _mutx.Leave();
+
+    return fRet;
+}
+
+/***************************************************************************
+    If there is a request for the chunk, remove it from the queue. If the
+    data has been read, put it in *pblck, set *pcrep to the requested crep
+    and return true. If the thread is reading the data, this waits for it.
+    If the thread hasn't gotten to the request yet, or the read failed,
+    this returns false and the caller should read the data itself.
+***************************************************************************/
+bool CRPQ::FTake(PCRF pcrf, CTG ctg, CNO cno, PBLCK pblck, long *pcrep)
+{
+    AssertThis(0);
+    AssertPo(pblck, 0);
+    AssertVarMem(pcrep);
+    CRPR crpr;
+    long icrpr;
+
+    _mutx.Enter();
+    _FreeCancelled();
+    for (;;)
+    {
+        if (!_FFindCrpr(pcrf, ctg, cno, &icrpr))
+        {
+            _mutx.Leave();
+            TrashVar(pcrep);
+            return fFalse;
+        }
+        _pglcrpr->Get(icrpr, &crpr);
+        if (crpsReading != crpr.crps)
+            break;
+
+#ifdef WIN
+        // wait for the thread to finish reading it
+        _mutx.Leave();
+        WaitForSingleObject(_hevtRead, INFINITE);
+        _mutx.Enter();
+#else  //! WIN
+        Bug("no thread, so how is this being read?");
+        break;
+#endif //! WIN
+    }
+
+    if (crpsRead != crpr.crps)
+    {
+        _FreeCrpr(icrpr);
+        _mutx.Leave();
+        TrashVar(pcrep);
+        return fFalse;
+    }
+
+    // take the hq
+    _cbQueued -= crpr.flo.cb;
+    ReleasePpo(&crpr.flo.pfil);
+    _pglcrpr->Delete(icrpr);
+    _mutx.Leave();
+
+    pblck->SetHq(&crpr.hq);
+    *pcrep = crpr.crep;
+    return fTrue;
+}
+
+/***************************************************************************
+    Toss all requests for the CRF, or all requests if pcrf is nil. If the
+    thread is reading one, it's marked cancelled and freed on a later call
+    once the thread is done with it.
+***************************************************************************/
+void CRPQ::Cancel(PCRF pcrf)
+{
+    AssertBaseThis(0);
+    CRPR *qcrpr;
+    long icrpr;
+
+    _mutx.Enter();
+    if (pvNil != _pglcrpr)
+    {
+        for (icrpr = _pglcrpr->IvMac(); icrpr-- > 0;)
+        {
+            qcrpr = (CRPR *)_pglcrpr->QvGet(icrpr);
+            if (pvNil != pcrf && qcrpr->pcrf != pcrf)
+                continue;
+            if (crpsReading == qcrpr->crps)
+                qcrpr->pcrf = pvNil;
+            else
+                _FreeCrpr(icrpr);
+        }
+    }
+    _mutx.Leave();
+}
+
+#ifdef WIN
+/***************************************************************************
+    AT: Static method. Thread function for the CRPQ object.
+***************************************************************************/
+ulong __stdcall CRPQ::_ThreadProc(void *pv)
+{
+    PCRPQ pcrpq = (PCRPQ)pv;
+
+    // don't AssertPo here - validating walks the request list
+    Assert(pvNil != pcrpq, "nil crpq");
+
+    return pcrpq->_LuThread();
+}
+
+/***************************************************************************
+    AT: Wait for requests, then read them in order.
+***************************************************************************/
+ulong CRPQ::_LuThread(void)
+{
+    CRPR crpr;
+    CRPR *qcrpr;
+    long icrpr, icrprMac;
+    HQ hq;
+    bool fRead;
+
+    for (;;)
+    {
+        WaitForSingleObject(_hevt, INFINITE);
+
+        for (;;)
+        {
+            if (_fDone)
+                return 0;
+
+            // find the first queued request
+            _mutx.Enter();
+            icrprMac = _pglcrpr->IvMac();
+            for (icrpr = 0; icrpr < icrprMac; icrpr++)
+            {
+                qcrpr = (CRPR *)_pglcrpr->QvGet(icrpr);
+                if (crpsQueued == qcrpr->crps)
+                {
+                    qcrpr->crps = crpsReading;
+                    crpr = *qcrpr;
+                    break;
+                }
+            }
+            _mutx.Leave();
+
+            if (icrpr >= icrprMac)
+                break;
+
+            // read it - the request holds a reference to the file, so
+            // this is safe even if the request is cancelled
+            hq = hqNil;
+            fRead = _FReadCrpr(&crpr, &hq);
+
+            // find it again - there is at most one request being read, and
+            // the main thread never frees it while it's being read. If it
+            // was cancelled, the main thread frees it later.
+            _mutx.Enter();
+            for (icrpr = _pglcrpr->IvMac(); icrpr-- > 0;)
+            {
+                qcrpr = (CRPR *)_pglcrpr->QvGet(icrpr);
+                if (crpsReading == qcrpr->crps)
+                    break;
+            }
+            Assert(icrpr >= 0, "where did the request go?");
+            qcrpr->crps = fRead ? crpsRead : crpsFailed;
+            qcrpr->hq = hq;
+            _mutx.Leave();
+
+            SetEvent(_hevtRead);
+        }
+    }
+}
+#endif // WIN
+
+#ifdef DEBUG
+/***************************************************************************
+    Assert the validity of the prefetch queue.
+***************************************************************************/
+void CRPQ::AssertValid(ulong grf)
+{
+    CRPQ_PAR::AssertValid(0);
+    _mutx.Enter();
+    AssertNilOrPo(_pglcrpr, 0);
+    AssertIn(_cbQueued, 0, kcbMaxCrpq + kcbMax / 2);
+    _mutx.Leave();
+}
+
+/***************************************************************************
+    Mark memory for the prefetch queue.
+***************************************************************************/
+void CRPQ::MarkMem(void)
+{
+    AssertValid(0);
+    CRPR crpr;
+    long icrpr;
+
+    CRPQ_PAR::MarkMem();
+
+    _mutx.Enter();
+    if (pvNil != _pglcrpr)
+    {
+        MarkMemObj(_pglcrpr);
+        for (icrpr = _pglcrpr->IvMac(); icrpr-- > 0;)
+        {
+            _pglcrpr->Get(icrpr, &crpr);
+            MarkHq(crpr.hq);
+        }
+    }
+    _mutx.Leave();
+}
+#endif // DEBUG
+
 /***************************************************************************
     A PFNRPO to read GHQ objects.
 ***************************************************************************/
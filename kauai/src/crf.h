@@ -97,6 +97,15 @@ class BACO : public BACO_PAR
 typedef bool FNRPO(PCRF pcrf, CTG ctg, CNO cno, PBLCK pblck, PBACO *ppbaco, long *pcb);
 typedef FNRPO *PFNRPO;
 
+// cache counters
+struct CRCT
+{
+    long cactHit;   // requests satisfied from the cache
+    long cactMiss;  // requests that had to read the chunk
+    long cactEvict; // objects purged to make room
+    long cbEvict;   // bytes purged to make room
+};
+
 typedef class RCA *PRCA;
 #define RCA_PAR BASE
 #define kclsRCA 'RCA'
@@ -110,6 +119,10 @@ class RCA : public RCA_PAR
     virtual PBACO PbacoFind(CTG ctg, CNO cno, PFNRPO pfnrpo, RSC rsc = rscNil) = 0;
     virtual bool FSetCrep(long crep, CTG ctg, CNO cno, PFNRPO pfnrpo, RSC rsc = rscNil) = 0;
     virtual PCRF PcrfFindChunk(CTG ctg, CNO cno, RSC rsc = rscNil) = 0;
+    virtual bool FPrefetchAsync(CTG ctg, CNO cno, PFNRPO pfnrpo, RSC rsc = rscNil, long crep = crepNormal) = 0;
+
+    virtual void GetCrct(CRCT *pcrct) = 0;
+    virtual void ResetCrct(void) = 0;
 };
 
 /***************************************************************************
@@ -132,17 +145,37 @@ class CRF : public CRF_PAR
         long cb;          // size of data
     };
 
+    // purge candidate - an entry in the purge heap
+    struct CRPE
+    {
+        long crep;        // the crep when the object was released
+        long cactRelease; // the cactRelease of the cre when it was released
+        CTG ctg;
+        CNO cno;
+        PFNRPO pfnrpo;
+    };
+
     PCFL _pcfl;
-    PGL _pglcre; // sorted by (cki, pfnrpo)
+    PGL _pglcre;  // sorted by (cki, pfnrpo)
+    PGL _pglcrpe; // min-heap of purge candidates, keyed by (crep, cactRelease)
     long _cbMax;
     long _cbCur;
     long _cactRelease;
+    CRCT _crct;
 
     CRF(PCFL pcfl, long cbMax);
     bool _FFindCre(CTG ctg, CNO cno, PFNRPO pfnrpo, long *picre);
     bool _FFindBaco(PBACO pbaco, long *picre);
     bool _FPurgeCb(long cbPurge, long crepLast);
 
+    // purge heap management
+    static bool _FLessCrpe(CRPE *pcrpe1, CRPE *pcrpe2);
+    bool _FEnsureCrpe(void);
+    void _PushCrpe(CRE *pcre);
+    void _PushCrpeCore(CRPE *pcrpe);
+    bool _FPopCrpe(CRPE *pcrpe, long *picre);
+    void _RebuildCrpe(void);
+
   public:
     ~CRF(void);
     static PCRF PcrfNew(PCFL pcfl, long cbMax);
@@ -152,6 +185,10 @@ class CRF : public CRF_PAR
     virtual PBACO PbacoFind(CTG ctg, CNO cno, PFNRPO pfnrpo, RSC rsc = rscNil);
     virtual bool FSetCrep(long crep, CTG ctg, CNO cno, PFNRPO pfnrpo, RSC rsc = rscNil);
     virtual PCRF PcrfFindChunk(CTG ctg, CNO cno, RSC rsc = rscNil);
+    virtual bool FPrefetchAsync(CTG ctg, CNO cno, PFNRPO pfnrpo, RSC rsc = rscNil, long crep = crepNormal);
+
+    virtual void GetCrct(CRCT *pcrct);
+    virtual void ResetCrct(void);
 
     long CbMax(void)
     {
@@ -197,6 +234,10 @@ class CRM : public CRM_PAR
     virtual PBACO PbacoFind(CTG ctg, CNO cno, PFNRPO pfnrpo, RSC rsc = rscNil);
     virtual bool FSetCrep(long crep, CTG ctg, CNO cno, PFNRPO pfnrpo, RSC rsc = rscNil);
     virtual PCRF PcrfFindChunk(CTG ctg, CNO cno, RSC rsc = rscNil);
+    virtual bool FPrefetchAsync(CTG ctg, CNO cno, PFNRPO pfnrpo, RSC rsc = rscNil, long crep = crepNormal);
+
+    virtual void GetCrct(CRCT *pcrct);
+    virtual void ResetCrct(void);
 
     bool FAddCfl(PCFL pcfl, long cbMax, long *piv = pvNil);
     long Ccrf(void)
@@ -207,6 +248,69 @@ class CRM : public CRM_PAR
     PCRF PcrfGet(long icrf);
 };
 
+/***************************************************************************
+    Chunky resource prefetch queue. A worker thread reads and unpacks
+    chunk data queued by CRF::FPrefetchAsync. When the CRF next loads the
+    chunk (TLoad or PbacoFetch), it takes the data from the queue, so only
+    the BACO construction happens on the main thread. There is just one
+    of these, vcrpqUtil, shared by all the CRFs.
+***************************************************************************/
+typedef class CRPQ *PCRPQ;
+#define CRPQ_PAR BASE
+#define kclsCRPQ 'CRPQ'
+class CRPQ : public CRPQ_PAR
+{
+    RTCLASS_DEC
+    ASSERT
+    MARKMEM
+
+  protected:
+    // prefetch request
+    struct CRPR
+    {
+        PCRF pcrf; // no reference - the CRF cancels its requests when it goes
+        CTG ctg;
+        CNO cno;
+        long crep;
+        long crps;    // request state
+        bool fPacked; // whether the data on file is packed
+        FLO flo;      // the data on file - holds a reference to flo.pfil
+        HQ hq;        // the unpacked data, once read
+    };
+
+    MUTX _mutx;
+    PGL _pglcrpr;
+    long _cbQueued; // total size of the queued and read data
+    bool _fInited;
+    bool _fDone;
+#ifdef WIN
+    HANDLE _hevt;     // signaled when a request is queued
+    HANDLE _hevtRead; // signaled when the thread finishes a request
+    HANDLE _hth;
+#endif // WIN
+
+    bool _FInit(void);
+    bool _FFindCrpr(PCRF pcrf, CTG ctg, CNO cno, long *picrpr);
+    void _FreeCrpr(long icrpr);
+    void _FreeCancelled(void);
+    static bool _FReadCrpr(CRPR *pcrpr, HQ *phq);
+
+#ifdef WIN
+    static ulong __stdcall _ThreadProc(void *pv);
+    ulong _LuThread(void);
+#endif // WIN
+
+  public:
+    CRPQ(void);
+    ~CRPQ(void);
+
+    bool FEnqueue(PCRF pcrf, CTG ctg, CNO cno, PBLCK pblck, long crep);
+    bool FQueued(PCRF pcrf, CTG ctg, CNO cno);
+    bool FTake(PCRF pcrf, CTG ctg, CNO cno, PBLCK pblck, long *pcrep);
+    void Cancel(PCRF pcrf);
+    void ShutDown(void);
+};
+
 /***************************************************************************
     An object (BACO) wrapper around a generic HQ.
 ***************************************************************************/
@@ -21,7 +21,12 @@ inline void Debugger(void)
 {
     __asm { int 3 }
 }
-#endif // WIN
+#elif defined(LINUX)
+inline void Debugger(void)
+{
+    __builtin_trap();
+}
+#endif // LINUX
 
 #ifdef DEBUG
 bool FAssertProc(schar *pszsFile, long lwLine, schar *pszsMsg, void *pv, long cb);
@@ -398,6 +398,18 @@ bool FLO::FWriteRgb(void *pv, long cbWrite, FP dfp)
     return this->pfil->FWriteRgb(pv, cbWrite, this->fp + dfp);
 }
 
+/***************************************************************************
+    If the file is memory mapped, return a pointer to the flo's data in
+    the view. Otherwise return pvNil. The pointer is only valid while the
+    file is open.
+***************************************************************************/
+void *FLO::PvMapped(void)
+{
+    AssertThis(ffloReadable);
+
+    return this->pfil->PvMapped(this->fp, this->cb);
+}
+
 /***************************************************************************
     Copy data from this flo to another.
 ***************************************************************************/
@@ -1157,6 +1169,31 @@ bool BLCK::FGetFlo(PFLO pflo, bool fPackedOk)
     return fTrue;
 }
 
+/***************************************************************************
+    If the block is an unpacked piece of a memory mapped file, return a
+    pointer to the data in the view, otherwise return pvNil. If ppfil is
+    not nil, the file is AddRef'ed and returned in *ppfil; the caller
+    should hold onto it for as long as it uses the pointer.
+***************************************************************************/
+void *BLCK::PvMapped(PFIL *ppfil)
+{
+    AssertThis(0);
+    AssertNilOrVarMem(ppfil);
+    void *pv;
+
+    if (pvNil != ppfil)
+        *ppfil = pvNil;
+    if (_fPacked || pvNil == _flo.pfil || _flo.cb <= 0)
+        return pvNil;
+
+    if (pvNil != (pv = _flo.PvMapped()) && pvNil != ppfil)
+    {
+        *ppfil = _flo.pfil;
+        _flo.pfil->AddRef();
+    }
+    return pv;
+}
+
 /***************************************************************************
     Return whether the block is packed. If the block is compressed, but
     determining the compression type failed, *pcfmt is set to cfmtNil and
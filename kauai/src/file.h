@@ -51,6 +51,18 @@ enum
     kelCritical
 };
 
+#ifdef LINUX
+/****************************************
+    Block cache statistics for a file
+****************************************/
+struct FCS
+{
+    long cactHit;  // blocks found in the cache
+    long cactMiss; // reads that had to go to the file
+    long cbRead;   // bytes read from the file, including read-ahead
+};
+#endif // LINUX
+
 /****************************************
     FIL class
 ****************************************/
@@ -77,11 +89,19 @@ class FIL : public FIL_PAR
     ulong _grffil; // permissions, mark and temp flags
     long _el;
 
+    // read-only view of the file - see FMap
+    byte *_prgbMap;
+    long _cbMap;
+
 #ifdef MAC
     short _fref;
 #elif defined(WIN)
     HANDLE _hfile;
-#endif // WIN
+    HANDLE _hmap;
+#elif defined(LINUX)
+    int _fd;
+    FCS _fcs;
+#endif // LINUX
 
     // private methods
     FIL(FNI *pfni, ulong grffil);
@@ -90,6 +110,10 @@ class FIL : public FIL_PAR
     bool _FOpen(bool fCreate, ulong grffil);
     void _Close(bool fFinal = fFalse);
     void _SetFpPos(FP fp);
+#ifdef LINUX
+    bool _FReadDirect(void *pv, long cb, FP fp);
+    bool _FReadCached(void *pv, long cb, FP fp);
+#endif // LINUX
 
   public:
     // public static members
@@ -110,6 +134,11 @@ class FIL : public FIL_PAR
     static PFIL PfilCreate(FNI *pfni, ulong grffil = ffilWriteEnable | ffilDenyWrite);
     static PFIL PfilCreateTemp(FNI *pfni = pvNil);
     static PFIL PfilFromFni(FNI *pfni);
+#ifdef LINUX
+    // the block cache shared by all files
+    static bool FSetCache(long cblk, long cblkReadAhead);
+    void GetFcs(FCS *pfcs);
+#endif // LINUX
 
     virtual void Release(void);
     void Mark(void)
@@ -165,6 +194,14 @@ class FIL : public FIL_PAR
     bool FRename(FNI *pfni);
     bool FSetFni(FNI *pfni);
     void Flush(void);
+
+    // memory mapping
+    bool FMap(void);
+    bool FMapped(void)
+    {
+        return pvNil != _prgbMap;
+    }
+    void *PvMapped(FP fp, long cb);
 };
 
 /****************************************
@@ -202,6 +239,7 @@ struct FLO
         return FReadHq(phq, cb, 0);
     }
     bool FTranslate(short osk);
+    void *PvMapped(void);
 
     ASSERT
 };
@@ -284,6 +322,9 @@ class BLCK : public BLCK_PAR
     bool FWriteToBlck(PBLCK pblckDst, bool fPackedOk = fFalse);
     bool FGetFlo(PFLO pflo, bool fPackedOk = fFalse);
 
+    // zero-copy access to the data of a mapped file
+    void *PvMapped(PFIL *ppfil = pvNil);
+
     // packing and unpacking
     bool FPacked(long *pcfmt = pvNil);
     bool FPackData(long cfmt = cfmtNil);
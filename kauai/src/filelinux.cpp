@@ -0,0 +1,814 @@
+/***************************************************************************
+    Project: Kauai
+
+    POSIX file management.  Reads and writes are positional (pread and
+    pwrite), so there is no file pointer to keep in sync.
+
+    Small reads go through a block cache shared by all files.  Each
+    block holds kcbCacheBlock bytes of one file at a block aligned
+    offset.  Blocks are found through a hash on (pfil, iblk) and
+    recycled in least recently used order.  On a miss we read the
+    missing run of blocks plus a read-ahead window with a single preadv.
+    Writes and size changes invalidate the blocks they touch, and
+    closing a file drops all of its blocks (the file may be renamed or
+    swapped while closed).
+
+    Share-deny flags aren't enforced - POSIX locks are only advisory.
+
+***************************************************************************/
+#include "util.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+ASSERTNAME
+
+const long kcbCacheBlock = 0x1000;
+const long kcblkCacheDef = 1024;
+const long kcblkReadAheadDef = 4;
+
+// reads at least this big bypass the cache
+const long kcbReadDirect = 0x10000;
+
+/****************************************
+    Cache block
+****************************************/
+typedef struct CBL *PCBL;
+struct CBL
+{
+    PFIL pfil;     // owning file, pvNil if the block is free
+    long iblk;     // block number within the file
+    long cb;       // number of valid bytes (less than a block at EOF)
+    PCBL pcblHash; // next block in the hash chain
+    PCBL pcblPrev; // more recently used
+    PCBL pcblNext; // less recently used
+    byte rgb[kcbCacheBlock];
+};
+
+// The cache is shared by all files, so it's guarded by its own mutx.
+// Always enter a file's _mutx before _mutxCache.  The cache memory is
+// allocated with malloc since it isn't owned by any object that could
+// mark it.
+priv MUTX _mutxCache;
+priv long _cblkCache = kcblkCacheDef;
+priv long _cblkReadAhead = kcblkReadAheadDef;
+priv PCBL _prgcbl;      // the blocks
+priv PCBL *_prgpcblHash; // hash buckets
+priv long _cpcblHash;    // number of hash buckets - a power of 2
+priv PCBL _pcblFirst;    // most recently used
+priv PCBL _pcblLast;     // least recently used
+
+priv bool _FEnsureCache(void);
+priv void _FreeCache(void);
+priv void _PurgeCache(PFIL pfil, long iblkMin = 0, long iblkLim = klwMax);
+
+/***************************************************************************
+    Return the hash bucket for the given block.
+***************************************************************************/
+priv PCBL *_PpcblHash(PFIL pfil, long iblk)
+{
+    ulong lu = (ulong)(size_t)pfil / size(long) * 0x9E3779B1 + (ulong)iblk;
+
+    return &_prgpcblHash[(lu ^ (lu >> 13)) & (_cpcblHash - 1)];
+}
+
+/***************************************************************************
+    Find the block for the given file and block number.  Returns pvNil if
+    it's not cached.
+***************************************************************************/
+priv PCBL _PcblFind(PFIL pfil, long iblk)
+{
+    PCBL pcbl;
+
+    for (pcbl = *_PpcblHash(pfil, iblk); pvNil != pcbl; pcbl = pcbl->pcblHash)
+    {
+        if (pcbl->pfil == pfil && pcbl->iblk == iblk)
+            break;
+    }
+    return pcbl;
+}
+
+/***************************************************************************
+    Remove the block from the hash table and mark it free.
+***************************************************************************/
+priv void _Unhash(PCBL pcbl)
+{
+    PCBL *ppcbl;
+
+    if (pvNil == pcbl->pfil)
+        return;
+
+    for (ppcbl = _PpcblHash(pcbl->pfil, pcbl->iblk); *ppcbl != pcbl; ppcbl = &(*ppcbl)->pcblHash)
+        Assert(pvNil != *ppcbl, "block not in its hash chain");
+    *ppcbl = pcbl->pcblHash;
+    pcbl->pcblHash = pvNil;
+    pcbl->pfil = pvNil;
+}
+
+/***************************************************************************
+    Unlink the block from the LRU list and insert it at the head (fFirst)
+    or the tail.
+***************************************************************************/
+priv void _MoveCbl(PCBL pcbl, bool fFirst)
+{
+    // unlink
+    if (pvNil != pcbl->pcblPrev)
+        pcbl->pcblPrev->pcblNext = pcbl->pcblNext;
+    else
+        _pcblFirst = pcbl->pcblNext;
+    if (pvNil != pcbl->pcblNext)
+        pcbl->pcblNext->pcblPrev = pcbl->pcblPrev;
+    else
+        _pcblLast = pcbl->pcblPrev;
+
+    // relink
+    if (fFirst)
+    {
+        pcbl->pcblPrev = pvNil;
+        pcbl->pcblNext = _pcblFirst;
+        if (pvNil != _pcblFirst)
+            _pcblFirst->pcblPrev = pcbl;
+        else
+            _pcblLast = pcbl;
+        _pcblFirst = pcbl;
+    }
+    else
+    {
+        pcbl->pcblNext = pvNil;
+        pcbl->pcblPrev = _pcblLast;
+        if (pvNil != _pcblLast)
+            _pcblLast->pcblNext = pcbl;
+        else
+            _pcblFirst = pcbl;
+        _pcblLast = pcbl;
+    }
+}
+
+/***************************************************************************
+    Make sure the cache is allocated.  Returns false if the cache is
+    disabled or we couldn't allocate it.
+***************************************************************************/
+priv bool _FEnsureCache(void)
+{
+    long icbl;
+
+    if (pvNil != _prgcbl)
+        return fTrue;
+    if (_cblkCache <= 0)
+        return fFalse;
+
+    for (_cpcblHash = 1; _cpcblHash < _cblkCache; _cpcblHash <<= 1)
+    {
+    }
+    _prgcbl = (PCBL)calloc(_cblkCache, size(CBL));
+    _prgpcblHash = (PCBL *)calloc(_cpcblHash, size(PCBL));
+    if (pvNil == _prgcbl || pvNil == _prgpcblHash)
+    {
+        Warn("allocating the file cache failed");
+        _FreeCache();
+        _cblkCache = 0;
+        return fFalse;
+    }
+
+    for (icbl = 0; icbl < _cblkCache; icbl++)
+    {
+        _prgcbl[icbl].pcblPrev = icbl > 0 ? &_prgcbl[icbl - 1] : pvNil;
+        _prgcbl[icbl].pcblNext = icbl < _cblkCache - 1 ? &_prgcbl[icbl + 1] : pvNil;
+    }
+    _pcblFirst = &_prgcbl[0];
+    _pcblLast = &_prgcbl[_cblkCache - 1];
+    return fTrue;
+}
+
+/***************************************************************************
+    Free the cache memory.
+***************************************************************************/
+priv void _FreeCache(void)
+{
+    free(_prgcbl);
+    free(_prgpcblHash);
+    _prgcbl = pvNil;
+    _prgpcblHash = pvNil;
+    _cpcblHash = 0;
+    _pcblFirst = _pcblLast = pvNil;
+}
+
+/***************************************************************************
+    Drop the given range of blocks of the file from the cache.
+***************************************************************************/
+priv void _PurgeCache(PFIL pfil, long iblkMin, long iblkLim)
+{
+    PCBL pcbl;
+    long iblk;
+
+    _mutxCache.Enter();
+    if (pvNil == _prgcbl)
+        goto LRet;
+
+    if (iblkLim - iblkMin <= _cblkCache)
+    {
+        for (iblk = iblkMin; iblk < iblkLim; iblk++)
+        {
+            if (pvNil != (pcbl = _PcblFind(pfil, iblk)))
+            {
+                _Unhash(pcbl);
+                _MoveCbl(pcbl, fFalse);
+            }
+        }
+    }
+    else
+    {
+        for (pcbl = _prgcbl + _cblkCache; pcbl-- > _prgcbl;)
+        {
+            if (pcbl->pfil == pfil && FIn(pcbl->iblk, iblkMin, iblkLim))
+            {
+                _Unhash(pcbl);
+                _MoveCbl(pcbl, fFalse);
+            }
+        }
+    }
+
+LRet:
+    _mutxCache.Leave();
+}
+
+/***************************************************************************
+    Static method to set the size of the block cache shared by all files
+    and how many blocks to read ahead on a miss.  A cblk of zero turns the
+    cache off.  Discards everything that's cached.
+***************************************************************************/
+bool FIL::FSetCache(long cblk, long cblkReadAhead)
+{
+    AssertIn(cblk, 0, kcbMax / kcbCacheBlock);
+    AssertIn(cblkReadAhead, 0, kcbMax / kcbCacheBlock);
+    bool fRet;
+
+    _mutxCache.Enter();
+    _FreeCache();
+    _cblkCache = cblk;
+    _cblkReadAhead = cblkReadAhead;
+    fRet = cblk == 0 || _FEnsureCache();
+    _mutxCache.Leave();
+
+    return fRet;
+}
+
+/***************************************************************************
+    Get the cache statistics for this file.
+***************************************************************************/
+void FIL::GetFcs(FCS *pfcs)
+{
+    AssertThis(0);
+    AssertVarMem(pfcs);
+
+    _mutx.Enter();
+    *pfcs = _fcs;
+    _mutx.Leave();
+}
+
+/***************************************************************************
+    Open or create the file.  If the file is already open, sets the
+    permissions according to grffil.
+***************************************************************************/
+bool FIL::_FOpen(bool fCreate, ulong grffil)
+{
+    AssertBaseThis(0);
+    bool fRet = fFalse;
+    int fd;
+    int grfo;
+
+    _mutx.Enter();
+
+    if (_el >= kelCritical)
+        goto LRet;
+
+    grffil &= kgrffilPerm;
+    if (_fOpen)
+    {
+        Assert(!fCreate, "can't create an open file");
+        if ((~_grffil & grffil) == 0)
+        {
+            // permissions are already set high enough
+            fRet = fTrue;
+            goto LRet;
+        }
+
+        // maintain the permissions we had before
+        grffil |= _grffil & kgrffilPerm;
+    }
+
+    grfo = (grffil & ffilWriteEnable) ? O_RDWR : O_RDONLY;
+    if (fCreate)
+        grfo |= O_CREAT | O_TRUNC;
+    if (0 > (fd = open(_fni._stnFile.Psz(), grfo | O_CLOEXEC, 0666)))
+    {
+        // if it was open, keep the old descriptor and permissions
+        if (_fOpen)
+            goto LRet;
+        _el = kelCritical;
+        goto LRet;
+    }
+
+    if (_fOpen)
+        close(_fd);
+    _fd = fd;
+    _fOpen = fTrue;
+    _fEverOpen = fTrue;
+    _grffil = (_grffil & ~kgrffilPerm) | grffil;
+    fRet = fTrue;
+
+LRet:
+    _mutx.Leave();
+
+    return fRet;
+}
+
+/***************************************************************************
+    Close the file.
+***************************************************************************/
+void FIL::_Close(bool fFinal)
+{
+    AssertBaseThis(0);
+
+    _mutx.Enter();
+
+    // the file may be renamed or swapped before it's opened again
+    _PurgeCache(this);
+
+    if (_fOpen)
+    {
+        Flush();
+        close(_fd);
+        _fOpen = fFalse;
+        _fd = -1;
+    }
+
+    if (fFinal && pvNil != _prgbMap)
+    {
+        munmap(_prgbMap, _cbMap);
+        _prgbMap = pvNil;
+        _cbMap = 0;
+    }
+
+    if ((_grffil & ffilTemp) && fFinal && _fEverOpen)
+    {
+        if (unlink(_fni._stnFile.Psz()) != 0)
+            Warn("Deleting temp file failed");
+    }
+
+    _mutx.Leave();
+}
+
+/***************************************************************************
+    Flush the file.
+***************************************************************************/
+void FIL::Flush(void)
+{
+    AssertThis(0);
+
+    _mutx.Enter();
+
+    if (_fOpen && (_grffil & ffilWriteEnable))
+        fdatasync(_fd);
+
+    _mutx.Leave();
+}
+
+/***************************************************************************
+    Map a view of the entire file into memory. Only read-only files can be
+    mapped. The view is copy-on-write, so stray writes into the view are
+    never seen by the file. The view stays valid until the file is finally
+    closed (it survives _Close(fFalse)). Files on network volumes aren't
+    mapped, since a page fault there can fail long after the mapping
+    succeeded. Failing to map is not an error - the caller should just
+    fall back to reading the file.
+***************************************************************************/
+bool FIL::FMap(void)
+{
+    AssertThis(0);
+    FP fpMac;
+    void *pv;
+
+    _mutx.Enter();
+
+    if (pvNil != _prgbMap)
+        goto LRet;
+    if ((_grffil & ffilWriteEnable) || (_fni.Grfvk() & (fvkRemovable | fvkNetwork)))
+        goto LRet;
+    if ((fpMac = FpMac()) <= 0)
+        goto LRet;
+    if (!_fOpen && !_FOpen(fFalse, _grffil))
+        goto LRet;
+
+    if (MAP_FAILED == (pv = mmap(pvNil, fpMac, PROT_READ | PROT_WRITE, MAP_PRIVATE, _fd, 0)))
+        goto LRet;
+    _prgbMap = (byte *)pv;
+    _cbMap = fpMac;
+
+LRet:
+    _mutx.Leave();
+
+    return pvNil != _prgbMap;
+}
+
+/***************************************************************************
+    If the file is mapped, return a pointer to the given range of the
+    view. Returns pvNil if the file isn't mapped or the range isn't in
+    the view.
+***************************************************************************/
+void *FIL::PvMapped(FP fp, long cb)
+{
+    AssertThis(0);
+    AssertIn(cb, 0, kcbMax);
+
+    if (pvNil == _prgbMap || !FIn(fp, 0, _cbMap) || cb > _cbMap - fp)
+        return pvNil;
+    return _prgbMap + fp;
+}
+
+/***************************************************************************
+    Make sure the file is open - assumes the mutx is already entered.
+    Reads and writes are positional, so there's no file pointer to set.
+***************************************************************************/
+void FIL::_SetFpPos(FP fp)
+{
+    AssertThis(0);
+
+    if (!_fOpen)
+        _FOpen(fFalse, _grffil);
+
+    if (_el < kelSeek && !_fOpen)
+    {
+        PushErc(ercFileGeneral);
+        _el = kelSeek;
+    }
+}
+
+/***************************************************************************
+    Set the length of the file.  This doesn't zero the appended portion.
+***************************************************************************/
+bool FIL::FSetFpMac(FP fp)
+{
+    AssertThis(0);
+    AssertIn(fp, 0, kcbMax);
+    bool fRet;
+
+    _mutx.Enter();
+
+    Assert(_grffil & ffilWriteEnable, "can't write to read only file");
+    _SetFpPos(fp);
+
+    if (_el < kelWrite)
+    {
+        _fWrote = fTrue;
+        _PurgeCache(this, fp / kcbCacheBlock);
+        if (ftruncate(_fd, fp) != 0)
+        {
+            PushErc(ercFileGeneral);
+            _el = kelWrite;
+        }
+    }
+    fRet = _el < kelWrite;
+
+    _mutx.Leave();
+
+    return fRet;
+}
+
+/***************************************************************************
+    Return the length of the file.
+***************************************************************************/
+FP FIL::FpMac(void)
+{
+    AssertThis(0);
+    FP fp = 0;
+    struct stat st;
+
+    _mutx.Enter();
+
+    _SetFpPos(0);
+    if (_el < kelSeek)
+    {
+        if (fstat(_fd, &st) != 0)
+        {
+            PushErc(ercFileGeneral);
+            _el = kelSeek;
+        }
+        else
+            fp = (FP)st.st_size;
+    }
+
+    _mutx.Leave();
+
+    return fp;
+}
+
+/***************************************************************************
+    Read a block directly from the file - assumes the mutx is already
+    entered.
+***************************************************************************/
+bool FIL::_FReadDirect(void *pv, long cb, FP fp)
+{
+    AssertThis(0);
+    AssertPvCb(pv, cb);
+    ssize_t cbT;
+
+    while (cb > 0)
+    {
+        if (0 >= (cbT = pread(_fd, pv, cb, fp)))
+        {
+            if (cbT < 0 && errno == EINTR)
+                continue;
+            return fFalse;
+        }
+        _fcs.cbRead += cbT;
+        pv = PvAddBv(pv, cbT);
+        cb -= cbT;
+        fp += cbT;
+    }
+    return fTrue;
+}
+
+/***************************************************************************
+    Read a block through the cache - assumes the mutx is already entered.
+    On a miss, the missing run of blocks (up to the end of the request
+    plus the read-ahead window, and stopping at the first block that's
+    already cached) is filled with a single read.  If the cache can't
+    satisfy the read, the rest of it goes straight to the file.
+***************************************************************************/
+bool FIL::_FReadCached(void *pv, long cb, FP fp)
+{
+    AssertThis(0);
+    AssertPvCb(pv, cb);
+    struct iovec rgiov[64];
+    PCBL rgpcbl[64];
+    PCBL pcbl;
+    long iblk, iblkLim, ipcbl, cpcbl, cpcblMax;
+    long ib, cbT;
+    ssize_t cbRead;
+
+    _mutxCache.Enter();
+
+    if (!_FEnsureCache())
+        goto LDirect;
+
+    iblkLim = (fp + cb - 1) / kcbCacheBlock + 1;
+    cpcblMax = LwMin(LwMin(CvFromRgv(rgpcbl), LwMax(_cblkCache / 2, 1)), iblkLim - fp / kcbCacheBlock + _cblkReadAhead);
+    while (cb > 0)
+    {
+        iblk = fp / kcbCacheBlock;
+        ib = fp - iblk * kcbCacheBlock;
+        if (pvNil != (pcbl = _PcblFind(this, iblk)))
+            _fcs.cactHit++;
+        else
+        {
+            // fill a run of blocks starting with this one
+            for (cpcbl = 0; cpcbl < cpcblMax && (cpcbl == 0 || pvNil == _PcblFind(this, iblk + cpcbl)); cpcbl++)
+            {
+                // recycle the least recently used block
+                pcbl = _pcblLast;
+                _Unhash(pcbl);
+                _MoveCbl(pcbl, fTrue);
+                rgpcbl[cpcbl] = pcbl;
+                rgiov[cpcbl].iov_base = pcbl->rgb;
+                rgiov[cpcbl].iov_len = kcbCacheBlock;
+            }
+
+            _fcs.cactMiss++;
+            while (0 > (cbRead = preadv(_fd, rgiov, cpcbl, (off_t)iblk * kcbCacheBlock)) && errno == EINTR)
+            {
+            }
+            if (cbRead > 0)
+                _fcs.cbRead += cbRead;
+
+            // hash the blocks we got, free the rest
+            for (ipcbl = 0; ipcbl < cpcbl; ipcbl++)
+            {
+                pcbl = rgpcbl[ipcbl];
+                pcbl->cb = LwBound(cbRead - ipcbl * kcbCacheBlock, 0, kcbCacheBlock + 1);
+                if (pcbl->cb == 0)
+                {
+                    _MoveCbl(pcbl, fFalse);
+                    continue;
+                }
+                pcbl->pfil = this;
+                pcbl->iblk = iblk + ipcbl;
+                PCBL *ppcbl = _PpcblHash(this, pcbl->iblk);
+                pcbl->pcblHash = *ppcbl;
+                *ppcbl = pcbl;
+            }
+            pcbl = _PcblFind(this, iblk);
+        }
+
+        // a short block at EOF may not cover the request
+        if (pvNil == pcbl || pcbl->cb <= ib)
+            goto LDirect;
+        _MoveCbl(pcbl, fTrue);
+        cbT = LwMin(cb, pcbl->cb - ib);
+        CopyPb(pcbl->rgb + ib, pv, cbT);
+        pv = PvAddBv(pv, cbT);
+        cb -= cbT;
+        fp += cbT;
+    }
+    _mutxCache.Leave();
+    return fTrue;
+
+LDirect:
+    _mutxCache.Leave();
+    return _FReadDirect(pv, cb, fp);
+}
+
+/***************************************************************************
+    Read a block from the file.
+***************************************************************************/
+bool FIL::FReadRgb(void *pv, long cb, FP fp)
+{
+    AssertThis(0);
+    AssertIn(cb, 0, kcbMax);
+    AssertIn(fp, 0, klwMax);
+    AssertPvCb(pv, cb);
+
+    bool fRet = fFalse;
+
+    if (cb <= 0)
+        return fTrue;
+
+    _mutx.Enter();
+
+    Debug(FP dfp = FpMac() - fp;)
+
+        _SetFpPos(fp);
+    if (_el >= kelRead)
+        goto LRet;
+
+    Assert(dfp >= cb, "read past EOF");
+    if (!(cb < kcbReadDirect ? _FReadCached(pv, cb, fp) : _FReadDirect(pv, cb, fp)))
+    {
+        PushErc(ercFileGeneral);
+        _el = kelRead;
+        goto LRet;
+    }
+
+    fRet = fTrue;
+
+LRet:
+    _mutx.Leave();
+    return fRet;
+}
+
+/***************************************************************************
+    Write a block to the file.
+***************************************************************************/
+bool FIL::FWriteRgb(void *pv, long cb, FP fp)
+{
+    AssertThis(0);
+    AssertIn(cb, 0, kcbMax);
+    AssertIn(fp, 0, klwMax);
+    AssertPvCb(pv, cb);
+
+    ssize_t cbT;
+    bool fRet = fFalse;
+
+    if (cb <= 0)
+        return fTrue;
+
+    _mutx.Enter();
+
+    Assert(_grffil & ffilWriteEnable, "can't write to read only file");
+
+    _SetFpPos(fp);
+    if (_el >= kelWrite)
+        goto LRet;
+
+    _fWrote = fTrue;
+    _PurgeCache(this, fp / kcbCacheBlock, (fp + cb - 1) / kcbCacheBlock + 1);
+    while (cb > 0)
+    {
+        if (0 >= (cbT = pwrite(_fd, pv, cb, fp)))
+        {
+            if (cbT < 0 && errno == EINTR)
+                continue;
+            PushErc(ercFileGeneral);
+            _el = kelWrite;
+            goto LRet;
+        }
+        pv = PvAddBv(pv, cbT);
+        cb -= cbT;
+        fp += cbT;
+    }
+
+    fRet = fTrue;
+
+LRet:
+    _mutx.Leave();
+    return fRet;
+}
+
+/***************************************************************************
+    Swap the names of the two files.  They should be in the same directory.
+***************************************************************************/
+bool FIL::FSwapNames(PFIL pfil)
+{
+    AssertThis(0);
+    AssertPo(pfil, 0);
+    FNI fni;
+    FNI fniT;
+    bool fRet = fFalse;
+
+    if (this == pfil)
+    {
+        Bug("Why are you calling FSwapNames on the same file?");
+        return fTrue;
+    }
+
+    _mutx.Enter();
+    pfil->_mutx.Enter();
+
+    Assert(_fni.FSameDir(&pfil->_fni), "trying to change directories with FSwapNames");
+
+    fni = pfil->_fni;
+    if (!fni.FGetUnique(fni.Ftg()))
+        goto LRet;
+
+    _Close();
+    pfil->_Close();
+
+    if (!_fni.FRename(&fni))
+        goto LFail;
+    if (!pfil->_fni.FRename(&_fni))
+        goto LRenameFail;
+    if (!fni.FRename(&pfil->_fni))
+    {
+        if (!_fni.FRename(&pfil->_fni))
+        {
+            Bug("rename failure");
+            pfil->_fni = _fni;
+            _fni = fni;
+            goto LFail;
+        }
+
+    LRenameFail:
+        if (!fni.FRename(&_fni))
+        {
+            Bug("rename failure");
+            _fni = fni;
+        }
+        goto LFail;
+    }
+
+    fni = _fni;
+    _fni = pfil->_fni;
+    pfil->_fni = fni;
+    fRet = fTrue;
+
+LFail:
+    // reopen the files
+    _FOpen(fFalse, _grffil);
+    pfil->_FOpen(fFalse, pfil->_grffil);
+
+LRet:
+    _mutx.Leave();
+    pfil->_mutx.Leave();
+
+    if (!fRet)
+        PushErc(ercFileSwapNames);
+
+    AssertThis(0);
+    AssertPo(pfil, 0);
+
+    return fRet;
+}
+
+/***************************************************************************
+    Rename a file.  The new fni should be on the same volume.
+    This may fail without an error code being set.
+***************************************************************************/
+bool FIL::FRename(FNI *pfni)
+{
+    AssertThis(0);
+    AssertPo(pfni, ffniFile);
+    FNI fni;
+    bool fRet = fFalse;
+
+    _mutx.Enter();
+
+    Assert(_fni.FSameDir(pfni), "trying to change directories with FRename");
+
+    _Close();
+    if (fRet = _fni.FRename(pfni))
+        _fni = *pfni;
+
+    // reopen the file
+    if (!_FOpen(fFalse, _grffil))
+        fRet = fFalse;
+
+    _mutx.Leave();
+
+    if (!fRet)
+        PushErc(ercFileRename);
+
+    AssertThis(0);
+    return fRet;
+}
@@ -96,6 +96,24 @@ void FIL::_Close(void)
     _el = elNil;
 }
 
+/***************************************************************************
+    Memory mapping isn't supported on the Mac.
+***************************************************************************/
+bool FIL::FMap(void)
+{
+    AssertThis(0);
+    return fFalse;
+}
+
+/***************************************************************************
+    Memory mapping isn't supported on the Mac.
+***************************************************************************/
+void *FIL::PvMapped(FP fp, long cb)
+{
+    AssertThis(0);
+    return pvNil;
+}
+
 /***************************************************************************
     Flush the file (and its volume?).
 ***************************************************************************/
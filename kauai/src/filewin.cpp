@@ -111,6 +111,15 @@ void FIL::_Close(bool fFinal)
         _hfile = hBadWin;
     }
 
+    if (fFinal && pvNil != _prgbMap)
+    {
+        UnmapViewOfFile(_prgbMap);
+        CloseHandle(_hmap);
+        _prgbMap = pvNil;
+        _hmap = hNil;
+        _cbMap = 0;
+    }
+
     if ((_grffil & ffilTemp) && fFinal && _fEverOpen)
     {
         if (!DeleteFile(_fni._stnFile.Psz()))
@@ -135,6 +144,62 @@ void FIL::Flush(void)
     _mutx.Leave();
 }
 
+/***************************************************************************
+    Map a view of the entire file into memory. Only read-only files can be
+    mapped. The view is copy-on-write, so stray writes into the view are
+    never seen by the file. The view stays valid until the file is finally
+    closed (it survives _Close(fFalse)). Files on removable or network
+    volumes aren't mapped, since a page fault there can fail long after
+    the mapping succeeded. Failing to map is not an error - the caller
+    should just fall back to reading the file.
+***************************************************************************/
+bool FIL::FMap(void)
+{
+    AssertThis(0);
+    FP fpMac;
+
+    _mutx.Enter();
+
+    if (pvNil != _prgbMap)
+        goto LRet;
+    if ((_grffil & ffilWriteEnable) || (_fni.Grfvk() & (fvkRemovable | fvkNetwork)))
+        goto LRet;
+    if ((fpMac = FpMac()) <= 0)
+        goto LRet;
+    if (!_fOpen && !_FOpen(fFalse, _grffil))
+        goto LRet;
+
+    if (hNil == (_hmap = CreateFileMapping(_hfile, pvNil, PAGE_WRITECOPY, 0, 0, pvNil)))
+        goto LRet;
+    if (pvNil == (_prgbMap = (byte *)MapViewOfFile(_hmap, FILE_MAP_COPY, 0, 0, 0)))
+    {
+        CloseHandle(_hmap);
+        _hmap = hNil;
+        goto LRet;
+    }
+    _cbMap = fpMac;
+
+LRet:
+    _mutx.Leave();
+
+    return pvNil != _prgbMap;
+}
+
+/***************************************************************************
+    If the file is mapped, return a pointer to the given range of the
+    view. Returns pvNil if the file isn't mapped or the range isn't in
+    the view.
+***************************************************************************/
+void *FIL::PvMapped(FP fp, long cb)
+{
+    AssertThis(0);
+    AssertIn(cb, 0, kcbMax);
+
+    if (pvNil == _prgbMap || !FIn(fp, 0, _cbMap) || cb > _cbMap - fp)
+        return pvNil;
+    return _prgbMap + fp;
+}
+
 /***************************************************************************
     Seek to the given fp - assumes the mutx is already entered.
 ***************************************************************************/
@@ -72,15 +72,15 @@ class FNI : public FNI_PAR
 #ifdef MAC
     long _lwDir; // the directory id
     FSS _fss;
-#elif defined(WIN)
+#elif defined(WIN) || defined(LINUX)
     STN _stnFile;
-#endif // WIN
+#endif // WIN || LINUX
 
-#ifdef WIN
+#if defined(WIN) || defined(LINUX)
     void _SetFtgFromName(void);
     long _CchExt(void);
     bool _FChangeLeaf(PSTN pstn);
-#endif // WIN
+#endif // WIN || LINUX
 
   public:
     FNI(void);
@@ -109,6 +109,7 @@ class FNI : public FNI_PAR
     void GetStnPath(PSTN pstn);
 
     tribool TExists(void);
+    bool FGetModTime(ulong *ptim);
     bool FDelete(void);
     bool FRename(PFNI pfniNew);
     bool FEqual(PFNI pfni);
@@ -169,6 +170,11 @@ class FNE : public FNE_PAR
         ulong grfvol; // which volumes are available (for enumerating volumes)
         long chVol;   // which volume we're on (for enumerating volumes)
 #endif                // WIN
+#ifdef LINUX
+        FNI fni;      // directory fni
+        void *pdir;   // DIR * for enumerating files/directories
+        bool fVolume; // the root still needs to be returned (for enumerating volumes)
+#endif                // LINUX
     };
 
     FTG _rgftg[kcftgFneBase];
@@ -180,9 +186,9 @@ class FNE : public FNE_PAR
     FES _fesCur;
 
     void _Free(void);
-#ifdef WIN
+#if defined(WIN) || defined(LINUX)
     bool _FPop(void);
-#endif // WIN
+#endif // WIN || LINUX
 
   public:
     FNE(void);
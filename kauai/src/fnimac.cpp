@@ -314,6 +314,33 @@ bool FNI::TExists(void)
     return tYes;
 }
 
+/***************************************************************************
+    Get the time the file was last modified, in seconds since 1970.
+    Pushes an erc and returns false on error.
+***************************************************************************/
+bool FNI::FGetModTime(ulong *ptim)
+{
+    AssertThis(ffniFile);
+    AssertVarMem(ptim);
+    CInfoPBRec iob;
+    achar st[kcbMaxSt];
+
+    ClearPb(&iob, size(iob));
+    CopySt((achar *)_fss.name, st);
+    iob.hFileInfo.ioNamePtr = (byte *)st;
+    iob.hFileInfo.ioVRefNum = _fss.vRefNum;
+    iob.hFileInfo.ioDirID = _fss.parID;
+    if (PBGetCatInfo(&iob, fFalse) != noErr)
+    {
+        PushErc(ercFniGeneral);
+        return fFalse;
+    }
+
+    // Mac dates count seconds since 1904
+    *ptim = iob.hFileInfo.ioFlMdDat - 2082844800;
+    return fTrue;
+}
+
 /***************************************************************************
     Delete the file.
 ***************************************************************************/
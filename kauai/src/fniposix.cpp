@@ -0,0 +1,989 @@
+/***************************************************************************
+    Project: Kauai
+
+    POSIX file name management.  Paths are absolute and use '/'.  As on
+    Windows, the ftg of a file is its (upper cased) extension; extensions
+    we add are lower case, which is how the content files are named.
+
+***************************************************************************/
+#include "util.h"
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+ASSERTNAME
+
+// This is the FTG to use for temp files - clients may set this to whatever
+// they want.
+FTG vftgTemp = kftgTemp;
+
+// maximal number of short characters in an extension is 4 (so it fits in
+// a long).
+const long kcchsMaxExt = size(long);
+
+priv void _CleanFtg(FTG *pftg, PSTN pstnExt = pvNil);
+priv bool _FFullPath(PSTN pstn, PSTN pstnFull);
+FNI _fniTemp;
+
+RTCLASS(FNI)
+RTCLASS(FNE)
+
+/***************************************************************************
+    Make pstn into an absolute path with no "." or ".." components and no
+    repeated slashes, relative to the current directory if it isn't
+    absolute already.  Backslashes are taken as separators too.  A
+    trailing slash is kept.  The file needn't exist.
+***************************************************************************/
+priv bool _FFullPath(PSTN pstn, PSTN pstnFull)
+{
+    AssertPo(pstn, 0);
+    AssertPo(pstnFull, 0);
+    SZ sz;
+    STN stn;
+    achar *pch, *pchLim, *pchName;
+    long cch;
+
+    if (pstn->Cch() == 0)
+        return fFalse;
+
+    if (pstn->Psz()[0] != ChLit('/') && pstn->Psz()[0] != ChLit('\\'))
+    {
+        if (pvNil == getcwd(sz, kcchMaxSz))
+            return fFalse;
+        stn = sz;
+        if (!stn.FAppendCh(ChLit('/')) || !stn.FAppendStn(pstn))
+            return fFalse;
+    }
+    else
+        stn = *pstn;
+
+    pstnFull->SetNil();
+    pch = stn.Psz();
+    pchLim = pch + stn.Cch();
+    while (pch < pchLim)
+    {
+        // skip separators
+        if (*pch == ChLit('/') || *pch == ChLit('\\'))
+        {
+            pch++;
+            continue;
+        }
+
+        for (pchName = pch; pch < pchLim && *pch != ChLit('/') && *pch != ChLit('\\'); pch++)
+        {
+        }
+        cch = pch - pchName;
+        if (cch == 1 && pchName[0] == ChLit('.'))
+            continue;
+        if (cch == 2 && pchName[0] == ChLit('.') && pchName[1] == ChLit('.'))
+        {
+            // back up over the last component (if any)
+            long ich;
+
+            for (ich = pstnFull->Cch(); ich > 0 && pstnFull->Psz()[ich - 1] != ChLit('/'); ich--)
+            {
+            }
+            pstnFull->Delete(LwMax(ich - 1, 0));
+            continue;
+        }
+        if (!pstnFull->FAppendCh(ChLit('/')) || !pstnFull->FAppendRgch(pchName, cch))
+            return fFalse;
+    }
+
+    // keep a trailing slash, and the root is just a slash
+    if ((pstnFull->Cch() == 0 || pchLim[-1] == ChLit('/') || pchLim[-1] == ChLit('\\')) &&
+        !pstnFull->FAppendCh(ChLit('/')))
+    {
+        return fFalse;
+    }
+    return fTrue;
+}
+
+/***************************************************************************
+    Sets the fni to nil values.
+***************************************************************************/
+void FNI::SetNil(void)
+{
+    _ftg = ftgNil;
+    _stnFile.SetNil();
+    AssertThis(ffniEmpty);
+}
+
+/***************************************************************************
+    Constructor for fni class.
+***************************************************************************/
+FNI::FNI(void)
+{
+    SetNil();
+}
+
+/***************************************************************************
+    Builds the fni from the path.
+***************************************************************************/
+bool FNI::FBuildFromPath(PSTN pstn, FTG ftgDef)
+{
+    AssertThis(0);
+    AssertPo(pstn, 0);
+
+    long cch;
+    achar *pchT;
+
+    if (kftgDir != ftgDef)
+    {
+        // if the path ends with a slash or only has periods after the last
+        // slash, force the fni to be a directory.
+
+        cch = pstn->Cch();
+        for (pchT = pstn->Prgch() + cch - 1;; pchT--)
+        {
+            if (cch-- <= 0 || *pchT == ChLit('\\') || *pchT == ChLit('/'))
+            {
+                ftgDef = kftgDir;
+                break;
+            }
+            if (*pchT != ChLit('.'))
+                break;
+        }
+    }
+
+    if (!_FFullPath(pstn, &_stnFile))
+        goto LFail;
+
+    if (ftgDef == kftgDir)
+    {
+        if (_stnFile.Psz()[_stnFile.Cch() - 1] != ChLit('/') && !_stnFile.FAppendCh(ChLit('/')))
+            goto LFail;
+        _ftg = kftgDir;
+    }
+    else
+    {
+        _SetFtgFromName();
+        if (_ftg == 0 && ftgDef != ftgNil && pstn->Prgch()[pstn->Cch() - 1] != ChLit('.') && !FChangeFtg(ftgDef))
+        {
+        LFail:
+            SetNil();
+            PushErc(ercFniGeneral);
+            return fFalse;
+        }
+    }
+
+    AssertThis(ffniFile | ffniDir);
+    return fTrue;
+}
+
+/***************************************************************************
+    Get a unique filename in the directory currently indicated by the fni.
+***************************************************************************/
+bool FNI::FGetUnique(FTG ftg)
+{
+    AssertThis(ffniFile | ffniDir);
+    static short _dsw = 0;
+    STN stn;
+    STN stnOld;
+    short sw;
+    long cact;
+
+    if (Ftg() == kftgDir)
+        stnOld.SetNil();
+    else
+        GetLeaf(&stnOld);
+
+    sw = (short)TsCurrentSystem() + ++_dsw;
+    for (cact = 20; cact != 0; cact--, sw += ++_dsw)
+    {
+        stn.FFormatSz(PszLit("Temp%04x"), (long)sw);
+        if (stn.FEqual(&stnOld))
+            continue;
+        if (FSetLeaf(&stn, ftg) && TExists() == tNo)
+            return fTrue;
+    }
+    SetNil();
+    PushErc(ercFniGeneral);
+    return fFalse;
+}
+
+/***************************************************************************
+    Get a temporary fni.
+***************************************************************************/
+bool FNI::FGetTemp(void)
+{
+    AssertThis(0);
+
+    if (_fniTemp._ftg != kftgDir)
+    {
+        // get the temp directory
+        STN stn;
+        char *psz;
+
+        if (pvNil == (psz = getenv("TMPDIR")) || psz[0] == 0)
+            psz = (char *)"/tmp";
+        stn = psz;
+        if (!_fniTemp.FBuildFromPath(&stn, kftgDir))
+            return fFalse;
+        AssertPo(&_fniTemp, ffniDir);
+    }
+    *this = _fniTemp;
+    return FGetUnique(vftgTemp);
+}
+
+/***************************************************************************
+    Return the file type of the fni.
+***************************************************************************/
+FTG FNI::Ftg(void)
+{
+    AssertThis(0);
+    return _ftg;
+}
+
+/***************************************************************************
+    Return the volume kind for the given fni.  We can only tell network
+    file systems apart.
+***************************************************************************/
+ulong FNI::Grfvk(void)
+{
+    AssertThis(ffniDir | ffniFile);
+    struct statfs sfs;
+
+    if (statfs(_stnFile.Psz(), &sfs) != 0)
+        return fvkNil;
+
+    switch ((ulong)sfs.f_type)
+    {
+    case 0x6969:     // NFS
+    case 0x517B:     // SMB
+    case 0xFE534D42: // SMB2
+    case 0xFF534D42: // CIFS
+        return fvkNetwork;
+    }
+    return fvkNil;
+}
+
+/***************************************************************************
+    Set the leaf to the given string and type.
+***************************************************************************/
+bool FNI::FSetLeaf(PSTN pstn, FTG ftg)
+{
+    AssertThis(ffniFile | ffniDir);
+    AssertNilOrPo(pstn, 0);
+
+    _CleanFtg(&ftg);
+    Assert(FPure(ftg == kftgDir) == FPure(pstn == pvNil || pstn->Cch() == 0), "ftg doesn't match pstn");
+    if (!_FChangeLeaf(pstn))
+        goto LFail;
+
+    if ((kftgDir != ftg) && (ftgNil != ftg) && !FChangeFtg(ftg))
+        goto LFail;
+
+    AssertThis(ffniFile | ffniDir);
+    return fTrue;
+
+LFail:
+    SetNil();
+    PushErc(ercFniGeneral);
+    return fFalse;
+}
+
+/******************************************************************************
+    Changes just the FTG of the FNI, leaving the file path and filename alone
+    (but does change the extension). Returns: fTrue if it succeeds
+******************************************************************************/
+bool FNI::FChangeFtg(FTG ftg)
+{
+    AssertThis(ffniFile);
+    Assert(ftg != ftgNil && ftg != kftgDir, "Bad FTG");
+    STN stnFtg;
+    long cchBase;
+
+    _CleanFtg(&ftg, &stnFtg);
+    if (_ftg == ftg)
+        return fTrue;
+
+    // set the extension
+    cchBase = _stnFile.Cch() - _CchExt();
+
+    // use >= to leave room for the '.'
+    if (cchBase + stnFtg.Cch() >= kcchMaxStn)
+        return fFalse;
+
+    _stnFile.Delete(cchBase);
+    _ftg = ftg;
+    if (stnFtg.Cch() > 0)
+    {
+        long ich;
+
+        _stnFile.FAppendCh(ChLit('.'));
+        for (ich = 0; ich < stnFtg.Cch(); ich++)
+            _stnFile.FAppendCh((achar)(byte)ChsLower((schar)stnFtg.Psz()[ich]));
+    }
+    return fTrue;
+}
+
+/***************************************************************************
+    Get the leaf name.
+***************************************************************************/
+void FNI::GetLeaf(PSTN pstn)
+{
+    AssertThis(0);
+    AssertPo(pstn, 0);
+    achar *pch;
+    PSZ psz = _stnFile.Psz();
+
+    for (pch = psz + _stnFile.Cch(); pch-- > psz && *pch != ChLit('/');)
+    {
+    }
+    Assert(pch >= psz, "bad fni");
+
+    pstn->SetSz(pch + 1);
+}
+
+/***************************************************************************
+    Get a string representing the path of the fni.
+***************************************************************************/
+void FNI::GetStnPath(PSTN pstn)
+{
+    AssertThis(0);
+    AssertPo(pstn, 0);
+    *pstn = _stnFile;
+}
+
+/***************************************************************************
+    Determines if the file/directory exists.  Returns tMaybe on error or
+    if the fni type (file or dir) doesn't match the disk object of the
+    same name.  Dot files count as hidden.
+***************************************************************************/
+tribool FNI::TExists(void)
+{
+    AssertThis(ffniFile | ffniDir);
+    struct stat st;
+    STN stn;
+
+    if (stat(_stnFile.Psz(), &st) != 0)
+    {
+        /* Any of these are equivalent to "there's no file with that name" */
+        if (errno == ENOENT || errno == ENOTDIR)
+            return tNo;
+        PushErc(ercFniGeneral);
+        return tMaybe;
+    }
+    if ((_ftg == kftgDir) != FPure(S_ISDIR(st.st_mode)))
+    {
+        PushErc(ercFniMismatch);
+        return tMaybe;
+    }
+    if (_ftg != kftgDir)
+    {
+        GetLeaf(&stn);
+        if (stn.Psz()[0] == ChLit('.'))
+        {
+            PushErc(ercFniHidden);
+            return tMaybe;
+        }
+    }
+    return tYes;
+}
+
+/***************************************************************************
+    Get the time the file was last modified, in seconds since 1970 (UTC).
+    Pushes an erc and returns false on error.
+***************************************************************************/
+bool FNI::FGetModTime(ulong *ptim)
+{
+    AssertThis(ffniFile);
+    AssertVarMem(ptim);
+    struct stat st;
+
+    if (stat(_stnFile.Psz(), &st) != 0)
+    {
+        PushErc(ercFniGeneral);
+        return fFalse;
+    }
+    *ptim = (ulong)st.st_mtime;
+    return fTrue;
+}
+
+/***************************************************************************
+    Delete the physical file.  Should not be open.
+***************************************************************************/
+bool FNI::FDelete(void)
+{
+    AssertThis(ffniFile);
+    Assert(FIL::PfilFromFni(this) == pvNil, "file is open");
+
+    if (unlink(_stnFile.Psz()) == 0)
+        return fTrue;
+    PushErc(ercFniDelete);
+    return fFalse;
+}
+
+/***************************************************************************
+    Renames the file indicated by this to *pfni.  Like MoveFile, this
+    won't replace an existing file.
+***************************************************************************/
+bool FNI::FRename(FNI *pfni)
+{
+    AssertThis(ffniFile);
+    AssertPo(pfni, ffniFile);
+
+    if (access(_stnFile.Psz(), W_OK) == 0 && pfni->TExists() == tNo &&
+        rename(_stnFile.Psz(), pfni->_stnFile.Psz()) == 0)
+    {
+        return fTrue;
+    }
+    PushErc(ercFniRename);
+    return fFalse;
+}
+
+/***************************************************************************
+    Compare two fni's for equality.  File names are case sensitive.
+***************************************************************************/
+bool FNI::FEqual(FNI *pfni)
+{
+    AssertThis(ffniFile | ffniDir);
+    AssertPo(pfni, ffniFile | ffniDir);
+
+    return pfni->_stnFile.FEqual(&_stnFile);
+}
+
+/***************************************************************************
+    Return whether the fni refers to a directory.
+***************************************************************************/
+bool FNI::FDir(void)
+{
+    AssertThis(0);
+    return _ftg == kftgDir;
+}
+
+/***************************************************************************
+    Return whether the directory portions of the fni's are the same.
+***************************************************************************/
+bool FNI::FSameDir(FNI *pfni)
+{
+    AssertThis(ffniFile | ffniDir);
+    AssertPo(pfni, ffniFile | ffniDir);
+    FNI fni1, fni2;
+
+    fni1 = *this;
+    fni2 = *pfni;
+    fni1._FChangeLeaf(pvNil);
+    fni2._FChangeLeaf(pvNil);
+    return fni1.FEqual(&fni2);
+}
+
+/***************************************************************************
+    Determine if the directory pstn in fni exists, optionally creating it
+    and/or moving into it.  Specify ffniCreateDir to create it if it
+    doesn't exist.  Specify ffniMoveTo to make the fni refer to it.
+***************************************************************************/
+bool FNI::FDownDir(PSTN pstn, ulong grffni)
+{
+    AssertThis(ffniDir);
+    AssertPo(pstn, 0);
+
+    FNI fniT;
+
+    fniT = *this;
+    // the +1 is for the / character
+    if (fniT._stnFile.Cch() + pstn->Cch() + 1 > kcchMaxStn)
+    {
+        PushErc(ercFniGeneral);
+        return fFalse;
+    }
+    AssertDo(fniT._stnFile.FAppendStn(pstn), 0);
+    AssertDo(fniT._stnFile.FAppendCh(ChLit('/')), 0);
+    fniT._ftg = kftgDir;
+    AssertPo(&fniT, ffniDir);
+
+    if (fniT.TExists() != tYes)
+    {
+        if (!(grffni & ffniCreateDir))
+            return fFalse;
+        // try to create it
+        if (mkdir(fniT._stnFile.Psz(), 0777) != 0)
+        {
+            PushErc(ercFniDirCreate);
+            return fFalse;
+        }
+    }
+    if (grffni & ffniMoveToDir)
+        *this = fniT;
+
+    return fTrue;
+}
+
+/***************************************************************************
+    Gets the lowest directory name (if pstn is not nil) and optionally
+    moves the fni up a level (if ffniMoveToDir is specified).
+***************************************************************************/
+bool FNI::FUpDir(PSTN pstn, ulong grffni)
+{
+    AssertThis(ffniDir);
+    AssertNilOrPo(pstn, 0);
+
+    long cch;
+    STN stn;
+
+    // the root has no parent
+    if ((cch = _stnFile.Cch()) <= 1)
+        return fFalse;
+
+    // find the slash before the last component
+    for (cch--; cch > 0 && _stnFile.Psz()[cch - 1] != ChLit('/'); cch--)
+    {
+    }
+    Assert(cch > 0, "bad fni");
+
+    if (pvNil != pstn)
+    {
+        // copy the tail and delete the trailing slash
+        pstn->SetSz(_stnFile.Psz() + cch);
+        pstn->Delete(pstn->Cch() - 1);
+    }
+
+    if (grffni & ffniMoveToDir)
+    {
+        _stnFile.Delete(cch);
+        AssertThis(ffniDir);
+    }
+    return fTrue;
+}
+
+#ifdef DEBUG
+/***************************************************************************
+    Assert validity of the FNI.
+***************************************************************************/
+void FNI::AssertValid(ulong grffni)
+{
+    FNI_PAR::AssertValid(0);
+    AssertPo(&_stnFile, 0);
+
+    long cch;
+    PSZ psz;
+
+    if (grffni == 0)
+        grffni = ffniEmpty | ffniDir | ffniFile;
+
+    if (_ftg == ftgNil)
+    {
+        Assert(grffni & ffniEmpty, "unexpected empty");
+        Assert(_stnFile.Cch() == 0, "named empty?");
+        return;
+    }
+
+    psz = _stnFile.Psz();
+    cch = _stnFile.Cch();
+    if (cch == 0 || psz[0] != ChLit('/'))
+    {
+        Bug("bad fni");
+        return;
+    }
+
+    if (_ftg == kftgDir)
+    {
+        Assert(grffni & ffniDir, "unexpected dir");
+        Assert(psz[cch - 1] == ChLit('/'), "expected trailing slash");
+    }
+    else
+    {
+        Assert(grffni & ffniFile, "unexpected file");
+        Assert(psz[cch - 1] != ChLit('/'), "expected filename");
+    }
+}
+#endif // DEBUG
+
+/***************************************************************************
+    Find the length of the file extension on the fni (including the period).
+    Allow up to kcchsMaxExt characters for the extension (plus one for the
+    period).
+***************************************************************************/
+long FNI::_CchExt(void)
+{
+    AssertBaseThis(0);
+    long cch;
+    PSZ psz = _stnFile.Psz();
+    achar *pch = psz + _stnFile.Cch() - 1;
+
+    for (cch = 1; cch <= kcchsMaxExt + 1 && pch >= psz; cch++, pch--)
+    {
+        if ((achar)(schar)*pch != *pch)
+        {
+            // not an ANSI character - so doesn't qualify for our
+            // definition of an extension
+            return 0;
+        }
+
+        switch (*pch)
+        {
+        case ChLit('.'):
+            return cch;
+        case ChLit('/'):
+            return 0;
+        }
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+    Set the ftg from the file name.
+***************************************************************************/
+void FNI::_SetFtgFromName(void)
+{
+    AssertBaseThis(0);
+    Assert(_stnFile.Cch() > 0, 0);
+    long cch, ich;
+    achar *pchLim = _stnFile.Psz() + _stnFile.Cch();
+
+    if (pchLim[-1] == ChLit('/'))
+        _ftg = kftgDir;
+    else
+    {
+        _ftg = 0;
+        cch = _CchExt() - 1;
+        AssertIn(cch, -1, kcchsMaxExt + 1);
+        pchLim -= cch;
+        for (ich = 0; ich < cch; ich++)
+            _ftg = (_ftg << 8) | (long)(byte)ChsUpper((schar)pchLim[ich]);
+    }
+    AssertThis(ffniFile | ffniDir);
+}
+
+/***************************************************************************
+    Change the leaf of the fni.
+***************************************************************************/
+bool FNI::_FChangeLeaf(PSTN pstn)
+{
+    AssertThis(ffniFile | ffniDir);
+    AssertNilOrPo(pstn, 0);
+
+    achar *pch;
+    PSZ psz;
+    long cchBase, cch;
+
+    psz = _stnFile.Psz();
+    for (pch = psz + _stnFile.Cch(); pch-- > psz && *pch != ChLit('/');)
+    {
+    }
+    Assert(pch >= psz, "bad fni");
+
+    cchBase = pch - psz + 1;
+    _stnFile.Delete(cchBase);
+    _ftg = kftgDir;
+    if (pstn != pvNil && (cch = pstn->Cch()) > 0)
+    {
+        if (cchBase + cch > kcchMaxStn)
+            return fFalse;
+        AssertDo(_stnFile.FAppendStn(pstn), 0);
+        _SetFtgFromName();
+    }
+    AssertThis(ffniFile | ffniDir);
+    return fTrue;
+}
+
+/***************************************************************************
+    Make sure the ftg is all uppercase and has no characters after a zero.
+***************************************************************************/
+priv void _CleanFtg(FTG *pftg, PSTN pstnExt)
+{
+    AssertVarMem(pftg);
+    AssertNilOrPo(pstnExt, 0);
+
+    long ichs;
+    schar chs;
+    bool fZero;
+    FTG ftgNew;
+
+    if (pvNil != pstnExt)
+        pstnExt->SetNil();
+
+    if (*pftg == kftgDir || *pftg == ftgNil)
+        return;
+
+    fZero = fFalse;
+    ftgNew = 0;
+    for (ichs = 0; ichs < kcchsMaxExt; ichs++)
+    {
+        chs = (schar)((ulong)*pftg >> (ichs * 8));
+        fZero |= (chs == 0);
+        if (!fZero)
+        {
+            chs = ChsUpper(chs);
+            ftgNew |= (long)(byte)chs << (8 * ichs);
+            if (pvNil != pstnExt)
+                pstnExt->FInsertCh(0, (achar)(byte)chs);
+        }
+    }
+
+    *pftg = ftgNew;
+}
+
+/***************************************************************************
+    Constructor for a File Name Enumerator.
+***************************************************************************/
+FNE::FNE(void)
+{
+    AssertBaseThis(0);
+    _prgftg = _rgftg;
+    _pglfes = pvNil;
+    _fesCur.pdir = pvNil;
+    _fesCur.fVolume = fFalse;
+    _fInited = fFalse;
+    AssertThis(0);
+}
+
+/***************************************************************************
+    Destructor for an FNE.
+***************************************************************************/
+FNE::~FNE(void)
+{
+    AssertBaseThis(0);
+    _Free();
+}
+
+/***************************************************************************
+    Free all the memory associated with the FNE.
+***************************************************************************/
+void FNE::_Free(void)
+{
+    if (_prgftg != _rgftg)
+    {
+        FreePpv((void **)&_prgftg);
+        _prgftg = _rgftg;
+    }
+    do
+    {
+        if (pvNil != _fesCur.pdir)
+            closedir((DIR *)_fesCur.pdir);
+    } while (pvNil != _pglfes && _pglfes->FPop(&_fesCur));
+    _fesCur.pdir = pvNil;
+    _fesCur.fVolume = fFalse;
+    _fInited = fFalse;
+    ReleasePpo(&_pglfes);
+    AssertThis(0);
+}
+
+/***************************************************************************
+    Initialize the fne to do an enumeration.  With no directory, the only
+    "volume" is the root.
+***************************************************************************/
+bool FNE::FInit(FNI *pfniDir, FTG *prgftg, long cftg, ulong grffne)
+{
+    AssertThis(0);
+    AssertNilOrVarMem(pfniDir);
+    AssertIn(cftg, 0, kcbMax);
+    AssertPvCb(prgftg, LwMul(cftg, size(FTG)));
+    FTG *pftg;
+
+    // free the old stuff
+    _Free();
+
+    if (0 >= cftg)
+        _cftg = 0;
+    else
+    {
+        long cb = LwMul(cftg, size(FTG));
+
+        if (cftg > kcftgFneBase && !FAllocPv((void **)&_prgftg, cb, fmemNil, mprNormal))
+        {
+            _prgftg = _rgftg;
+            PushErc(ercFneGeneral);
+            AssertThis(0);
+            return fFalse;
+        }
+        CopyPb(prgftg, _prgftg, cb);
+        _cftg = cftg;
+        for (pftg = _prgftg + _cftg; pftg-- > _prgftg;)
+            _CleanFtg(pftg);
+    }
+
+    if (pfniDir == pvNil)
+        _fesCur.fVolume = fTrue;
+    else
+    {
+        _fesCur.fVolume = fFalse;
+        _fesCur.fni = *pfniDir;
+        if (!_fesCur.fni._FChangeLeaf(pvNil))
+        {
+            PushErc(ercFneGeneral);
+            _Free();
+            AssertThis(0);
+            return fFalse;
+        }
+    }
+    _fesCur.pdir = pvNil;
+    _fRecurse = FPure(grffne & ffneRecurse);
+    _fInited = fTrue;
+    AssertThis(0);
+    return fTrue;
+}
+
+/***************************************************************************
+    Get the next FNI in the enumeration.
+***************************************************************************/
+bool FNE::FNextFni(FNI *pfni, ulong *pgrffneOut, ulong grffneIn)
+{
+    AssertThis(0);
+    AssertVarMem(pfni);
+    AssertNilOrVarMem(pgrffneOut);
+    STN stn;
+    FNI fniT;
+    bool fT;
+    struct dirent *pde;
+    FTG *pftg;
+
+    if (!_fInited)
+    {
+        Bug("must initialize the FNE before using it!");
+        return fFalse;
+    }
+
+    if (grffneIn & ffneSkipDir)
+    {
+        // skip the rest of the stuff in this dir
+        if (!_FPop())
+            goto LDone;
+    }
+
+    if (_fesCur.fVolume)
+    {
+        // volume
+        _fesCur.fVolume = fFalse;
+        stn = PszLit("/");
+        AssertDo(pfni->FBuildFromPath(&stn), 0);
+        goto LGotOne;
+    }
+    if (_fesCur.fni._ftg != kftgDir)
+        goto LDone;
+
+    // directory or file
+    for (;;)
+    {
+        if (pvNil == _fesCur.pdir && pvNil == (_fesCur.pdir = opendir(_fesCur.fni._stnFile.Psz())))
+        {
+            PushErc(ercFneGeneral);
+            goto LPop;
+        }
+
+        errno = 0;
+        if (pvNil == (pde = readdir((DIR *)_fesCur.pdir)))
+        {
+            if (errno != 0)
+                PushErc(ercFneGeneral);
+            goto LPop;
+        }
+
+        // dot files are hidden
+        if (pde->d_name[0] == '.')
+            continue;
+
+        stn.SetSz(pde->d_name);
+        fniT = _fesCur.fni;
+        fT = fniT._FChangeLeaf(&stn);
+        if (fT && tYes != fniT.TExists())
+        {
+            // it's a directory (or it went away or is hidden)
+            fniT = _fesCur.fni;
+            fT = fniT.FDownDir(&stn, ffniMoveToDir);
+        }
+        vpers->Flush(ercFniMismatch);
+        if (!fT)
+            continue;
+        *pfni = fniT;
+
+        if (_cftg == 0)
+            goto LGotOne;
+        for (pftg = _prgftg + _cftg; pftg-- > _prgftg;)
+        {
+            if (*pftg == pfni->_ftg)
+                goto LGotOne;
+        }
+    }
+    Bug("How did we fall through to here?");
+
+LPop:
+    if (pvNil == _pglfes || _pglfes->IvMac() == 0)
+    {
+    LDone:
+        _Free();
+        AssertThis(0);
+        return fFalse;
+    }
+
+    // we're about to pop a directory, so send the current directory back
+    // with ffnePost
+    if (pvNil != pgrffneOut)
+        *pgrffneOut = ffnePost;
+    *pfni = _fesCur.fni;
+    AssertDo(_FPop(), 0);
+    AssertPo(pfni, ffniDir);
+    AssertThis(0);
+    return fTrue;
+
+LGotOne:
+    AssertPo(pfni, ffniFile | ffniDir);
+    if (pvNil != pgrffneOut)
+        *pgrffneOut = ffnePre | ffnePost;
+
+    if (_fRecurse && pfni->_ftg == kftgDir)
+    {
+        if ((pvNil != _pglfes || pvNil != (_pglfes = GL::PglNew(size(FES), 5))) && _pglfes->FPush(&_fesCur))
+        {
+            // set up the new fes
+            _fesCur.fni = *pfni;
+            _fesCur.pdir = pvNil;
+            _fesCur.fVolume = fFalse;
+            if (pvNil != pgrffneOut)
+                *pgrffneOut = ffnePre;
+        }
+        else
+            PushErc(ercFneGeneral);
+    }
+    AssertThis(0);
+    return fTrue;
+}
+
+/***************************************************************************
+    Pop a state in the FNE.
+***************************************************************************/
+bool FNE::_FPop(void)
+{
+    AssertBaseThis(0);
+    if (pvNil != _fesCur.pdir)
+    {
+        closedir((DIR *)_fesCur.pdir);
+        _fesCur.pdir = pvNil;
+    }
+    return pvNil != _pglfes && _pglfes->FPop(&_fesCur);
+}
+
+#ifdef DEBUG
+/***************************************************************************
+    Assert the validity of a FNE.
+***************************************************************************/
+void FNE::AssertValid(ulong grf)
+{
+    FNE_PAR::AssertValid(0);
+    if (_fInited)
+    {
+        AssertNilOrPo(_pglfes, 0);
+        AssertIn(_cftg, 0, kcbMax);
+        AssertPvCb(_prgftg, LwMul(size(FTG), _cftg));
+        Assert((_cftg <= kcftgFneBase) == (_prgftg == _rgftg), "wrong _prgftg");
+    }
+    else
+        Assert(_pglfes == pvNil, 0);
+}
+
+/***************************************************************************
+    Mark memory for the FNE.
+***************************************************************************/
+void FNE::MarkMem(void)
+{
+    AssertValid(0);
+    FNE_PAR::MarkMem();
+    if (_prgftg != _rgftg)
+        MarkPv(_prgftg);
+    MarkMemObj(_pglfes);
+}
+#endif // DEBUG
@@ -470,6 +470,30 @@ tribool FNI::TExists(void)
     return tYes;
 }
 
+/***************************************************************************
+    Get the time the file was last modified, in seconds since 1970 (UTC).
+    Pushes an erc and returns false on error.
+***************************************************************************/
+bool FNI::FGetModTime(ulong *ptim)
+{
+    AssertThis(ffniFile);
+    AssertVarMem(ptim);
+    WIN32_FILE_ATTRIBUTE_DATA wfad;
+    ULARGE_INTEGER uli;
+
+    if (!GetFileAttributesEx(_stnFile.Psz(), GetFileExInfoStandard, &wfad))
+    {
+        PushErc(ercFniGeneral);
+        return fFalse;
+    }
+
+    // FILETIMEs count 100ns intervals since 1601
+    uli.LowPart = wfad.ftLastWriteTime.dwLowDateTime;
+    uli.HighPart = wfad.ftLastWriteTime.dwHighDateTime;
+    *ptim = (ulong)(uli.QuadPart / 10000000 - 11644473600);
+    return fTrue;
+}
+
 /***************************************************************************
     Delete the physical file.  Should not be open.
 ***************************************************************************/
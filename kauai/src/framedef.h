@@ -27,7 +27,12 @@
 #define MacWin(mac, win) win
 #define Mac(foo)
 #define Win(foo) foo
-#endif // WIN
+#elif defined(LINUX)
+// data formats follow Windows
+#define MacWin(mac, win) win
+#define Mac(foo)
+#define Win(foo)
+#endif // LINUX
 
 /***************************************************************************
     Miscellaneous defines
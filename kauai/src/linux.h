@@ -0,0 +1,52 @@
+/***************************************************************************
+    Project: Kauai
+
+    Linux standard header file - the equivalent of mac.h.  Besides the
+    system headers, this supplies the few Windows calls the portable code
+    makes through MacWin.
+
+***************************************************************************/
+#ifndef LINUX_H
+#define LINUX_H
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+/***************************************************************************
+    Milliseconds since some arbitrary starting point.
+***************************************************************************/
+inline unsigned long timeGetTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/***************************************************************************
+    The default Windows caret blink rate.
+***************************************************************************/
+inline unsigned long GetCaretBlinkTime(void)
+{
+    return 530;
+}
+
+/***************************************************************************
+    Case mapping of single byte characters, in place.
+***************************************************************************/
+inline unsigned long CharUpperBuffA(char *prgch, unsigned long cch)
+{
+    for (unsigned long ich = 0; ich < cch; ich++)
+        prgch[ich] = (char)toupper((unsigned char)prgch[ich]);
+    return cch;
+}
+inline unsigned long CharLowerBuffA(char *prgch, unsigned long cch)
+{
+    for (unsigned long ich = 0; ich < cch; ich++)
+        prgch[ich] = (char)tolower((unsigned char)prgch[ich]);
+    return cch;
+}
+
+#endif //! LINUX_H
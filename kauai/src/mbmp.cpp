@@ -22,6 +22,7 @@ MBMP::~MBMP(void)
 {
     AssertBaseThis(0);
     FreePhq(&_hqrgb);
+    ReleasePpo(&_pfilMap);
 }
 
 /***************************************************************************
@@ -259,6 +260,8 @@ PMBMP MBMP::PmbmpReadNative(FNI *pfni, byte bTransparent, long xp, long yp, ulon
 
 /***************************************************************************
     Read a masked bitmap from a block.  May free the block or modify it.
+    If the block is in a memory mapped file and the data can be used as
+    is, the MBMP references the data in place rather than copying it.
 ***************************************************************************/
 PMBMP MBMP::PmbmpRead(PBLCK pblck)
 {
@@ -270,15 +273,34 @@ PMBMP MBMP::PmbmpRead(PBLCK pblck)
     bool fSwap;
     RC rc;
     HQ hqrgb = hqNil;
+    PFIL pfilMap = pvNil;
+    void *pvMap;
 
-    if (!pblck->FUnpackData())
-        return pvNil;
     cbTot = pblck->Cb();
+    if (pvNil != (pvMap = pblck->PvMapped(&pfilMap)))
+    {
+        // the mapped view is read-only, so only use it if the data
+        // doesn't need to be fixed up
+        qmbmph = (MBMPH *)pvMap;
+        if (cbTot < size(MBMPH) || qmbmph->bo != kboCur || qmbmph->rc.FEmpty())
+        {
+            ReleasePpo(&pfilMap);
+            pvMap = pvNil;
+        }
+    }
 
-    if (cbTot < size(MBMPH) || hqNil == (hqrgb = pblck->HqFree()))
-        return pvNil;
+    if (pvNil == pfilMap)
+    {
+        if (!pblck->FUnpackData())
+            return pvNil;
+        cbTot = pblck->Cb();
+
+        if (cbTot < size(MBMPH) || hqNil == (hqrgb = pblck->HqFree()))
+            return pvNil;
+
+        qmbmph = (MBMPH *)QvFromHq(hqrgb);
+    }
 
-    qmbmph = (MBMPH *)QvFromHq(hqrgb);
     fSwap = (kboOther == qmbmph->bo);
     if (fSwap)
         SwapBytesBom(qmbmph, kbomMbmph);
@@ -305,11 +327,14 @@ PMBMP MBMP::PmbmpRead(PBLCK pblck)
     {
     LFail:
         FreePhq(&hqrgb);
+        ReleasePpo(&pfilMap);
         return pvNil;
     }
 
     pmbmp->_cbRgcb = cbRgcb;
     pmbmp->_hqrgb = hqrgb;
+    pmbmp->_pfilMap = pfilMap;
+    pmbmp->_pvMap = pvMap;
 
     if (fSwap)
     {
@@ -367,7 +392,7 @@ PMBMP MBMP::PmbmpRead(PBLCK pblck)
 long MBMP::CbOnFile(void)
 {
     AssertThis(0);
-    return CbOfHq(_hqrgb);
+    return _Cb();
 }
 
 /***************************************************************************
@@ -379,6 +404,18 @@ bool MBMP::FWrite(PBLCK pblck)
     AssertPo(pblck, 0);
     MBMPH *qmbmph;
 
+    if (pvNil != _pfilMap)
+    {
+        // mapped data is already in the on-file format (PmbmpRead
+        // verified that), and the view can't be modified anyway
+        if (_Cb() != pblck->Cb())
+        {
+            Bug("Wrong sized block");
+            return fFalse;
+        }
+        return pblck->FWriteRgb(_pvMap, _Cb(), 0);
+    }
+
     qmbmph = _Qmbmph();
     qmbmph->bo = kboCur;
     qmbmph->osk = koskCur;
@@ -454,7 +491,13 @@ void MBMP::AssertValid(ulong grf)
     RC rc;
 
     MBMP_PAR::AssertValid(0);
-    AssertHq(_hqrgb);
+    if (pvNil != _pfilMap)
+    {
+        AssertPo(_pfilMap, 0);
+        Assert(hqNil == _hqrgb && pvNil != _pvMap, "mapped MBMP has an hq");
+    }
+    else
+        AssertHq(_hqrgb);
 
     rc = _Qmbmph()->rc;
     ccb = rc.Dyp();
@@ -466,7 +509,7 @@ void MBMP::AssertValid(ulong grf)
         AssertIn(*qcb, 0, kcbMax);
         cbTot += *qcb++;
     }
-    Assert(cbTot + _cbRgcb + size(MBMPH) == CbOfHq(_hqrgb), "_hqrgb wrong size");
+    Assert(cbTot + _cbRgcb + size(MBMPH) == _Cb(), "_hqrgb wrong size");
 }
 
 /***************************************************************************
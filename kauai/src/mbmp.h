@@ -25,6 +25,16 @@ enum
     fmbmpMask = 2,
 };
 
+// run blitters used by MBMP::Draw
+enum
+{
+    kmbltScalar, // CopyPb and FillPb
+    kmbltVector, // 16 bytes at a time with SSE2 or NEON
+    kmbltLim
+};
+typedef void (*PFNCPRUN)(byte *pbDst, byte *pbSrc, long cb);
+typedef void (*PFNFLRUN)(byte *pbDst, long cb, byte b);
+
 typedef class MBMP *PMBMP;
 #define MBMP_PAR BACO
 #define kclsMBMP 'MBMP'
@@ -54,8 +64,18 @@ class MBMP : public MBMP_PAR
 
     // If fMask is true, the non-transparent pixels are not in _hqrgb. Instead,
     // all non-transparent pixels have the value bFill.
-    long _cbRgcb; // size of the rgcb portion of _hqrgb
-    HQ _hqrgb;    // MBMPH, short rgcb[_rc.Dyp()] followed by the pixel data
+
+    // If the MBMP was read from a memory mapped chunky file, _hqrgb is nil
+    // and _pvMap points at the chunk data in the view. We hold a reference
+    // to the file so the view stays valid.
+    long _cbRgcb;  // size of the rgcb portion of _hqrgb
+    HQ _hqrgb;     // MBMPH, short rgcb[_rc.Dyp()] followed by the pixel data
+    PFIL _pfilMap; // the mapped file _pvMap points into
+    void *_pvMap;  // mapped MBMPH, rgcb and pixel data
+
+    // run blitters used by Draw - see FSetMblt
+    static PFNCPRUN _pfncprun;
+    static PFNFLRUN _pfnflrun;
 
     // MBMP header on file
     struct MBMPH
@@ -77,11 +97,15 @@ class MBMP : public MBMP_PAR
 
     short *_Qrgcb(void)
     {
-        return (short *)PvAddBv(QvFromHq(_hqrgb), size(MBMPH));
+        return (short *)PvAddBv(_Qmbmph(), size(MBMPH));
     }
     MBMPH *_Qmbmph(void)
     {
-        return (MBMPH *)QvFromHq(_hqrgb);
+        return (MBMPH *)(pvNil != _pfilMap ? _pvMap : QvFromHq(_hqrgb));
+    }
+    long _Cb(void)
+    {
+        return pvNil != _pfilMap ? _Qmbmph()->cb : CbOfHq(_hqrgb);
     }
 
   public:
@@ -98,6 +122,8 @@ class MBMP : public MBMP_PAR
     void Draw(byte *prgbPixels, long cbRow, long dyp, long xpRef, long ypRef, RC *prcClip = pvNil,
               PREGN pregnClip = pvNil);
     void DrawMask(byte *prgbPixels, long cbRow, long dyp, long xpRef, long ypRef, RC *prcClip = pvNil);
+    static long MbltBest(void);
+    static bool FSetMblt(long mblt);
     bool FPtIn(long xp, long yp);
 
     virtual bool FWrite(PBLCK pblck);
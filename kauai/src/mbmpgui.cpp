@@ -11,281 +11,198 @@
 
 ***************************************************************************/
 #include "frame.h"
+#include "simd.h"
 ASSERTNAME
 
+PFNCPRUN MBMP::_pfncprun;
+PFNFLRUN MBMP::_pfnflrun;
+
 /***************************************************************************
-    This routine is called to draw the masked bitmap onto prgbPixels.
-    cbRow and dyp are the respective width and height of prgbPixels.
-    xpRef and ypRef are the coordinates within the prgbPixels to place
-    the reference point of the MBMP.  The drawing will be clipped to both
-    prcClip and pregnClip, which may be nil.
+    Scalar run blitters.  These are the only ones without SSE2 or NEON.
 ***************************************************************************/
-void MBMP::Draw(byte *prgbPixels, long cbRow, long dyp, long xpRef, long ypRef, RC *prcClip, PREGN pregnClip)
+priv void _CopyRunScalar(byte *pbDst, byte *pbSrc, long cb)
 {
-    AssertThis(0);
-    AssertIn(cbRow, 1, kcbMax);
-    AssertIn(dyp, 1, kcbMax);
-    AssertPvCb(prgbPixels, LwMul(cbRow, dyp));
-    AssertNilOrVarMem(prcClip);
-    AssertNilOrPo(pregnClip, 0);
+    CopyPb(pbSrc, pbDst, cb);
+}
 
-#ifdef IN_80386
-    // NOTE the "rep movsd" and "rep movsb" used for writing the bytes is
-    // responsible for most of the speed improvement of this over the straight
-    // C code.  The remaining asm gives us an additional 5 - 15 percent depending
-    // on the complexity of the transparency (the more complex, the more
-    // improvement over the C version).
+priv void _FillRunScalar(byte *pbDst, long cb, byte b)
+{
+    FillPb(pbDst, cb, b);
+}
 
-    long yp, dxpT, xpOn;
-    byte *qbRowSrc, *qbLastSrc, *pbOff;
-    short *qcb;
-    byte bFill;
-    long lwFill;
-    REGSC regsc;
-    RC rcClip(0, 0, cbRow, dyp);
-    MBMPH *qmbmph = _Qmbmph();
-    RC rcMbmp = qmbmph->rc;
-    bool fMask = qmbmph->fMask;
+#ifdef IN_SSE2
+/***************************************************************************
+    Copy a run of opaque pixels 16 at a time.  Runs are short (at most 255
+    pixels), so rather than aligning or looping over the tail, the last
+    few bytes are written by an overlapping store.  The source never
+    overlaps the destination.
+***************************************************************************/
+priv SSE2_FUNC void _CopyRunSse2(byte *pbDst, byte *pbSrc, long cb)
+{
+    if (cb >= 16)
+    {
+        byte *pbLast = pbDst + cb - 16;
 
-    // Intersect prcClip with the boundary of prgbPixels.
-    if (pvNil != prcClip && !rcClip.FIntersect(prcClip))
-        return;
+        for (; pbDst < pbLast; pbDst += 16, pbSrc += 16)
+            _mm_storeu_si128((__m128i *)pbDst, _mm_loadu_si128((__m128i *)pbSrc));
+        _mm_storeu_si128((__m128i *)pbLast, _mm_loadu_si128((__m128i *)(pbSrc - (pbDst - pbLast))));
+    }
+    else if (cb >= 8)
+    {
+        _mm_storel_epi64((__m128i *)pbDst, _mm_loadl_epi64((__m128i *)pbSrc));
+        _mm_storel_epi64((__m128i *)(pbDst + cb - 8), _mm_loadl_epi64((__m128i *)(pbSrc + cb - 8)));
+    }
+    else
+    {
+        while (cb-- > 0)
+            *pbDst++ = *pbSrc++;
+    }
+}
 
-    // Translate the mbmp's rc into coordinate system of prgbPixel's rc
-    rcMbmp.Offset(xpRef, ypRef);
+/***************************************************************************
+    Fill a run with a solid color 16 pixels at a time.
+***************************************************************************/
+priv SSE2_FUNC void _FillRunSse2(byte *pbDst, long cb, byte b)
+{
+    __m128i xmm = _mm_set1_epi8((char)b);
 
-    // Intersect rcClip with mbmp's translated rc.
-    if (!rcClip.FIntersect(&rcMbmp))
-        return;
+    if (cb >= 16)
+    {
+        byte *pbLast = pbDst + cb - 16;
 
-    // Set up the region scanner
-    if (pvNil != pregnClip)
-        regsc.Init(pregnClip, &rcClip);
+        for (; pbDst < pbLast; pbDst += 16)
+            _mm_storeu_si128((__m128i *)pbDst, xmm);
+        _mm_storeu_si128((__m128i *)pbLast, xmm);
+    }
+    else if (cb >= 8)
+    {
+        _mm_storel_epi64((__m128i *)pbDst, xmm);
+        _mm_storel_epi64((__m128i *)(pbDst + cb - 8), xmm);
+    }
     else
-        regsc.InitRc(&rcClip, &rcClip);
+    {
+        while (cb-- > 0)
+            *pbDst++ = b;
+    }
+}
+#endif // IN_SSE2
 
-    qcb = _Qrgcb();
-    qbRowSrc = (byte *)PvAddBv(qcb, _cbRgcb);
-    prgbPixels += LwMul(rcClip.ypTop, cbRow) + rcClip.xpLeft;
-    rcMbmp.Offset(-rcClip.xpLeft, -rcClip.ypTop);
-    rcClip.OffsetToOrigin();
+#ifdef IN_NEON
+/***************************************************************************
+    Copy a run of opaque pixels 16 at a time.  See _CopyRunSse2.
+***************************************************************************/
+priv void _CopyRunNeon(byte *pbDst, byte *pbSrc, long cb)
+{
+    if (cb >= 16)
+    {
+        byte *pbLast = pbDst + cb - 16;
 
-    if (fMask)
+        for (; pbDst < pbLast; pbDst += 16, pbSrc += 16)
+            vst1q_u8(pbDst, vld1q_u8(pbSrc));
+        vst1q_u8(pbLast, vld1q_u8(pbSrc - (pbDst - pbLast)));
+    }
+    else if (cb >= 8)
     {
-        bFill = qmbmph->bFill;
-        lwFill = LwFromBytes(bFill, bFill, bFill, bFill);
+        vst1_u8(pbDst, vld1_u8(pbSrc));
+        vst1_u8(pbDst + cb - 8, vld1_u8(pbSrc + cb - 8));
     }
+    else
+    {
+        while (cb-- > 0)
+            *pbDst++ = *pbSrc++;
+    }
+}
 
-    // Step down through rgcb until to top of clipping rc
-    for (yp = rcMbmp.ypTop; yp < 0; yp++)
-        qbRowSrc += *qcb++;
+/***************************************************************************
+    Fill a run with a solid color 16 pixels at a time.
+***************************************************************************/
+priv void _FillRunNeon(byte *pbDst, long cb, byte b)
+{
+    uint8x16_t q = vdupq_n_u8(b);
 
-    // copy each row appropriately
-    for (;;)
+    if (cb >= 16)
     {
-        if ((xpOn = regsc.XpCur()) == klwMax)
-        {
-            // empty strip of the region
-            long dypT;
+        byte *pbLast = pbDst + cb - 16;
 
-            dypT = regsc.DypCur();
-            if ((yp += dypT) >= rcClip.ypBottom)
-                break;
-            regsc.ScanNext(dypT);
-            prgbPixels += LwMul(dypT, cbRow);
-            for (; dypT > 0; dypT--)
-                qbRowSrc += *qcb++;
-            continue;
-        }
-        AssertIn(xpOn, 0, rcClip.xpRight);
-        pbOff = prgbPixels + LwMin(regsc.XpFetch(), rcClip.xpRight);
-
-        // register allocation:
-        // esi: qbSrc
-        // edi: pbDst
-        // ebx: pbOn
-        // edx: dxp
-        // eax: temp value
-
-#define qbSrc esi
-#define pbDst edi
-#define pbOn ebx
-#define dxp edx
-#define lwT eax
-
-        __asm {
-            // qbSrc = qbRowSrc;
-			mov		qbSrc,qbRowSrc
-
-                // lwT = *qcb++;
-			mov		lwT,qcb
-			add		qcb,2
-			movzx	lwT,WORD PTR[lwT]
-
-            // qbLastSrc = qbSrc + lwT
-			lea		lwT,DWORD PTR[qbSrc+lwT-1]
-			mov		qbLastSrc,lwT
-
-                // pbDst = prgbPixels + rcMbmp.xpLeft;
-                // pbOn = prgbPixels + xpOn;
-			mov		pbOn,xpOn
-			mov		pbDst,prgbPixels
-			add		pbOn,pbDst
-			add		pbDst,rcMbmp.xpLeft
-
-                // dxp = 0;
-			xor		dxp,dxp
-
-LGetDxp:
-                // if (qbLastSrc <= qbSrc) goto LNextRow
-			cmp		qbLastSrc,qbSrc
-			jbe		LNextRow
-
-                // dxp = qbSrc[1]; pbDst += *qbSrc; qbSrc += 2;
-			movzx	lwT,BYTE PTR[qbSrc]
-			movzx	dxp,BYTE PTR[qbSrc+1]
-			add		pbDst,lwT
-			add		qbSrc,2
-
-LTestDxp:
-                // if (dxp == 0) goto LGetDxp
-			test	dxp,dxp
-			je		LGetDxp
-
-                // if (pbDst + dxp > pbOn) goto LAfterOn;
-			lea		lwT,DWORD PTR[pbDst+dxp]
-			cmp		lwT,pbOn
-			ja		LAfterOn
-
-                // pbDst += dxp;
-			add		pbDst,dxp
-
-                // if (!fMask) qbSrc += dxp; goto LGetDxp
-			test	fMask,-1L
-			jnz		LGetDxp
-			add		qbSrc,dxp
-			jmp		LGetDxp
-
-LAfterOn:
-                // Assert(pbDst + dxp > pbOn, 0);
-                // if (pbDst < pbOff) goto LBeforeOff;
-			cmp		pbDst,pbOff
-			jb		LBeforeOff
-
-                // save the value of dxp across C code
-			mov		dxpT,dxp
-        }
+        for (; pbDst < pbLast; pbDst += 16)
+            vst1q_u8(pbDst, q);
+        vst1q_u8(pbLast, q);
+    }
+    else if (cb >= 8)
+    {
+        vst1_u8(pbDst, vget_low_u8(q));
+        vst1_u8(pbDst + cb - 8, vget_low_u8(q));
+    }
+    else
+    {
+        while (cb-- > 0)
+            *pbDst++ = b;
+    }
+}
+#endif // IN_NEON
 
-        // destination is after pbOff - need to advance the region scan
-        xpOn = regsc.XpFetch();
-        if (xpOn == klwMax)
-            goto LNextRow;
-        pbOff = prgbPixels + LwMin(regsc.XpFetch(), rcClip.xpRight);
-
-        __asm {
-            // restore the value of dxp
-			mov		dxp,dxpT
-
-                // pbOn = prgbPixels + xpOn;
-			mov		pbOn,prgbPixels
-			add		pbOn,xpOn
-
-                // goto LTestDxp;
-			jmp		LTestDxp
-
-LBeforeOff:
-                // AssertIn(0, pbOn - pbDst - dxp + 1, pbOff - pbDst);
-                // if (pbOn <= pbDst) goto LDstAfterOn;
-			cmp		pbOn,pbDst
-			jbe		LDstAfterOn
-
-                // destination is before pbOn: use pbDst as a temporary value to
-                // store (pbDst - pbOn), which should be negative.
-                //
-                // pbDst -= pbOn;
-                // dxp += pbDst;
-			sub		pbDst,pbOn
-			add		dxp,pbDst
-
-                // if (!fMask) qbSrc -= pbDst;
-			test	fMask,-1L
-			jnz		LMask
-			sub		qbSrc,pbDst
-
-LMask:
-                // pbDst = pbOn;
-			mov		pbDst,pbOn
-
-LDstAfterOn:
-                // AssertIn(0, pbOn - pbDst, pbOff - pbDst);
-                // lwT = LwMin(dxp, pbOff - pbDst);
-			mov		lwT,pbOff
-			sub		lwT,pbDst
-			cmp		lwT,dxp
-			jle		LKeepLwT
-			mov		lwT,dxp
-
-LKeepLwT:
-                // dxp -= lwT;
-			sub		dxp,lwT
-
-                // if (fMask) goto LFill;
-			test	fMask,-1L
-			jnz		LFill
-
-                // CopyPb(qbSrc, pbDst, lwT);
-                // qbSrc += lwT; pbDst += lwT;
-
-                // move the longs
-			mov		ecx,lwT
-			shr		ecx,2
-			rep		movsd
-
-                // move the extra bytes
-			mov		ecx,lwT
-			and		ecx,3
-			rep		movsb
-
-                // goto LTestDxp;
-			jmp		LTestDxp
-
-LFill:
-                // FillPb(pbDst, lwT, _bFill);
-                // pbDst += lwT;
-			mov		ecx,lwT
-			mov		eax,lwFill
-
-                // fill the longs
-			mov		dxpT,ecx
-			shr		ecx,2
-			rep		stosd
-
-                // fill the bytes
-			mov		ecx,dxpT
-			and		ecx,3
-			rep		stosb
-
-                // goto LTestDxp;
-			jmp		LTestDxp
-        }
+/***************************************************************************
+    Static method to return the fastest run blitter this processor can
+    use.
+***************************************************************************/
+long MBMP::MbltBest(void)
+{
+#if defined(IN_SSE2) || defined(IN_NEON)
+    return FVectorMoves() ? kmbltVector : kmbltScalar;
+#else
+    return kmbltScalar;
+#endif
+}
 
-#undef qbSrc
-#undef pbDst
-#undef pbOn
-#undef dxp
-#undef lwT
+/***************************************************************************
+    Static method to set which run blitters Draw uses.  Both produce the
+    same pixels; this is for timing and testing.  Fails if the processor
+    can't do mblt.  Draw uses MbltBest() if this is never called.
+***************************************************************************/
+bool MBMP::FSetMblt(long mblt)
+{
+    AssertIn(mblt, 0, kmbltLim);
 
-    LNextRow:
-        if (++yp >= rcClip.ypBottom)
-            break;
-        regsc.ScanNext(1);
+    if (mblt > MbltBest())
+        return fFalse;
 
-        // advance row pointers
-        prgbPixels += cbRow;
-        qbRowSrc = qbLastSrc + 1;
+    switch (mblt)
+    {
+    case kmbltScalar:
+        _pfncprun = _CopyRunScalar;
+        _pfnflrun = _FillRunScalar;
+        break;
+
+#if defined(IN_SSE2) || defined(IN_NEON)
+    case kmbltVector:
+#ifdef IN_SSE2
+        _pfncprun = _CopyRunSse2;
+        _pfnflrun = _FillRunSse2;
+#else  //! IN_SSE2
+        _pfncprun = _CopyRunNeon;
+        _pfnflrun = _FillRunNeon;
+#endif //! IN_SSE2
+        break;
+#endif // IN_SSE2 || IN_NEON
     }
+    return fTrue;
+}
 
-#else //! IN_80386
+/***************************************************************************
+    This routine is called to draw the masked bitmap onto prgbPixels.
+    cbRow and dyp are the respective width and height of prgbPixels.
+    xpRef and ypRef are the coordinates within the prgbPixels to place
+    the reference point of the MBMP.  The drawing will be clipped to both
+    prcClip and pregnClip, which may be nil.
+***************************************************************************/
+void MBMP::Draw(byte *prgbPixels, long cbRow, long dyp, long xpRef, long ypRef, RC *prcClip, PREGN pregnClip)
+{
+    AssertThis(0);
+    AssertIn(cbRow, 1, kcbMax);
+    AssertIn(dyp, 1, kcbMax);
+    AssertPvCb(prgbPixels, LwMul(cbRow, dyp));
+    AssertNilOrVarMem(prcClip);
+    AssertNilOrPo(pregnClip, 0);
 
     long yp, dxp, dypT, dxpT;
     byte *qbRowSrc, *qbSrc, *qbLastSrc;
@@ -296,6 +213,10 @@ LFill:
     MBMPH *qmbmph = _Qmbmph();
     RC rcMbmp = qmbmph->rc;
     bool fMask = qmbmph->fMask;
+    byte bFill = qmbmph->bFill;
+
+    if (pvNil == _pfncprun)
+        AssertDo(FSetMblt(MbltBest()), 0);
 
     // Intersect prcClip with the boundary of prgbPixels.
     if (pvNil != prcClip && !rcClip.FIntersect(prcClip))
@@ -388,15 +309,13 @@ LFill:
             AssertIn(0, pbOn - pbDst, pbOff - pbDst);
             dxp -= (dxpT = LwMin(dxp, pbOff - pbDst));
             if (fMask)
-            {
-                FillPb(pbDst, dxpT, qmbmph->bFill);
-                pbDst += dxpT;
-            }
+                (*_pfnflrun)(pbDst, dxpT, bFill);
             else
             {
-                while (dxpT--)
-                    *pbDst++ = *qbSrc++;
+                (*_pfncprun)(pbDst, qbSrc, dxpT);
+                qbSrc += dxpT;
             }
+            pbDst += dxpT;
         }
 
     LNextRow:
@@ -408,8 +327,6 @@ LFill:
         prgbPixels += cbRow;
         qbRowSrc = qbLastSrc + 1;
     }
-
-#endif //! IN_80386
 }
 
 /***************************************************************************
@@ -437,6 +354,9 @@ void MBMP::DrawMask(byte *prgbPixels, long cbRow, long dyp, long xpRef, long ypR
     RC rcMbmp = qmbmph->rc;
     bool fMask = qmbmph->fMask;
 
+    if (pvNil == _pfncprun)
+        AssertDo(FSetMblt(MbltBest()), 0);
+
     // Intersect prcClip with the boundary of prgbPixels.
     if (pvNil != prcClip && !rcClip.FIntersect(prcClip))
         return;
@@ -514,7 +434,7 @@ void MBMP::DrawMask(byte *prgbPixels, long cbRow, long dyp, long xpRef, long ypR
                     else
                         prgbPixels[ib] |= bMask;
                     if (ib + 1 < ibNext)
-                        FillPb(prgbPixels + ib + 1, ibNext - ib - 1, fTrans ? 0 : 0xFF);
+                        (*_pfnflrun)(prgbPixels + ib + 1, ibNext - ib - 1, fTrans ? 0 : 0xFF);
                     if (fTrans)
                         prgbPixels[ibNext] &= bMaskNext;
                     else
@@ -17,10 +17,14 @@ RTCLASS(REGN)
 RTCLASS(REGSC)
 
 long const kcdxpBlock = 100;
+long const kcxpScratchMax = 0x4000; // bigger scratch GLs aren't kept
 
 /***************************************************************************
     Region builder class.  For building the _pglxp of a region and getting
-    its bounding rectangle and _dxp value.
+    its bounding rectangle and _dxp value.  Rows are built in a scratch GL
+    that is kept from one region operation to the next, so the only
+    allocation is for the result, and none at all if the result is
+    rectangular or the destination region's GL can be reused.
 ***************************************************************************/
 typedef class REGBL *PREGBL;
 #define REGBL_PAR BASE
@@ -33,21 +37,42 @@ class REGBL : public REGBL_PAR
     RC _rc;
     PGL _pglxp;
     bool _fResize;
+    bool _fScratch; // _pglxp is _pglxpScratch
 
     long _idypPrev;
     long _idypCur;
     long _ixpCur;
 
+    static PGL _pglxpScratch; // kept between uses
+    static bool _fScratchBusy;
+    static bool _fUseScratch;
+
+    void _Release(void);
+
   public:
     REGBL(void)
     {
         _pglxp = pvNil;
+        _fScratch = fFalse;
     }
     ~REGBL(void)
     {
-        ReleasePpo(&_pglxp);
+        _Release();
     }
 
+    static void SetUseScratch(bool fUseScratch)
+    {
+        _fUseScratch = fUseScratch;
+        if (!fUseScratch && !_fScratchBusy)
+            ReleasePpo(&_pglxpScratch);
+    }
+#ifdef DEBUG
+    static void MarkScratch(void)
+    {
+        MarkMemObj(_pglxpScratch);
+    }
+#endif // DEBUG
+
     bool FInit(RC *prcRef, PGL pglxp = pvNil);
     bool FStartRow(long dyp, long cxpMax);
     void EndRow(void);
@@ -70,9 +95,32 @@ class REGBL : public REGBL_PAR
         AssertThis(0);
         return _ypCur >= _rcRef.ypBottom && _idypCur == ivNil;
     }
-    PGL PglxpFree(RC *prc, long *pdxp);
+    bool FFree(RC *prc, long *pdxp, PGL *ppglxp);
 };
 
+PGL REGBL::_pglxpScratch;
+bool REGBL::_fScratchBusy;
+bool REGBL::_fUseScratch = fTrue;
+
+/***************************************************************************
+    Let go of the GL being built, returning it to the scratch slot if
+    that's where it came from.
+***************************************************************************/
+void REGBL::_Release(void)
+{
+    if (_fScratch)
+    {
+        Assert(_pglxp == _pglxpScratch && _fScratchBusy, "scratch GL confusion");
+        if (_pglxpScratch->IvMac() > kcxpScratchMax)
+            ReleasePpo(&_pglxpScratch);
+        _fScratchBusy = fFalse;
+        _fScratch = fFalse;
+        _pglxp = pvNil;
+    }
+    else
+        ReleasePpo(&_pglxp);
+}
+
 /***************************************************************************
     Initialize a region builder.
 ***************************************************************************/
@@ -82,13 +130,24 @@ bool REGBL::FInit(RC *prcRef, PGL pglxp)
     AssertNilOrPo(pglxp, 0);
     Assert(!prcRef->FEmpty(), "empty reference rectangle");
 
-    ReleasePpo(&_pglxp);
+    _Release();
     if (pvNil != pglxp)
     {
         _pglxp = pglxp;
         _pglxp->AddRef();
         _fResize = fFalse;
     }
+    else if (_fUseScratch && !_fScratchBusy &&
+             (pvNil != _pglxpScratch || pvNil != (_pglxpScratch = GL::PglNew(size(long)))))
+    {
+        // the scratch GL isn't in use (regions aren't built recursively,
+        // but this copes if they ever are)
+        _pglxp = _pglxpScratch;
+        _pglxp->SetMinGrow(kcdxpBlock);
+        _fScratchBusy = fTrue;
+        _fScratch = fTrue;
+        _fResize = fTrue;
+    }
     else
     {
         if (pvNil == (_pglxp = GL::PglNew(size(long))))
@@ -125,7 +184,7 @@ bool REGBL::FStartRow(long dyp, long cxpMax)
         ivLim = LwRoundAway(ivLim, kcdxpBlock);
         if (ivLim > _pglxp->IvMac() && !_pglxp->FSetIvMac(ivLim))
         {
-            ReleasePpo(&_pglxp);
+            _Release();
             return fFalse;
         }
     }
@@ -178,14 +237,21 @@ void REGBL::EndRow(void)
 }
 
 /***************************************************************************
-    Clean up and return all the relevant information.
+    Clean up and return all the relevant information.  *ppglxp is the
+    destination region's current GL.  It's reused for the result when
+    nothing else refers to it, and released otherwise.  The only failure
+    is not being able to copy the rows out of the scratch GL, in which case
+    nothing is changed.
 ***************************************************************************/
-PGL REGBL::PglxpFree(RC *prc, long *pdxp)
+bool REGBL::FFree(RC *prc, long *pdxp, PGL *ppglxp)
 {
     AssertThis(0);
     AssertVarMem(prc);
     AssertVarMem(pdxp);
-    PGL pglxp;
+    AssertVarMem(ppglxp);
+    AssertNilOrPo(*ppglxp, 0);
+    PGL pglxp = pvNil;
+    long dxp = 0;
 
     // see if the last row is empty
     if (_ypCur > _rc.ypBottom)
@@ -194,12 +260,10 @@ PGL REGBL::PglxpFree(RC *prc, long *pdxp)
         _ixpCur = _idypPrev;
     }
 
-    *pdxp = 0;
     if (0 == _ixpCur)
     {
         // empty
         Assert(_rc.FEmpty(), 0);
-        ReleasePpo(&_pglxp);
         _rc.Zero();
     }
     else
@@ -208,21 +272,43 @@ PGL REGBL::PglxpFree(RC *prc, long *pdxp)
         if (_ixpCur <= 4)
         {
             // rectangular
-            ReleasePpo(&_pglxp);
         }
-        else
+        else if (!_fScratch)
         {
+            // built in its own GL
             AssertDo(_pglxp->FSetIvMac(_ixpCur), 0);
             AssertDo(_pglxp->FEnsureSpace(0, fgrpShrink), 0);
-            *pdxp = -_rc.xpLeft;
+            pglxp = _pglxp;
+            _pglxp = pvNil;
+            dxp = -_rc.xpLeft;
+        }
+        else
+        {
+            // copy the rows out of the scratch GL
+            if (pvNil != *ppglxp && (*ppglxp)->CactRef() == 1)
+            {
+                if (!(*ppglxp)->FSetIvMac(_ixpCur))
+                    return fFalse;
+                pglxp = *ppglxp;
+                *ppglxp = pvNil;
+            }
+            else if (pvNil == (pglxp = GL::PglNew(size(long), _ixpCur)) || !pglxp->FSetIvMac(_ixpCur))
+            {
+                ReleasePpo(&pglxp);
+                return fFalse;
+            }
+            CopyPb(_pglxp->QvGet(0), pglxp->QvGet(0), LwMul(_ixpCur, size(long)));
+            dxp = -_rc.xpLeft;
         }
         _rc.Offset(_rcRef.xpLeft, 0);
     }
 
+    ReleasePpo(ppglxp);
+    *ppglxp = pglxp;
     *prc = _rc;
-    pglxp = _pglxp;
-    _pglxp = pvNil;
-    return pglxp;
+    *pdxp = dxp;
+    _Release();
+    return fTrue;
 }
 
 /***************************************************************************
@@ -417,6 +503,83 @@ LFindLim:
     Assert((_pxpLimRow - _pxpMinRow) & 1, "logic error above");
 }
 
+/***************************************************************************
+    Return whether the union of two rectangles is a rectangle: one contains
+    the other, or they share both edges in one direction and touch or
+    overlap in the other.  This is the usual case for dirty rectangles
+    from adjacent lines or cells.
+***************************************************************************/
+priv bool _FUnionIsRc(RC *prc1, RC *prc2)
+{
+    AssertVarMem(prc1);
+    AssertVarMem(prc2);
+
+    if (prc1->FEmpty() || prc2->FEmpty() || prc1->FContains(prc2) || prc2->FContains(prc1))
+        return fTrue;
+    if (prc1->xpLeft == prc2->xpLeft && prc1->xpRight == prc2->xpRight)
+        return prc1->ypTop <= prc2->ypBottom && prc2->ypTop <= prc1->ypBottom;
+    if (prc1->ypTop == prc2->ypTop && prc1->ypBottom == prc2->ypBottom)
+        return prc1->xpLeft <= prc2->xpRight && prc2->xpLeft <= prc1->xpRight;
+    return fFalse;
+}
+
+/***************************************************************************
+    If *prcSrc minus *prcSub is a rectangle, put it in *prcDst and return
+    true.  It is when *prcSub misses *prcSrc, covers it, or cuts off a
+    whole strip along one side.
+***************************************************************************/
+priv bool _FDiffIsRc(RC *prcSrc, RC *prcSub, RC *prcDst)
+{
+    AssertVarMem(prcSrc);
+    AssertVarMem(prcSub);
+    AssertVarMem(prcDst);
+    RC rc;
+
+    if (!rc.FIntersect(prcSrc, prcSub))
+    {
+        *prcDst = *prcSrc;
+        return fTrue;
+    }
+    if (rc == *prcSrc)
+    {
+        prcDst->Zero();
+        return fTrue;
+    }
+
+    *prcDst = *prcSrc;
+    if (rc.xpLeft == prcSrc->xpLeft && rc.xpRight == prcSrc->xpRight)
+    {
+        if (rc.ypTop == prcSrc->ypTop)
+            prcDst->ypTop = rc.ypBottom;
+        else if (rc.ypBottom == prcSrc->ypBottom)
+            prcDst->ypBottom = rc.ypTop;
+        else
+            return fFalse;
+        return fTrue;
+    }
+    if (rc.ypTop == prcSrc->ypTop && rc.ypBottom == prcSrc->ypBottom)
+    {
+        if (rc.xpLeft == prcSrc->xpLeft)
+            prcDst->xpLeft = rc.xpRight;
+        else if (rc.xpRight == prcSrc->xpRight)
+            prcDst->xpRight = rc.xpLeft;
+        else
+            return fFalse;
+        return fTrue;
+    }
+    return fFalse;
+}
+
+/***************************************************************************
+    Turn the region builder's scratch GL on or off.  With it off, each
+    region operation allocates its own GL to build in, as it used to.
+    This is only for timing comparisons.
+***************************************************************************/
+void REGN::SetScratch(bool fScratch)
+{
+    REGBL::SetUseScratch(fScratch);
+}
+
 /***************************************************************************
     Static method to create a new region and set it to a rectangle.
 ***************************************************************************/
@@ -588,14 +751,13 @@ void REGN::Scale(long lwNumX, long lwDenX, long lwNumY, long lwDenY)
         regsc.ScanNext(dyp);
     }
 
-    ReleasePpo(&_pglxp);
     FreePhrgn(&_hrgn);
 
     // force the region scanner to let go of the pglxp before the
     // region builder tries to resize it.
     regsc.Free();
 
-    _pglxp = regbl.PglxpFree(&_rc, &_dxp);
+    AssertDo(regbl.FFree(&_rc, &_dxp, &_pglxp), 0);
 }
 
 /***************************************************************************
@@ -619,7 +781,8 @@ bool REGN::FUnion(PREGN pregn1, PREGN pregn2)
     }
 
     rc.Union(&pregn1->_rc, &pregn2->_rc);
-    if (pvNil == pregn1->_pglxp && rc == pregn1->_rc || pvNil == pregn2->_pglxp && rc == pregn2->_rc)
+    if (pvNil == pregn1->_pglxp && rc == pregn1->_rc || pvNil == pregn2->_pglxp && rc == pregn2->_rc ||
+        pvNil == pregn1->_pglxp && pvNil == pregn2->_pglxp && _FUnionIsRc(&pregn1->_rc, &pregn2->_rc))
     {
         // union is a rectangle
         SetRc(&rc);
@@ -663,6 +826,12 @@ bool REGN::FUnionRc(RC *prc, PREGN pregn)
     // we're done
     if (this == pregn && pvNil == _pglxp && rc == _rc)
         return fTrue;
+    if (pvNil == pregn->_pglxp && _FUnionIsRc(prc, &pregn->_rc))
+    {
+        // union is a rectangle
+        SetRc(&rc);
+        return fTrue;
+    }
 
     regsc1.InitRc(prc, &rc);
     regsc2.Init(pregn, &rc);
@@ -750,10 +919,12 @@ bool REGN::_FUnionCore(RC *prc, PREGSC pregsc1, PREGSC pregsc2)
         pregsc2->ScanNext(dyp);
     }
 
-    ReleasePpo(&_pglxp);
+    // let go of the sources so our GL can be reused if it was one
+    pregsc1->Free();
+    pregsc2->Free();
+    if (!regbl.FFree(&_rc, &_dxp, &_pglxp))
+        return fFalse;
     FreePhrgn(&_hrgn);
-
-    _pglxp = regbl.PglxpFree(&_rc, &_dxp);
     AssertThis(0);
     return fTrue;
 }
@@ -906,10 +1077,12 @@ bool REGN::_FIntersectCore(RC *prc, PREGSC pregsc1, PREGSC pregsc2)
         pregsc2->ScanNext(dyp);
     }
 
-    ReleasePpo(&_pglxp);
+    // let go of the sources so our GL can be reused if it was one
+    pregsc1->Free();
+    pregsc2->Free();
+    if (!regbl.FFree(&_rc, &_dxp, &_pglxp))
+        return fFalse;
     FreePhrgn(&_hrgn);
-
-    _pglxp = regbl.PglxpFree(&_rc, &_dxp);
     AssertThis(0);
     return fTrue;
 }
@@ -941,6 +1114,12 @@ bool REGN::FDiff(PREGN pregn1, PREGN pregn2)
         SetRc(&rc);
         return fTrue;
     }
+    if (pvNil == pregn1->_pglxp && pvNil == pregn2->_pglxp && _FDiffIsRc(&pregn2->_rc, &pregn1->_rc, &rc))
+    {
+        // both rectangles and the difference is a rectangle
+        SetRc(&rc);
+        return fTrue;
+    }
 
     rc = pregn2->_rc;
     regsc1.Init(pregn1, &rc);
@@ -975,6 +1154,12 @@ bool REGN::FDiffRc(RC *prc, PREGN pregn)
         SetRc(&rc);
         return fTrue;
     }
+    if (pvNil == pregn->_pglxp && _FDiffIsRc(&pregn->_rc, prc, &rc))
+    {
+        // both rectangles and the difference is a rectangle
+        SetRc(&rc);
+        return fTrue;
+    }
 
     rc = pregn->_rc;
     regsc1.InitRc(prc, &rc);
@@ -1011,6 +1196,12 @@ bool REGN::FDiffFromRc(RC *prc, PREGN pregn)
         SetRc(&rc);
         return fTrue;
     }
+    if (pvNil == pregn->_pglxp && _FDiffIsRc(prc, &pregn->_rc, &rc))
+    {
+        // both rectangles and the difference is a rectangle
+        SetRc(&rc);
+        return fTrue;
+    }
 
     regsc1.InitRc(prc, prc);
     regsc2.Init(pregn, prc);
@@ -1094,10 +1285,12 @@ bool REGN::_FDiffCore(RC *prc, PREGSC pregsc1, PREGSC pregsc2)
         pregsc2->ScanNext(dyp);
     }
 
-    ReleasePpo(&_pglxp);
+    // let go of the sources so our GL can be reused if it was one
+    pregsc1->Free();
+    pregsc2->Free();
+    if (!regbl.FFree(&_rc, &_dxp, &_pglxp))
+        return fFalse;
     FreePhrgn(&_hrgn);
-
-    _pglxp = regbl.PglxpFree(&_rc, &_dxp);
     AssertThis(0);
     return fTrue;
 }
@@ -1311,4 +1504,12 @@ void REGN::MarkMem(void)
     REGN_PAR::MarkMem();
     MarkMemObj(_pglxp);
 }
+
+/***************************************************************************
+    Mark the region builder's scratch memory.
+***************************************************************************/
+void REGN::MarkScratch(void)
+{
+    REGBL::MarkScratch();
+}
 #endif // DEBUG
@@ -72,6 +72,11 @@ class REGN : public REGN_PAR
 
     HRGN HrgnCreate(void);
     HRGN HrgnEnsure(void);
+
+    static void SetScratch(bool fScratch);
+#ifdef DEBUG
+    static void MarkScratch(void);
+#endif // DEBUG
 };
 
 /***************************************************************************
@@ -3307,6 +3307,18 @@ bool RTUN::FDo(PDOCB pdocb)
     return FUndo(pdocb);
 }
 
+/***************************************************************************
+    Return roughly how much memory the undo holds: the replaced text.
+***************************************************************************/
+long RTUN::CbMem(void)
+{
+    AssertThis(0);
+
+    if (pvNil == _ptxrd)
+        return size(RTUN);
+    return size(RTUN) + LwMul(_ptxrd->CpMac(), size(achar));
+}
+
 /***************************************************************************
     If possible, combine the given rtun with this one. Returns success.
 ***************************************************************************/
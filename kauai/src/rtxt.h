@@ -409,6 +409,7 @@ class RTUN : public RTUN_PAR
     virtual bool FDo(PDOCB pdocb);
 
     bool FCombine(PRTUN prtun);
+    long CbMem(void);
 };
 
 /***************************************************************************
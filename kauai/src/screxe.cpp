@@ -10,6 +10,14 @@
     Script interpreter.  See scrcom.cpp for an explanation of the format
     of compiled scripts.
 
+    When a script is read, it is also decoded into an SCIN for each
+    instruction (SCPT::_FDecode), so the interpreter doesn't unpack the
+    opcode, push count and variable name every time the instruction runs.
+    Jump targets are still script locations, and SCINs are indexed by
+    location, so jumps need no translation.  Each distinct local variable
+    gets a slot, and the interpreter remembers where each slot's variable
+    was last found in the local variable map, skipping the binary search.
+
 ***************************************************************************/
 #include "util.h"
 ASSERTNAME
@@ -23,6 +31,10 @@ RTCLASS(STRG)
 static STN _stn;
 #endif // DEBUG
 
+bool SCEB::_fProfile;
+PGL SCEB::_pglscpf;
+PGL SCEB::_pgloppf;
+
 /***************************************************************************
     Constructor for the script interpreter.
 ***************************************************************************/
@@ -33,8 +45,10 @@ SCEB::SCEB(PRCA prca, PSTRG pstrg)
 
     _pgllwStack = pvNil;
     _pglrtvm = pvNil;
+    _pglirtvmSlot = pvNil;
     _pscpt = pvNil;
     _fPaused = fFalse;
+    _fNoPredecode = fFalse;
 
     _prca = prca;
     if (pvNil != _prca)
@@ -79,6 +93,7 @@ void SCEB::Free(void)
 
     ReleasePpo(&_pgllwStack);
     ReleasePpo(&_pglrtvm);
+    ReleasePpo(&_pglirtvmSlot);
     ReleasePpo(&_pscpt);
     _fPaused = fFalse;
 }
@@ -101,6 +116,7 @@ void SCEB::AssertValid(ulong grfsceb)
     AssertNilOrPo(_pgllwStack, 0);
     AssertNilOrPo(_pscpt, 0);
     AssertNilOrPo(_pglrtvm, 0);
+    AssertNilOrPo(_pglirtvmSlot, 0);
     AssertNilOrPo(_pstrg, 0);
     AssertNilOrPo(_prca, 0);
 }
@@ -115,6 +131,7 @@ void SCEB::MarkMem(void)
     MarkMemObj(_pgllwStack);
     MarkMemObj(_pscpt);
     MarkMemObj(_pglrtvm);
+    MarkMemObj(_pglirtvmSlot);
     MarkMemObj(_prca);
 }
 #endif // DEBUG
@@ -169,6 +186,17 @@ bool SCEB::FAttachScript(PSCPT pscpt, long *prglw, long clw)
         goto LFail;
     }
 
+    // decode the script if reading it didn't, and make the local variable
+    // slots.  Neither is required, so failure isn't an error.
+    if (_pscpt->_FDecode() && _pscpt->_cslot > 0 &&
+        pvNil != (_pglirtvmSlot = GL::PglNew(size(long), _pscpt->_cslot)))
+    {
+        if (_pglirtvmSlot->FSetIvMac(_pscpt->_cslot))
+            FillPb(_pglirtvmSlot->QvGet(0), LwMul(_pscpt->_cslot, size(long)), 0xFF); // ivNil
+        else
+            ReleasePpo(&_pglirtvmSlot);
+    }
+
     // add the parameters and literal strings
     if (clw > 0)
         _AddParameters(prglw, clw);
@@ -182,6 +210,14 @@ bool SCEB::FAttachScript(PSCPT pscpt, long *prglw, long clw)
         return fFalse;
     }
 
+    if (_fProfile)
+    {
+        SCPF *qscpf;
+
+        if (pvNil != (qscpf = _QscpfEnsure(_pscpt->Ctg(), _pscpt->Cno())))
+            qscpf->crun++;
+    }
+
     // set the pc and claim we're paused
     _ilwCur = 1;
     _fPaused = fTrue;
@@ -201,6 +237,13 @@ bool SCEB::FResume(long *plwReturn, bool *pfPaused)
     long ilw, clwPush;
     long lw;
     long op;
+    SCIN scin;
+    SCIN *qscin;
+    SCPF *qscpf;
+    OPPF *qoppf;
+    bool fProfile = _fProfile;
+    ulong tusResume = 0, tusOp = 0;
+    long cop = 0, cvAlloc = 0;
 
     TrashVar(plwReturn);
     TrashVar(pfPaused);
@@ -210,9 +253,36 @@ bool SCEB::FResume(long *plwReturn, bool *pfPaused)
         goto LFail;
     }
 
+    if (fProfile)
+    {
+        tusResume = TusCurrentSystem();
+        cvAlloc = _CvAllocTot();
+    }
+
     AssertIn(_ilwCur, 1, _ilwMac + 1);
     for (_fPaused = fFalse; _ilwCur < _ilwMac && !_fError && !_fPaused;)
     {
+        if (fProfile)
+            tusOp = TusCurrentSystem();
+
+        if (pvNil != _pscpt->_pglscin && !_fNoPredecode &&
+            0 < (qscin = (SCIN *)_pscpt->_pglscin->QvGet(_ilwCur))->ilwPush)
+        {
+            // a decoded instruction
+            scin = *qscin;
+            ilw = _ilwCur = scin.ilwPush;
+            clwPush = scin.clwPush;
+            if (opNil != (op = scin.opVar))
+            {
+                rtvn = scin.rtvn;
+                if (ivNil != scin.islot ? !_FExecSlotOp(op, scin.islot, &rtvn) : !_FExecVarOp(op, &rtvn))
+                    goto LFail;
+            }
+            else if (opNil != (op = scin.op) && !_FExecOp(op))
+                goto LFail;
+            goto LPush;
+        }
+
         lw = *(long *)_pscpt->_pgllw->QvGet(_ilwCur++);
         clwPush = B2Lw(lw);
         if (!FIn(clwPush, 0, _ilwMac - _ilwCur + 1))
@@ -244,6 +314,17 @@ bool SCEB::FResume(long *plwReturn, bool *pfPaused)
                 goto LFail;
         }
 
+    LPush:
+        if (fProfile)
+        {
+            cop++;
+            if (pvNil != (qoppf = _QoppfEnsure(op)))
+            {
+                qoppf->cop++;
+                qoppf->dtus += TusCurrentSystem() - tusOp;
+            }
+        }
+
         // push the stack stuff (if we didn't do a jump)
         if (clwPush > 0 && ilw == _ilwCur)
         {
@@ -259,6 +340,13 @@ bool SCEB::FResume(long *plwReturn, bool *pfPaused)
         }
     }
 
+    if (fProfile && pvNil != _pscpt && pvNil != (qscpf = _QscpfEnsure(_pscpt->Ctg(), _pscpt->Cno())))
+    {
+        qscpf->cop += cop;
+        qscpf->dtus += TusCurrentSystem() - tusResume;
+        qscpf->cvAlloc += _CvAllocTot() - cvAlloc;
+    }
+
     if (_ilwCur >= _ilwMac || _fError)
         _fPaused = fFalse;
     if (!_fPaused)
@@ -272,6 +360,244 @@ bool SCEB::FResume(long *plwReturn, bool *pfPaused)
     return !_fError;
 }
 
+/***************************************************************************
+    Find or add the profile counters for the given script.  Returns pvNil
+    if there's no memory for them.  The pointer is only good until the
+    next call.
+***************************************************************************/
+SCPF *SCEB::_QscpfEnsure(CTG ctg, CNO cno)
+{
+    long iscpf, iscpfMin, iscpfLim;
+    SCPF *qrgscpf;
+    SCPF scpf;
+
+    if (pvNil == _pglscpf && pvNil == (_pglscpf = GL::PglNew(size(SCPF))))
+        return pvNil;
+
+    qrgscpf = (SCPF *)_pglscpf->QvGet(0);
+    for (iscpfMin = 0, iscpfLim = _pglscpf->IvMac(); iscpfMin < iscpfLim;)
+    {
+        iscpf = (iscpfMin + iscpfLim) / 2;
+        if (qrgscpf[iscpf].ctg < ctg || qrgscpf[iscpf].ctg == ctg && qrgscpf[iscpf].cno < cno)
+            iscpfMin = iscpf + 1;
+        else
+            iscpfLim = iscpf;
+    }
+
+    if (iscpfMin >= _pglscpf->IvMac() || qrgscpf[iscpfMin].ctg != ctg || qrgscpf[iscpfMin].cno != cno)
+    {
+        ClearPb(&scpf, size(SCPF));
+        scpf.ctg = ctg;
+        scpf.cno = cno;
+        if (!_pglscpf->FInsert(iscpfMin, &scpf))
+            return pvNil;
+    }
+    return (SCPF *)_pglscpf->QvGet(iscpfMin);
+}
+
+/***************************************************************************
+    Find or add the profile counters for the given opcode.  Returns pvNil
+    if there's no memory for them.  The pointer is only good until the
+    next call.
+***************************************************************************/
+OPPF *SCEB::_QoppfEnsure(long op)
+{
+    long ioppf, ioppfMin, ioppfLim;
+    OPPF *qrgoppf;
+    OPPF oppf;
+
+    if (pvNil == _pgloppf && pvNil == (_pgloppf = GL::PglNew(size(OPPF))))
+        return pvNil;
+
+    qrgoppf = (OPPF *)_pgloppf->QvGet(0);
+    for (ioppfMin = 0, ioppfLim = _pgloppf->IvMac(); ioppfMin < ioppfLim;)
+    {
+        ioppf = (ioppfMin + ioppfLim) / 2;
+        if (qrgoppf[ioppf].op < op)
+            ioppfMin = ioppf + 1;
+        else
+            ioppfLim = ioppf;
+    }
+
+    if (ioppfMin >= _pgloppf->IvMac() || qrgoppf[ioppfMin].op != op)
+    {
+        ClearPb(&oppf, size(OPPF));
+        oppf.op = op;
+        if (!_pgloppf->FInsert(ioppfMin, &oppf))
+            return pvNil;
+    }
+    return (OPPF *)_pgloppf->QvGet(ioppfMin);
+}
+
+/***************************************************************************
+    Return the number of allocations made so far.  Only the debug
+    allocator counts them, so this is always zero in ship builds.
+***************************************************************************/
+long SCEB::_CvAllocTot(void)
+{
+#ifdef DEBUG
+    return vdmglob.dmaglBase.cvTot + vdmglob.dmaglHq.cvTot + vdmglob.dmaglPv.cvTot;
+#else  //! DEBUG
+    return 0;
+#endif //! DEBUG
+}
+
+/***************************************************************************
+    Throw away the profile counters, leaving profiling on or off.
+***************************************************************************/
+void SCEB::ResetProfile(void)
+{
+    if (pvNil != _pglscpf)
+        _pglscpf->FSetIvMac(0);
+    if (pvNil != _pgloppf)
+        _pgloppf->FSetIvMac(0);
+}
+
+/***************************************************************************
+    Turn off profiling and free the profile counters.
+***************************************************************************/
+void SCEB::FreeProfile(void)
+{
+    _fProfile = fFalse;
+    ReleasePpo(&_pglscpf);
+    ReleasePpo(&_pgloppf);
+}
+
+/***************************************************************************
+    Get the profile counters for the iscpf'th script run since the
+    counters were reset.  These are sorted by ctg, then cno.
+***************************************************************************/
+void SCEB::GetScpf(long iscpf, SCPF *pscpf)
+{
+    AssertIn(iscpf, 0, Cscpf());
+    AssertVarMem(pscpf);
+
+    _pglscpf->Get(iscpf, pscpf);
+}
+
+/***************************************************************************
+    Get the profile counters for the ioppf'th opcode executed since the
+    counters were reset.  These are sorted by op.
+***************************************************************************/
+void SCEB::GetOppf(long ioppf, OPPF *poppf)
+{
+    AssertIn(ioppf, 0, Coppf());
+    AssertVarMem(poppf);
+
+    _pgloppf->Get(ioppf, poppf);
+}
+
+/***************************************************************************
+    Write the profile counters to the given text file, scripts then
+    opcodes, each sorted by time with the slowest first.
+***************************************************************************/
+bool SCEB::FWriteProfile(PFNI pfni)
+{
+    AssertPo(pfni, ffniFile);
+    PFIL pfil;
+    PGL pglisrt = pvNil;
+    long iv, ivMac, isrt, ivT;
+    ulong dtus;
+    SCPF scpf;
+    OPPF oppf;
+    STN stn;
+    FP fp = 0;
+    bool fRet = fFalse;
+
+    if (pvNil == (pfil = FIL::PfilCreate(pfni)))
+        return fFalse;
+    if (pvNil == (pglisrt = GL::PglNew(size(long))))
+        goto LFail;
+
+    stn = PszLit("Scripts (ctg, cno, runs, instructions, us, allocations):");
+    if (!_FWriteProfileStn(pfil, &fp, &stn))
+        goto LFail;
+    for (iv = 0, ivMac = Cscpf(); iv < ivMac; iv++)
+    {
+        // insertion sort the indices by time, slowest first
+        GetScpf(iv, &scpf);
+        for (isrt = pglisrt->IvMac(); isrt > 0; isrt--)
+        {
+            pglisrt->Get(isrt - 1, &ivT);
+            if (((SCPF *)_pglscpf->QvGet(ivT))->dtus >= scpf.dtus)
+                break;
+        }
+        if (!pglisrt->FInsert(isrt, &iv))
+            goto LFail;
+    }
+    for (isrt = 0; isrt < pglisrt->IvMac(); isrt++)
+    {
+        pglisrt->Get(isrt, &iv);
+        GetScpf(iv, &scpf);
+        stn.FFormatSz(PszLit("'%f' 0x%08x %8d %10d %10u %8d"), scpf.ctg, scpf.cno, scpf.crun, scpf.cop, scpf.dtus,
+                      scpf.cvAlloc);
+        if (!_FWriteProfileStn(pfil, &fp, &stn))
+            goto LFail;
+    }
+
+    pglisrt->FSetIvMac(0);
+    stn = PszLit("");
+    if (!_FWriteProfileStn(pfil, &fp, &stn))
+        goto LFail;
+    stn = PszLit("Opcodes (op, count, us, us per 1000):");
+    if (!_FWriteProfileStn(pfil, &fp, &stn))
+        goto LFail;
+    for (iv = 0, ivMac = Coppf(); iv < ivMac; iv++)
+    {
+        GetOppf(iv, &oppf);
+        for (isrt = pglisrt->IvMac(); isrt > 0; isrt--)
+        {
+            pglisrt->Get(isrt - 1, &ivT);
+            if (((OPPF *)_pgloppf->QvGet(ivT))->dtus >= oppf.dtus)
+                break;
+        }
+        if (!pglisrt->FInsert(isrt, &iv))
+            goto LFail;
+    }
+    for (isrt = 0; isrt < pglisrt->IvMac(); isrt++)
+    {
+        pglisrt->Get(isrt, &iv);
+        GetOppf(iv, &oppf);
+        dtus = LwMulDiv(oppf.dtus, 1000, LwMax(1, oppf.cop));
+        stn.FFormatSz(PszLit("0x%04x %10d %10u %8u"), oppf.op, oppf.cop, oppf.dtus, dtus);
+        if (!_FWriteProfileStn(pfil, &fp, &stn))
+            goto LFail;
+    }
+    fRet = fTrue;
+
+LFail:
+    ReleasePpo(&pglisrt);
+    if (!fRet)
+        pfil->SetTemp();
+    ReleasePpo(&pfil);
+    return fRet;
+}
+
+/***************************************************************************
+    Write a line of the profile report.
+***************************************************************************/
+bool SCEB::_FWriteProfileStn(PFIL pfil, FP *pfp, PSTN pstn)
+{
+    AssertPo(pfil, 0);
+    AssertVarMem(pfp);
+    AssertPo(pstn, 0);
+    achar rgchEol[] = {ChLit('\xD'), ChLit('\xA')};
+
+    return pfil->FWriteRgbSeq(pstn->Prgch(), LwMul(pstn->Cch(), size(achar)), pfp) &&
+           pfil->FWriteRgbSeq(rgchEol, MacWin(size(achar), 2 * size(achar)), pfp);
+}
+
+#ifdef DEBUG
+/***************************************************************************
+    Mark the profile counters.
+***************************************************************************/
+void SCEB::MarkProfile(void)
+{
+    MarkMemObj(_pglscpf);
+    MarkMemObj(_pgloppf);
+}
+#endif // DEBUG
+
 /***************************************************************************
     Put the parameters in the local variable list.
 ***************************************************************************/
@@ -408,6 +734,50 @@ bool SCEB::_FExecVarOp(long op, RTVN *prtvn)
     return !_fError;
 }
 
+/***************************************************************************
+    Execute a local variable instruction that has a slot.  If the slot
+    still points at the variable in _pglrtvm, this skips the search.
+***************************************************************************/
+bool SCEB::_FExecSlotOp(long op, long islot, RTVN *prtvn)
+{
+    AssertThis(0);
+    AssertIn(islot, 0, _pscpt->_cslot);
+    AssertVarMem(prtvn);
+    long irtvm, lw;
+    RTVM *qrtvm;
+
+    if (pvNil == _pglirtvmSlot)
+        return _FExecVarOp(op, prtvn);
+
+    irtvm = *(long *)_pglirtvmSlot->QvGet(islot);
+    if (pvNil == _pglrtvm || !FIn(irtvm, 0, _pglrtvm->IvMac()) ||
+        (qrtvm = (RTVM *)_pglrtvm->QvGet(irtvm))->rtvn.lu1 != prtvn->lu1 || qrtvm->rtvn.lu2 != prtvn->lu2)
+    {
+        // do it the slow way and remember where the variable is
+        if (!_FExecVarOp(op, prtvn))
+            return fFalse;
+        if (pvNil != _pglrtvm && FFindRtvm(_pglrtvm, prtvn, pvNil, &irtvm))
+            _pglirtvmSlot->Put(islot, &irtvm);
+        return fTrue;
+    }
+
+    switch (op)
+    {
+    case kopPushLocVar:
+        _Push(qrtvm->lwValue);
+        break;
+    case kopPopLocVar:
+        lw = _LwPop();
+        if (!_fError)
+            ((RTVM *)_pglrtvm->QvGet(irtvm))->lwValue = lw;
+        break;
+    default:
+        _Error(fTrue);
+        break;
+    }
+    return !_fError;
+}
+
 /***************************************************************************
     Execute an instruction.
 ***************************************************************************/
@@ -1337,13 +1707,26 @@ bool SCPT::FReadScript(PCRF pcrf, CTG ctg, CNO cno, PBLCK pblck, PBACO *ppbaco,
     AssertPo(pcrf, 0);
     AssertPo(pblck, fblckReadable);
     AssertNilOrVarMem(ppbaco);
+    PSCPT pscpt;
 
+    // the decoded instruction table is kept alongside the code, one SCIN
+    // per code long, so it counts toward the cache size too
     *pcb = pblck->Cb(fTrue);
+    *pcb += LwMul(*pcb / size(long), size(SCIN));
     if (pvNil == ppbaco)
         return fTrue;
 
-    *ppbaco = PscptRead(pcrf->Pcfl(), ctg, cno);
-    return pvNil != *ppbaco;
+    if (pvNil == (pscpt = PscptRead(pcrf->Pcfl(), ctg, cno)))
+    {
+        *ppbaco = pvNil;
+        return fFalse;
+    }
+
+    *pcb = pblck->Cb(fTrue);
+    if (pvNil != pscpt->_pglscin)
+        *pcb += LwMul(pscpt->_pglscin->IvMac(), size(SCIN));
+    *ppbaco = pscpt;
+    return fTrue;
 }
 
 /***************************************************************************
@@ -1385,9 +1768,90 @@ PSCPT SCPT::PscptRead(PCFL pcfl, CTG ctg, CNO cno)
         SwapBytesRglw(pgllw->QvGet(0), pgllw->IvMac());
     pscpt->_pgllw = pgllw;
     pscpt->_pgstLiterals = pgst;
+
+    // if this fails, the interpreter tries again when the script is run
+    pscpt->_FDecode();
     return pscpt;
 }
 
+/***************************************************************************
+    Decode the script into _pglscin, giving each local variable a slot.
+    Decoding stops at a bad instruction; the interpreter decodes from
+    there on the fly and reports the error when it gets there.
+***************************************************************************/
+bool SCPT::_FDecode(void)
+{
+    AssertThis(0);
+    long ilw, ilwOp, ilwMac;
+    long lw, clwPush, islot;
+    SCIN scin;
+    RTVN *qrgrtvn;
+    PGL pglrtvn = pvNil;
+
+    if (pvNil != _pglscin)
+        return fTrue;
+
+    ilwMac = _pgllw->IvMac();
+    if (pvNil == (_pglscin = GL::PglNew(size(SCIN), ilwMac)) || !_pglscin->FSetIvMac(ilwMac) ||
+        pvNil == (pglrtvn = GL::PglNew(size(RTVN))))
+    {
+        goto LFail;
+    }
+    if (ilwMac > 0)
+        ClearPb(_pglscin->QvGet(0), LwMul(ilwMac, size(SCIN)));
+
+    // the first long is the version number
+    for (ilw = 1; ilw < ilwMac;)
+    {
+        lw = *(long *)_pgllw->QvGet(ilwOp = ilw++);
+        clwPush = B2Lw(lw);
+        if (!FIn(clwPush, 0, ilwMac - ilw + 1))
+            break;
+
+        ClearPb(&scin, size(scin));
+        scin.islot = ivNil;
+        if (opNil != (scin.opVar = B3Lw(lw)))
+        {
+            if (clwPush-- == 0)
+                break;
+            scin.rtvn.lu1 = (ulong)lw & 0x0000FFFF;
+            scin.rtvn.lu2 = *(ulong *)_pgllw->QvGet(ilw++);
+
+            if (kopPushLocVar == scin.opVar || kopPopLocVar == scin.opVar)
+            {
+                // find or make the variable's slot.  Scripts only have
+                // a handful of locals, so a linear search is fine.
+                qrgrtvn = (RTVN *)pglrtvn->QvGet(0);
+                for (islot = pglrtvn->IvMac(); islot-- > 0;)
+                {
+                    if (qrgrtvn[islot].lu1 == scin.rtvn.lu1 && qrgrtvn[islot].lu2 == scin.rtvn.lu2)
+                        break;
+                }
+                if (islot < 0 && !pglrtvn->FAdd(&scin.rtvn, &islot))
+                    goto LFail;
+                scin.islot = islot;
+            }
+        }
+        else
+            scin.op = SuLow(lw);
+
+        scin.ilwPush = ilw;
+        scin.clwPush = clwPush;
+        _pglscin->Put(ilwOp, &scin);
+        ilw += clwPush;
+    }
+
+    _cslot = pglrtvn->IvMac();
+    ReleasePpo(&pglrtvn);
+    return fTrue;
+
+LFail:
+    ReleasePpo(&_pglscin);
+    ReleasePpo(&pglrtvn);
+    _cslot = 0;
+    return fFalse;
+}
+
 /***************************************************************************
     Destructor for a script.
 ***************************************************************************/
@@ -1396,6 +1860,7 @@ SCPT::~SCPT(void)
     AssertBaseThis(0);
     ReleasePpo(&_pgllw);
     ReleasePpo(&_pgstLiterals);
+    ReleasePpo(&_pglscin);
 }
 
 /***************************************************************************
@@ -1470,6 +1935,8 @@ void SCPT::AssertValid(ulong grf)
     SCPT_PAR::AssertValid(0);
     AssertPo(_pgllw, 0);
     AssertNilOrPo(_pgstLiterals, 0);
+    AssertNilOrPo(_pglscin, 0);
+    Assert(pvNil == _pglscin || _pglscin->IvMac() == _pgllw->IvMac(), "decoded script doesn't match");
 }
 
 /***************************************************************************
@@ -1481,6 +1948,7 @@ void SCPT::MarkMem(void)
     SCPT_PAR::MarkMem();
     MarkMemObj(_pgllw);
     MarkMemObj(_pgstLiterals);
+    MarkMemObj(_pglscin);
 }
 #endif // DEBUG
 
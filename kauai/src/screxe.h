@@ -29,6 +29,22 @@ struct RTVM
 bool FFindRtvm(PGL pglrtvm, RTVN *prtvn, long *plwValue, long *pirtvm);
 bool FAssignRtvm(PGL *ppglrtvm, RTVN *prtvn, long lw);
 
+/****************************************
+    Pre-decoded script instruction.  A
+    SCPT keeps one of these for each long
+    of code.  Only the ones at instruction
+    starts have a non-zero ilwPush.
+****************************************/
+struct SCIN
+{
+    long opVar;   // variable op, or opNil
+    long op;      // normal op, or opNil
+    RTVN rtvn;    // the variable for a variable op
+    long islot;   // local variable slot, or ivNil
+    long ilwPush; // the longs to push follow the instruction here
+    long clwPush; // how many longs to push
+};
+
 /***************************************************************************
     A script.  This is here rather than in scrcom.* because scrcom is
     rarely included in shipping products, but screxe.* is.
@@ -45,11 +61,15 @@ class SCPT : public SCPT_PAR
   protected:
     PGL _pgllw;
     PGST _pgstLiterals;
+    PGL _pglscin; // the decoded instructions
+    long _cslot;  // number of local variable slots used by _pglscin
 
     SCPT(void)
     {
     }
 
+    bool _FDecode(void);
+
     friend class SCEB;
     friend class SCCB;
 
@@ -92,6 +112,30 @@ class STRG : public STRG_PAR
     void Delete(long stid);
 };
 
+/****************************************
+    Script profile counters.  Times are in
+    microseconds.  Allocations are only
+    counted in debug builds.
+****************************************/
+// counters for a single script
+struct SCPF
+{
+    CTG ctg; // the script's chunk (ctgNil if it wasn't read from a CRF)
+    CNO cno;
+    long crun;    // times it was started
+    long cop;     // instructions executed
+    ulong dtus;   // time spent running it, including any scripts it runs
+    long cvAlloc; // allocations made while running it
+};
+
+// counters for a single opcode
+struct OPPF
+{
+    long op;    // opNil for instructions that only push values
+    long cop;   // times executed
+    ulong dtus; // time spent executing it
+};
+
 /***************************************************************************
     The script interpreter.
 ***************************************************************************/
@@ -116,11 +160,18 @@ class SCEB : public SCEB_PAR
     PGL _pgllwStack;   // the execution stack
     PGL _pglrtvm;      // the local variables
     PSCPT _pscpt;      // the script
-    long _ilwMac;      // the length of the script
-    long _ilwCur;      // the current location in the script
-    bool _fError : 1;  // an error has occured
-    bool _fPaused : 1; // if we're paused
-    long _lwReturn;    // the return value from the script
+    long _ilwMac;           // the length of the script
+    long _ilwCur;           // the current location in the script
+    bool _fError : 1;       // an error has occured
+    bool _fPaused : 1;      // if we're paused
+    bool _fNoPredecode : 1; // don't use the script's decoded instructions
+    long _lwReturn;         // the return value from the script
+    PGL _pglirtvmSlot;      // where each local variable slot was last found in _pglrtvm
+
+    // profiling, shared by all interpreters
+    static bool _fProfile;
+    static PGL _pglscpf; // per script counters, sorted by ctg then cno
+    static PGL _pgloppf; // per opcode counters, sorted by op
 
     void _Push(long lw)
     {
@@ -149,6 +200,7 @@ class SCEB : public SCEB_PAR
     virtual void _AddStrings(PGST pgst);
     virtual bool _FExecVarOp(long op, RTVN *prtvn);
     virtual bool _FExecOp(long op);
+    bool _FExecSlotOp(long op, long islot, RTVN *prtvn);
     virtual void _PushVar(PGL pglrtvm, RTVN *prtvn);
     virtual void _AssignVar(PGL *ppglrtvm, RTVN *prtvn, long lw);
     virtual PGL _PglrtvmThis(void);
@@ -161,6 +213,11 @@ class SCEB : public SCEB_PAR
     virtual short _SwCur(void);
     virtual short _SwMin(void);
 
+    static SCPF *_QscpfEnsure(CTG ctg, CNO cno);
+    static OPPF *_QoppfEnsure(long op);
+    static long _CvAllocTot(void);
+    static bool _FWriteProfileStn(PFIL pfil, FP *pfp, PSTN pstn);
+
 #ifdef DEBUG
     void _WarnSz(PSZ psz, ...);
 #endif // DEBUG
@@ -174,6 +231,38 @@ class SCEB : public SCEB_PAR
     virtual bool FResume(long *plwReturn = pvNil, bool *pfPaused = pvNil);
     virtual bool FAttachScript(PSCPT pscpt, long *prglw = pvNil, long clw = 0);
     virtual void Free(void);
+
+    // for timing the decoded instructions against decoding on the fly
+    void SetPredecode(bool fPredecode)
+    {
+        _fNoPredecode = !fPredecode;
+    }
+
+    // script profiling
+    static void SetProfile(bool fProfile)
+    {
+        _fProfile = fProfile;
+    }
+    static bool FProfile(void)
+    {
+        return _fProfile;
+    }
+    static void ResetProfile(void);
+    static void FreeProfile(void);
+    static long Cscpf(void)
+    {
+        return pvNil == _pglscpf ? 0 : _pglscpf->IvMac();
+    }
+    static void GetScpf(long iscpf, SCPF *pscpf);
+    static long Coppf(void)
+    {
+        return pvNil == _pgloppf ? 0 : _pgloppf->IvMac();
+    }
+    static void GetOppf(long ioppf, OPPF *poppf);
+    static bool FWriteProfile(PFNI pfni);
+#ifdef DEBUG
+    static void MarkProfile(void);
+#endif // DEBUG
 };
 
 #endif //! SCREXE_H
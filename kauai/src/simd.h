@@ -0,0 +1,31 @@
+/***************************************************************************
+    Project: Kauai
+
+    Vector instruction support.  Include this (after util.h) to use SSE2
+    or NEON intrinsics.  Exactly one of IN_SSE2 and IN_NEON is defined if
+    the target might have 16 byte vector moves.  Code using SSE2 must
+    check FVectorMoves() before running, and mark its functions SSE2_FUNC
+    so compilers that don't assume SSE2 will still generate it.
+
+***************************************************************************/
+#ifndef SIMD_H
+#define SIMD_H
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define IN_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#define IN_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(IN_SSE2) && defined(__GNUC__) && !defined(__SSE2__)
+#define SSE2_FUNC __attribute__((target("sse2")))
+#else
+#define SSE2_FUNC
+#endif
+
+// whether the processor can do 16 byte vector moves (SSE2 or NEON)
+bool FVectorMoves(void);
+
+#endif //! SIMD_H
@@ -27,6 +27,8 @@ void MarkUtilMem(void)
     MarkMemObj(&vkcdcUtil);
     MarkMemObj(&vcodmUtil);
     MarkMemObj(vpcodmUtil);
+    MarkMemObj(&vcrpqUtil);
+    SCEB::MarkProfile();
 
     for (pcfl = CFL::PcflFirst(); pcfl != pvNil; pcfl = pcfl->PcflNext())
         MarkMemObj(pcfl);
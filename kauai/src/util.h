@@ -22,6 +22,18 @@
 #define LITTLE_ENDIAN
 #endif // IN_80386
 
+#ifdef LINUX
+// glibc defines LITTLE_ENDIAN whatever the byte order is
+#include <endian.h>
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+#ifndef LITTLE_ENDIAN
+#define LITTLE_ENDIAN
+#endif //! LITTLE_ENDIAN
+#else  // __BYTE_ORDER != __LITTLE_ENDIAN
+#undef LITTLE_ENDIAN
+#endif // __BYTE_ORDER != __LITTLE_ENDIAN
+#endif // LINUX
+
 #ifdef LITTLE_ENDIAN
 #define BigLittle(a, b) b
 #define Big(a)
@@ -58,7 +70,11 @@ typedef HPALETTE HPAL;
 typedef HCURSOR HCRS;
 #define hBadWin INVALID_HANDLE_VALUE // some windows APIs return this
 
-#endif // WIN
+#elif defined(LINUX)
+
+#include "linux.h"
+
+#endif // LINUX
 
 #define size(foo) ((long)sizeof(foo))
 #define offset(FOO, field) ((int)&((FOO *)0)->field)
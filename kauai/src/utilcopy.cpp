@@ -12,8 +12,27 @@
 
 ***************************************************************************/
 #include "util.h"
+#include "simd.h"
 ASSERTNAME
 
+/***************************************************************************
+    Return whether the processor can do 16 byte vector moves.
+***************************************************************************/
+bool FVectorMoves(void)
+{
+#if defined(IN_SSE2) && (defined(_M_X64) || defined(__x86_64__))
+    return fTrue;
+#elif defined(IN_SSE2) && defined(WIN)
+    return IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE);
+#elif defined(IN_SSE2) && defined(__GNUC__)
+    return __builtin_cpu_supports("sse2");
+#elif defined(IN_NEON)
+    return fTrue;
+#else
+    return fFalse;
+#endif
+}
+
 /***************************************************************************
     Fill a block with a specific byte value.
 ***************************************************************************/
@@ -47,6 +47,10 @@ KCDC vkcdcUtil;
 CODM vcodmUtil(&vkcdcUtil, kcfmtKauai2);
 PCODM vpcodmUtil = &vcodmUtil;
 
+// Chunky resource prefetch queue. The worker thread isn't started until
+// something is queued.
+CRPQ vcrpqUtil;
+
 // Standard scalable application clok.
 USAC _usac;
 PUSAC vpusac = &_usac;
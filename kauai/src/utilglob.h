@@ -60,6 +60,7 @@ inline ulong TsCurrentSystem(void)
     // n.b. WIN: timeGetTime is more accurate than GetTickCount
     return MacWin(TickCount(), timeGetTime());
 }
+ulong TusCurrentSystem(void);
 inline ulong DtsCaret(void)
 {
     return MacWin(GetCaretTime(), GetCaretBlinkTime());
@@ -89,6 +90,11 @@ extern KCDC vkcdcUtil;
 extern CODM vcodmUtil;
 extern PCODM vpcodmUtil;
 
+/***************************************************************************
+    Global chunky resource prefetch queue, shared by all CRFs.
+***************************************************************************/
+extern CRPQ vcrpqUtil;
+
 /***************************************************************************
     Debug memory globals
 ***************************************************************************/
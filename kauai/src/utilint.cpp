@@ -11,10 +11,10 @@
     WARNING: Must be in a fixed (pre-loaded) seg on Mac.
 
 ***************************************************************************/
-#include "util.h"
-
+// before util.h, whose size() macro trips up some C++ headers
 #include <cmath>
 
+#include "util.h"
 ASSERTNAME
 
 /***************************************************************************
@@ -1129,6 +1129,34 @@ void USAC::Scale(ulong luScale)
     _luScale = luScale;
 }
 
+/***************************************************************************
+    Return the system time in microseconds.  This is for timing short
+    operations - it wraps about every 71 minutes, so only differences
+    between nearby values mean anything.
+***************************************************************************/
+ulong TusCurrentSystem(void)
+{
+#ifdef MAC
+    UnsignedWide uw;
+
+    Microseconds(&uw);
+    return uw.lo;
+#elif defined(WIN)
+    static LARGE_INTEGER _liFreq;
+    LARGE_INTEGER li;
+
+    if (_liFreq.QuadPart == 0 && !QueryPerformanceFrequency(&_liFreq))
+        return timeGetTime() * 1000;
+    QueryPerformanceCounter(&li);
+    return (ulong)(li.QuadPart / _liFreq.QuadPart * 1000000 + li.QuadPart % _liFreq.QuadPart * 1000000 / _liFreq.QuadPart);
+#elif defined(LINUX)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ulong)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
 /***************************************************************************
     Set the DVER structure.
 ***************************************************************************/
@@ -344,7 +344,21 @@ typedef Point PTS;
 #elif defined(WIN)
 typedef RECT RCS;
 typedef POINT PTS;
-#endif // WIN
+#elif defined(LINUX)
+// laid out like the Windows versions
+struct RCS
+{
+    long left;
+    long top;
+    long right;
+    long bottom;
+};
+struct PTS
+{
+    long x;
+    long y;
+};
+#endif // LINUX
 
 /****************************************
     Rectangle and point stuff
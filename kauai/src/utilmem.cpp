@@ -239,7 +239,7 @@ bool FAllocPv(void **ppv, long cb, ulong grfmem, long mpr)
     return fTrue;
 }
 
-#ifdef WIN
+#if defined(WIN) || defined(LINUX)
 /***************************************************************************
     Resizes the given block.  *ppv may change.  If fmemClear, clears any
     newly added space.
@@ -359,7 +359,7 @@ bool _FResizePpv(void **ppv, long cbNew, long cbOld, ulong grfmem, long mpr)
 
     return fTrue;
 }
-#endif // WIN
+#endif // WIN || LINUX
 
 /***************************************************************************
     If *ppv is not nil, frees it and sets *ppv to nil.
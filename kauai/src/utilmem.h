@@ -148,12 +148,12 @@ inline void *QvFromHq(HQ hq)
 {
     return vadst.PvStrip(*(void **)hq);
 }
-#elif defined(WIN)
+#elif defined(WIN) || defined(LINUX)
 inline void *QvFromHq(HQ hq)
 {
     return (void *)hq;
 }
-#endif // WIN
+#endif // WIN || LINUX
 
 #define AssertHq(hq)
 #define MarkHq(hq)
@@ -169,10 +169,10 @@ inline void *QvFromHq(HQ hq)
 bool FAllocPvDebug(void **ppv, long cb, ulong grfmem, long mpr, schar *pszsFile, long lwLine, DMAGL *pdmagl);
 #define FAllocPv(ppv, cb, grfmem, mpr) FAllocPvDebug(ppv, cb, grfmem, mpr, __szsFile, __LINE__, &vdmglob.dmaglPv)
 
-// resizing routine - WIN only
-#ifdef WIN
+// resizing routine - not on MAC
+#if defined(WIN) || defined(LINUX)
 bool _FResizePpvDebug(void **ppv, long cbNew, long cbOld, ulong grfmem, long mpr, DMAGL *pdmagl);
-#endif // WIN
+#endif // WIN || LINUX
 
 // freeing routine
 void FreePpvDebug(void **ppv, DMAGL *pdmagl);
@@ -192,11 +192,11 @@ void MarkPv(void *pv);
 #define FAllocPvDebug(ppv, cb, grfmem, mpr, pszsFile, luLine, pdmagl) FAllocPv(ppv, cb, grfmem, mpr)
 bool FAllocPv(void **ppv, long cb, ulong grfmem, long mpr);
 
-// resizing routine - WIN only
-#ifdef WIN
+// resizing routine - not on MAC
+#if defined(WIN) || defined(LINUX)
 #define _FResizePpvDebug(ppv, cbNew, cbOld, grfmem, mpr, pdmagl) _FResizePpv(ppv, cbNew, cbOld, grfmem, mpr)
 bool _FResizePpv(void **ppv, long cbNew, long cbOld, ulong grfmem, long mpr);
-#endif // WIN
+#endif // WIN || LINUX
 
 // freeing routine
 #define FreePpvDebug(ppv, pdmagl) FreePpv(ppv)
@@ -268,9 +268,36 @@ class MUTX
   protected:
 #ifdef WIN
     CRITICAL_SECTION _crit;
-#endif // WIN
+#elif defined(LINUX)
+    pthread_mutex_t _mutex;
+#endif // LINUX
 
   public:
+#ifdef LINUX
+    // recursive, like a critical section
+    MUTX(void)
+    {
+        pthread_mutexattr_t attr;
+
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&_mutex, &attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+    ~MUTX(void)
+    {
+        pthread_mutex_destroy(&_mutex);
+    }
+
+    void Enter(void)
+    {
+        pthread_mutex_lock(&_mutex);
+    }
+    void Leave(void)
+    {
+        pthread_mutex_unlock(&_mutex);
+    }
+#else  //! LINUX
     MUTX(void)
     {
         Win(InitializeCriticalSection(&_crit);)
@@ -288,6 +315,7 @@ class MUTX
     {
         Win(LeaveCriticalSection(&_crit);)
     }
+#endif //! LINUX
 };
 
 extern MUTX vmutxMem;
@@ -295,9 +323,16 @@ extern MUTX vmutxMem;
 /****************************************
     Current thread id
 ****************************************/
+#ifdef LINUX
+inline long LwThreadCur(void)
+{
+    return (long)pthread_self();
+}
+#else  //! LINUX
 inline long LwThreadCur(void)
 {
     return MacWin(0, GetCurrentThreadId());
 }
+#endif //! LINUX
 
 #endif //! UTILMEM_H
@@ -0,0 +1,1503 @@
+/* Copyright (c) Microsoft Corporation.
+   Licensed under the MIT License. */
+
+/***************************************************************************
+    Project: Kauai
+    Copyright (c) Microsoft Corporation
+
+    Command line tool to time various pieces of Kauai. Each benchmark is
+    a separate sub-command:
+
+        kbench <benchmark> [options...]
+
+    Times are measured with TsCurrentSystem, so are in milliseconds.
+
+***************************************************************************/
+#include <stdio.h>
+#include "frame.h"
+#include "kiddef.h"
+ASSERTNAME
+
+typedef bool (*PFNBNCH)(long cpszs, char **prgpszs);
+
+// benchmark descriptor
+struct BNCH
+{
+    PSZS pszsName;
+    PFNBNCH pfnbnch;
+    PSZS pszsUsage;
+};
+
+bool _FBenchCfl(long cpszs, char **prgpszs);
+bool _FBenchKcdc(long cpszs, char **prgpszs);
+bool _FBenchPack(long cpszs, char **prgpszs);
+bool _FBenchMbmp(long cpszs, char **prgpszs);
+bool _FBenchScpt(long cpszs, char **prgpszs);
+bool _FBenchSave(long cpszs, char **prgpszs);
+bool _FBenchRegn(long cpszs, char **prgpszs);
+
+BNCH _rgbnch[] = {
+    {"cfl", _FBenchCfl, "cfl [-n <chunks>] [-l <lookups>] [<chunkyFile>]"},
+    {"kcdc", _FBenchKcdc, "kcdc [-f <format>] [-e <effort>] <file>..."},
+    {"pack", _FBenchPack, "pack [-n <chunks>] [-s <size>] [-t <maxThreads>] [-f] [<chunkyFile>]"},
+    {"mbmp", _FBenchMbmp, "mbmp [-n <draws>] [<chunkyFile>]"},
+    {"scpt", _FBenchScpt, "scpt [-n <runs>] <chunkyFile>..."},
+    {"save", _FBenchSave, "save [-n <saves>] [-s <maxMegabytes>]"},
+    {"regn", _FBenchRegn, "regn [-n <frames>] [-r <rectsPerFrame>]"},
+};
+
+bool _FGetLwFromSzs(PSZS pszs, long *plw);
+bool _FGetOption(long *pcpszs, char ***pprgpszs, long *plw);
+void _PrintRate(PSZS pszsWhat, long cact, ulong dts);
+
+/***************************************************************************
+    Main routine.  Returns non-zero iff there's an error.
+***************************************************************************/
+int __cdecl main(int cpszs, char *prgpszs[])
+{
+    STN stn;
+    long ibnch;
+    bool fRet;
+
+#ifdef UNICODE
+    fprintf(stderr, "\nMicrosoft (R) Kauai Benchmark Utility (Unicode; " Debug("Debug; ") __DATE__ "; " __TIME__ ")\n");
+#else  //! UNICODE
+    fprintf(stderr, "\nMicrosoft (R) Kauai Benchmark Utility (Ansi; " Debug("Debug; ") __DATE__ "; " __TIME__ ")\n");
+#endif //! UNICODE
+    fprintf(stderr, "Copyright (C) Microsoft Corp 1995. All rights reserved.\n\n");
+
+    if (cpszs < 2)
+        goto LUsage;
+
+    stn.SetSzs(prgpszs[1]);
+    for (ibnch = 0; ibnch < CvFromRgv(_rgbnch); ibnch++)
+    {
+        STN stnName;
+
+        stnName.SetSzs(_rgbnch[ibnch].pszsName);
+        if (stn.FEqualUser(&stnName))
+        {
+            fRet = (*_rgbnch[ibnch].pfnbnch)(cpszs - 2, prgpszs + 2);
+            FIL::ShutDown();
+            return fRet ? 0 : 1;
+        }
+    }
+
+LUsage:
+    // print usage
+    fprintf(stderr, "%s", "Usage:  kbench <benchmark> [options]\n\nBenchmarks:\n");
+    for (ibnch = 0; ibnch < CvFromRgv(_rgbnch); ibnch++)
+        fprintf(stderr, "    %s\n", _rgbnch[ibnch].pszsUsage);
+    fprintf(stderr, "\n");
+    return 1;
+}
+
+/***************************************************************************
+    Time random lookups in a chunky file, first with the plain binary
+    search of the index and then with the hash side index. If no file
+    is given, a temp file with the requested number of chunks is
+    generated.
+***************************************************************************/
+bool _FBenchCfl(long cpszs, char **prgpszs)
+{
+    static CTG _rgctg[] = {'ACTN', 'BKTH', 'GOKD', 'MBMP', 'MODL', 'TMAP', 'WAVE', 'GLXF'};
+    FNI fni;
+    STN stn;
+    CKI cki;
+    CNO cno;
+    long ccki, icki, ilookup, ipass;
+    long cckiGen = 20000;
+    long clookup = 1000000;
+    long cfound;
+    ulong ts;
+    PCFL pcfl = pvNil;
+    PGL pglcki = pvNil;
+    bool fRet = fFalse;
+
+    for (; cpszs > 0; cpszs--, prgpszs++)
+    {
+        if ((*prgpszs)[0] == '-' || (*prgpszs)[0] == '/')
+        {
+            switch ((*prgpszs)[1])
+            {
+            case 'n':
+            case 'N':
+                if (!_FGetOption(&cpszs, &prgpszs, &cckiGen) || cckiGen <= 0)
+                    goto LUsage;
+                break;
+
+            case 'l':
+            case 'L':
+                if (!_FGetOption(&cpszs, &prgpszs, &clookup) || clookup <= 0)
+                    goto LUsage;
+                break;
+
+            default:
+                goto LUsage;
+            }
+        }
+        else if (pvNil != pcfl)
+            goto LUsage;
+        else
+        {
+            stn.SetSzs(prgpszs[0]);
+            if (!fni.FBuildFromPath(&stn) || pvNil == (pcfl = CFL::PcflOpen(&fni, fcflNil)))
+            {
+                fprintf(stderr, "Can't open chunky file\n\n");
+                goto LFail;
+            }
+        }
+    }
+
+    if (pvNil == pcfl)
+    {
+        // generate a file with a handful of ctgs and sparse cnos
+        if (pvNil == (pcfl = CFL::PcflCreateTemp()))
+            goto LFail;
+        for (icki = 0; icki < cckiGen; icki++)
+        {
+            cno = (icki / CvFromRgv(_rgctg)) * 3 + 1;
+            if (!pcfl->FPutPv(&icki, size(long), _rgctg[icki % CvFromRgv(_rgctg)], cno))
+                goto LFail;
+        }
+    }
+
+    // collect the ckis to look up
+    ccki = pcfl->Ccki();
+    if (ccki == 0 || pvNil == (pglcki = GL::PglNew(size(CKI), ccki)))
+        goto LFail;
+    for (icki = 0; icki < ccki; icki++)
+    {
+        AssertDo(pcfl->FGetCki(icki, &cki), 0);
+        if (!pglcki->FAdd(&cki))
+            goto LFail;
+    }
+
+    printf("%ld chunks, %ld lookups\n", ccki, clookup);
+    for (ipass = 0; ipass < 2; ipass++)
+    {
+        RND rnd(12345);
+
+        pcfl->SetHashIndex(ipass != 0);
+
+        // prime the index (builds the hash table on the hash pass)
+        pglcki->Get(0, &cki);
+        pcfl->FFind(cki.ctg, cki.cno);
+
+        cfound = 0;
+        ts = TsCurrentSystem();
+        for (ilookup = 0; ilookup < clookup; ilookup++)
+        {
+            pglcki->Get(rnd.LwNext(ccki), &cki);
+            if (pcfl->FFind(cki.ctg, cki.cno))
+                cfound++;
+        }
+        _PrintRate(ipass == 0 ? "binary search" : "hash index", clookup, TsCurrentSystem() - ts);
+
+        if (cfound != clookup)
+        {
+            fprintf(stderr, "Lookups failed!\n\n");
+            goto LFail;
+        }
+    }
+    fRet = fTrue;
+    goto LFail;
+
+LUsage:
+    fprintf(stderr, "Usage:  kbench %s\n\n", _rgbnch[0].pszsUsage);
+LFail:
+    ReleasePpo(&pglcki);
+    ReleasePpo(&pcfl);
+    return fRet;
+}
+
+/***************************************************************************
+    Time compressing a corpus at each effort level (or just the one
+    requested) and compare speed and size against the exhaustive encoder
+    (kceffMax). Each file on the command line is added to the corpus. If a
+    file is a chunky file, each of its chunks is a separate corpus entry,
+    since that's how chunks are compressed. All output is decompressed and
+    verified, and the decompression rate is reported too.
+***************************************************************************/
+bool _FBenchKcdc(long cpszs, char **prgpszs)
+{
+    FNI fni;
+    STN stn;
+    CKI cki;
+    BLCK blck;
+    FLO flo;
+    long cfmt = vpcodmUtil->CfmtDefault();
+    long ceffMin = kceffMin;
+    long ceffLim = kceffMax + 1;
+    long ceff, iv, icki, cb, cbDst, cbSrcTot, cbDstTot, cbDstMax;
+    ulong ts, dts, dtsDec, dtsMax;
+    PCFL pcfl;
+    PGG pggCorpus = pvNil;
+    byte *prgbDst = pvNil;
+    byte *prgbCheck = pvNil;
+    bool fT;
+    bool fRet = fFalse;
+
+    if (pvNil == (pggCorpus = GG::PggNew()))
+        goto LFail;
+
+    for (; cpszs > 0; cpszs--, prgpszs++)
+    {
+        if ((*prgpszs)[0] == '-' || (*prgpszs)[0] == '/')
+        {
+            switch ((*prgpszs)[1])
+            {
+            case 'f':
+            case 'F':
+                if (!_FGetOption(&cpszs, &prgpszs, &cfmt) || !vpcodmUtil->FCanDo(cfmt, fTrue))
+                    goto LUsage;
+                break;
+
+            case 'e':
+            case 'E':
+                if (!_FGetOption(&cpszs, &prgpszs, &ceffMin) || !FIn(ceffMin, kceffMin, kceffMax + 1))
+                    goto LUsage;
+                ceffLim = ceffMin + 1;
+                break;
+
+            default:
+                goto LUsage;
+            }
+            continue;
+        }
+
+        stn.SetSzs(prgpszs[0]);
+        if (!fni.FBuildFromPath(&stn))
+            goto LUsage;
+
+        if (pvNil != (pcfl = CFL::PcflOpen(&fni, fcflNil)))
+        {
+            for (icki = 0; pcfl->FGetCki(icki, &cki, pvNil, &blck); icki++)
+            {
+                if (!blck.FUnpackData() || (cb = blck.Cb()) == 0)
+                    continue;
+                if (!pggCorpus->FAdd(cb, &iv))
+                {
+                    ReleasePpo(&pcfl);
+                    goto LFail;
+                }
+                fT = blck.FReadRgb(pggCorpus->PvLock(iv), cb, 0);
+                pggCorpus->Unlock();
+                if (!fT)
+                    pggCorpus->Delete(iv);
+            }
+            ReleasePpo(&pcfl);
+        }
+        else if (pvNil != (flo.pfil = FIL::PfilOpen(&fni)))
+        {
+            flo.fp = 0;
+            flo.cb = flo.pfil->FpMac();
+            if (flo.cb > 0)
+            {
+                if (!pggCorpus->FAdd(flo.cb, &iv))
+                {
+                    ReleasePpo(&flo.pfil);
+                    goto LFail;
+                }
+                fT = flo.FReadRgb(pggCorpus->PvLock(iv), flo.cb, 0);
+                pggCorpus->Unlock();
+                if (!fT)
+                    pggCorpus->Delete(iv);
+            }
+            ReleasePpo(&flo.pfil);
+        }
+        else
+        {
+            fprintf(stderr, "Can't open %s\n\n", prgpszs[0]);
+            goto LFail;
+        }
+    }
+
+    if (pggCorpus->IvMac() == 0)
+        goto LUsage;
+
+    // allocate buffers big enough for the largest entry
+    for (cbSrcTot = cbDstMax = 0, iv = pggCorpus->IvMac(); iv-- > 0;)
+    {
+        cb = pggCorpus->Cb(iv);
+        cbSrcTot += cb;
+        cbDstMax = LwMax(cbDstMax, cb);
+    }
+    if (!FAllocPv((void **)&prgbDst, cbDstMax, fmemNil, mprNormal) ||
+        !FAllocPv((void **)&prgbCheck, cbDstMax, fmemNil, mprNormal))
+    {
+        goto LFail;
+    }
+
+    printf("%ld entries, %ld bytes\n", pggCorpus->IvMac(), cbSrcTot);
+    printf("%-8s %10s %8s %10s %8s %8s %8s\n", "effort", "bytes", "ratio", "ms", "MB/sec", "speedup", "dec MB/s");
+
+    // time the exhaustive encoder first, so the others can be compared
+    dtsMax = 0;
+    for (ceff = kceffMax; ceff >= kceffMin; ceff--)
+    {
+        if (ceff != kceffMax && !FIn(ceff, ceffMin, ceffLim))
+            continue;
+
+        cbDstTot = 0;
+        dts = dtsDec = 0;
+        for (iv = 0; iv < pggCorpus->IvMac(); iv++)
+        {
+            cb = pggCorpus->Cb(iv);
+            ts = TsCurrentSystem();
+            if (!vpcodmUtil->FCompress(pggCorpus->PvLock(iv), cb, prgbDst, cb, &cbDst, cfmt, ceff))
+                cbDst = cb; // stored uncompressed
+            dts += TsCurrentSystem() - ts;
+
+            cbDstTot += cbDst;
+
+            if (cbDst < cb)
+            {
+                ts = TsCurrentSystem();
+                fT = vpcodmUtil->FDecompress(prgbDst, cbDst, prgbCheck, cb, &cbDst);
+                dtsDec += TsCurrentSystem() - ts;
+                if (!fT || cbDst != cb || FcmpCompareRgb(prgbCheck, pggCorpus->QvGet(iv), cb) != fcmpEq)
+                {
+                    pggCorpus->Unlock();
+                    fprintf(stderr, "Effort %ld: round trip of entry %ld failed!\n\n", ceff, iv);
+                    goto LFail;
+                }
+            }
+            pggCorpus->Unlock();
+        }
+
+        if (ceff == kceffMax)
+            dtsMax = dts;
+        if (!FIn(ceff, ceffMin, ceffLim))
+            continue;
+
+        printf("%-8ld %10ld %7.1f%% %10lu", ceff, cbDstTot, (double)cbDstTot * 100 / cbSrcTot, dts);
+        if (dts > 0)
+            printf(" %8.2f %7.1fx", (double)cbSrcTot * 1000 / dts / (1024 * 1024), (double)dtsMax / dts);
+        if (dts > 0 && dtsDec > 0)
+            printf(" %8.2f", (double)cbSrcTot * 1000 / dtsDec / (1024 * 1024));
+        printf("\n");
+    }
+    fRet = fTrue;
+    goto LFail;
+
+LUsage:
+    fprintf(stderr, "Usage:  kbench %s\n\n", _rgbnch[1].pszsUsage);
+LFail:
+    FreePpv((void **)&prgbDst);
+    FreePpv((void **)&prgbCheck);
+    ReleasePpo(&pggCorpus);
+    return fRet;
+}
+
+#ifdef DEBUG
+/***************************************************************************
+    Run FPackDataBatch on the first few chunks of the corpus with each HQ
+    allocation it makes failing in turn, to exercise its error paths
+    (freeing an HQ twice asserts in FreePhq). Stops at the first run that
+    doesn't use up the simulated failure.
+***************************************************************************/
+bool _FPackFailSweep(PGG pggCorpus, PGL pglcki, long cth)
+{
+    const long kcckiSweep = 8;
+    PCFL pcfl;
+    PGL pglckiSweep;
+    CKI cki;
+    long cactDo, iv;
+    bool fT, fDone;
+
+    if (pvNil == (pglckiSweep = GL::PglNew(size(CKI))))
+        return fFalse;
+    for (iv = 0; iv < LwMin(kcckiSweep, pglcki->IvMac()); iv++)
+    {
+        pglcki->Get(iv, &cki);
+        if (!pglckiSweep->FAdd(&cki))
+        {
+            ReleasePpo(&pglckiSweep);
+            return fFalse;
+        }
+    }
+
+    for (cactDo = 0;; cactDo++)
+    {
+        if (pvNil == (pcfl = CFL::PcflCreateTemp()))
+            break;
+        for (iv = 0; iv < pglckiSweep->IvMac(); iv++)
+        {
+            pglckiSweep->Get(iv, &cki);
+            fT = pcfl->FPutPv(pggCorpus->PvLock(iv), pggCorpus->Cb(iv), cki.ctg, cki.cno);
+            pggCorpus->Unlock();
+            if (!fT)
+                break;
+        }
+        if (iv < pglckiSweep->IvMac())
+            break;
+
+        vdmglob.dmaglHq.cactDo = cactDo;
+        vdmglob.dmaglHq.cactFail = 1;
+        fT = pcfl->FPackDataBatch(pglckiSweep, cth);
+        fDone = vdmglob.dmaglHq.cactFail > 0;
+        vdmglob.dmaglHq.cactDo = vdmglob.dmaglHq.cactFail = 0;
+        ReleasePpo(&pcfl);
+
+        if (fDone)
+        {
+            ReleasePpo(&pglckiSweep);
+            if (!fT)
+            {
+                fprintf(stderr, "Packing failed with no simulated failure!\n\n");
+                return fFalse;
+            }
+            printf("survived %ld simulated allocation failures\n", cactDo);
+            return fTrue;
+        }
+    }
+
+    ReleasePpo(&pcfl);
+    ReleasePpo(&pglckiSweep);
+    fprintf(stderr, "Couldn't set up the failure sweep\n\n");
+    return fFalse;
+}
+#endif // DEBUG
+
+/***************************************************************************
+    Time CFL::FPackDataBatch packing a set of chunks with 1, 2, 4, ... up
+    to the requested number of threads, and report the speedup over a
+    single thread. The chunks are copied (unpacked) from the given chunky
+    file, or are generated compressible data if no file is given. Each
+    pass starts from a fresh temp file holding the unpacked chunks. In debug builds, -f then
+    runs the error path sweep of _FPackFailSweep.
+***************************************************************************/
+bool _FBenchPack(long cpszs, char **prgpszs)
+{
+    const CTG kctgBench = 'BNCH';
+    FNI fni;
+    STN stn;
+    CKI cki;
+    BLCK blck;
+    long cckiGen = 256;
+    long cbGen = 0x00010000;
+    long cthMax = 8;
+    long cth, iv, icki, ib, cb, cbSrcTot, cpacked;
+    ulong ts, dts, dtsOne;
+    byte *pb;
+    PCFL pcfl = pvNil;
+    PCFL pcflSrc = pvNil;
+    PGG pggCorpus = pvNil;
+    PGL pglcki = pvNil;
+    bool fT;
+    bool fFailSweep = fFalse;
+    bool fRet = fFalse;
+
+    for (; cpszs > 0; cpszs--, prgpszs++)
+    {
+        if ((*prgpszs)[0] == '-' || (*prgpszs)[0] == '/')
+        {
+            switch ((*prgpszs)[1])
+            {
+            case 'n':
+            case 'N':
+                if (!_FGetOption(&cpszs, &prgpszs, &cckiGen) || cckiGen <= 0)
+                    goto LUsage;
+                break;
+
+#ifdef DEBUG
+            case 'f':
+            case 'F':
+                fFailSweep = fTrue;
+                break;
+#endif // DEBUG
+
+            case 's':
+            case 'S':
+                if (!_FGetOption(&cpszs, &prgpszs, &cbGen) || cbGen <= 0)
+                    goto LUsage;
+                break;
+
+            case 't':
+            case 'T':
+                if (!_FGetOption(&cpszs, &prgpszs, &cthMax) || !FIn(cthMax, 1, kcthMaxPack + 1))
+                    goto LUsage;
+                break;
+
+            default:
+                goto LUsage;
+            }
+        }
+        else if (pvNil != pcflSrc)
+            goto LUsage;
+        else
+        {
+            stn.SetSzs(prgpszs[0]);
+            if (!fni.FBuildFromPath(&stn) || pvNil == (pcflSrc = CFL::PcflOpen(&fni, fcflNil)))
+            {
+                fprintf(stderr, "Can't open chunky file\n\n");
+                goto LFail;
+            }
+        }
+    }
+
+    // build the corpus of unpacked chunk data
+    if (pvNil == (pggCorpus = GG::PggNew()))
+        goto LFail;
+    if (pvNil != pcflSrc)
+    {
+        for (icki = 0; pcflSrc->FGetCki(icki, &cki, pvNil, &blck); icki++)
+        {
+            if (!blck.FUnpackData() || (cb = blck.Cb()) == 0)
+                continue;
+            if (!pggCorpus->FAdd(cb, &iv))
+                goto LFail;
+            fT = blck.FReadRgb(pggCorpus->PvLock(iv), cb, 0);
+            pggCorpus->Unlock();
+            if (!fT)
+                pggCorpus->Delete(iv);
+        }
+    }
+    else
+    {
+        // words from a small vocabulary compress about as well as real data
+        static achar _rgchWord[] = "the actor walks to scene and camera turns left ";
+        RND rnd(12345);
+
+        for (icki = 0; icki < cckiGen; icki++)
+        {
+            if (!pggCorpus->FAdd(cbGen, &iv))
+                goto LFail;
+            pb = (byte *)pggCorpus->PvLock(iv);
+            for (ib = 0; ib < cbGen; ib++)
+            {
+                if (rnd.LwNext(8) == 0)
+                    pb[ib] = (byte)rnd.LwNext(256);
+                else
+                    pb[ib] = (byte)_rgchWord[(ib + rnd.LwNext(4)) % (CvFromRgv(_rgchWord) - 1)];
+            }
+            pggCorpus->Unlock();
+        }
+    }
+    if (pggCorpus->IvMac() == 0)
+        goto LUsage;
+    if (pvNil == (pglcki = GL::PglNew(size(CKI), pggCorpus->IvMac())))
+        goto LFail;
+    for (cbSrcTot = 0, iv = 0; iv < pggCorpus->IvMac(); iv++)
+    {
+        cbSrcTot += pggCorpus->Cb(iv);
+        cki.ctg = kctgBench;
+        cki.cno = iv;
+        if (!pglcki->FAdd(&cki))
+            goto LFail;
+    }
+
+    printf("%ld chunks, %ld bytes\n", pggCorpus->IvMac(), cbSrcTot);
+    printf("%-8s %10s %8s %8s %8s\n", "threads", "ms", "MB/sec", "speedup", "packed");
+
+    dtsOne = 0;
+    for (cth = 1;; cth = LwMin(cth * 2, cthMax))
+    {
+        if (pvNil == (pcfl = CFL::PcflCreateTemp()))
+            goto LFail;
+        for (iv = 0; iv < pggCorpus->IvMac(); iv++)
+        {
+            fT = pcfl->FPutPv(pggCorpus->PvLock(iv), pggCorpus->Cb(iv), kctgBench, iv);
+            pggCorpus->Unlock();
+            if (!fT)
+                goto LFail;
+        }
+
+        ts = TsCurrentSystem();
+        fT = pcfl->FPackDataBatch(pglcki, cth);
+        dts = TsCurrentSystem() - ts;
+        if (!fT)
+        {
+            fprintf(stderr, "Packing with %ld threads failed!\n\n", cth);
+            goto LFail;
+        }
+
+        // make sure the packed chunks still hold the right data
+        for (cpacked = 0, iv = 0; iv < pggCorpus->IvMac(); iv++)
+        {
+            AssertDo(pcfl->FFind(kctgBench, iv, &blck), 0);
+            if (blck.FPacked())
+                cpacked++;
+            cb = pggCorpus->Cb(iv);
+            fT = blck.FUnpackData() && blck.Cb() == cb;
+            if (fT)
+            {
+                HQ hq = hqNil;
+
+                fT = blck.FReadHq(&hq) &&
+                     FcmpCompareRgb(QvFromHq(hq), pggCorpus->QvGet(iv), cb) == fcmpEq;
+                FreePhq(&hq);
+            }
+            if (!fT)
+            {
+                fprintf(stderr, "Chunk %ld is wrong after packing with %ld threads!\n\n", iv, cth);
+                goto LFail;
+            }
+        }
+        ReleasePpo(&pcfl);
+
+        if (cth == 1)
+            dtsOne = dts;
+        printf("%-8ld %10lu", cth, dts);
+        if (dts > 0)
+            printf(" %8.2f %7.1fx", (double)cbSrcTot * 1000 / dts / (1024 * 1024), (double)dtsOne / dts);
+        else
+            printf(" %8s %8s", "", "");
+        printf(" %8ld\n", cpacked);
+
+        if (cth == cthMax)
+            break;
+    }
+#ifdef DEBUG
+    if (fFailSweep && !_FPackFailSweep(pggCorpus, pglcki, cthMax))
+        goto LFail;
+#endif // DEBUG
+    fRet = fTrue;
+    goto LFail;
+
+LUsage:
+    fprintf(stderr, "Usage:  kbench %s\n\n", _rgbnch[2].pszsUsage);
+LFail:
+    ReleasePpo(&pcfl);
+    ReleasePpo(&pcflSrc);
+    ReleasePpo(&pglcki);
+    ReleasePpo(&pggCorpus);
+    return fRet;
+}
+
+/***************************************************************************
+    Time MBMP::Draw with each run blitter, unclipped, clipped to a
+    rectangle and clipped to a checkerboard region. The MBMPs are the
+    MBMP chunks of the given chunky file, or generated sprites (opaque,
+    solid mask and small icon) if no file is given. Each pass draws the
+    same MBMPs at the same random positions, and the result is compared
+    against the scalar blitter's. The pixel rate counts the pixels of
+    each MBMP's bounding rectangle that fall in the clip rectangle.
+***************************************************************************/
+bool _FBenchMbmp(long cpszs, char **prgpszs)
+{
+    const long kdxpDst = 640;
+    const long kdypDst = 480;
+    const long kdzpTile = 32;
+    static PSZS _rgpszsClip[] = {"none", "rect", "region"};
+    static PSZS _rgpszsMblt[] = {"scalar", "vector"};
+    FNI fni;
+    STN stn;
+    CKI cki;
+    BLCK blck;
+    RC rc, rcT, rcDst, rcClip;
+    long cdraw = 20000;
+    long icki, imbmp, idraw, iclip, mblt, xp, yp, dxp, dyp;
+    double cpix;
+    ulong ts, dts;
+    byte *prgbPixels = pvNil;
+    byte *prgbDst = pvNil;
+    byte *prgbCheck = pvNil;
+    PMBMP pmbmp;
+    PCFL pcfl = pvNil;
+    PGL pglpmbmp = pvNil;
+    PREGN pregn = pvNil;
+    bool fRet = fFalse;
+
+    for (; cpszs > 0; cpszs--, prgpszs++)
+    {
+        if ((*prgpszs)[0] == '-' || (*prgpszs)[0] == '/')
+        {
+            switch ((*prgpszs)[1])
+            {
+            case 'n':
+            case 'N':
+                if (!_FGetOption(&cpszs, &prgpszs, &cdraw) || cdraw <= 0)
+                    goto LUsage;
+                break;
+
+            default:
+                goto LUsage;
+            }
+        }
+        else if (pvNil != pcfl)
+            goto LUsage;
+        else
+        {
+            stn.SetSzs(prgpszs[0]);
+            if (!fni.FBuildFromPath(&stn) || pvNil == (pcfl = CFL::PcflOpen(&fni, fcflNil)))
+            {
+                fprintf(stderr, "Can't open chunky file\n\n");
+                goto LFail;
+            }
+        }
+    }
+
+    if (pvNil == (pglpmbmp = GL::PglNew(size(PMBMP))))
+        goto LFail;
+    if (pvNil != pcfl)
+    {
+        for (icki = 0; pcfl->FGetCkiCtg(kctgMbmp, icki, &cki, pvNil, &blck); icki++)
+        {
+            if (pvNil == (pmbmp = MBMP::PmbmpRead(&blck)))
+                continue;
+            if (!pglpmbmp->FAdd(&pmbmp))
+            {
+                ReleasePpo(&pmbmp);
+                goto LFail;
+            }
+        }
+    }
+    else
+    {
+        // an actor sized sprite with ragged edges and holes, the same
+        // shape as a solid mask, and a small icon with short runs
+        static long _rgdzp[] = {120, 160, 120, 160, 32, 32};
+        static ulong _rggrfmbmp[] = {fmbmpNil, fmbmpMask, fmbmpNil};
+        RND rnd(12345);
+        double dx, dy;
+
+        for (imbmp = 0; imbmp < CvFromRgv(_rggrfmbmp); imbmp++)
+        {
+            dxp = _rgdzp[2 * imbmp];
+            dyp = _rgdzp[2 * imbmp + 1];
+            if (!FAllocPv((void **)&prgbPixels, LwMul(dxp, dyp), fmemNil, mprNormal))
+                goto LFail;
+            for (yp = 0; yp < dyp; yp++)
+            {
+                for (xp = 0; xp < dxp; xp++)
+                {
+                    // inside a ragged ellipse, with a few transparent specks
+                    dx = (2.0 * xp - dxp) / dxp;
+                    dy = (2.0 * yp - dyp) / dyp;
+                    if (dx * dx + dy * dy > 1 - rnd.LwNext(16) / 100.0 || rnd.LwNext(24) == 0)
+                    {
+                        prgbPixels[LwMul(yp, dxp) + xp] = 0;
+                    }
+                    else
+                        prgbPixels[LwMul(yp, dxp) + xp] = (byte)(1 + rnd.LwNext(255));
+                }
+            }
+            rc.Set(0, 0, dxp, dyp);
+            pmbmp = MBMP::PmbmpNew(prgbPixels, dxp, dyp, &rc, dxp / 2, dyp, 0, _rggrfmbmp[imbmp], 0x23);
+            FreePpv((void **)&prgbPixels);
+            if (pvNil == pmbmp)
+                goto LFail;
+            if (!pglpmbmp->FAdd(&pmbmp))
+            {
+                ReleasePpo(&pmbmp);
+                goto LFail;
+            }
+        }
+    }
+    if (pglpmbmp->IvMac() == 0)
+        goto LUsage;
+
+    // the clip region is a checkerboard of tiles
+    rcDst.Set(0, 0, kdxpDst, kdypDst);
+    if (pvNil == (pregn = REGN::PregnNew(pvNil)))
+        goto LFail;
+    for (yp = 0; yp < kdypDst; yp += kdzpTile)
+    {
+        for (xp = (yp / kdzpTile & 1) * kdzpTile; xp < kdxpDst; xp += 2 * kdzpTile)
+        {
+            rc.Set(xp, yp, xp + kdzpTile, yp + kdzpTile);
+            if (!pregn->FUnionRc(&rc))
+                goto LFail;
+        }
+    }
+
+    if (!FAllocPv((void **)&prgbDst, LwMul(kdxpDst, kdypDst), fmemNil, mprNormal) ||
+        !FAllocPv((void **)&prgbCheck, LwMul(kdxpDst, kdypDst), fmemNil, mprNormal))
+    {
+        goto LFail;
+    }
+
+    printf("%ld MBMPs, %ld draws\n", pglpmbmp->IvMac(), cdraw);
+    printf("%-8s %-8s %10s %12s\n", "clip", "blitter", "ms", "Mpix/sec");
+    for (iclip = 0; iclip < CvFromRgv(_rgpszsClip); iclip++)
+    {
+        rcClip = rcDst;
+        if (iclip == 1)
+            rcClip.Inset(kdxpDst / 4, kdypDst / 4);
+
+        for (mblt = kmbltScalar; mblt < kmbltLim; mblt++)
+        {
+            RND rnd(12345);
+
+            if (!MBMP::FSetMblt(mblt))
+                continue;
+
+            ClearPb(prgbDst, LwMul(kdxpDst, kdypDst));
+            cpix = 0;
+            dts = 0;
+            for (idraw = 0; idraw < cdraw; idraw++)
+            {
+                pglpmbmp->Get(idraw % pglpmbmp->IvMac(), &pmbmp);
+                pmbmp->GetRc(&rc);
+                xp = rnd.LwNext(kdxpDst + rc.Dxp()) - rc.xpRight;
+                yp = rnd.LwNext(kdypDst + rc.Dyp()) - rc.ypBottom;
+                rc.Offset(xp, yp);
+                if (rcT.FIntersect(&rc, &rcClip))
+                    cpix += rcT.Dxp() * (double)rcT.Dyp();
+
+                ts = TsCurrentSystem();
+                pmbmp->Draw(prgbDst, kdxpDst, kdypDst, xp, yp, iclip == 1 ? &rcClip : pvNil,
+                            iclip == 2 ? pregn : pvNil);
+                dts += TsCurrentSystem() - ts;
+            }
+
+            printf("%-8s %-8s %10lu", _rgpszsClip[iclip], _rgpszsMblt[mblt], dts);
+            if (dts > 0)
+                printf(" %12.2f", cpix * 1000 / dts / 1000000);
+            printf("\n");
+
+            if (mblt == kmbltScalar)
+                CopyPb(prgbDst, prgbCheck, LwMul(kdxpDst, kdypDst));
+            else if (FcmpCompareRgb(prgbDst, prgbCheck, LwMul(kdxpDst, kdypDst)) != fcmpEq)
+            {
+                fprintf(stderr, "The %s blitter doesn't match the scalar one!\n\n", _rgpszsMblt[mblt]);
+                goto LFail;
+            }
+        }
+    }
+    fRet = fTrue;
+    goto LFail;
+
+LUsage:
+    fprintf(stderr, "Usage:  kbench %s\n\n", _rgbnch[3].pszsUsage);
+LFail:
+    MBMP::FSetMblt(MBMP::MbltBest());
+    if (pvNil != pglpmbmp)
+    {
+        for (imbmp = pglpmbmp->IvMac(); imbmp-- > 0;)
+        {
+            pglpmbmp->Get(imbmp, &pmbmp);
+            ReleasePpo(&pmbmp);
+        }
+        ReleasePpo(&pglpmbmp);
+    }
+    FreePpv((void **)&prgbPixels);
+    FreePpv((void **)&prgbDst);
+    FreePpv((void **)&prgbCheck);
+    ReleasePpo(&pregn);
+    ReleasePpo(&pcfl);
+    return fRet;
+}
+
+extern AROP _rgaropSccg[];
+
+/***************************************************************************
+    Script interpreter for the scpt benchmark.  There are no GOBs, so the
+    GOB operations (and anything else past the base interpreter) just pop
+    their arguments and return zero.  Scripts that run too long are
+    stopped, so a script waiting on a GOB that never changes doesn't loop
+    forever.
+***************************************************************************/
+class SCEBB : public SCEB
+{
+  protected:
+    PGL _pglrtvmThis;
+    PGL _pglrtvmGlobal;
+    PGL _pglrtvmRemote;
+
+    virtual bool _FExecOp(long op);
+    virtual PGL *_PpglrtvmThis(void)
+    {
+        return &_pglrtvmThis;
+    }
+    virtual PGL *_PpglrtvmGlobal(void)
+    {
+        return &_pglrtvmGlobal;
+    }
+    virtual PGL *_PpglrtvmRemote(long lw)
+    {
+        return &_pglrtvmRemote;
+    }
+
+  public:
+    long cop;    // operations executed
+    long copMax; // when to give up on the script
+
+    SCEBB(void)
+    {
+        _pglrtvmThis = _pglrtvmGlobal = _pglrtvmRemote = pvNil;
+        cop = 0;
+        copMax = 100000;
+    }
+    ~SCEBB(void)
+    {
+        ReleasePpo(&_pglrtvmThis);
+        ReleasePpo(&_pglrtvmGlobal);
+        ReleasePpo(&_pglrtvmRemote);
+    }
+};
+
+/***************************************************************************
+    Execute an operation, stubbing out the ones the base interpreter
+    doesn't know about.
+***************************************************************************/
+bool SCEBB::_FExecOp(long op)
+{
+    AROP *parop;
+    long cact;
+
+    if (++cop > copMax)
+    {
+        _Error(fFalse);
+        return fFalse;
+    }
+    if (op < kopLimSccb)
+        return SCEB::_FExecOp(op);
+
+    for (parop = _rgaropSccg; opNil != parop->op && op != parop->op; parop++)
+        ;
+    if (opNil == parop->op)
+    {
+        _Error(fFalse);
+        return fFalse;
+    }
+
+    if (parop->clwVar > 0)
+    {
+        cact = _LwPop();
+        for (cact = LwMul(cact, parop->clwVar); cact > 0 && !_fError; cact--)
+            _LwPop();
+    }
+    for (cact = parop->clwFixed; cact > 0 && !_fError; cact--)
+        _LwPop();
+    if (!parop->fVoid)
+        _Push(0);
+    return !_fError;
+}
+
+/***************************************************************************
+    Time reading and running the scripts in the given chunky files.  Each
+    script is run <runs> times with its instructions decoded at read time
+    and again decoding each instruction as it runs.  Scripts that fail
+    (usually because they call an operation the benchmark doesn't
+    implement) still count the operations executed before the failure.
+***************************************************************************/
+bool _FBenchScpt(long cpszs, char **prgpszs)
+{
+    static CTG _rgctg[] = {kctgScript, kctgAnimation};
+    FNI fni;
+    STN stn;
+    CKI cki;
+    BLCK blck;
+    long crun = 100;
+    long icfl, ictg, icki, irun, iscpt, cscpt, cb;
+    long rgcop[2];
+    ulong rgdts[2];
+    ulong ts, dtsRead;
+    bool fPaused, fPredecode;
+    PCFL pcfl;
+    PSCPT pscpt;
+    SCEBB *pscebb = pvNil;
+    PGL pglpscpt = pvNil;
+    PGL pglpcfl = pvNil;
+    bool fRet = fFalse;
+
+    if (pvNil == (pglpcfl = GL::PglNew(size(PCFL))))
+        goto LFail;
+    for (; cpszs > 0; cpszs--, prgpszs++)
+    {
+        if ((*prgpszs)[0] == '-' || (*prgpszs)[0] == '/')
+        {
+            switch ((*prgpszs)[1])
+            {
+            case 'n':
+            case 'N':
+                if (!_FGetOption(&cpszs, &prgpszs, &crun) || crun <= 0)
+                    goto LUsage;
+                break;
+
+            default:
+                goto LUsage;
+            }
+        }
+        else
+        {
+            stn.SetSzs(prgpszs[0]);
+            if (!fni.FBuildFromPath(&stn) || pvNil == (pcfl = CFL::PcflOpen(&fni, fcflNil)))
+            {
+                fprintf(stderr, "Can't open chunky file\n\n");
+                goto LFail;
+            }
+            if (!pglpcfl->FAdd(&pcfl))
+            {
+                ReleasePpo(&pcfl);
+                goto LFail;
+            }
+        }
+    }
+    if (pglpcfl->IvMac() == 0)
+        goto LUsage;
+
+    // read (and decode) the scripts
+    if (pvNil == (pglpscpt = GL::PglNew(size(PSCPT))))
+        goto LFail;
+    cb = 0;
+    dtsRead = 0;
+    for (icfl = 0; icfl < pglpcfl->IvMac(); icfl++)
+    {
+        pglpcfl->Get(icfl, &pcfl);
+        for (ictg = 0; ictg < CvFromRgv(_rgctg); ictg++)
+        {
+            for (icki = 0; pcfl->FGetCkiCtg(_rgctg[ictg], icki, &cki, pvNil, &blck); icki++)
+            {
+                ts = TsCurrentSystem();
+                pscpt = SCPT::PscptRead(pcfl, cki.ctg, cki.cno);
+                dtsRead += TsCurrentSystem() - ts;
+                if (pvNil == pscpt)
+                    continue;
+                cb += blck.Cb();
+                if (!pglpscpt->FAdd(&pscpt))
+                {
+                    ReleasePpo(&pscpt);
+                    goto LFail;
+                }
+            }
+        }
+    }
+    if ((cscpt = pglpscpt->IvMac()) == 0)
+    {
+        fprintf(stderr, "No scripts found\n\n");
+        goto LFail;
+    }
+    printf("%ld scripts, %ld bytes, %ld runs each\n", cscpt, cb, crun);
+    _PrintRate("read", cscpt, dtsRead);
+
+    // run each script with and without the decoded instructions
+    for (fPredecode = fFalse;; fPredecode = fTrue)
+    {
+        rgcop[fPredecode] = 0;
+        rgdts[fPredecode] = 0;
+        for (iscpt = 0; iscpt < cscpt; iscpt++)
+        {
+            pglpscpt->Get(iscpt, &pscpt);
+            for (irun = 0; irun < crun; irun++)
+            {
+                if (pvNil == (pscebb = NewObj SCEBB))
+                    goto LFail;
+                pscebb->SetPredecode(fPredecode);
+
+                ts = TsCurrentSystem();
+                if (pscebb->FRunScript(pscpt, pvNil, 0, pvNil, &fPaused))
+                {
+                    while (fPaused && pscebb->FResume(pvNil, &fPaused))
+                        ;
+                }
+                rgdts[fPredecode] += TsCurrentSystem() - ts;
+                rgcop[fPredecode] += pscebb->cop;
+                ReleasePpo(&pscebb);
+            }
+        }
+        _PrintRate(fPredecode ? "run (decoded ops)" : "run (plain ops)", rgcop[fPredecode], rgdts[fPredecode]);
+        if (fPredecode)
+            break;
+    }
+    if (rgcop[fFalse] != rgcop[fTrue])
+    {
+        fprintf(stderr, "The decoded scripts executed %ld operations, not %ld!\n\n", rgcop[fTrue], rgcop[fFalse]);
+        goto LFail;
+    }
+    fRet = fTrue;
+    goto LFail;
+
+LUsage:
+    fprintf(stderr, "Usage:  kbench %s\n\n", _rgbnch[4].pszsUsage);
+LFail:
+    ReleasePpo(&pscebb);
+    if (pvNil != pglpscpt)
+    {
+        for (iscpt = pglpscpt->IvMac(); iscpt-- > 0;)
+        {
+            pglpscpt->Get(iscpt, &pscpt);
+            ReleasePpo(&pscpt);
+        }
+        ReleasePpo(&pglpscpt);
+    }
+    if (pvNil != pglpcfl)
+    {
+        for (icfl = pglpcfl->IvMac(); icfl-- > 0;)
+        {
+            pglpcfl->Get(icfl, &pcfl);
+            ReleasePpo(&pcfl);
+        }
+        ReleasePpo(&pglpcfl);
+    }
+    return fRet;
+}
+
+/***************************************************************************
+    Time saving chunky files of increasing size (1 MB, 2 MB, ... up to
+    the -s size) after changing one chunk, the way a movie is saved after
+    a small edit: new data goes to the extra file and FSave puts it in
+    the main file.  Each file is saved in place, then by rewriting the
+    whole file.  Times are the average per save.
+***************************************************************************/
+bool _FBenchSave(long cpszs, char **prgpszs)
+{
+    const CTG kctgBench = 'BNCH';
+    const long kcbChunkMax = 0x10000;
+    long cmbMax = 64;
+    long csave = 10;
+    long cmb, cb, cbTot, cno, isave, ipass;
+    ulong ts;
+    ulong rgdts[2];
+    byte *prgb = pvNil;
+    PCFL pcfl = pvNil;
+    bool fRet = fFalse;
+
+    for (; cpszs > 0; cpszs--, prgpszs++)
+    {
+        if ((*prgpszs)[0] != '-' && (*prgpszs)[0] != '/')
+            goto LUsage;
+
+        switch ((*prgpszs)[1])
+        {
+        case 'n':
+        case 'N':
+            if (!_FGetOption(&cpszs, &prgpszs, &csave) || csave <= 0)
+                goto LUsage;
+            break;
+
+        case 's':
+        case 'S':
+            if (!_FGetOption(&cpszs, &prgpszs, &cmbMax) || !FIn(cmbMax, 1, 1024))
+                goto LUsage;
+            break;
+
+        default:
+            goto LUsage;
+        }
+    }
+
+    if (!FAllocPv((void **)&prgb, kcbChunkMax, fmemNil, mprNormal))
+        goto LFail;
+    BLOCK
+    {
+        RND rnd(12345);
+
+        for (cb = 0; cb < kcbChunkMax; cb++)
+            prgb[cb] = (byte)rnd.LwNext(256);
+    }
+
+    printf("%8s %8s %14s %14s\n", "MB", "chunks", "in place ms", "rewrite ms");
+    for (cmb = 1; cmb <= cmbMax; cmb *= 2)
+    {
+        RND rnd(12345);
+
+        if (pvNil == (pcfl = CFL::PcflCreateTemp()))
+            goto LFail;
+        for (cbTot = 0, cno = 0; cbTot < LwMul(cmb, 0x00100000); cbTot += cb, cno++)
+        {
+            cb = 1 + rnd.LwNext(kcbChunkMax);
+            if (!pcfl->FPutPv(prgb, cb, kctgBench, cno))
+                goto LFail;
+        }
+
+        // write the file, then send new data to the extra file the way
+        // movies do
+        if (!pcfl->FSave(kctgBench) || !pcfl->FSetGrfcfl(fcflAddToExtra, fcflAddToExtra))
+            goto LFail;
+
+        for (ipass = 0; ipass < 2; ipass++)
+        {
+            pcfl->SetSaveInPlace(ipass == 0);
+            rgdts[ipass] = 0;
+            for (isave = 0; isave < csave; isave++)
+            {
+                // a small edit replaces one chunk
+                if (!pcfl->FPutPv(prgb, 1 + rnd.LwNext(kcbChunkMax), kctgBench, rnd.LwNext(cno)))
+                    goto LFail;
+
+                ts = TsCurrentSystem();
+                if (!pcfl->FSave(kctgBench))
+                {
+                    fprintf(stderr, "Saving failed\n\n");
+                    goto LFail;
+                }
+                rgdts[ipass] += TsCurrentSystem() - ts;
+            }
+        }
+        printf("%8ld %8ld %14lu %14lu\n", cmb, cno, rgdts[0] / csave, rgdts[1] / csave);
+        ReleasePpo(&pcfl);
+    }
+    fRet = fTrue;
+    goto LFail;
+
+LUsage:
+    fprintf(stderr, "Usage:  kbench %s\n\n", _rgbnch[5].pszsUsage);
+LFail:
+    FreePpv((void **)&prgb);
+    ReleasePpo(&pcfl);
+    return fRet;
+}
+
+/***************************************************************************
+    Run one pass of the region benchmark: each frame unions a batch of
+    dirty rectangles (sprites, runs of text lines, overlapping redraws)
+    into a region the way MarkRc does, clips it to the view, takes out an
+    opaque palette, scans the result into rectangles and merges it into an
+    accumulated region, which is reset every 8 frames.  Returns the number
+    of rectangles scanned, so passes can be checked against each other.
+***************************************************************************/
+long _CrcRunRegnFrames(PREGN pregn, PREGN pregnAcc, long cframe, long crcFrame)
+{
+    AssertPo(pregn, 0);
+    AssertPo(pregnAcc, 0);
+    RND rnd(12345);
+    RC rcView(8, 8, 632, 472);
+    RC rcPalette(560, 0, 640, 480);
+    RC rc, rcPrev(0, 0, 0, 0);
+    REGSC regsc;
+    long iframe, irc, dyp;
+    long crc = 0;
+
+    for (iframe = 0; iframe < cframe; iframe++)
+    {
+        pregn->SetRc(pvNil);
+        for (irc = 0; irc < crcFrame; irc++)
+        {
+            switch (rnd.LwNext(3))
+            {
+            case 0:
+                // a sprite somewhere
+                rc.xpLeft = rnd.LwNext(600);
+                rc.ypTop = rnd.LwNext(440);
+                rc.xpRight = rc.xpLeft + 16 + rnd.LwNext(80);
+                rc.ypBottom = rc.ypTop + 16 + rnd.LwNext(80);
+                break;
+
+            case 1:
+                // the next line of text under the last rectangle
+                rc = rcPrev;
+                rc.ypTop = rcPrev.ypBottom;
+                rc.ypBottom = rc.ypTop + 12;
+                break;
+
+            default:
+                // a redraw overlapping the last rectangle
+                rc = rcPrev;
+                rc.Offset(rnd.LwNext(17) - 8, rnd.LwNext(17) - 8);
+                break;
+            }
+            if (!pregn->FUnionRc(&rc))
+                return -1;
+            rcPrev = rc;
+        }
+        if (!pregn->FIntersectRc(&rcView) || !pregn->FDiffRc(&rcPalette))
+            return -1;
+
+        if (!pregn->FEmpty(&rc))
+        {
+            regsc.Init(pregn, &rc);
+            for (dyp = 0;;)
+            {
+                while (regsc.XpCur() < klwMax)
+                {
+                    regsc.XpFetch();
+                    regsc.XpFetch();
+                    crc++;
+                }
+                if ((dyp += regsc.DypCur()) >= rc.Dyp())
+                    break;
+                regsc.ScanNext(regsc.DypCur());
+            }
+            regsc.Free();
+        }
+
+        if (iframe % 8 == 0)
+            pregnAcc->SetRc(pvNil);
+        if (!pregnAcc->FUnion(pregn))
+            return -1;
+    }
+    return crc;
+}
+
+/***************************************************************************
+    Time region operations on a dirty rectangle workload, first with each
+    operation allocating its own GL to build in and then with the region
+    builder's scratch GL.
+***************************************************************************/
+bool _FBenchRegn(long cpszs, char **prgpszs)
+{
+    long cframe = 10000;
+    long crcFrame = 12;
+    long ipass;
+    long rgcrc[2];
+    ulong ts;
+    PREGN pregn = pvNil;
+    PREGN pregnAcc = pvNil;
+    bool fRet = fFalse;
+
+    for (; cpszs > 0; cpszs--, prgpszs++)
+    {
+        if ((*prgpszs)[0] != '-' && (*prgpszs)[0] != '/')
+            goto LUsage;
+
+        switch ((*prgpszs)[1])
+        {
+        case 'n':
+        case 'N':
+            if (!_FGetOption(&cpszs, &prgpszs, &cframe) || cframe <= 0)
+                goto LUsage;
+            break;
+
+        case 'r':
+        case 'R':
+            if (!_FGetOption(&cpszs, &prgpszs, &crcFrame) || !FIn(crcFrame, 1, 1000))
+                goto LUsage;
+            break;
+
+        default:
+            goto LUsage;
+        }
+    }
+
+    if (pvNil == (pregn = REGN::PregnNew()) || pvNil == (pregnAcc = REGN::PregnNew()))
+        goto LFail;
+
+    for (ipass = 0; ipass < 2; ipass++)
+    {
+        REGN::SetScratch(ipass == 1);
+        ts = TsCurrentSystem();
+        rgcrc[ipass] = _CrcRunRegnFrames(pregn, pregnAcc, cframe, crcFrame);
+        ts = TsCurrentSystem() - ts;
+        if (rgcrc[ipass] < 0)
+        {
+            fprintf(stderr, "Region operation failed\n\n");
+            goto LFail;
+        }
+        _PrintRate(ipass == 0 ? "frames, own GLs" : "frames, scratch GL", cframe, ts);
+    }
+    if (rgcrc[0] != rgcrc[1])
+    {
+        fprintf(stderr, "Results differ: %ld vs %ld rectangles\n\n", rgcrc[0], rgcrc[1]);
+        goto LFail;
+    }
+    printf("%ld rectangles scanned per pass\n", rgcrc[0]);
+    fRet = fTrue;
+    goto LFail;
+
+LUsage:
+    fprintf(stderr, "Usage:  kbench %s\n\n", _rgbnch[6].pszsUsage);
+LFail:
+    REGN::SetScratch(fTrue);
+    ReleasePpo(&pregn);
+    ReleasePpo(&pregnAcc);
+    return fRet;
+}
+
+/***************************************************************************
+    Parse the numeric argument of an option that takes one. Advances
+    *pcpszs and *pprgpszs past the argument.
+***************************************************************************/
+bool _FGetOption(long *pcpszs, char ***pprgpszs, long *plw)
+{
+    AssertVarMem(pcpszs);
+    AssertVarMem(pprgpszs);
+    AssertVarMem(plw);
+
+    if (*pcpszs <= 1 || !_FGetLwFromSzs((*pprgpszs)[1], plw))
+        return fFalse;
+
+    (*pcpszs)--;
+    (*pprgpszs)++;
+    return fTrue;
+}
+
+/***************************************************************************
+    Print the time for cact operations and the resulting rate.
+***************************************************************************/
+void _PrintRate(PSZS pszsWhat, long cact, ulong dts)
+{
+    printf("%-24s %8lu ms", pszsWhat, dts);
+    if (dts > 0)
+        printf("  %12.0f /sec", (double)cact * 1000 / dts);
+    printf("\n");
+}
+
+/***************************************************************************
+    Get a long value from a string. If the string isn't a number and the
+    length is <= 4, assumes the characters are to be packed into a long
+    (ala CTGs and FTGs).
+***************************************************************************/
+bool _FGetLwFromSzs(PSZS pszs, long *plw)
+{
+    STN stn;
+    long ich;
+
+    stn.SetSzs(pszs);
+    if (stn.FGetLw(plw))
+        return fTrue;
+
+    if (stn.Cch() > 4)
+        return fFalse;
+
+    *plw = 0;
+    for (ich = 0; ich < stn.Cch(); ich++)
+        *plw = (*plw << 8) + (byte)stn.Prgch()[ich];
+
+    return fTrue;
+}
+
+#ifdef DEBUG
+bool _fEnableWarnings = fTrue;
+
+/***************************************************************************
+    Warning proc called by Warn() macro
+***************************************************************************/
+void WarnProc(PSZS pszsFile, long lwLine, PSZS pszsMessage)
+{
+    if (_fEnableWarnings)
+    {
+        fprintf(stderr, "%s(%ld) : warning", pszsFile, lwLine);
+        if (pszsMessage != pvNil)
+        {
+            fprintf(stderr, ": %s", pszsMessage);
+        }
+        fprintf(stderr, "\n");
+    }
+}
+
+/***************************************************************************
+    Returning true breaks into the debugger.
+***************************************************************************/
+bool FAssertProc(PSZS pszsFile, long lwLine, PSZS pszsMessage, void *pv, long cb)
+{
+    fprintf(stderr, "An assert occurred: \n");
+    if (pszsMessage != pvNil)
+        fprintf(stderr, "   Message: %s\n", pszsMessage);
+    if (pv != pvNil)
+    {
+        fprintf(stderr, "   Address %x\n", pv);
+        if (cb != 0)
+        {
+            fprintf(stderr, "   Value: ");
+            switch (cb)
+            {
+            default: {
+                byte *pb;
+                byte *pbLim;
+
+                for (pb = (byte *)pv, pbLim = pb + cb; pb < pbLim; pb++)
+                    fprintf(stderr, "%02x", (int)*pb);
+            }
+            break;
+
+            case 2:
+                fprintf(stderr, "%04x", (int)*(short *)pv);
+                break;
+
+            case 4:
+                fprintf(stderr, "%08lx", *(long *)pv);
+                break;
+            }
+            printf("\n");
+        }
+    }
+    fprintf(stderr, "   File: %s\n", pszsFile);
+    fprintf(stderr, "   Line: %ld\n", lwLine);
+
+    return fFalse;
+}
+#endif // DEBUG
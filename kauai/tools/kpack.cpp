@@ -30,6 +30,8 @@ int __cdecl main(int cpszs, char *prgpszs[])
     bool fCompress = fTrue;
     long cfni = 0;
     long cfmt = vpcodmUtil->CfmtDefault();
+    long ceff = ceffNil;
+    char *pszsT;
 
 #ifdef UNICODE
     fprintf(stderr, "\nMicrosoft (R) Kauai Pack Utility (Unicode; " Debug("Debug; ") __DATE__ "; " __TIME__ ")\n");
@@ -55,24 +57,44 @@ int __cdecl main(int cpszs, char *prgpszs[])
             case 'c':
             case 'C':
                 fCompress = fTrue;
-                switch ((*prgpszs)[2])
+                pszsT = *prgpszs + 2;
+                switch (*pszsT)
                 {
                 case '\0':
+                case ':':
                     cfmt = vpcodmUtil->CfmtDefault();
                     break;
                 case '0':
                     cfmt = cfmtNil;
+                    pszsT++;
                     break;
                 case '1':
                     cfmt = kcfmtKauai;
+                    pszsT++;
                     break;
                 case '2':
                     cfmt = kcfmtKauai2;
+                    pszsT++;
                     break;
                 default:
                     fprintf(stderr, "Bad compression format\n\n");
                     goto LUsage;
                 }
+
+                // optional effort level
+                if (*pszsT == ':')
+                {
+                    if (!_FGetLwFromSzs(pszsT + 1, &ceff) || !FIn(ceff, kceffMin, kceffMax + 1))
+                    {
+                        fprintf(stderr, "Bad compression effort\n\n");
+                        goto LUsage;
+                    }
+                }
+                else if (*pszsT != '\0')
+                {
+                    fprintf(stderr, "Bad compression format\n\n");
+                    goto LUsage;
+                }
                 break;
 
             case 'p':
@@ -175,6 +197,8 @@ int __cdecl main(int cpszs, char *prgpszs[])
     else
     {
         blck.Set(floSrc.pfil, 0, floSrc.cb, fFalse);
+        if (ceffNil != ceff)
+            vpcodmUtil->SetCeffDefault(ceff);
         if (cfmtNil != cfmt)
             blck.FPackData(cfmt);
 
@@ -206,7 +230,8 @@ int __cdecl main(int cpszs, char *prgpszs[])
 
 LUsage:
     // print usage
-    fprintf(stderr, "%s", "Usage:  kpack [-d] [-c[0|1|2]] [-p <format>] <srcFile> <dstFile>\n\n");
+    fprintf(stderr, "%s", "Usage:  kpack [-d] [-c[0|1|2][:<effort>]] [-p <format>] <srcFile> <dstFile>\n\n"
+                       "        <effort> is 1 (fastest) to 9 (smallest, the default)\n\n");
 
 LFail:
     if (pvNil != floDst.pfil)
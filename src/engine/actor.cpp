@@ -140,9 +140,11 @@ ACTR::~ACTR(void)
     AssertBaseThis(0);
 
     _CloseTags();
+    _InvalAkf();
     ReleasePpo(&_pbody);
     ReleasePpo(&_pggaev);
     ReleasePpo(&_pglrpt);
+    FreePhq(&_hqRte);
     ReleasePpo(&_pglsmm);
     ReleasePpo(&_ptmpl);
 }
@@ -298,6 +300,7 @@ void ACTR::_InitState(void)
 {
     AssertBaseThis(0);
 
+    _InvalAkf();
     _Hide();
     _fLifeDirty = fTrue;
     if (_ptmpl != pvNil && _pbody != pvNil)
@@ -359,11 +362,17 @@ bool ACTR::FGotoFrame(long nfrm, bool *pfSoundInFrame)
     bool fQuickMethodValid;
     long iaevT = -1;
     long iaev;
+    long iakf;
+    bool fUseAkf = !_fModeRecord && !_fNoAkf;
     AEV *paev;
 
     if (nfrm == _nfrmCur)
         return fTrue;
 
+    // A route read from file is decoded the first time the actor is shown
+    if (!_FEnsureRte())
+        return fFalse;
+
     // Initialization
     if (nfrm < _nfrmCur || _nfrmCur == knfrmInvalid)
     {
@@ -390,40 +399,57 @@ bool ACTR::FGotoFrame(long nfrm, bool *pfSoundInFrame)
             }
         }
 
-        // Will be walking forward from the nearest earlier add event
-        // Search backward to find it.
-        if (fMidPath)
+        // Resume from the latest snapshot before nfrm if there is one.
+        // Otherwise, will be walking forward from the nearest earlier
+        // add event.  Search backward to find it.
+        if (fUseAkf && nfrm > _nfrmFirst && _FFindAkf(nfrm - 1, &iakf) && _FRestoreAkf(iakf))
+        {
+            fPositionDirty = fTrue;
+            _nfrmCur++;
+            _iaevFrmMin = _iaevCur;
+        }
+        else
         {
-            for (iaev = _iaevCur - 1; iaev >= 0; iaev--)
+            if (fMidPath)
             {
-                paev = (AEV *)_pggaev->QvFixedGet(iaev);
-                if (paev->aet == aetAdd && paev->nfrm <= nfrm)
+                for (iaev = _iaevCur - 1; iaev >= 0; iaev--)
                 {
-                    iaevT = iaev;
-                    break;
+                    paev = (AEV *)_pggaev->QvFixedGet(iaev);
+                    if (paev->aet == aetAdd && paev->nfrm <= nfrm)
+                    {
+                        iaevT = iaev;
+                        break;
+                    }
                 }
             }
+            _SetStateRewound();
+            if (fMidPath)
+            {
+                AssertIn(iaevT, 0, _pggaev->IvMac());
+                _iaevFrmMin = _iaevCur = _iaevAddCur = iaevT;
+                paev = (AEV *)_pggaev->QvFixedGet(_iaevCur);
+                _rtelCur = paev->rtel;
+                _nfrmCur = paev->nfrm;
+                Assert(paev->aet == aetAdd, "Illegal _iaevAddCur state var");
+                _rtelCur.dnfrm--;
+                _GetXyzFromRtel(&_rtelCur, &_xyzCur);
+            }
+            else
+            {
+                _nfrmCur = LwMin(nfrm, _nfrmFirst);
+            }
+            _ptmpl->FSetDefaultCost(_pbody);
         }
-        _SetStateRewound();
-        if (fMidPath)
-        {
-            AssertIn(iaevT, 0, _pggaev->IvMac());
-            _iaevFrmMin = _iaevCur = _iaevAddCur = iaevT;
-            paev = (AEV *)_pggaev->QvFixedGet(_iaevCur);
-            _rtelCur = paev->rtel;
-            _nfrmCur = paev->nfrm;
-            Assert(paev->aet == aetAdd, "Illegal _iaevAddCur state var");
-            _rtelCur.dnfrm--;
-            _GetXyzFromRtel(&_rtelCur, &_xyzCur);
-        }
-        else
-        {
-            _nfrmCur = LwMin(nfrm, _nfrmFirst);
-        }
-        _ptmpl->FSetDefaultCost(_pbody);
     }
     else
     {
+        // Skip ahead to the latest snapshot before nfrm if that's
+        // further along than the current frame
+        if (fUseAkf && _FFindAkf(nfrm - 1, &iakf) && ((AKF *)_pggakf->QvFixedGet(iakf))->nfrm > _nfrmCur &&
+            _FRestoreAkf(iakf))
+        {
+            fPositionDirty = fTrue;
+        }
         _nfrmCur++;
         _iaevFrmMin = _iaevCur; // Save 1st event of this frame
     }
@@ -444,6 +470,8 @@ bool ACTR::FGotoFrame(long nfrm, bool *pfSoundInFrame)
         fPositionBody = (_nfrmCur == nfrm);
         if (!_FDoFrm(fPositionBody, &fPositionDirty, pfSoundInFrame))
             fSuccess = fFalse;
+        else if (!_fModeRecord && _nfrmCur > _nfrmFirst && (_nfrmCur - _nfrmFirst) % kdnfrmAkf == 0)
+            _SaveAkf();
 
         if (nfrm == _nfrmCur)
             break;
@@ -456,6 +484,307 @@ bool ACTR::FGotoFrame(long nfrm, bool *pfSoundInFrame)
     return fSuccess;
 }
 
+/***************************************************************************
+
+    Find the latest state snapshot taken at or before frame nfrm.
+    Returns fFalse if there isn't one.
+
+***************************************************************************/
+bool ACTR::_FFindAkf(long nfrm, long *piakf)
+{
+    AssertBaseThis(0);
+    AssertVarMem(piakf);
+
+    long iakfMin, iakfLim, iakf;
+
+    if (pvNil == _pggakf)
+        return fFalse;
+
+    for (iakfMin = 0, iakfLim = _pggakf->IvMac(); iakfMin < iakfLim;)
+    {
+        iakf = (iakfMin + iakfLim) / 2;
+        if (((AKF *)_pggakf->QvFixedGet(iakf))->nfrm <= nfrm)
+            iakfMin = iakf + 1;
+        else
+            iakfLim = iakf;
+    }
+
+    *piakf = iakfMin - 1;
+    return iakfMin > 0;
+}
+
+/***************************************************************************
+
+    Snapshot the actor state at the end of frame _nfrmCur, so FGotoFrame
+    can later resume from here.  Failure just means slower seeks, so
+    isn't reported.
+
+***************************************************************************/
+void ACTR::_SaveAkf(void)
+{
+    AssertBaseThis(0);
+    Assert(!_fModeRecord, "Snapshot taken while recording");
+
+    AKF akf;
+    long iakf;
+    long cbSmm;
+
+    if (pvNil == _pbody)
+        return;
+
+    if (_FFindAkf(_nfrmCur, &iakf))
+    {
+        if (((AKF *)_pggakf->QvFixedGet(iakf))->nfrm == _nfrmCur)
+            return;
+        iakf++;
+    }
+    else
+        iakf = 0;
+
+    if (pvNil == _pggakf && pvNil == (_pggakf = GG::PggNew(size(AKF))))
+        return;
+
+    if (pvNil == (akf.pcost = NewObj COST()))
+        return;
+    if (!akf.pcost->FGet(_pbody))
+        goto LFail;
+
+    akf.nfrm = _nfrmCur;
+    akf.dxyzRte = _dxyzRte;
+    akf.dxyzSubRte = _dxyzSubRte;
+    akf.xyzCur = _xyzCur;
+    akf.rtelCur = _rtelCur;
+    akf.xfrm = _xfrm;
+    akf.dwrStep = _dwrStep;
+    akf.grfactn = _grfactn;
+    akf.anidCur = _anidCur;
+    akf.ccelCur = _ccelCur;
+    akf.celnCur = _celnCur;
+    akf.iaevCur = _iaevCur;
+    akf.iaevFrmMin = _iaevFrmMin;
+    akf.iaevActnCur = _iaevActnCur;
+    akf.iaevAddCur = _iaevAddCur;
+    akf.fOnStage = _fOnStage;
+    akf.fFrozen = _fFrozen;
+    akf.fUseBmat34Cur = _fUseBmat34Cur;
+
+    cbSmm = LwMul(_pglsmm->IvMac(), size(SMM));
+    if (!_pggakf->FInsert(iakf, cbSmm, cbSmm > 0 ? _pglsmm->QvGet(0) : pvNil, &akf))
+        goto LFail;
+    return;
+
+LFail:
+    ReleasePpo(&akf.pcost);
+}
+
+/***************************************************************************
+
+    Restore the actor state from snapshot iakf.  The body is not
+    positioned - the caller does that after playing forward from here.
+
+***************************************************************************/
+bool ACTR::_FRestoreAkf(long iakf)
+{
+    AssertBaseThis(0);
+    AssertPo(_pggakf, 0);
+    AssertIn(iakf, 0, _pggakf->IvMac());
+
+    AKF akf;
+    long csmm;
+
+    _pggakf->GetFixed(iakf, &akf);
+    AssertPo(akf.pcost, 0);
+
+    csmm = _pggakf->Cb(iakf) / size(SMM);
+    if (!_pglsmm->FSetIvMac(csmm))
+        return fFalse;
+    if (csmm > 0)
+        CopyPb(_pggakf->QvGet(iakf), _pglsmm->QvGet(0), LwMul(csmm, size(SMM)));
+
+    if (!akf.fOnStage)
+        _Hide();
+    else if (!_fOnStage)
+        _pbody->Show();
+    akf.pcost->Set(_pbody);
+
+    _nfrmCur = akf.nfrm;
+    _dxyzRte = akf.dxyzRte;
+    _dxyzSubRte = akf.dxyzSubRte;
+    _xyzCur = akf.xyzCur;
+    _rtelCur = akf.rtelCur;
+    _xfrm = akf.xfrm;
+    _dwrStep = akf.dwrStep;
+    _grfactn = akf.grfactn;
+    _anidCur = akf.anidCur;
+    _ccelCur = akf.ccelCur;
+    _celnCur = akf.celnCur;
+    _iaevCur = akf.iaevCur;
+    _iaevFrmMin = akf.iaevFrmMin;
+    _iaevActnCur = akf.iaevActnCur;
+    _iaevAddCur = akf.iaevAddCur;
+    _fOnStage = akf.fOnStage;
+    _fFrozen = akf.fFrozen;
+    _fUseBmat34Cur = akf.fUseBmat34Cur;
+    return fTrue;
+}
+
+/***************************************************************************
+
+    Discard all the state snapshots.  Must be called whenever the route
+    or events are edited.
+
+***************************************************************************/
+void ACTR::_InvalAkf(void)
+{
+    AssertBaseThis(0);
+
+    AKF akf;
+    long iakf;
+
+    if (pvNil == _pggakf)
+        return;
+
+    for (iakf = 0; iakf < _pggakf->IvMac(); iakf++)
+    {
+        _pggakf->GetFixed(iakf, &akf);
+        ReleasePpo(&akf.pcost);
+    }
+    ReleasePpo(&_pggakf);
+}
+
+#ifdef DEBUG
+/***************************************************************************
+
+    Seek benchmark.  Builds a scratch actor from ptagTmpl in pscen with a
+    cfrm frame walk that rotates and stretches every so often, plays it
+    once to lay down the state snapshots, then times cseek random seeks
+    with and without them.  The same seek sequence is used for both runs.
+    The snapshot path is checked against a full replay along the way.
+
+***************************************************************************/
+bool ACTR::FBenchSeek(PSCEN pscen, PTAG ptagTmpl, long cfrm, long cseek, ulong *pdtsAkf, ulong *pdtsReplay)
+{
+    AssertPo(pscen, 0);
+    AssertVarMem(ptagTmpl);
+    AssertIn(cfrm, 2, klwMax);
+    AssertIn(cseek, 1, klwMax);
+    AssertVarMem(pdtsAkf);
+    AssertVarMem(pdtsReplay);
+
+    const long kdnfrmEdit = 25;
+    const long kcrptSide = 5;
+    bool fRet = fFalse;
+    long crpt = cfrm / 4 + 2;
+    long irpt;
+    long nfrm;
+    long iseek;
+    long ipass;
+    ulong ts;
+    RTEL rtel;
+    XYZ xyz;
+    RPT rpt;
+    PACTR pactr;
+
+    if (pvNil == (pactr = PactrNew(ptagTmpl)))
+        return fFalse;
+    pactr->SetPscen(pscen);
+    if (pvNil == pactr->_pbody)
+        goto LFail;
+
+    if (!pactr->FGotoFrame(0) || !pactr->FAddOnStageCore())
+        goto LFail;
+
+    // Walk the perimeter of a square from the add point
+    pactr->_pglrpt->Get(0, &rpt);
+    for (irpt = 1; irpt < crpt; irpt++)
+    {
+        rpt.dwr = BR_SCALAR(2.0);
+        pactr->_pglrpt->Put(irpt - 1, &rpt);
+        switch ((irpt / kcrptSide) % 4)
+        {
+        case 0:
+            rpt.xyz.dxr = BrsAdd(rpt.xyz.dxr, BR_SCALAR(2.0));
+            break;
+        case 1:
+            rpt.xyz.dzr = BrsAdd(rpt.xyz.dzr, BR_SCALAR(2.0));
+            break;
+        case 2:
+            rpt.xyz.dxr = BrsSub(rpt.xyz.dxr, BR_SCALAR(2.0));
+            break;
+        default:
+            rpt.xyz.dzr = BrsSub(rpt.xyz.dzr, BR_SCALAR(2.0));
+            break;
+        }
+        rpt.dwr = rZero;
+        if (!pactr->_pglrpt->FAdd(&rpt))
+            goto LFail;
+    }
+    pactr->_InvalAkf();
+    pactr->_fLifeDirty = fTrue;
+
+    if (!pactr->FSetStep(BR_SCALAR(0.5)) || !pactr->_FUnfreeze())
+        goto LFail;
+
+    for (nfrm = kdnfrmEdit; nfrm < cfrm; nfrm += kdnfrmEdit)
+    {
+        if (!pactr->FGotoFrame(nfrm))
+            goto LFail;
+        if ((nfrm / kdnfrmEdit) & 1)
+        {
+            if (!pactr->FRotate(aZero, BR_ANGLE_DEG(30.0), aZero, fTrue))
+                goto LFail;
+        }
+        else if (!pactr->FPull(((nfrm / kdnfrmEdit) & 2) ? BR_SCALAR(2.0) : BR_SCALAR(0.5), rOne, rOne))
+            goto LFail;
+    }
+
+    // Play through once so the snapshots exist for the first pass
+    if (!pactr->FGotoFrame(0) || !pactr->FGotoFrame(cfrm - 1))
+        goto LFail;
+
+    for (ipass = 0; ipass < 2; ipass++)
+    {
+        RND rnd(cfrm);
+
+        pactr->_fNoAkf = (ipass != 0);
+        ts = TsCurrentSystem();
+        for (iseek = 0; iseek < cseek; iseek++)
+        {
+            if (!pactr->FGotoFrame(rnd.LwNext(cfrm)))
+                goto LFail;
+        }
+        *(ipass == 0 ? pdtsAkf : pdtsReplay) = TsCurrentSystem() - ts;
+    }
+
+    // A seek through the snapshots must land exactly where a replay does
+    for (nfrm = 1; nfrm < cfrm; nfrm += kdnfrmAkf / 2 + 1)
+    {
+        pactr->_fNoAkf = fTrue;
+        if (!pactr->FGotoFrame(0) || !pactr->FGotoFrame(nfrm))
+            goto LFail;
+        rtel = pactr->_rtelCur;
+        xyz = pactr->_xyzCur;
+
+        pactr->_fNoAkf = fFalse;
+        if (!pactr->FGotoFrame(cfrm - 1) || !pactr->FGotoFrame(nfrm))
+            goto LFail;
+        if (rtel.irpt != pactr->_rtelCur.irpt || rtel.dwrOffset != pactr->_rtelCur.dwrOffset ||
+            xyz.dxr != pactr->_xyzCur.dxr || xyz.dyr != pactr->_xyzCur.dyr || xyz.dzr != pactr->_xyzCur.dzr)
+        {
+            Bug("Snapshot seek disagrees with replay");
+            goto LFail;
+        }
+    }
+    fRet = fTrue;
+
+LFail:
+    if (pactr->_fOnStage)
+        pactr->_Hide();
+    ReleasePpo(&pactr);
+    return fRet;
+}
+#endif // DEBUG
+
 /***************************************************************************
 
     Backup To a smaller frame.  	(Optimization)
@@ -1272,6 +1601,8 @@ void ACTR::_MergeAev(long iaevFirst, long iaevNew, long *piaevRtn)
     long iaev;
     BMAT34 bmat34;
 
+    _InvalAkf();
+
     if ((_pggaev->IvMac() < iaevFirst) || (iaevFirst == iaevNew))
     {
         if (pvNil != piaevRtn)
@@ -1556,6 +1887,8 @@ bool ACTR::_FInsertGgRpt(long irpt, RPT *prpt, BRS dwrPrior)
     RPT rpt;
     BRS dwrTotal = rZero; // Dist from prev node to node after the inserted node
 
+    _InvalAkf();
+
     if (!_pglrpt->FInsert(irpt, prpt))
         return fFalse;
 
@@ -1797,6 +2130,8 @@ bool ACTR::_FAddAevFromPrev(long iaevLim, ulong grfaet)
     long iaevLast;
     bool fPrunedPrevSubrte = fFalse;
 
+    _InvalAkf();
+
     // Locate the next active (not stalled) region of the subroute
     // Note: Not finding a previous aev is not a failure
     _FFindPrevAevAet(aetAdd, iaevLim, &iaevAdd);
@@ -1925,6 +2260,8 @@ bool ACTR::_FAddAevFromLater(void)
     RTEL rtelAdd;
     bool fPositionBody = fFalse;
 
+    _InvalAkf();
+
     Assert(1 == _iaevCur, "_FAddAevFromLater logic error");
     // Find the next Add event
     for (iaev = _iaevCur; iaev < _pggaev->IvMac(); iaev++)
@@ -2162,6 +2499,8 @@ void ACTR::_DelAddFrame(long iaevAdd, long iaevLim)
 
     AssertIn(iaevAdd, 0, iaevLim);
 
+    _InvalAkf();
+
     paev = (AEV *)_pggaev->QvFixedGet(iaevAdd);
     irptAdd = paev->rtel.irpt;
 
@@ -2281,6 +2620,8 @@ void ACTR::SetAddOrient(BRA xa, BRA ya, BRA za, ulong grfbra, XYZ *pdxyz)
 
     AEVADD aevadd;
 
+    _InvalAkf();
+
     _pggaev->Get(_iaevAddCur, &aevadd);
 
     if (pvNil == pdxyz)
@@ -2551,6 +2892,8 @@ bool ACTR::FSoonerLater(long dnfrm)
     long dnfrmSub;
     long dnfrmT;
 
+    _InvalAkf();
+
     if (0 == dnfrm)
         return fTrue;
 
@@ -2683,6 +3026,8 @@ bool ACTR::FTweakRoute(BRS dxr, BRS dyr, BRS dzr, ulong grfmaf)
 
     XYZ xyz;
 
+    _InvalAkf();
+
     if (!_pggaev->FEnsureSpace(1, kcbVarTweak, fgrpNil))
         return fFalse;
 
@@ -2751,6 +3096,8 @@ bool ACTR::FMoveRoute(BRS dxr, BRS dyr, BRS dzr, bool *pfMoved, ulong grfmaf)
     BRA ya;
     BRA za;
 
+    _InvalAkf();
+
     fMoved = (rZero != dxr || rZero != dyr || rZero != dzr);
     if (pvNil != pfMoved)
         *pfMoved = fMoved;
@@ -2984,6 +3331,8 @@ void ACTR::_PrepXfrmFill(long aet, void *pvVar, long cbVar, long iaevMin, long i
     void *pvVarCmp = pvNil;
     long cb;
 
+    _InvalAkf();
+
     _pggaev->Lock();
 
     if (ivNil != iaevCmp)
@@ -3106,6 +3455,8 @@ bool ACTR::_FInsertAev(long iaev, long cbNew, void *pvVar, void *paev, bool fUpd
 
     PTAG ptag;
 
+    _InvalAkf();
+
     if (!_pggaev->FInsert(iaev, cbNew, pvVar, paev))
         return fFalse;
 
@@ -3148,6 +3499,8 @@ void ACTR::_RemoveAev(long iaev, bool fUpdateState)
     PTAG ptag;
     PAEV qaev;
 
+    _InvalAkf();
+
     // First, close tags
     _pggaev->Lock();
     if (_FIsIaevTag(_pggaev, iaev, &ptag, &qaev))
@@ -3199,6 +3552,8 @@ void ACTR::_PrepActnFill(long iaevMin, long anidPrev, long anidNew, ulong grfaet
     long iaev;
     long anid = anidPrev;
 
+    _InvalAkf();
+
     for (iaev = iaevMin; iaev < _pggaev->IvMac(); iaev++)
     {
         _pggaev->GetFixed(iaev, &aev);
@@ -3281,6 +3636,8 @@ void ACTR::_PrepCostFill(long iaevMin, AEVCOST *paevcost)
     CMTL *pcmtl = pvNil;
     bool fReplacePrev = fTrue;
 
+    _InvalAkf();
+
     // Locate the most current costume for this body part
     _pbody->GetPartSetMaterial(paevcost->ibset, &fMtrl, &pmtrlCmp, &pcmtlCmp);
     fCmtl = !fMtrl;
@@ -3369,6 +3726,8 @@ void ACTR::_AdjustAevForRteIns(long irptAdjust, long iaevMin)
     RPT rptBack, rptAdjust;
     BRS dwrBack;
 
+    _InvalAkf();
+
     if (irptAdjust > 0)
     {
         _pglrpt->Get(irptAdjust - 1, &rptBack);
@@ -3422,6 +3781,8 @@ void ACTR::_AdjustAevForRteDel(long irptAdjust, long iaevMin)
     RPT rptBack, rptAdjust;
     BRS dwrBack, dwrFwd;
 
+    _InvalAkf();
+
     if (0 == irptAdjust)
         dwrBack = rZero;
     else
@@ -4033,6 +4394,9 @@ bool ACTR::_FComputeLifetime(long *pnfrmLast)
         return fTrue;
     }
 
+    if (!_FEnsureRte())
+        return fFalse;
+
     // Locate final subroute
     rtel.irpt = 0;
     rtel.dwrOffset = rZero;
@@ -4317,6 +4681,8 @@ bool ACTR::FBeginRecord(ulong tsCurrent, bool fReplace, PACTR pactrRestore)
     long nfrmPrev;
     bool fClosestSubrte = fTrue;
 
+    _InvalAkf();
+
     _pglrpt->Get(_rtelCur.irpt, &rpt);
     _fPathInserted = fFalse;
 
@@ -4432,6 +4798,8 @@ bool ACTR::FRecordMove(BRS dxr, BRS dyr, BRS dzr, ulong grfmaf, ulong tsCurrent,
     BRS rFractMoved;
     BRS dwrMouse;
 
+    _InvalAkf();
+
     Assert(_fOnStage, "Recording an actor that wasn't selectable??");
     if (!_fModeRecord)
         return fTrue; // Potential client call on motion fill
@@ -4592,6 +4960,8 @@ bool ACTR::FEndRecord(bool fReplace, PACTR pactrRestore)
     long iaevJoinFirst = _iaevCur;
     long iaevNew;
 
+    _InvalAkf();
+
     // Determine whether to rejoin to the path
     // REVIEW (*****): Can we assert _fOnStage?
     if (_fModeRecord && (!_fOnStage || fReplace))
@@ -4864,6 +5234,8 @@ void ACTR::_DeleteFwdCore(bool fDeleteAll, bool *pfAlive, long iaevCur)
     RPT rpt;
     AEV *paev;
 
+    _InvalAkf();
+
     if (ivNil == iaevCur)
         iaevCur = _iaevCur;
 
@@ -5025,6 +5397,8 @@ void ACTR::DeleteBackCore(bool *pfAlive)
     RPT rptOld;
     long dnrpt;
 
+    _InvalAkf();
+
     // Nop if not yet at first frame
     if (_nfrmCur <= _nfrmFirst)
     {
@@ -5242,6 +5616,8 @@ void ACTR::_TruncateSubRte(long irptDelLim)
     long iaevLim = _iaevCur;
     long irpt = _rtelCur.irpt;
 
+    _InvalAkf();
+
     if (_rtelCur.dwrOffset == rZero)
         return;
 
@@ -5433,6 +5809,8 @@ bool ACTR::FChangeTagTmpl(TAG *ptagTmplNew)
     AEV aev;
     AEVCOST aevcost;
 
+    _InvalAkf();
+
     ptmpl = (PTMPL)vptagm->PbacoFetch(ptagTmplNew, TMPL::FReadTmpl);
     if (pvNil == ptmpl)
         return fFalse;
@@ -5492,6 +5870,15 @@ void ACTR::AssertValid(ulong grfobj)
     AssertPo(_pggaev, 0);
     AssertPo(_pglrpt, 0);
     AssertPo(_pglsmm, 0);
+    AssertNilOrPo(_pggakf, 0);
+    if (hqNil != _hqRte)
+    {
+        AssertHq(_hqRte);
+        Assert(knfrmInvalid == _nfrmCur && 0 == _pglrpt->IvMac(), "actor used before its route was decoded");
+    }
+
+    if (_fDelta)
+        return; // the state variables describe the rebuilt actor
 
     long iaevMac = _pggaev->IvMac();
     long irptMac = _pglrpt->IvMac();
@@ -5645,9 +6032,18 @@ void ACTR::MarkMem(void)
     }
     MarkMemObj(_pggaev);
     MarkMemObj(_pglrpt);
+    MarkHq(_hqRte);
     MarkMemObj(_pbody);
     MarkMemObj(_ptmpl);
     MarkMemObj(_pglsmm);
+    MarkMemObj(_pggakf);
+    if (pvNil != _pggakf)
+    {
+        long iakf;
+
+        for (iakf = 0; iakf < _pggakf->IvMac(); iakf++)
+            MarkMemObj(((AKF *)_pggakf->QvFixedGet(iakf))->pcost);
+    }
     _tagTmpl.MarkMem();
 }
 
@@ -20,6 +20,19 @@
 ASSERTNAME
 RTCLASS(AUND)
 
+/***************************************************************************
+    Mix cb bytes at pv into the running checksum lu.
+***************************************************************************/
+priv ulong _LuMixRgb(ulong lu, void *pv, long cb)
+{
+    AssertPvCb(pv, cb);
+    byte *pb = (byte *)pv;
+
+    while (cb-- > 0)
+        lu = (lu ^ *pb++) * 0x01000193;
+    return lu;
+}
+
 /***************************************************************************
 
     Duplicate the actor from this frame through
@@ -268,6 +281,12 @@ bool ACTR::FDup(PACTR *ppactr, bool fReset)
     PACTR pactrSrc = this;
     PACTR pactrDest;
 
+    Assert(!_fDelta, "Duplicating a delta");
+
+    // The member copy below must not share an undecoded route
+    if (!_FEnsureRte())
+        return fFalse;
+
     // Due to state var duplication, using NewObj, not PactrNew
     pactrDest = (*ppactr) = NewObj ACTR();
     if (*ppactr == pvNil)
@@ -287,6 +306,8 @@ bool ACTR::FDup(PACTR *ppactr, bool fReset)
     *(pactrDest) = *pactrSrc;
     pactrDest->_cactRef = cactRef;
     pactrDest->_fTimeFrozen = fFalse;
+    pactrDest->_fDelta = fFalse;
+    pactrDest->_pggakf = pvNil; // state snapshots aren't shared
 
     if (!pactrDest->_FCreateGroups())
     {
@@ -325,6 +346,11 @@ void ACTR::Restore(PACTR pactr)
 
     Assert(pactr->_ptmpl == _ptmpl, "Restore ptmpl logic error");
     Assert(pactr->_pbody == _pbody, "Restore pbody logic error");
+    Assert(!pactr->_fDelta, "Restoring from a delta");
+    Assert(hqNil == pactr->_hqRte, "Restoring from an undecoded route");
+
+    _InvalAkf();
+    FreePhq(&_hqRte); // the restored route replaces it
 
     // Copy over all members
     // Note that both copies will point to the same *_pbody & *_ptmpl
@@ -334,6 +360,7 @@ void ACTR::Restore(PACTR pactr)
     PGL pglsmm = pactrDest->_pglsmm;
     *(pactrDest) = *pactrSrc;
     pactrDest->_cactRef = cactRef;
+    pactrDest->_pggakf = pvNil; // state snapshots aren't shared
     pactrDest->_pggaev = pggaev;
     pactrDest->_pglrpt = pglrpt;
     pactrDest->_pglsmm = pglsmm;
@@ -453,6 +480,270 @@ LFail:
     return fFalse;
 }
 
+/***************************************************************************
+
+    Turn this undo snapshot into a delta against pactrBase: keep only the
+    events and route points between the leading and trailing runs that
+    match pactrBase.  pactrBase must look exactly the same when
+    FApplyDelta is called.  Returns fFalse if nothing is shared or we
+    ran out of memory, in which case the snapshot is left whole.
+
+***************************************************************************/
+bool ACTR::FMakeDelta(PACTR pactrBase)
+{
+    AssertThis(0);
+    AssertPo(pactrBase, 0);
+    Assert(pvNil == _pbody, "Only undo snapshots can be deltas");
+    Assert(!pactrBase->_fDelta, "Delta base is a delta");
+
+    ADLT adlt;
+    long caev, caevMin, caevMid;
+    long crpt, crptMin, crptMid;
+    long iaev;
+    PTAG ptag;
+    PGG pggaev = pvNil;
+    PGL pglrpt = pvNil;
+
+    if (_fDelta)
+        return fTrue;
+    if (!pactrBase->_FEnsureRte())
+        return fFalse;
+
+    caev = _pggaev->IvMac();
+    adlt.caevBase = pactrBase->_pggaev->IvMac();
+    caevMin = LwMin(caev, adlt.caevBase);
+    adlt.caevHead = 0;
+    while (adlt.caevHead < caevMin && _FEqualAev(_pggaev, adlt.caevHead, pactrBase->_pggaev, adlt.caevHead))
+        adlt.caevHead++;
+    adlt.caevTail = 0;
+    while (adlt.caevHead + adlt.caevTail < caevMin &&
+           _FEqualAev(_pggaev, caev - 1 - adlt.caevTail, pactrBase->_pggaev, adlt.caevBase - 1 - adlt.caevTail))
+    {
+        adlt.caevTail++;
+    }
+
+    crpt = _pglrpt->IvMac();
+    adlt.crptBase = pactrBase->_pglrpt->IvMac();
+    crptMin = LwMin(crpt, adlt.crptBase);
+    adlt.crptHead = 0;
+    while (adlt.crptHead < crptMin &&
+           FEqualRgb(_pglrpt->QvGet(adlt.crptHead), pactrBase->_pglrpt->QvGet(adlt.crptHead), size(RPT)))
+    {
+        adlt.crptHead++;
+    }
+    adlt.crptTail = 0;
+    while (adlt.crptHead + adlt.crptTail < crptMin &&
+           FEqualRgb(_pglrpt->QvGet(crpt - 1 - adlt.crptTail),
+                     pactrBase->_pglrpt->QvGet(adlt.crptBase - 1 - adlt.crptTail), size(RPT)))
+    {
+        adlt.crptTail++;
+    }
+
+    if (adlt.caevHead + adlt.caevTail + adlt.crptHead + adlt.crptTail == 0)
+        return fFalse;
+
+    caevMid = caev - adlt.caevHead - adlt.caevTail;
+    crptMid = crpt - adlt.crptHead - adlt.crptTail;
+    if (pvNil == (pggaev = GG::PggNew(size(AEV), caevMid)))
+        goto LFail;
+    if (!pggaev->FCopyEntries(_pggaev, adlt.caevHead, 0, caevMid))
+        goto LFail;
+    if (pvNil == (pglrpt = GL::PglNew(size(RPT), crptMid)))
+        goto LFail;
+    if (crptMid > 0)
+    {
+        if (!pglrpt->FSetIvMac(crptMid))
+            goto LFail;
+        CopyPb(_pglrpt->QvGet(adlt.crptHead), pglrpt->QvGet(0), LwMul(crptMid, size(RPT)));
+    }
+    adlt.luCheck = _LuCheckRuns(pactrBase, &adlt);
+
+    // The shared events' tags will be reopened from the base
+    _pggaev->Lock();
+    for (iaev = 0; iaev < caev; iaev++)
+    {
+        if (iaev >= adlt.caevHead && iaev < caev - adlt.caevTail)
+            continue;
+        if (_FIsIaevTag(_pggaev, iaev, &ptag))
+            TAGM::CloseTag(ptag);
+    }
+    _pggaev->Unlock();
+
+    // The middle events' tags move with them
+    SwapVars(&_pggaev, &pggaev);
+    SwapVars(&_pglrpt, &pglrpt);
+    ReleasePpo(&pggaev);
+    ReleasePpo(&pglrpt);
+    _adlt = adlt;
+    _fDelta = fTrue;
+    return fTrue;
+
+LFail:
+    ReleasePpo(&pggaev);
+    ReleasePpo(&pglrpt);
+    return fFalse;
+}
+
+/***************************************************************************
+
+    Rebuild a delta undo snapshot from pactrBase, which must look the way
+    it did when FMakeDelta was called.  Returns fFalse if it doesn't or we
+    ran out of memory; the snapshot is still a delta in that case.
+
+***************************************************************************/
+bool ACTR::FApplyDelta(PACTR pactrBase)
+{
+    AssertThis(0);
+    AssertPo(pactrBase, 0);
+    Assert(!pactrBase->_fDelta, "Delta base is a delta");
+
+    long caevMid, crptMid, caevTail;
+    long iaev;
+    PTAG ptag;
+    PGG pggaev = pvNil;
+    PGL pglrpt = pvNil;
+
+    if (!_fDelta)
+        return fTrue;
+
+    if (pactrBase->_pggaev->IvMac() != _adlt.caevBase || pactrBase->_pglrpt->IvMac() != _adlt.crptBase ||
+        _LuCheckRuns(pactrBase, &_adlt) != _adlt.luCheck)
+    {
+        // the base was changed without an undo record
+        return fFalse;
+    }
+
+    caevMid = _pggaev->IvMac();
+    crptMid = _pglrpt->IvMac();
+    if (pvNil == (pggaev = GG::PggNew(size(AEV), _adlt.caevHead + caevMid + _adlt.caevTail, kcbVarAdd)))
+        goto LFail;
+    if (!pggaev->FCopyEntries(pactrBase->_pggaev, 0, 0, _adlt.caevHead) ||
+        !pggaev->FCopyEntries(_pggaev, 0, _adlt.caevHead, caevMid) ||
+        !pggaev->FCopyEntries(pactrBase->_pggaev, _adlt.caevBase - _adlt.caevTail, _adlt.caevHead + caevMid,
+                              _adlt.caevTail))
+    {
+        goto LFail;
+    }
+
+    if (pvNil == (pglrpt = GL::PglNew(size(RPT), kcrptGrow)))
+        goto LFail;
+    pglrpt->SetMinGrow(kcrptGrow);
+    if (!pglrpt->FSetIvMac(_adlt.crptHead + crptMid + _adlt.crptTail))
+        goto LFail;
+    if (_adlt.crptHead > 0)
+        CopyPb(pactrBase->_pglrpt->QvGet(0), pglrpt->QvGet(0), LwMul(_adlt.crptHead, size(RPT)));
+    if (crptMid > 0)
+        CopyPb(_pglrpt->QvGet(0), pglrpt->QvGet(_adlt.crptHead), LwMul(crptMid, size(RPT)));
+    if (_adlt.crptTail > 0)
+    {
+        CopyPb(pactrBase->_pglrpt->QvGet(_adlt.crptBase - _adlt.crptTail),
+               pglrpt->QvGet(_adlt.crptHead + crptMid), LwMul(_adlt.crptTail, size(RPT)));
+    }
+
+    // Reopen the tags of the events that came from the base
+    caevTail = pggaev->IvMac() - _adlt.caevTail;
+    pggaev->Lock();
+    for (iaev = 0; iaev < pggaev->IvMac(); iaev++)
+    {
+        if (iaev >= _adlt.caevHead && iaev < caevTail)
+            continue;
+        if (_FIsIaevTag(pggaev, iaev, &ptag))
+            TAGM::DupTag(ptag);
+    }
+    pggaev->Unlock();
+
+    SwapVars(&_pggaev, &pggaev);
+    SwapVars(&_pglrpt, &pglrpt);
+    ReleasePpo(&pggaev);
+    ReleasePpo(&pglrpt);
+    _fDelta = fFalse;
+    AssertThis(0);
+    return fTrue;
+
+LFail:
+    ReleasePpo(&pggaev);
+    ReleasePpo(&pglrpt);
+    return fFalse;
+}
+
+/***************************************************************************
+
+    Return whether event iaev1 of pggaev1 is the same as event iaev2 of
+    pggaev2, byte for byte.
+
+***************************************************************************/
+bool ACTR::_FEqualAev(PGG pggaev1, long iaev1, PGG pggaev2, long iaev2)
+{
+    AssertPo(pggaev1, 0);
+    AssertPo(pggaev2, 0);
+
+    long cb = pggaev1->Cb(iaev1);
+
+    if (cb != pggaev2->Cb(iaev2))
+        return fFalse;
+    if (!FEqualRgb(pggaev1->QvFixedGet(iaev1), pggaev2->QvFixedGet(iaev2), size(AEV)))
+        return fFalse;
+    return cb == 0 || FEqualRgb(pggaev1->QvGet(iaev1), pggaev2->QvGet(iaev2), cb);
+}
+
+/***************************************************************************
+
+    Checksum the runs of pactrBase's events and route that padlt says are
+    shared with a delta.
+
+***************************************************************************/
+ulong ACTR::_LuCheckRuns(PACTR pactrBase, ADLT *padlt)
+{
+    AssertPo(pactrBase, 0);
+    AssertVarMem(padlt);
+
+    ulong lu = 0;
+    long iaev, cb;
+    PGG pggaev = pactrBase->_pggaev;
+    PGL pglrpt = pactrBase->_pglrpt;
+
+    pggaev->Lock();
+    for (iaev = 0; iaev < pggaev->IvMac(); iaev++)
+    {
+        if (iaev == padlt->caevHead)
+            iaev = LwMax(iaev, pggaev->IvMac() - padlt->caevTail);
+        if (iaev >= pggaev->IvMac())
+            break;
+        lu = _LuMixRgb(lu, pggaev->QvFixedGet(iaev), size(AEV));
+        if ((cb = pggaev->Cb(iaev)) > 0)
+            lu = _LuMixRgb(lu, pggaev->QvGet(iaev), cb);
+    }
+    pggaev->Unlock();
+
+    if (padlt->crptHead > 0)
+        lu = _LuMixRgb(lu, pglrpt->QvGet(0), LwMul(padlt->crptHead, size(RPT)));
+    if (padlt->crptTail > 0)
+    {
+        lu = _LuMixRgb(lu, pglrpt->QvGet(pglrpt->IvMac() - padlt->crptTail), LwMul(padlt->crptTail, size(RPT)));
+    }
+    return lu;
+}
+
+/***************************************************************************
+
+    Return roughly how much memory the actor's event, route and sound
+    groups take.  Used to size the undo list.
+
+***************************************************************************/
+long ACTR::CbMem(void)
+{
+    AssertThis(0);
+
+    long cb = size(ACTR);
+
+    cb += _pggaev->CbOnFile() + _pglrpt->CbOnFile() + _pglsmm->CbOnFile();
+    if (hqNil != _hqRte)
+        cb += CbOfHq(_hqRte);
+    if (pvNil != _pggakf)
+        cb += _pggakf->CbOnFile();
+    return cb;
+}
+
 /***************************************************************************
 
     Duplicate the indicated portion of the route from this frame on
@@ -1469,6 +1760,16 @@ bool AUND::FUndo(PDOCB pdocb)
         pactr->AddRef();
     }
 
+    //
+    // A buried undo only holds what differs from the actor as it is now
+    //
+    if (_pactr != pvNil && _pactr->FDelta() && (pactr == pvNil || !_pactr->FApplyDelta(pactr)))
+    {
+        ReleasePpo(&pactr);
+        _pmvie->ClearUndo();
+        return (fFalse);
+    }
+
     //
     // Have scene replace the old actor with this one
     //
@@ -1555,6 +1856,77 @@ void AUND::SetPactr(PACTR pactr)
     pactr->AddRef();
 }
 
+/****************************************************
+ * Return roughly how much memory this undo holds.
+ *
+ * Parameters:
+ * 	None.
+ *
+ * Returns:
+ *  Bytes held.
+ *
+ ****************************************************/
+long AUND::CbMem(void)
+{
+    AssertThis(0);
+
+    if (_pactr == pvNil)
+        return size(AUND);
+    return size(AUND) + _pactr->CbMem();
+}
+
+/****************************************************
+ * Return the whole actor this undo puts back.
+ *
+ * Parameters:
+ * 	None.
+ *
+ * Returns:
+ *  The actor, or pvNil if there isn't one or it is
+ *  only held as a delta.
+ *
+ ****************************************************/
+PACTR AUND::PactrUndo(void)
+{
+    AssertThis(0);
+
+    if (_pactr == pvNil || _pactr->FDelta())
+        return pvNil;
+    return _pactr;
+}
+
+/****************************************************
+ * Another undo is going on top of this one.  If it
+ * puts back the same actor, that actor is exactly
+ * what the scene will hold when this undo is next
+ * used, so keep only what differs from it.
+ *
+ * Parameters:
+ * 	pmunbNext - The undo going on top.
+ *
+ * Returns:
+ *  None.
+ *
+ ****************************************************/
+void AUND::Bury(PMUNB pmunbNext)
+{
+    AssertThis(0);
+    AssertPo(pmunbNext, 0);
+
+    PACTR pactrBase;
+
+    // Don't touch a snapshot someone else is still using
+    if (_pactr == pvNil || _pactr->CactRef() > 1 || _pactr->Arid() != _arid)
+        return;
+
+    pactrBase = pmunbNext->PactrUndo();
+    if (pactrBase == pvNil || pactrBase->Arid() != _arid || pmunbNext->Iscen() != _iscen)
+        return;
+
+    // On failure the snapshot just stays whole
+    _pactr->FMakeDelta(pactrBase);
+}
+
 #ifdef DEBUG
 /****************************************************
  * Mark memory used by the AUND
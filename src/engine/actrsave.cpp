@@ -16,6 +16,9 @@
      |
      +---GGAE (chid 0) // _pggaev (actor events)
 
+    PATH and GGAE are written in the compact encoding described at ACZF.
+    Chunks written as a plain GL and GG are still read.
+
 
 ***************************************************************************/
 #include "soc.h"
@@ -36,6 +39,453 @@ struct ACTF // Actor chunk on file
 };
 const BOM kbomActf = 0x5ffc0000 | kbomTag;
 
+/***************************************************************************
+    Compact PATH and GGAE chunks.  Stored as a GL and a GG, every route
+    point costs four longs and every cel step of a recorded walk adds an
+    event, so long walks make big movies.  The compact chunks store each
+    long as a zigzag varint of its delta from the previous route point or
+    event (for an event's variable part, the previous event of the same
+    type with the same size), so a steady walk takes a few bytes a step.
+    The varints are byte order independent except for the events'
+    variable parts, which are the writer's longs and are swapped by their
+    BOMs like the GG's.  The signature sits where a GL keeps its cbEntry
+    and a GG its ilocMac, neither of which can take that value, so old
+    chunks are recognized and read as before.
+***************************************************************************/
+struct ACZF // Actor Compact chunk on File
+{
+    short bo;   // Byte order
+    short osk;  // OS kind
+    long lwSig; // klwSigRte or klwSigAev; the digit is the encoding version
+    long cv;    // Number of route points or events
+    long cbVar; // Total size of the events' variable parts
+};
+const BOM kbomAczf = 0x5fc00000;
+
+const long klwSigRte = 'RTZ1';
+const long klwSigAev = 'AEZ1';
+
+const long kcbLwzMax = (size(long) * 8 + 6) / 7;      // Most bytes a varint takes
+const long kclwRpt = size(RPT) / size(long);          // Varints per route point
+const long kclwAevFixed = 6;                          // Varints per AEV, plus the var part
+const long kclwAevVarMax = size(BMAT34) / size(long); // Largest AEV var part
+
+/***************************************************************************
+    Write lw at pb as a zigzag varint and return the number of bytes used.
+***************************************************************************/
+priv long _CbPutLwz(byte *pb, long lw)
+{
+    ulong lu = ((ulong)lw << 1) ^ (ulong)(lw >> (size(long) * 8 - 1));
+    long cb = 0;
+
+    while (lu >= 0x80)
+    {
+        pb[cb++] = (byte)(lu | 0x80);
+        lu >>= 7;
+    }
+    pb[cb++] = (byte)lu;
+    return cb;
+}
+
+/***************************************************************************
+    Read a zigzag varint at *ppb, not reading at or beyond pbLim, and
+    advance *ppb past it.
+***************************************************************************/
+priv bool _FGetLwz(byte **ppb, byte *pbLim, long *plw)
+{
+    ulong lu = 0;
+    long cbit;
+    byte b;
+
+    for (cbit = 0;; cbit += 7)
+    {
+        if (*ppb >= pbLim || cbit >= size(long) * 8)
+            return fFalse;
+        b = *(*ppb)++;
+        lu |= (ulong)(b & 0x7F) << cbit;
+        if (!(b & 0x80))
+            break;
+    }
+    *plw = (long)(lu >> 1) ^ -(long)(lu & 1);
+    return fTrue;
+}
+
+/***************************************************************************
+    Deltas are taken in unsigned arithmetic so that wild values wrap
+    rather than overflow.
+***************************************************************************/
+priv long _LwDelta(long lw, long lwPrev)
+{
+    return (long)((ulong)lw - (ulong)lwPrev);
+}
+
+priv long _LwUndelta(long dlw, long lwPrev)
+{
+    return (long)((ulong)lwPrev + (ulong)dlw);
+}
+
+/***************************************************************************
+    If the cb bytes at pv start with a compact chunk header with the given
+    signature, put it in *paczf and return true.  paczf->bo is left as the
+    writer's byte order.
+***************************************************************************/
+priv bool _FGetAczf(void *pv, long cb, long lwSig, ACZF *paczf)
+{
+    AssertPvCb(pv, cb);
+    AssertVarMem(paczf);
+
+    short bo;
+
+    if (cb < size(ACZF))
+        return fFalse;
+    CopyPb(pv, paczf, size(ACZF));
+    bo = paczf->bo;
+    if (kboOther == bo)
+        SwapBytesBom(paczf, kbomAczf);
+    if (kboCur != paczf->bo || lwSig != paczf->lwSig)
+        return fFalse;
+    paczf->bo = bo;
+    return fTrue;
+}
+
+/***************************************************************************
+    Return whether the (unpacked) chunk in pblck is a compact chunk with
+    the given signature.
+***************************************************************************/
+priv bool _FIsCompact(PBLCK pblck, long lwSig)
+{
+    AssertPo(pblck, fblckUnpacked);
+
+    byte rgb[size(ACZF)];
+    ACZF aczf;
+
+    if (pblck->Cb() < size(ACZF) || !pblck->FReadRgb(rgb, size(ACZF), 0))
+        return fFalse;
+    return _FGetAczf(rgb, size(ACZF), lwSig, &aczf);
+}
+
+/***************************************************************************
+    Encode the route pglrpt as a compact PATH chunk in a new hq.
+***************************************************************************/
+priv bool _FEncodeRte(PGL pglrpt, HQ *phq)
+{
+    AssertPo(pglrpt, 0);
+    AssertVarMem(phq);
+
+    ACZF aczf;
+    long rglwPrev[kclwRpt];
+    long *plw;
+    byte *pb;
+    long cb, ilw, irpt;
+
+    AssertBomRglw(kbomRpt, size(RPT));
+    aczf.bo = kboCur;
+    aczf.osk = koskCur;
+    aczf.lwSig = klwSigRte;
+    aczf.cv = pglrpt->IvMac();
+    aczf.cbVar = 0;
+    if (!FAllocHq(phq, size(ACZF) + LwMul(aczf.cv, kclwRpt * kcbLwzMax), fmemNil, mprNormal))
+        return fFalse;
+
+    pb = (byte *)PvLockHq(*phq);
+    CopyPb(&aczf, pb, size(ACZF));
+    cb = size(ACZF);
+    ClearPb(rglwPrev, size(rglwPrev));
+    plw = (long *)pglrpt->PvLock(0);
+    for (irpt = 0; irpt < aczf.cv; irpt++)
+    {
+        for (ilw = 0; ilw < kclwRpt; ilw++, plw++)
+        {
+            cb += _CbPutLwz(pb + cb, _LwDelta(*plw, rglwPrev[ilw]));
+            rglwPrev[ilw] = *plw;
+        }
+    }
+    pglrpt->Unlock();
+    UnlockHq(*phq);
+
+    AssertDo(FResizePhq(phq, cb, fmemNil, mprNormal), "shrinking failed");
+    return fTrue;
+}
+
+/***************************************************************************
+    Decode the compact PATH chunk in the cb bytes at prgb into pglrpt,
+    which must be empty.
+***************************************************************************/
+priv bool _FDecodeRte(byte *prgb, long cb, PGL pglrpt)
+{
+    AssertPvCb(prgb, cb);
+    AssertPo(pglrpt, 0);
+    Assert(0 == pglrpt->IvMac(), "route not empty");
+
+    ACZF aczf;
+    long rglwPrev[kclwRpt];
+    long *plw;
+    long *plwLim;
+    byte *pb = prgb + size(ACZF);
+    byte *pbLim = prgb + cb;
+    long ilw;
+    long dlw;
+
+    // Every long takes at least one byte
+    if (!_FGetAczf(prgb, cb, klwSigRte, &aczf) || !FIn(aczf.cv, 0, (cb - size(ACZF)) / kclwRpt + 1))
+        goto LBug;
+    if (0 == aczf.cv)
+    {
+        if (pb != pbLim)
+            goto LBug;
+        return fTrue;
+    }
+    if (!pglrpt->FSetIvMac(aczf.cv))
+        return fFalse;
+
+    ClearPb(rglwPrev, size(rglwPrev));
+    plw = (long *)pglrpt->PvLock(0);
+    plwLim = plw + LwMul(aczf.cv, kclwRpt);
+    for (ilw = 0; plw < plwLim; plw++)
+    {
+        if (!_FGetLwz(&pb, pbLim, &dlw))
+            break;
+        *plw = rglwPrev[ilw] = _LwUndelta(dlw, rglwPrev[ilw]);
+        if (++ilw == kclwRpt)
+            ilw = 0;
+    }
+    pglrpt->Unlock();
+    if (plw == plwLim && pb == pbLim)
+        return fTrue;
+    pglrpt->FSetIvMac(0);
+
+LBug:
+    Bug("Corrupt compact route");
+    return fFalse;
+}
+
+/***************************************************************************
+    SwapBytes the variable part of an event of type aet.
+***************************************************************************/
+priv void _SwapBytesAevVar(long aet, void *pvVar)
+{
+    switch (aet)
+    {
+    case aetCost:
+        SwapBytesBom(pvVar, kbomAevcost);
+        break;
+    case aetSnd:
+        SwapBytesBom(pvVar, kbomAevsnd);
+        break;
+    case aetSize:
+        SwapBytesBom(pvVar, kbomAevsize);
+        break;
+    case aetPull:
+        SwapBytesBom(pvVar, kbomAevpull);
+        break;
+    case aetRotF:
+    case aetRotH:
+        SwapBytesBom(pvVar, kbomAevrot);
+        break;
+    case aetActn:
+        SwapBytesBom(pvVar, kbomAevactn);
+        break;
+    case aetAdd:
+        SwapBytesBom(pvVar, kbomAevadd);
+        break;
+    case aetFreeze:
+        SwapBytesBom(pvVar, kbomAevfreeze);
+        break;
+    case aetMove:
+        SwapBytesBom(pvVar, kbomAevmove);
+        break;
+    case aetTweak:
+        SwapBytesBom(pvVar, kbomAevtweak);
+        break;
+    case aetStep:
+        SwapBytesBom(pvVar, kbomAevstep);
+        break;
+    case aetRem:
+        // no var data
+        break;
+    default:
+        Bug("Unknown AET");
+        break;
+    }
+}
+
+/***************************************************************************
+    Encode the event list pggaev as a compact GGAE chunk in a new hq.
+***************************************************************************/
+priv bool _FEncodeAev(PGG pggaev, HQ *phq)
+{
+    AssertPo(pggaev, 0);
+    AssertVarMem(phq);
+
+    ACZF aczf;
+    AEV aevPrev;
+    AEV *paev;
+    long rgcbPrev[aetLim];
+    long rgrglwPrev[aetLim][kclwAevVarMax];
+    long *plw;
+    byte *pb;
+    long cb, cbVar, clw, ilw, iaev;
+    bool fDelta;
+    bool fRet = fTrue;
+
+    aczf.bo = kboCur;
+    aczf.osk = koskCur;
+    aczf.lwSig = klwSigAev;
+    aczf.cv = pggaev->IvMac();
+    aczf.cbVar = 0;
+    for (iaev = 0; iaev < aczf.cv; iaev++)
+        aczf.cbVar += pggaev->Cb(iaev);
+    cb = size(ACZF) + LwMul(aczf.cv, kclwAevFixed * kcbLwzMax) + LwMul(aczf.cbVar / size(long), kcbLwzMax);
+    if (!FAllocHq(phq, cb, fmemNil, mprNormal))
+        return fFalse;
+
+    pb = (byte *)PvLockHq(*phq);
+    CopyPb(&aczf, pb, size(ACZF));
+    cb = size(ACZF);
+    ClearPb(&aevPrev, size(AEV));
+    for (long aet = 0; aet < aetLim; aet++)
+        rgcbPrev[aet] = ivNil;
+
+    pggaev->Lock();
+    for (iaev = 0; iaev < aczf.cv; iaev++)
+    {
+        paev = (AEV *)pggaev->QvFixedGet(iaev);
+        cbVar = pggaev->Cb(iaev);
+        if (!FIn(paev->aet, 0, aetLim) || cbVar % size(long) != 0 || cbVar > size(rgrglwPrev[0]))
+        {
+            Bug("Unknown AET or bad var size");
+            fRet = fFalse;
+            break;
+        }
+
+        cb += _CbPutLwz(pb + cb, paev->aet);
+        cb += _CbPutLwz(pb + cb, _LwDelta(paev->nfrm, aevPrev.nfrm));
+        cb += _CbPutLwz(pb + cb, _LwDelta(paev->rtel.irpt, aevPrev.rtel.irpt));
+        cb += _CbPutLwz(pb + cb, paev->rtel.dwrOffset);
+        cb += _CbPutLwz(pb + cb, paev->rtel.dnfrm);
+        cb += _CbPutLwz(pb + cb, cbVar);
+        aevPrev = *paev;
+
+        clw = cbVar / size(long);
+        fDelta = (cbVar == rgcbPrev[paev->aet]);
+        plw = (long *)pggaev->QvGet(iaev);
+        for (ilw = 0; ilw < clw; ilw++)
+        {
+            cb += _CbPutLwz(pb + cb, _LwDelta(plw[ilw], fDelta ? rgrglwPrev[paev->aet][ilw] : 0));
+            rgrglwPrev[paev->aet][ilw] = plw[ilw];
+        }
+        rgcbPrev[paev->aet] = cbVar;
+    }
+    pggaev->Unlock();
+    UnlockHq(*phq);
+
+    if (!fRet)
+    {
+        FreePhq(phq);
+        return fFalse;
+    }
+    AssertDo(FResizePhq(phq, cb, fmemNil, mprNormal), "shrinking failed");
+    return fTrue;
+}
+
+/***************************************************************************
+    Decode the compact GGAE chunk in the cb bytes at prgb into a new GG.
+***************************************************************************/
+priv PGG _PggaevDecode(byte *prgb, long cb)
+{
+    AssertPvCb(prgb, cb);
+
+    ACZF aczf;
+    AEV aev;
+    long rgcbPrev[aetLim];
+    long rgrglwPrev[aetLim][kclwAevVarMax];
+    long rglw[kclwAevVarMax];
+    byte *pb = prgb + size(ACZF);
+    byte *pbLim = prgb + cb;
+    long cbVar, clw, ilw, iaev;
+    long lw;
+    bool fDelta;
+    PGG pggaev = pvNil;
+
+    // Every event takes at least kclwAevFixed bytes
+    if (!_FGetAczf(prgb, cb, klwSigAev, &aczf) || !FIn(aczf.cv, 0, (cb - size(ACZF)) / kclwAevFixed + 1) ||
+        !FIn(aczf.cbVar, 0, LwMul(cb - size(ACZF), size(long)) + 1))
+    {
+        goto LBug;
+    }
+    if (pvNil == (pggaev = GG::PggNew(size(AEV), aczf.cv, aczf.cbVar)))
+        return pvNil;
+
+    ClearPb(&aev, size(AEV));
+    for (long aet = 0; aet < aetLim; aet++)
+        rgcbPrev[aet] = ivNil;
+
+    for (iaev = 0; iaev < aczf.cv; iaev++)
+    {
+        if (!_FGetLwz(&pb, pbLim, &aev.aet) || !FIn(aev.aet, 0, aetLim) || !_FGetLwz(&pb, pbLim, &lw))
+            goto LBug;
+        aev.nfrm = _LwUndelta(lw, aev.nfrm);
+        if (!_FGetLwz(&pb, pbLim, &lw))
+            goto LBug;
+        aev.rtel.irpt = _LwUndelta(lw, aev.rtel.irpt);
+        if (!_FGetLwz(&pb, pbLim, &lw))
+            goto LBug;
+        aev.rtel.dwrOffset = lw;
+        if (!_FGetLwz(&pb, pbLim, &aev.rtel.dnfrm) || !_FGetLwz(&pb, pbLim, &cbVar) ||
+            !FIn(cbVar, 0, size(rglw) + 1) || cbVar % size(long) != 0)
+        {
+            goto LBug;
+        }
+
+        clw = cbVar / size(long);
+        fDelta = (cbVar == rgcbPrev[aev.aet]);
+        for (ilw = 0; ilw < clw; ilw++)
+        {
+            if (!_FGetLwz(&pb, pbLim, &lw))
+                goto LBug;
+            rglw[ilw] = _LwUndelta(lw, fDelta ? rgrglwPrev[aev.aet][ilw] : 0);
+            rgrglwPrev[aev.aet][ilw] = rglw[ilw];
+        }
+        rgcbPrev[aev.aet] = cbVar;
+
+        // The var part is the writer's longs: restore the writer's bytes,
+        // then swap them the way an old GGAE is swapped
+        if (kboOther == aczf.bo)
+        {
+            SwapBytesRglw(rglw, clw);
+            _SwapBytesAevVar(aev.aet, rglw);
+        }
+        if (!pggaev->FAdd(cbVar, pvNil, rglw, &aev))
+        {
+            ReleasePpo(&pggaev);
+            return pvNil;
+        }
+    }
+    if (pb == pbLim)
+        return pggaev;
+
+LBug:
+    Bug("Corrupt compact event list");
+    ReleasePpo(&pggaev);
+    return pvNil;
+}
+
+/***************************************************************************
+    Add a child of the given ACTR chunk holding the data in hq.
+***************************************************************************/
+priv bool _FAddChildHq(PCFL pcfl, CNO cnoActr, CHID chid, CTG ctg, HQ hq)
+{
+    AssertPo(pcfl, 0);
+    AssertHq(hq);
+
+    CNO cno;
+    BLCK blck;
+
+    if (!pcfl->FAddChild(kctgActr, cnoActr, chid, CbOfHq(hq), ctg, &cno, &blck))
+        return fFalse;
+    return blck.FWriteHq(hq, 0);
+}
+
 /***************************************************************************
     Write the actor out to disk.  Store the root chunk in the given CNO.
     If this function returns false, it is the client's responsibility to
@@ -47,10 +497,9 @@ bool ACTR::FWrite(PCFL pcfl, CNO cnoActr, CNO cnoScene)
     AssertPo(pcfl, 0);
 
     ACTF actf;
-    CNO cnoPath;
-    CNO cnoGgae;
     CNO cnoTmpl;
-    BLCK blck;
+    HQ hq;
+    bool fRet;
     KID kid;
     long iaev;
     AEV *paev;
@@ -102,20 +551,24 @@ bool ACTR::FWrite(PCFL pcfl, CNO cnoActr, CNO cnoScene)
     if (!pcfl->FPutPv(&actf, size(ACTF), kctgActr, cnoActr))
         return fFalse;
 
-    // Now write the PATH chunk:
-    if (!pcfl->FAddChild(kctgActr, cnoActr, kchidPath, _pglrpt->CbOnFile(), kctgPath, &cnoPath, &blck))
-    {
+    // Now write the PATH chunk.  A route that was never decoded goes back
+    // out as it was read.
+    if (hqNil != _hqRte)
+        hq = _hqRte;
+    else if (!_FEncodeRte(_pglrpt, &hq))
         return fFalse;
-    }
-    if (!_pglrpt->FWrite(&blck))
+    fRet = _FAddChildHq(pcfl, cnoActr, kchidPath, kctgPath, hq);
+    if (hq != _hqRte)
+        FreePhq(&hq);
+    if (!fRet)
         return fFalse;
 
     // Now write the GGAE chunk:
-    if (!pcfl->FAddChild(kctgActr, cnoActr, kchidGgae, _pggaev->CbOnFile(), kctgGgae, &cnoGgae, &blck))
-    {
+    if (!_FEncodeAev(_pggaev, &hq))
         return fFalse;
-    }
-    if (!_pggaev->FWrite(&blck))
+    fRet = _FAddChildHq(pcfl, cnoActr, kchidGgae, kctgGgae, hq);
+    FreePhq(&hq);
+    if (!fRet)
         return fFalse;
 
     // Adopt actor sounds into the scene
@@ -322,8 +775,15 @@ bool ACTR::_FReadRoute(PCFL pcfl, CNO cno)
     BLCK blck;
     short bo;
 
-    if (!pcfl->FFind(kctgPath, cno, &blck))
+    if (!pcfl->FFind(kctgPath, cno, &blck) || !blck.FUnpackData())
         return fFalse;
+    if (_FIsCompact(&blck, klwSigRte))
+    {
+        // Keep the encoded route until the actor is first shown
+        if (pvNil == (_pglrpt = GL::PglNew(size(RPT))))
+            return fFalse;
+        return blck.FReadHq(&_hqRte);
+    }
     _pglrpt = GL::PglRead(&blck, &bo);
     if (pvNil == _pglrpt)
         return fFalse;
@@ -344,18 +804,66 @@ bool ACTR::_FReadEvents(PCFL pcfl, CNO cno)
     AssertPo(pcfl, 0);
 
     BLCK blck;
-    short bo;
 
     if (!pcfl->FFind(kctgGgae, cno, &blck))
         return fFalse;
-    _pggaev = GG::PggRead(&blck, &bo);
-    if (pvNil == _pggaev)
+    _pggaev = _PggaevRead(&blck);
+    return pvNil != _pggaev;
+}
+
+/***************************************************************************
+    Decode the compact route read by _FReadRoute into _pglrpt, if that
+    hasn't happened yet.  Events hold tags that must be opened when the
+    actor is read, but the route isn't needed until the actor is first
+    shown, and an actor saved again untouched writes it back as read.
+***************************************************************************/
+bool ACTR::_FEnsureRte(void)
+{
+    AssertBaseThis(0);
+
+    bool fRet;
+
+    if (hqNil == _hqRte)
+        return fTrue;
+
+    fRet = _FDecodeRte((byte *)PvLockHq(_hqRte), CbOfHq(_hqRte), _pglrpt);
+    UnlockHq(_hqRte);
+    if (!fRet)
         return fFalse;
-    if (kboOther == bo)
-        _SwapBytesPggaev(_pggaev);
+    FreePhq(&_hqRte);
+    _pglrpt->SetMinGrow(kcrptGrow);
     return fTrue;
 }
 
+/***************************************************************************
+    Read an event list from a GGAE chunk in either encoding.
+***************************************************************************/
+PGG ACTR::_PggaevRead(PBLCK pblck)
+{
+    AssertPo(pblck, 0);
+
+    PGG pggaev;
+    HQ hq;
+    short bo;
+
+    if (!pblck->FUnpackData())
+        return pvNil;
+    if (_FIsCompact(pblck, klwSigAev))
+    {
+        if (!pblck->FReadHq(&hq))
+            return pvNil;
+        pggaev = _PggaevDecode((byte *)PvLockHq(hq), CbOfHq(hq));
+        UnlockHq(hq);
+        FreePhq(&hq);
+        return pggaev;
+    }
+
+    pggaev = GG::PggRead(pblck, &bo);
+    if (pvNil != pggaev && kboOther == bo)
+        _SwapBytesPggaev(pggaev);
+    return pggaev;
+}
+
 /***************************************************************************
     SwapBytes all events in pggaev
 ***************************************************************************/
@@ -368,49 +876,7 @@ void ACTR::_SwapBytesPggaev(PGG pggaev)
     for (iaev = 0; iaev < pggaev->IvMac(); iaev++)
     {
         SwapBytesBom(pggaev->QvFixedGet(iaev), kbomAev);
-        switch (((AEV *)pggaev->QvFixedGet(iaev))->aet)
-        {
-        case aetCost:
-            SwapBytesBom(pggaev->QvGet(iaev), kbomAevcost);
-            break;
-        case aetSnd:
-            SwapBytesBom(pggaev->QvGet(iaev), kbomAevsnd);
-            break;
-        case aetSize:
-            SwapBytesBom(pggaev->QvGet(iaev), kbomAevsize);
-            break;
-        case aetPull:
-            SwapBytesBom(pggaev->QvGet(iaev), kbomAevpull);
-            break;
-        case aetRotF:
-        case aetRotH:
-            SwapBytesBom(pggaev->QvGet(iaev), kbomAevrot);
-            break;
-        case aetActn:
-            SwapBytesBom(pggaev->QvGet(iaev), kbomAevactn);
-            break;
-        case aetAdd:
-            SwapBytesBom(pggaev->QvGet(iaev), kbomAevadd);
-            break;
-        case aetFreeze:
-            SwapBytesBom(pggaev->QvGet(iaev), kbomAevfreeze);
-            break;
-        case aetMove:
-            SwapBytesBom(pggaev->QvGet(iaev), kbomAevmove);
-            break;
-        case aetTweak:
-            SwapBytesBom(pggaev->QvGet(iaev), kbomAevtweak);
-            break;
-        case aetStep:
-            SwapBytesBom(pggaev->QvGet(iaev), kbomAevstep);
-            break;
-        case aetRem:
-            // no var data
-            break;
-        default:
-            Bug("Unknown AET");
-            break;
-        }
+        _SwapBytesAevVar(((AEV *)pggaev->QvFixedGet(iaev))->aet, pggaev->QvGet(iaev));
     }
 }
 
@@ -485,7 +951,6 @@ PGL ACTR::PgltagFetch(PCFL pcfl, CNO cno, bool *pfError)
 
     ACTF actf;
     BLCK blck;
-    short bo;
     PTAG ptag;
     PGL pgltag;
     PGG pggaev = pvNil;
@@ -547,11 +1012,9 @@ PGL ACTR::PgltagFetch(PCFL pcfl, CNO cno, bool *pfError)
         goto LFail;
     if (!pcfl->FFind(kctgGgae, kid.cki.cno, &blck))
         goto LFail;
-    pggaev = GG::PggRead(&blck, &bo);
+    pggaev = _PggaevRead(&blck);
     if (pvNil == pggaev)
         goto LFail;
-    if (kboOther == bo)
-        _SwapBytesPggaev(pggaev);
     pggaev->Lock();
     for (iaev = 0; iaev < pggaev->IvMac(); iaev++)
     {
@@ -622,3 +1085,156 @@ bool ACTR::_FIsIaevTag(PGG pggaev, long iaev, PTAG *pptag, PAEV *pqaev)
     *pptag = pvNil;
     return fFalse;
 }
+
+#ifdef DEBUG
+/***************************************************************************
+    Load benchmark.  For every actor in pcfl, reads the route and events
+    (in whichever encoding they are on file), builds both the old GL/GG
+    chunks and the compact ones in memory, and times reading each back
+    cact times.  The compact times include decoding the whole route,
+    which PactrRead itself leaves until the actor is first shown.
+    Returns the number of actors, the total chunk sizes (before any
+    compression by the packer) and the read times for both encodings.
+***************************************************************************/
+bool ACTR::FBenchLoad(PCFL pcfl, long cact, long *pcactr, long *pcbOld, long *pcbNew, ulong *pdtsOld,
+                      ulong *pdtsNew)
+{
+    AssertPo(pcfl, 0);
+    AssertIn(cact, 1, klwMax);
+    AssertVarMem(pcactr);
+    AssertVarMem(pcbOld);
+    AssertVarMem(pcbNew);
+    AssertVarMem(pdtsOld);
+    AssertVarMem(pdtsNew);
+
+    bool fRet = fFalse;
+    bool fOk;
+    long icki, iact, iaev;
+    CKI cki;
+    KID kidPath, kidGgae;
+    BLCK blck, blckRte, blckAev;
+    HQ hqRte = hqNil;
+    HQ hqAev = hqNil;
+    PGL pglrpt = pvNil;
+    PGG pggaev = pvNil;
+    PGL pglrptT;
+    PGG pggaevT;
+    ulong ts;
+    short bo;
+
+    *pcactr = *pcbOld = *pcbNew = 0;
+    *pdtsOld = *pdtsNew = 0;
+    for (icki = 0; pcfl->FGetCkiCtg(kctgActr, icki, &cki); icki++)
+    {
+        if (!pcfl->FGetKidChidCtg(kctgActr, cki.cno, kchidPath, kctgPath, &kidPath) ||
+            !pcfl->FGetKidChidCtg(kctgActr, cki.cno, kchidGgae, kctgGgae, &kidGgae))
+        {
+            continue;
+        }
+
+        // Read the actor's route and events
+        if (!pcfl->FFind(kctgPath, kidPath.cki.cno, &blck) || !blck.FUnpackData())
+            goto LFail;
+        if (_FIsCompact(&blck, klwSigRte))
+        {
+            if (!blck.FReadHq(&hqRte) || pvNil == (pglrpt = GL::PglNew(size(RPT))))
+                goto LFail;
+            fOk = _FDecodeRte((byte *)PvLockHq(hqRte), CbOfHq(hqRte), pglrpt);
+            UnlockHq(hqRte);
+            FreePhq(&hqRte);
+            if (!fOk)
+                goto LFail;
+        }
+        else
+        {
+            if (pvNil == (pglrpt = GL::PglRead(&blck, &bo)))
+                goto LFail;
+            if (kboOther == bo)
+                SwapBytesRglw(pglrpt->QvGet(0), LwMul(pglrpt->IvMac(), size(RPT) / size(long)));
+        }
+        if (!pcfl->FFind(kctgGgae, kidGgae.cki.cno, &blck) || pvNil == (pggaev = _PggaevRead(&blck)))
+            goto LFail;
+
+        // Build both encodings
+        if (!blckRte.FSetTemp(pglrpt->CbOnFile()) || !pglrpt->FWrite(&blckRte) ||
+            !blckAev.FSetTemp(pggaev->CbOnFile()) || !pggaev->FWrite(&blckAev))
+        {
+            goto LFail;
+        }
+        if (!_FEncodeRte(pglrpt, &hqRte) || !_FEncodeAev(pggaev, &hqAev))
+            goto LFail;
+        *pcbOld += blckRte.Cb() + blckAev.Cb();
+        *pcbNew += CbOfHq(hqRte) + CbOfHq(hqAev);
+
+        // Check that the compact encoding gives back what went in
+        pglrptT = GL::PglNew(size(RPT));
+        if (pvNil == pglrptT)
+            goto LFail;
+        fOk = _FDecodeRte((byte *)PvLockHq(hqRte), CbOfHq(hqRte), pglrptT);
+        UnlockHq(hqRte);
+        pggaevT = _PggaevDecode((byte *)PvLockHq(hqAev), CbOfHq(hqAev));
+        UnlockHq(hqAev);
+        fOk = fOk && pvNil != pggaevT && pglrptT->IvMac() == pglrpt->IvMac() &&
+              pggaevT->IvMac() == pggaev->IvMac() &&
+              (0 == pglrpt->IvMac() ||
+               FEqualRgb(pglrptT->QvGet(0), pglrpt->QvGet(0), LwMul(pglrpt->IvMac(), size(RPT))));
+        for (iaev = 0; fOk && iaev < pggaev->IvMac(); iaev++)
+            fOk = _FEqualAev(pggaev, iaev, pggaevT, iaev);
+        ReleasePpo(&pglrptT);
+        ReleasePpo(&pggaevT);
+        if (!fOk)
+        {
+            Bug("compact encoding didn't round trip");
+            goto LFail;
+        }
+
+        // Time reading the old chunks
+        ts = TsCurrentSystem();
+        for (iact = 0; iact < cact; iact++)
+        {
+            pglrptT = GL::PglRead(&blckRte);
+            pggaevT = GG::PggRead(&blckAev);
+            if (pvNil == pglrptT || pvNil == pggaevT)
+            {
+                ReleasePpo(&pglrptT);
+                ReleasePpo(&pggaevT);
+                goto LFail;
+            }
+            ReleasePpo(&pglrptT);
+            ReleasePpo(&pggaevT);
+        }
+        *pdtsOld += TsCurrentSystem() - ts;
+
+        // Time decoding the compact ones
+        ts = TsCurrentSystem();
+        for (iact = 0; iact < cact; iact++)
+        {
+            pglrptT = GL::PglNew(size(RPT));
+            fOk = pvNil != pglrptT && _FDecodeRte((byte *)PvLockHq(hqRte), CbOfHq(hqRte), pglrptT);
+            UnlockHq(hqRte);
+            pggaevT = _PggaevDecode((byte *)PvLockHq(hqAev), CbOfHq(hqAev));
+            UnlockHq(hqAev);
+            fOk = fOk && pvNil != pggaevT;
+            ReleasePpo(&pglrptT);
+            ReleasePpo(&pggaevT);
+            if (!fOk)
+                goto LFail;
+        }
+        *pdtsNew += TsCurrentSystem() - ts;
+
+        FreePhq(&hqRte);
+        FreePhq(&hqAev);
+        ReleasePpo(&pglrpt);
+        ReleasePpo(&pggaev);
+        (*pcactr)++;
+    }
+    fRet = fTrue;
+
+LFail:
+    FreePhq(&hqRte);
+    FreePhq(&hqAev);
+    ReleasePpo(&pglrpt);
+    ReleasePpo(&pggaev);
+    return fRet;
+}
+#endif // DEBUG
@@ -74,6 +74,8 @@ bool ACTR::FSetSndCore(PTAG ptag, tribool fLoop, tribool fQueue, tribool fMotion
     long sqn;
     long cbVar;
 
+    _InvalAkf();
+
     // Verify sound before including in the event list
     pmsnd = (PMSND)vptagm->PbacoFetch(ptag, MSND::FReadMsnd);
     if (pvNil == pmsnd)
@@ -434,6 +436,8 @@ bool ACTR::FSetVlmSnd(long sty, bool fMotionMatch, long vlm)
     SMM smm;
     long nfrmMM = ivNil;
 
+    _InvalAkf();
+
     if (!_ptmpl->FGetCcelActn(_anidCur, &ccel))
         return fFalse;
 
@@ -629,6 +633,8 @@ bool ACTR::FDeleteSndCore(long sty, bool fMotionMatch)
     SMM smm;
     long nfrmMM = ivNil; // For motion match, this may be an earlier frame
 
+    _InvalAkf();
+
     // First the actor event list
     if (!_ptmpl->FGetCcelActn(_anidCur, &ccel))
         return fFalse;
@@ -724,6 +730,8 @@ bool ACTR::FResolveAllSndTags(CNO cnoScen)
     AEVSND aevsnd;
     bool fSuccess = fTrue;
 
+    _InvalAkf();
+
     for (iaev = 0; iaev < _pggaev->IvMac(); iaev++)
     {
         paev = (AEV *)_pggaev->QvFixedGet(iaev);
@@ -95,6 +95,7 @@ bool MODL::_FInit(PBLCK pblck)
     BRV *pbrv;
     long ibrf;
     BRF *pbrf;
+    byte *pbMap;
     MODL *pmodlThis = this;
     char szIdentifier[size(PMODL) + 1];
 
@@ -141,34 +142,46 @@ bool MODL::_FInit(PBLCK pblck)
             return fFalse;
         CopyPb(&pmodlThis, _pbmdl->identifier, size(PMODL));
 
-        _pbmdl->prepared_vertices =
-            (BRV *)BrResAllocate(_pbmdl, LwMul(modlf.cver, size(BRV)), BR_MEMORY_PREPARED_VERTICES);
-        if (pvNil == _pbmdl->prepared_vertices)
-            return fFalse;
-        _pbmdl->prepared_faces = (BRF *)BrResAllocate(_pbmdl, LwMul(modlf.cfac, size(BRF)), BR_MEMORY_PREPARED_FACES);
-        if (pvNil == _pbmdl->prepared_faces)
-            return fFalse;
-
-        if (!pblck->FReadRgb(_pbmdl->prepared_vertices, cbrgbrv, size(MODLF)))
+        // If the chunk is in a memory mapped file and is in our byte
+        // order, BRender can use the prepared data in place.
+        if (kboCur == modlf.bo && pblck->Cb() >= size(MODLF) + cbrgbrv + cbrgbrf &&
+            pvNil != (pbMap = (byte *)pblck->PvMapped(&_pfilMap)))
         {
-            return fFalse;
+            _pbmdl->prepared_vertices = (BRV *)(pbMap + size(MODLF));
+            _pbmdl->prepared_faces = (BRF *)(pbMap + size(MODLF) + cbrgbrv);
         }
-        if (kboOther == modlf.bo)
+        else
         {
-            for (ibrv = 0, pbrv = _pbmdl->prepared_vertices; ibrv < modlf.cver; ibrv++, pbrv++)
+            _pbmdl->prepared_vertices =
+                (BRV *)BrResAllocate(_pbmdl, LwMul(modlf.cver, size(BRV)), BR_MEMORY_PREPARED_VERTICES);
+            if (pvNil == _pbmdl->prepared_vertices)
+                return fFalse;
+            _pbmdl->prepared_faces =
+                (BRF *)BrResAllocate(_pbmdl, LwMul(modlf.cfac, size(BRF)), BR_MEMORY_PREPARED_FACES);
+            if (pvNil == _pbmdl->prepared_faces)
+                return fFalse;
+
+            if (!pblck->FReadRgb(_pbmdl->prepared_vertices, cbrgbrv, size(MODLF)))
             {
-                SwapBytesBom(pbrv, kbomBrv);
+                return fFalse;
             }
-        }
-        if (!pblck->FReadRgb(_pbmdl->prepared_faces, cbrgbrf, size(MODLF) + cbrgbrv))
-        {
-            return fFalse;
-        }
-        if (kboOther == modlf.bo)
-        {
-            for (ibrf = 0, pbrf = _pbmdl->prepared_faces; ibrf < modlf.cfac; ibrf++, pbrf++)
+            if (kboOther == modlf.bo)
+            {
+                for (ibrv = 0, pbrv = _pbmdl->prepared_vertices; ibrv < modlf.cver; ibrv++, pbrv++)
+                {
+                    SwapBytesBom(pbrv, kbomBrv);
+                }
+            }
+            if (!pblck->FReadRgb(_pbmdl->prepared_faces, cbrgbrf, size(MODLF) + cbrgbrv))
+            {
+                return fFalse;
+            }
+            if (kboOther == modlf.bo)
             {
-                SwapBytesBom(pbrf, kbomBrf);
+                for (ibrf = 0, pbrf = _pbmdl->prepared_faces; ibrf < modlf.cfac; ibrf++, pbrf++)
+                {
+                    SwapBytesBom(pbrf, kbomBrf);
+                }
             }
         }
 
@@ -249,8 +262,15 @@ MODL::~MODL(void)
     if (pvNil != _pbmdl)
     {
         BrModelRemove(_pbmdl);
+        if (pvNil != _pfilMap)
+        {
+            // the prepared data isn't a BRender resource
+            _pbmdl->prepared_vertices = pvNil;
+            _pbmdl->prepared_faces = pvNil;
+        }
         BrModelFree(_pbmdl);
     }
+    ReleasePpo(&_pfilMap);
 }
 
 /***************************************************************************
@@ -307,6 +327,9 @@ void MODL::AdjustTdfCharacter(void)
     long cbrv = _pbmdl->nprepared_vertices;
     long ibrv;
 
+    // other MODLs may share the mapped vertices
+    Assert(pvNil == _pfilMap, "can't adjust a mapped MODL");
+
     for (ibrv = 0; ibrv < cbrv; ibrv++)
     {
         _pbmdl->prepared_vertices[ibrv].p.v[0] -= dxr;
@@ -423,6 +446,7 @@ void MODL::AssertValid(ulong grf)
     MODL_PAR::AssertValid(fobjAllocated);
     AssertVarMem(_pbmdl);
     Assert((PMODL) * (long *)_pbmdl->identifier == this, "Bad MODL identifier");
+    AssertNilOrPo(_pfilMap, 0);
 }
 
 /***************************************************************************
@@ -198,7 +198,10 @@ MVIE::MVIE(void) : _clok(khidMvieClock)
     _trans = transNil;
     _vlmOrg = 0;
 
-    SetCundbMax(1);
+    // Buried actor undos only hold what differs from the undo above them
+    // (see AUND::Bury), so many levels fit in _cbUndoMax.
+    _cbUndoMax = kcbUndoMaxMvie;
+    SetCundbMax(kcundbMaxMvie);
 }
 
 /******************************************************************************
@@ -1315,9 +1318,78 @@ LRetry:
     pscen->UpdateSndFrame();
     InvalViewsAndScb();
 
+    //
+    // Start reading the next scene's content while this one plays
+    //
+    _PrefetchScen(iscen + 1);
+
     return (fRet);
 }
 
+/****************************************************
+ *
+ * Queues the content chunks used by scene iscen (its
+ * templates, models, MBMPs, sounds and so on) to be
+ * read on the prefetch thread, so switching to it
+ * later doesn't stall reading them.  Requests left
+ * over from the previous scene are tossed first, since
+ * they hold queue space that may never be used.
+ * Failure isn't an error; the chunks are just read
+ * when they're needed.
+ *
+ * Parameters:
+ *	iscen - Scene number to prefetch.
+ *
+ * Returns:
+ *  None
+ *
+ ****************************************************/
+void MVIE::_PrefetchScen(long iscen)
+{
+    AssertThis(0);
+
+    PTAGL ptagl;
+    KID kid;
+    TAG tag;
+    long itag;
+    long cerc;
+
+    vcrpqUtil.Cancel(pvNil);
+
+    if (!FIn(iscen, 0, Cscen()) || pvNil == _pcrfAutoSave)
+    {
+        return;
+    }
+
+    if (!_pcrfAutoSave->Pcfl()->FGetKidChidCtg(kctgMvie, _cno, iscen, kctgScen, &kid))
+    {
+        return;
+    }
+
+    cerc = vpers->Cerc();
+    ptagl = TAGL::PtaglNew();
+    if (pvNil != ptagl && SCEN::FAddTagsToTagl(_pcrfAutoSave->Pcfl(), kid.cki.cno, ptagl))
+    {
+        for (itag = 0; itag < ptagl->Ctag(); itag++)
+        {
+            ptagl->GetTag(itag, &tag);
+            // tags read from the file aren't open; the chunks they refer
+            // to are in the autosave file
+            if (ksidUseCrf == tag.sid)
+            {
+                tag.pcrf = _pcrfAutoSave;
+            }
+            vptagm->PrefetchTag(&tag);
+        }
+    }
+    ReleasePpo(&ptagl);
+
+    while (vpers->Cerc() > cerc)
+    {
+        vpers->FPop();
+    }
+}
+
 /****************************************************
  *
  * Creates a new scene and inserts it as scene number iscen.
@@ -2659,6 +2731,11 @@ LRetry:
         //
         _FDoGarbageCollection(pcfl);
 
+        //
+        // Compress the event and path chunks -- again, ignore any errors.
+        //
+        _PackEventChunks(pcfl);
+
         fSuccess = pcfl->FSave(kctgSoc, pfni);
 
         if (pfil != pvNil)
@@ -2733,6 +2810,35 @@ LFail0:
     return (fFalse);
 }
 
+/****************************************************
+ *
+ * Compress the actor event and path chunks.  Events are
+ * read by ACTR::_PggaevRead (for _FReadEvents,
+ * PgltagFetch and FBenchLoad) and paths by
+ * ACTR::_FReadRoute and FBenchLoad.  All of them call
+ * FUnpackData before decoding the compact form, so the
+ * chunks are safe to store packed.  The chunks are
+ * packed on as many threads as there are processors.
+ *
+ * Parameters:
+ *	pcfl - File holding the chunks
+ *
+ * Returns:
+ *  None
+ *
+ ****************************************************/
+void MVIE::_PackEventChunks(PCFL pcfl)
+{
+    AssertThis(0);
+    AssertPo(pcfl, 0);
+
+    static CTG _rgctg[] = {kctgFrmGg, kctgStartGg, kctgGgae, kctgPath};
+    long ictg;
+
+    for (ictg = 0; ictg < CvFromRgv(_rgctg); ictg++)
+        pcfl->FPackDataCtg(_rgctg[ictg]);
+}
+
 /****************************************************
  *
  * Do all garbage collection
@@ -3049,10 +3155,176 @@ bool MVIE::FAddUndo(PMUNB pmunb)
         return (fFalse);
     }
 
+    if (_ipundbLimDone > 1)
+    {
+        PMUNB pmunbPrev;
+
+        _pglpundb->Get(_ipundbLimDone - 2, &pmunbPrev);
+        AssertPo(pmunbPrev, 0);
+        pmunbPrev->Bury(pmunb);
+    }
+    _TrimUndo();
+
     Pmcc()->SetUndo(undoUndo);
     return (fTrue);
 }
 
+/****************************************************
+ *
+ * Returns roughly how much memory the undo levels hold.
+ *
+ * Parameters:
+ *	pcbLevelMax - Where to put the memory held by the
+ *		largest level, may be pvNil.
+ *
+ * Returns:
+ *  Bytes held by all the levels.
+ *
+ ****************************************************/
+long MVIE::_CbUndo(long *pcbLevelMax)
+{
+    AssertBaseThis(0);
+    AssertNilOrVarMem(pcbLevelMax);
+
+    long iundb, cb;
+    long cbTot = 0;
+    long cbLevelMax = 0;
+
+    if (pvNil != _pglpundb)
+    {
+        for (iundb = 0; iundb < _pglpundb->IvMac(); iundb++)
+        {
+            cb = CbUndoLevel(iundb);
+            cbTot += cb;
+            cbLevelMax = LwMax(cbLevelMax, cb);
+        }
+    }
+
+    if (pvNil != pcbLevelMax)
+        *pcbLevelMax = cbLevelMax;
+    return cbTot;
+}
+
+/****************************************************
+ *
+ * Drops the oldest undo levels until the rest fit in
+ * _cbUndoMax.  The newest level is always kept.
+ *
+ * Parameters:
+ *	None.
+ *
+ * Returns:
+ *  None.
+ *
+ ****************************************************/
+void MVIE::_TrimUndo(void)
+{
+    AssertBaseThis(0);
+
+    PUNDB pundb;
+    long cbTot;
+
+    if (pvNil == _pglpundb)
+        return;
+
+    cbTot = _CbUndo();
+    while (cbTot > _cbUndoMax && _ipundbLimDone > 1)
+    {
+        cbTot -= CbUndoLevel(0);
+        _pglpundb->Get(0, &pundb);
+        _pglpundb->Delete(0);
+        _ipundbLimDone--;
+        _cundbTrim++;
+        ReleasePpo(&pundb);
+    }
+    _cbUndoPeak = LwMax(_cbUndoPeak, cbTot);
+}
+
+/****************************************************
+ *
+ * Sets how much memory the undo levels may hold.
+ *
+ * Parameters:
+ *	cbUndoMax - The limit, in bytes.
+ *
+ * Returns:
+ *  None.
+ *
+ ****************************************************/
+void MVIE::SetCbUndoMax(long cbUndoMax)
+{
+    AssertThis(0);
+    AssertIn(cbUndoMax, 0, kcbMax);
+
+    _cbUndoMax = cbUndoMax;
+    _TrimUndo();
+}
+
+/****************************************************
+ *
+ * Returns roughly how much memory one undo level holds.
+ *
+ * Parameters:
+ *	iundb - The level, 0 being the oldest.
+ *
+ * Returns:
+ *  Bytes held.
+ *
+ ****************************************************/
+long MVIE::CbUndoLevel(long iundb)
+{
+    AssertBaseThis(0);
+    AssertPo(_pglpundb, 0);
+    AssertIn(iundb, 0, _pglpundb->IvMac());
+
+    PMUNB pmunb;
+
+    _pglpundb->Get(iundb, &pmunb);
+    AssertPo(pmunb, 0);
+    return pmunb->CbMem();
+}
+
+/****************************************************
+ *
+ * Gets the undo memory counters.
+ *
+ * Parameters:
+ *	punct - Where to put the counters.
+ *
+ * Returns:
+ *  None.
+ *
+ ****************************************************/
+void MVIE::GetUnct(UNCT *punct)
+{
+    AssertThis(0);
+    AssertVarMem(punct);
+
+    punct->cundb = CundbUndo() + CundbRedo();
+    punct->cbTot = _CbUndo(&punct->cbLevelMax);
+    punct->cbPeak = LwMax(_cbUndoPeak, punct->cbTot);
+    punct->cundbTrim = _cundbTrim;
+}
+
+/****************************************************
+ *
+ * Resets the undo memory peak and trim counters.
+ *
+ * Parameters:
+ *	None.
+ *
+ * Returns:
+ *  None.
+ *
+ ****************************************************/
+void MVIE::ResetUnct(void)
+{
+    AssertThis(0);
+
+    _cbUndoPeak = 0;
+    _cundbTrim = 0;
+}
+
 /****************************************************
  *
  * Clears out the undo buffer
@@ -5401,6 +5673,62 @@ void MVIE::MarkViews(void)
     }
 }
 
+/***************************************************************************
+ *
+ * Renders every frame of scenes iscenFirst through iscenLim - 1 as fast
+ * as possible, without waiting on the clock, and writes each frame into
+ * pfniDir as sSSSfFFFFF.bmp.  Sounds, pauses and text boxes are skipped,
+ * so the bitmaps hold only the rendered world.
+ *
+ * Parameters:
+ *	pfniDir - The directory to write the bitmaps into.
+ *	iscenFirst - The first scene to render.
+ *	iscenLim - One past the last scene to render.
+ *	pcfrm - Takes the number of frames written.
+ *
+ * Returns:
+ *  fTrue if all the frames were written, else fFalse.
+ *
+ **************************************************************************/
+bool MVIE::FWriteFrames(PFNI pfniDir, long iscenFirst, long iscenLim, long *pcfrm)
+{
+    AssertThis(0);
+    AssertPo(pfniDir, ffniDir);
+    AssertIn(iscenFirst, 0, klwMax);
+    AssertVarMem(pcfrm);
+
+    long iscen, nfrm;
+    FNI fni;
+    STN stn;
+
+    *pcfrm = 0;
+    iscenLim = LwMin(iscenLim, Cscen());
+    for (iscen = iscenFirst; iscen < iscenLim; iscen++)
+    {
+        if (!FSwitchScen(iscen))
+            return fFalse;
+
+        Pscen()->Disable(fscenSounds | fscenPauses | fscenTboxes);
+        Pscen()->Enable(fscenActrs);
+        for (nfrm = Pscen()->NfrmFirst(); nfrm <= Pscen()->NfrmLast(); nfrm++)
+        {
+            if (!Pscen()->FGotoFrm(nfrm))
+                return fFalse;
+            Pbwld()->Render();
+
+            fni = *pfniDir;
+            if (!stn.FFormatSz(PszLit("s%03df%05d.bmp"), iscen, nfrm - Pscen()->NfrmFirst()) || !fni.FSetLeaf(&stn) ||
+                !Pbwld()->FWriteBmp(&fni))
+            {
+                return fFalse;
+            }
+            (*pcfrm)++;
+        }
+    }
+
+    return fTrue;
+}
+
 /***************************************************************************
  *
  * This returns the current name of the movie.
@@ -83,6 +83,23 @@ struct SEV
 };
 
 const auto kbomSev = 0xF0000000;
+
+//
+// Skip list entry for a scene frame event.  There is one of these for each
+// sev in _pggsevFrm.  The Prev fields give the last event of that kind at or
+// before this one and isevCamNext the first camera change at or after it, so
+// seeking never has to walk the events it is skipping over.  ivNil means
+// there is no such event.
+//
+struct SEVX
+{
+    long isevCamPrev;   // last sevtChngCamera
+    long isevCamNext;   // next sevtChngCamera
+    long isevSndPrev;   // last sevtPlaySnd
+    long isevMidiPrev;  // last sevtPlaySnd of styMidi
+    long isevPausePrev; // last sevtPause
+};
+typedef SEVX *PSEVX;
 const auto kbomLong = 0xC0000000;
 
 //
@@ -411,6 +428,7 @@ class SUNS : public SUNS_PAR
 
     virtual bool FDo(PDOCB pdocb);
     virtual bool FUndo(PDOCB pdocb);
+    virtual long CbMem(void);
 };
 
 //
@@ -659,6 +677,7 @@ SCEN::~SCEN(void)
     // Delete frame event list.
     //
     ReleasePpo(&_pggsevFrm);
+    ReleasePpo(&_pglsevx);
 
     //
     // Remove the GL of actors.  We do not Release the actors
@@ -744,6 +763,7 @@ void SCEN::MarkMem(void)
 
     MarkMemObj(_pggsevStart);
     MarkMemObj(_pggsevFrm);
+    MarkMemObj(_pglsevx);
     MarkMemObj(_pglpactr);
     MarkMemObj(_pglptbox);
     MarkMemObj(_pmbmp);
@@ -781,6 +801,8 @@ void SCEN::AssertValid(ulong grf)
     AssertPo(_pglpactr, 0);
     AssertPo(_pglptbox, 0);
     AssertPo(_pggsevFrm, 0);
+    AssertNilOrPo(_pglsevx, 0);
+    Assert(_pglsevx == pvNil || _pglsevx->IvMac() == _pggsevFrm->IvMac(), "stale event index");
     AssertPo(_pggsevStart, 0);
     AssertPo(_pmvie, 0);
 
@@ -914,7 +936,9 @@ bool SCEN::FGotoFrm(long nfrm)
     SEV sev;
     PMVU pmvu;
     void *qvVar;
-    long isev;
+    long isev, isevLim, iisev;
+    long rgisev[3];
+    SEVX sevx;
     long nfrmOld = _nfrmCur;
 
     if (nfrm < _nfrmCur)
@@ -939,22 +963,39 @@ bool SCEN::FGotoFrm(long nfrm)
 
         _nfrmCur = nfrm;
 
+        if (!_FEnsureSevx())
+        {
+            PushErc(ercSocGotoFrameFailure);
+            return (fFalse);
+        }
+
         //
-        // Unplay all events to dest frame.
+        // Unplay all events to dest frame.  Unplaying a sound or a
+        // camera change restores the last one before the dest frame,
+        // so each only needs undoing once, however many are skipped.
         //
-        for (; _isevFrmLim > 0; _isevFrmLim--)
+        isevLim = _IsevFirstFrm(_nfrmCur + 1, 0, _isevFrmLim);
+        if (isevLim < _isevFrmLim)
         {
-            _pggsevFrm->GetFixed(_isevFrmLim - 1, &sev);
-            if (sev.nfrm <= _nfrmCur)
-            {
-                break;
-            }
+            _pglsevx->Get(_isevFrmLim - 1, &sevx);
+            _isevFrmLim = isevLim;
 
-            qvVar = _pggsevFrm->QvGet(_isevFrmLim - 1);
-            if (!_FUnPlaySev(&sev, qvVar))
+            rgisev[0] = sevx.isevSndPrev;
+            rgisev[1] = sevx.isevCamPrev;
+            for (iisev = 0; iisev < 2; iisev++)
             {
-                PushErc(ercSocGotoFrameFailure);
-                return (fFalse);
+                if (rgisev[iisev] == ivNil || rgisev[iisev] < isevLim)
+                {
+                    continue;
+                }
+
+                _pggsevFrm->GetFixed(rgisev[iisev], &sev);
+                qvVar = _pggsevFrm->QvGet(rgisev[iisev]);
+                if (!_FUnPlaySev(&sev, qvVar))
+                {
+                    PushErc(ercSocGotoFrameFailure);
+                    return (fFalse);
+                }
             }
         }
 
@@ -1005,23 +1046,56 @@ bool SCEN::FGotoFrm(long nfrm)
             _MarkMovieDirty();
         }
 
+        if (!_FEnsureSevx())
+        {
+            PushErc(ercSocGotoFrameFailure);
+            return (fFalse);
+        }
+
         //
-        // Play all events to dest frame.
+        // Catch up on the skipped frames.  Their sounds and pauses are
+        // not played, so only the last camera change, background midi
+        // and pause type have any lasting effect.
         //
-        for (; _isevFrmLim < _pggsevFrm->IvMac(); _isevFrmLim++)
-        {
-            _pggsevFrm->GetFixed(_isevFrmLim, &sev);
-            if (sev.nfrm > _nfrmCur)
+        isev = _IsevFirstFrm(_nfrmCur, _isevFrmLim, _pggsevFrm->IvMac());
+        isevLim = _IsevFirstFrm(_nfrmCur + 1, isev, _pggsevFrm->IvMac());
+        if (isev > _isevFrmLim)
+        {
+            _pglsevx->Get(isev - 1, &sevx);
+            rgisev[0] = sevx.isevCamPrev;
+            rgisev[1] = sevx.isevMidiPrev;
+            rgisev[2] = sevx.isevPausePrev;
+            for (iisev = 0; iisev < CvFromRgv(rgisev); iisev++)
             {
-                break;
+                if (rgisev[iisev] == ivNil || rgisev[iisev] < _isevFrmLim)
+                {
+                    continue;
+                }
+
+                _pggsevFrm->GetFixed(rgisev[iisev], &sev);
+                qvVar = _pggsevFrm->QvGet(rgisev[iisev]);
+                if (!_FPlaySev(&sev, qvVar, _grfscen | fscenSounds | fscenPauses))
+                {
+                    PushErc(ercSocGotoFrameFailure);
+                    return (fFalse);
+                }
             }
+            _isevFrmLim = isev;
+        }
+
+        //
+        // Play all events in the dest frame.
+        //
+        for (; _isevFrmLim < isevLim; _isevFrmLim++)
+        {
+            _pggsevFrm->GetFixed(_isevFrmLim, &sev);
             qvVar = _pggsevFrm->QvGet(_isevFrmLim);
-            if (!_FPlaySev(&sev, qvVar, (sev.nfrm == _nfrmCur ? _grfscen : (_grfscen | fscenSounds | fscenPauses))))
+            if (!_FPlaySev(&sev, qvVar, _grfscen))
             {
                 PushErc(ercSocGotoFrameFailure);
                 return (fFalse);
             }
-            if (sev.sevt == sevtPlaySnd && sev.nfrm == _nfrmCur)
+            if (sev.sevt == sevtPlaySnd)
                 fSoundInFrame = fTrue;
         }
     }
@@ -1099,35 +1173,38 @@ void SCEN::_DoPrerenderingWork(bool fStartNow)
     // (even though there's no sevtChngCamera), or if fStartNow
     // is fTrue, or if there is a sevtChngCamera in this
     // frame.  Otherwise, just return.
+    if (!_FEnsureSevx())
+    {
+        return; // prerendering is only an optimization
+    }
+
     if (_nfrmCur != _nfrmFirst && !fStartNow)
     {
-        for (isev = _isevFrmLim - 1; isev >= 0; isev--)
+        if (_isevFrmLim == 0)
         {
-            _pggsevFrm->GetFixed(isev, &sev);
-            if (sev.nfrm != _nfrmCur)
-            {
-                return; // no camera view change in this frame
-            }
-            if (sev.sevt == sevtChngCamera)
-            {
-                break; // found one!
-            }
+            return; // no camera view change in this frame
         }
-        if (isev < 0)
+        isev = ((PSEVX)_pglsevx->QvGet(_isevFrmLim - 1))->isevCamPrev;
+        if (isev == ivNil)
         {
-            return; // no camera view in this frame
+            return; // no camera view change in this frame
+        }
+        _pggsevFrm->GetFixed(isev, &sev);
+        if (sev.nfrm != _nfrmCur)
+        {
+            return; // no camera view change in this frame
         }
     }
 
     // Find when the next view change is
     nfrmNextChange = _nfrmLast; // if no more view changes, go til end of scene
-    for (isev = _isevFrmLim; isev < _pggsevFrm->IvMac(); isev++)
+    if (_isevFrmLim < _pggsevFrm->IvMac())
     {
-        _pggsevFrm->GetFixed(isev, &sev);
-        if (sev.sevt == sevtChngCamera)
+        isev = ((PSEVX)_pglsevx->QvGet(_isevFrmLim))->isevCamNext;
+        if (isev != ivNil)
         {
+            _pggsevFrm->GetFixed(isev, &sev);
             nfrmNextChange = sev.nfrm;
-            break;
         }
     }
 
@@ -1521,24 +1598,37 @@ bool SCEN::_FUnPlaySev(PSEV psev, void *qvVar)
 
     SEV sev;
     long isev;
-    PSEV qsevTmp;
+    SEVX sevx;
+
+    if (!_FEnsureSevx())
+    {
+        return (fFalse);
+    }
+
+    //
+    // Find the events in effect before this frame.
+    //
+    isev = _IsevFirstFrm(_nfrmCur, 0, _isevFrmLim) - 1;
+    if (isev >= 0)
+    {
+        _pglsevx->Get(isev, &sevx);
+    }
+    else
+    {
+        sevx.isevSndPrev = sevx.isevCamPrev = ivNil;
+    }
 
     switch (psev->sevt)
     {
     case sevtPlaySnd:
         //
-        // Go backwards and find previous background sound.
+        // Replay the previous background sound.
         //
-        for (isev = _isevFrmLim - 1; isev >= 0; isev--)
+        if (sevx.isevSndPrev != ivNil)
         {
-            qsevTmp = (PSEV)_pggsevFrm->QvFixedGet(isev);
-
-            if ((qsevTmp->sevt == sevtPlaySnd) && (qsevTmp->nfrm < _nfrmCur))
-            {
-                sev = *qsevTmp;
-                _FPlaySev(&sev, _pggsevFrm->QvGet(isev), _grfscen | fscenSounds); // Ignore failure.
-                return (fTrue);
-            }
+            _pggsevFrm->GetFixed(sevx.isevSndPrev, &sev);
+            _FPlaySev(&sev, _pggsevFrm->QvGet(sevx.isevSndPrev), _grfscen | fscenSounds); // Ignore failure.
+            return (fTrue);
         }
 
         //
@@ -1557,18 +1647,13 @@ bool SCEN::_FUnPlaySev(PSEV psev, void *qvVar)
         Assert(_pbkgd != pvNil, "No background in scene");
 
         //
-        // Go backwards and find previous camera position.
+        // Restore the previous camera position.
         //
-        for (isev = _isevFrmLim - 1; isev >= 0; isev--)
+        if (sevx.isevCamPrev != ivNil)
         {
-            qsevTmp = (PSEV)_pggsevFrm->QvFixedGet(isev);
-
-            if ((qsevTmp->sevt == sevtChngCamera) && (qsevTmp->nfrm < _nfrmCur))
-            {
-                sev = *qsevTmp;
-                AssertDo(_FPlaySev(&sev, _pggsevFrm->QvGet(isev), _grfscen), "Should not fail.");
-                return (fTrue);
-            }
+            _pggsevFrm->GetFixed(sevx.isevCamPrev, &sev);
+            AssertDo(_FPlaySev(&sev, _pggsevFrm->QvGet(sevx.isevCamPrev), _grfscen), "Should not fail.");
+            return (fTrue);
         }
 
         //
@@ -1629,6 +1714,7 @@ void SCEN::_MoveBackFirstFrame(long nfrm)
             // Move this back
             //
             sev.nfrm = nfrm;
+            _InvalSevx();
             _pggsevFrm->PutFixed(isev, &sev);
             _pggsevFrm->Move(isev, 0);
         }
@@ -1640,6 +1726,143 @@ void SCEN::_MoveBackFirstFrame(long nfrm)
     _nfrmFirst = nfrm;
 }
 
+/****************************************************
+ *
+ * This routine builds the skip list over the frame
+ * events, if it isn't already up to date.
+ *
+ * Parameters:
+ *	None.
+ *
+ * Returns:
+ *	fTrue if _pglsevx is valid, fFalse if out of memory.
+ *
+ ****************************************************/
+bool SCEN::_FEnsureSevx(void)
+{
+    AssertBaseThis(0);
+
+    long isev, isevMac;
+    long isevCamNext;
+    SEVX sevx;
+    PSEV qsev;
+    PSEVX qsevx;
+
+    if (pvNil != _pglsevx)
+    {
+        return (fTrue);
+    }
+
+    isevMac = _pggsevFrm->IvMac();
+    if (pvNil == (_pglsevx = GL::PglNew(size(SEVX), isevMac)) || !_pglsevx->FSetIvMac(isevMac))
+    {
+        ReleasePpo(&_pglsevx);
+        return (fFalse);
+    }
+
+    //
+    // Forward pass for the last event of each kind...
+    //
+    sevx.isevCamPrev = sevx.isevCamNext = ivNil;
+    sevx.isevSndPrev = sevx.isevMidiPrev = sevx.isevPausePrev = ivNil;
+    for (isev = 0; isev < isevMac; isev++)
+    {
+        qsev = (PSEV)_pggsevFrm->QvFixedGet(isev);
+        switch (qsev->sevt)
+        {
+        case sevtChngCamera:
+            sevx.isevCamPrev = isev;
+            break;
+
+        case sevtPlaySnd:
+            sevx.isevSndPrev = isev;
+            if (((PSSE)_pggsevFrm->QvGet(isev))->sty == styMidi)
+            {
+                sevx.isevMidiPrev = isev;
+            }
+            break;
+
+        case sevtPause:
+            sevx.isevPausePrev = isev;
+            break;
+        }
+        _pglsevx->Put(isev, &sevx);
+    }
+
+    //
+    // ...and a backward one for the next camera change.
+    //
+    isevCamNext = ivNil;
+    for (isev = isevMac - 1; isev >= 0; isev--)
+    {
+        qsevx = (PSEVX)_pglsevx->QvGet(isev);
+        if (qsevx->isevCamPrev == isev)
+        {
+            isevCamNext = isev;
+        }
+        qsevx->isevCamNext = isevCamNext;
+    }
+
+    return (fTrue);
+}
+
+/****************************************************
+ *
+ * This routine throws away the frame event skip list.
+ * It must be called before anything changes _pggsevFrm.
+ *
+ * Parameters:
+ *	None.
+ *
+ * Returns:
+ *	None.
+ *
+ ****************************************************/
+void SCEN::_InvalSevx(void)
+{
+    AssertBaseThis(0);
+
+    ReleasePpo(&_pglsevx);
+}
+
+/****************************************************
+ *
+ * This routine binary searches the frame events for
+ * the first one at or after the given frame.
+ *
+ * Parameters:
+ *	nfrm - Frame to search for.
+ *	isevMin, isevLim - Range of events to search.
+ *
+ * Returns:
+ *	Index of the first event in the range with an nfrm
+ *	of at least nfrm, or isevLim if there is none.
+ *
+ ****************************************************/
+long SCEN::_IsevFirstFrm(long nfrm, long isevMin, long isevLim)
+{
+    AssertBaseThis(0);
+    AssertIn(isevLim, 0, _pggsevFrm->IvMac() + 1);
+    AssertIn(isevMin, 0, isevLim + 1);
+
+    long isev;
+
+    while (isevMin < isevLim)
+    {
+        isev = (isevMin + isevLim) / 2;
+        if (((PSEV)_pggsevFrm->QvFixedGet(isev))->nfrm < nfrm)
+        {
+            isevMin = isev + 1;
+        }
+        else
+        {
+            isevLim = isev;
+        }
+    }
+
+    return (isevMin);
+}
+
 /****************************************************
  *
  * This routine adds a sound to the event list for this frame.
@@ -1750,6 +1973,7 @@ bool SCEN::FAddSndCore(bool fLoop, bool fQueue, long vlm, long sty, long ctag, P
             {
                 TAGM::CloseTag(psse->Ptag(itagc));
             }
+            _InvalSevx();
             _pggsevFrm->Delete(isevSnd);
             _isevFrmLim--;
         }
@@ -1781,6 +2005,7 @@ bool SCEN::FAddSndCore(bool fLoop, bool fQueue, long vlm, long sty, long ctag, P
             ReleasePpsse(&psseOld);
             return fFalse;
         }
+        _InvalSevx();
         if (!_pggsevFrm->FPut(isevSnd, psseNew->Cb(), psseNew))
         {
             ReleasePpsse(&psseOld);
@@ -1905,6 +2130,7 @@ bool SCEN::FAddSndCoreTagc(bool fLoop, bool fQueue, long vlm, long sty, long cta
             {
                 TAGM::CloseTag(psse->Ptag(itagc));
             }
+            _InvalSevx();
             _pggsevFrm->Delete(isevSnd);
             _isevFrmLim--;
         }
@@ -2040,6 +2266,7 @@ void SCEN::RemSndCore(long sty)
             {
                 TAGM::CloseTag(psse->Ptag(itagc));
             }
+            _InvalSevx();
             _pggsevFrm->Delete(isev);
             _isevFrmLim--;
 
@@ -2394,6 +2621,7 @@ bool SCEN::_FAddSev(PSEV psev, long cbVar, void *pvVar)
     //
     _MarkMovieDirty();
 
+    _InvalSevx();
     fRetValue = _pggsevFrm->FInsert(_isevFrmLim++, cbVar, pvVar, psev);
 
     if (!fRetValue)
@@ -3222,6 +3450,7 @@ bool SCEN::FPauseCore(WIT *pwit, long *pdts)
 
             if (*pwit == witNil)
             {
+                _InvalSevx();
                 _pggsevFrm->Delete(isev);
                 _isevFrmLim--;
             }
@@ -3229,6 +3458,7 @@ bool SCEN::FPauseCore(WIT *pwit, long *pdts)
             {
                 sevp.wit = *pwit;
                 sevp.dts = *pdts;
+                _InvalSevx();
                 _pggsevFrm->Put(isev, &sevp);
             }
 
@@ -3395,6 +3625,7 @@ LSuccess:
         //
         // Remove stale scene events
         //
+        _InvalSevx();
         _pggsevFrm->Delete(_pggsevFrm->IvMac() - 1);
     }
 
@@ -3603,6 +3834,7 @@ bool SCEN::FChangeCamCore(long icam, long *picamOld)
                     _pggsevFrm->Get(isev, picamOld);
                     if (_FPlaySev(qsevOld, &icam, _grfscen))
                     {
+                        _InvalSevx();
                         _pggsevFrm->Delete(isev);
                         _isevFrmLim--;
                         _MarkMovieDirty();
@@ -3615,6 +3847,7 @@ bool SCEN::FChangeCamCore(long icam, long *picamOld)
                 // Change it
                 //
                 _pggsevFrm->Get(isev, picamOld);
+                _InvalSevx();
                 _pggsevFrm->Put(isev, &icam);
                 _MarkMovieDirty();
                 if (_FPlaySev(qsev, &icam, _grfscen))
@@ -3650,6 +3883,7 @@ bool SCEN::FChangeCamCore(long icam, long *picamOld)
         }
         else
         {
+            _InvalSevx();
             _pggsevFrm->Delete(--_isevFrmLim);
         }
     }
@@ -3670,6 +3904,7 @@ LSuccess:
             _pggsevFrm->Get(isev, &icamNext);
             if (icamNext == icam)
             {
+                _InvalSevx();
                 _pggsevFrm->Delete(isev);
                 _isevFrmLim;
             }
@@ -5425,6 +5660,7 @@ bool SCEN::FChopCore()
     //
     for (; _isevFrmLim < _pggsevFrm->IvMac();)
     {
+        _InvalSevx();
         _pggsevFrm->Delete(_isevFrmLim);
     }
 
@@ -5579,6 +5815,7 @@ bool SCEN::FChopBackCore()
 
             fCopyCam = fFalse;
             sev.nfrm = _nfrmCur;
+            _InvalSevx();
             _pggsevFrm->PutFixed(_isevFrmLim, &sev);
         }
         else
@@ -5589,6 +5826,7 @@ bool SCEN::FChopBackCore()
                 continue;
             }
 
+            _InvalSevx();
             _pggsevFrm->Delete(_isevFrmLim);
         }
     }
@@ -6081,6 +6319,25 @@ bool SUNS::FUndo(PDOCB pdocb)
     return FDo(pdocb);
 }
 
+/****************************************************
+ * Return roughly how much memory this undo holds.
+ *
+ * Parameters:
+ * 	None.
+ *
+ * Returns:
+ *  Bytes held.
+ *
+ ****************************************************/
+long SUNS::CbMem(void)
+{
+    AssertThis(0);
+
+    if (_psse == pvNil)
+        return size(SUNS);
+    return size(SUNS) + size(SSE) + LwMul(_psse->ctagc, size(TAGC));
+}
+
 #ifdef DEBUG
 /****************************************************
  * Mark memory used by the SUNS
@@ -6201,7 +6458,7 @@ bool SUNA::FDo(PDOCB pdocb)
         Assert(_ut == utRep, "Bad Grf");
 
         pactr = _pmvie->Pscen()->PactrFromArid(_pactr->Arid());
-        if (!pactr->FDup(&pactrDup, fTrue))
+        if (!_pactr->FApplyDelta(pactr) || !pactr->FDup(&pactrDup, fTrue))
         {
             goto LFail;
         }
@@ -6286,7 +6543,7 @@ bool SUNA::FUndo(PDOCB pdocb)
         Assert(_ut == utRep, "Bad Grf");
 
         pactr = _pmvie->Pscen()->PactrFromArid(_pactr->Arid());
-        if (!pactr->FDup(&pactrDup, fTrue))
+        if (!_pactr->FApplyDelta(pactr) || !pactr->FDup(&pactrDup, fTrue))
         {
             goto LFail;
         }
@@ -6314,6 +6571,73 @@ LFail:
     return (fFalse);
 }
 
+/****************************************************
+ * Return roughly how much memory this undo holds.
+ *
+ * Parameters:
+ *	None.
+ *
+ * Returns:
+ *  Bytes held.
+ *
+ ****************************************************/
+long SUNA::CbMem(void)
+{
+    AssertThis(0);
+    return size(SUNA) + _pactr->CbMem();
+}
+
+/****************************************************
+ * Return the whole actor this undo puts back.
+ *
+ * Parameters:
+ *	None.
+ *
+ * Returns:
+ *  The actor, or pvNil if undoing doesn't put one back
+ *  or it is only held as a delta.
+ *
+ ****************************************************/
+PACTR SUNA::PactrUndo(void)
+{
+    AssertThis(0);
+
+    if (_ut == utAdd || _pactr->FDelta())
+        return pvNil;
+    return _pactr;
+}
+
+/****************************************************
+ * Another undo is going on top of this one.  A replace
+ * undo swaps _pactr with the actor in the scene, so if
+ * the new undo puts back the same actor, keep only what
+ * differs from it.
+ *
+ * Parameters:
+ *	pmunbNext - The undo going on top.
+ *
+ * Returns:
+ *  None.
+ *
+ ****************************************************/
+void SUNA::Bury(PMUNB pmunbNext)
+{
+    AssertThis(0);
+    AssertPo(pmunbNext, 0);
+
+    PACTR pactrBase;
+
+    if (_ut != utRep || _pactr->CactRef() > 1)
+        return;
+
+    pactrBase = pmunbNext->PactrUndo();
+    if (pactrBase == pvNil || pactrBase->Arid() != _pactr->Arid() || pmunbNext->Iscen() != _iscen)
+        return;
+
+    // On failure the snapshot just stays whole
+    _pactr->FMakeDelta(pactrBase);
+}
+
 #ifdef DEBUG
 /****************************************************
  * Mark memory used by the SUNA
@@ -14,15 +14,22 @@
     resources (the CRF and CRM classes).
 
     For each source, TAGM maintains (in an SFS) a CRM (Chunky Resource
-    Manager) of all the content	files on the source and a CRF (Chunky
-    Resource File), which is a single file on the HD which can be used
+    Manager) of all the content	files on the source.  For each of those
+    files that content has been cached from, it keeps (in a TCF) a CRF
+    (Chunky Resource File) on a cache file on the HD, which can be used
     for faster access to the source.  Both CRFs and CRMs can cache
-    resources in RAM.  Since Socrates copies *all* content from the CD
-    to the cache file, the CRM is told not to cache its resources in
-    RAM.  However, if the source is actually on the HD, TAGM notices and
-    doesn't copy any content to a cache file, since that would be a waste
-    of time.  Instead, the content is read directly from the CRM.  In this
-    case, TAGM does tell the CRM to cache its resources in RAM.
+    resources in RAM.  If the source is actually on the HD, TAGM notices
+    and doesn't copy any content to a cache file, since that would be a
+    waste of time.  Instead, the content is read directly from the CRM.
+    A source on a network drive is still cached, since reading it is
+    about as slow as reading the CD.
+
+    A cache file holds chunks with the same CTG/CNOs they have in the
+    source file, so a chunk's children are found the same way in both.
+    A chunk is only read from the cache file once it and all its
+    descendents are there; those chunks are listed (sorted) in the
+    kctgTagCacheTree chunk.  The kctgTagCacheHead chunk records the
+    source file the cache file was made from.
 
     Source names: every source has a long and short name.  This is so we
     can use long names for the source directory on the HD (e.g., "3D Movie
@@ -45,6 +52,10 @@ RTCLASS(TAGM)
 
 const BOM kbomSid = 0xc0000000;
 
+const CTG kctgTagCacheHead = 'TCHD';
+const CTG kctgTagCacheTree = 'TCTR';
+const long klwVersionTagCache = 1;
+
 // Source File Structure...keeps track of known sources and caches
 struct SFS
 {
@@ -54,6 +65,7 @@ struct SFS
     FNI fniCD;            // FNI of the CD directory
     PCRM pcrmSource;      // CRM of files on the CD (or possibly HD)
     tribool tContentOnHD; // Is the content on the HD or CD?
+    tribool tCacheHD;     // Should chunks from this source be cached to HD?
 
   public:
     void Clear(void) // Zeros out an SFS
@@ -63,9 +75,43 @@ struct SFS
         fniCD.SetNil();
         pcrmSource = pvNil;
         tContentOnHD = tMaybe;
+        tCacheHD = tMaybe;
     }
 };
 
+// Tag Cache Header...identifies the source file a cache file was made from
+struct TCH
+{
+    short bo;
+    short osk;
+    long lwVersion;
+    long sid;
+    ulong timSource;  // modification time of the source file
+    long cckiSource;  // number of chunks in the source file
+};
+
+// Tag Cache File...keeps track of the cache file for one source file
+struct TCF
+{
+    long sid;           // source this file belongs to
+    PCFL pcflSource;    // source file (owned by the source's CRM)
+    PCRF pcrfCache;     // CRF on the cache file, or pvNil if there isn't one
+    PGL pglckiTree;     // chunks cached along with all their descendents
+    bool fLooked : 1;   // have looked for an existing cache file
+    bool fFailed : 1;   // couldn't create a cache file, so don't try again
+    bool fDirty : 1;    // chunks have been added since the last save
+    bool fUsed : 1;     // chunks have been read since the last save
+};
+
+// Tag Cache Entry...a cache file found while trimming the cache directory
+struct TCE
+{
+    FNI fni;
+    ulong tim;   // modification time, which is when the file was last used
+    long cb;
+    bool fOpen;  // in use by this TAGM, so it can't be deleted
+};
+
 /***************************************************************************
     Initialize the tag manager
 ***************************************************************************/
@@ -93,6 +139,10 @@ PTAGM TAGM::PtagmNew(PFNI pfniHDRoot, PFNINSCD pfninscd, long cbCache)
     if (pvNil == ptagm->_pgstSource)
         goto LFail;
 
+    ptagm->_pgltcf = GL::PglNew(size(TCF));
+    if (pvNil == ptagm->_pgltcf)
+        goto LFail;
+
     AssertPo(ptagm, 0);
     return ptagm;
 LFail:
@@ -109,7 +159,22 @@ TAGM::~TAGM(void)
 
     long isfs;
     SFS sfs;
+    long itcf;
+    TCF tcf;
 
+    if (pvNil != _pgltcf)
+    {
+        _SaveCacheHD(sidNil);
+        for (itcf = 0; itcf < _pgltcf->IvMac(); itcf++)
+        {
+            _pgltcf->Get(itcf, &tcf);
+            ReleasePpo(&tcf.pcrfCache);
+            ReleasePpo(&tcf.pglckiTree);
+            _pgltcf->Put(itcf, &tcf);
+        }
+        _TrimCacheHD();
+        ReleasePpo(&_pgltcf);
+    }
     if (pvNil != _pglsfs)
     {
         for (isfs = 0; isfs < _pglsfs->IvMac(); isfs++)
@@ -501,7 +566,7 @@ PCRM TAGM::_PcrmSourceNew(long sid, PFNI pfniDir)
         goto LFail;
     while (fne.FNextFni(&fni))
     {
-        pcfl = CFL::PcflOpen(&fni, fcflNil);
+        pcfl = CFL::PcflOpen(&fni, fcflMapped);
         if (pvNil == pcfl)
             goto LFail;
         if (!pcrmSource->FAddCfl(pcfl, _cbCache))
@@ -808,6 +873,501 @@ bool TAGM::FBuildChildTag(PTAG ptagPar, CHID chid, CTG ctgChild, PTAG ptagChild)
     return fTrue;
 }
 
+/***************************************************************************
+    Mix cb bytes at pv into the hash value lu.
+***************************************************************************/
+priv ulong _LuHashRgb(ulong lu, void *pv, long cb)
+{
+    AssertIn(cb, 0, kcbMax);
+    AssertPvCb(pv, cb);
+
+    byte *pb = (byte *)pv;
+
+    while (cb-- > 0)
+        lu = (lu ^ *pb++) * 16777619;
+    return lu;
+}
+
+/***************************************************************************
+    Look for *pcki in the sorted GL of CKIs.  Returns whether it's there,
+    and where it is or would go in *picki.
+***************************************************************************/
+priv bool _FFindCki(PGL pglcki, CKI *pcki, long *picki)
+{
+    AssertPo(pglcki, 0);
+    AssertVarMem(pcki);
+    AssertVarMem(picki);
+
+    long ivMin, ivLim, iv;
+    CKI cki;
+
+    for (ivMin = 0, ivLim = pglcki->IvMac(); ivMin < ivLim;)
+    {
+        iv = (ivMin + ivLim) / 2;
+        pglcki->Get(iv, &cki);
+        if (cki.ctg < pcki->ctg || cki.ctg == pcki->ctg && cki.cno < pcki->cno)
+            ivMin = iv + 1;
+        else
+            ivLim = iv;
+    }
+    *picki = ivMin;
+    if (ivMin == pglcki->IvMac())
+        return fFalse;
+    pglcki->Get(ivMin, &cki);
+    return cki.ctg == pcki->ctg && cki.cno == pcki->cno;
+}
+
+/***************************************************************************
+    Fill in the header that identifies pcflSource's cache file.
+***************************************************************************/
+priv bool _FGetTch(long sid, PCFL pcflSource, TCH *ptch)
+{
+    AssertPo(pcflSource, 0);
+    AssertVarMem(ptch);
+
+    FNI fniSource;
+
+    ClearPb(ptch, size(TCH));
+    ptch->bo = kboCur;
+    ptch->osk = koskCur;
+    ptch->lwVersion = klwVersionTagCache;
+    ptch->sid = sid;
+    ptch->cckiSource = pcflSource->Ccki();
+    pcflSource->GetFni(&fniSource);
+    return fniSource.FGetModTime(&ptch->timSource);
+}
+
+/***************************************************************************
+    Copy a chunk's data and name (but not its children) from pcflSrc to
+    pcflDst, keeping its CTG and CNO.
+***************************************************************************/
+priv bool _FCopyChunkData(PCFL pcflSrc, PCFL pcflDst, CTG ctg, CNO cno)
+{
+    AssertPo(pcflSrc, 0);
+    AssertPo(pcflDst, 0);
+
+    BLCK blck;
+    STN stn;
+
+    if (!pcflSrc->FFind(ctg, cno, &blck) || !pcflDst->FPutBlck(&blck, ctg, cno))
+        return fFalse;
+    if (pcflSrc->FGetName(ctg, cno, &stn) && stn.Cch() > 0 && !pcflDst->FSetName(ctg, cno, &stn))
+        return fFalse;
+    return fTrue;
+}
+
+/***************************************************************************
+    Make sure that pcflCache (opened from disk) still matches pcflSource
+    and read its list of complete chunks into *ppglckiTree.  Every chunk
+    in the cache must be in the source with the same size and packing,
+    and at least as many children.
+***************************************************************************/
+priv bool _FVerifyCache(PCFL pcflCache, PCFL pcflSource, TCH *ptch, PGL *ppglckiTree)
+{
+    AssertPo(pcflCache, 0);
+    AssertPo(pcflSource, 0);
+    AssertVarMem(ptch);
+    AssertVarMem(ppglckiTree);
+
+    TCH tch;
+    BLCK blck, blckSource;
+    CKI cki;
+    long icki, ckid;
+    short bo, osk;
+
+    *ppglckiTree = pvNil;
+    if (!pcflCache->FFind(kctgTagCacheHead, 0, &blck) || blck.Cb() != size(TCH) ||
+        !blck.FReadRgb(&tch, size(TCH), 0) || !FEqualRgb(&tch, ptch, size(TCH)))
+    {
+        goto LFail;
+    }
+    if (!pcflCache->FFind(kctgTagCacheTree, 0, &blck) || pvNil == (*ppglckiTree = GL::PglRead(&blck, &bo, &osk)) ||
+        kboCur != bo || koskCur != osk || size(CKI) != (*ppglckiTree)->CbEntry())
+    {
+        goto LFail;
+    }
+
+    for (icki = 0; icki < pcflCache->Ccki(); icki++)
+    {
+        AssertDo(pcflCache->FGetCki(icki, &cki, &ckid, &blck), 0);
+        if (kctgTagCacheHead == cki.ctg || kctgTagCacheTree == cki.ctg)
+            continue;
+        if (!pcflSource->FFind(cki.ctg, cki.cno, &blckSource) || blckSource.Cb(fTrue) != blck.Cb(fTrue) ||
+            blckSource.FPacked() != blck.FPacked() || pcflSource->Ckid(cki.ctg, cki.cno) < ckid)
+        {
+            goto LFail;
+        }
+    }
+    for (icki = 0; icki < (*ppglckiTree)->IvMac(); icki++)
+    {
+        (*ppglckiTree)->Get(icki, &cki);
+        if (!pcflCache->FFind(cki.ctg, cki.cno) ||
+            pcflCache->Ckid(cki.ctg, cki.cno) != pcflSource->Ckid(cki.ctg, cki.cno))
+        {
+            goto LFail;
+        }
+    }
+    return fTrue;
+LFail:
+    ReleasePpo(ppglckiTree);
+    return fFalse;
+}
+
+/***************************************************************************
+    Determines whether chunks from source sid should be cached to HD.  As
+    with _FDetermineIfSourceHD, the return value is whether the function
+    completed without error.  The answer is remembered in the source's SFS,
+    since PbacoFetch asks on every fetch.
+***************************************************************************/
+bool TAGM::_FUseCacheHD(long sid, bool *pfUseCache)
+{
+    AssertThis(0);
+    Assert(sid >= 0, "Invalid sid");
+    AssertVarMem(pfUseCache);
+
+    long isfs;
+    SFS sfs;
+    bool fSourceIsOnHD;
+    FNI fniHD;
+
+    for (isfs = 0; isfs < _pglsfs->IvMac(); isfs++)
+    {
+        _pglsfs->Get(isfs, &sfs);
+        if (sid == sfs.sid && tMaybe != sfs.tCacheHD)
+        {
+            *pfUseCache = (tYes == sfs.tCacheHD);
+            return fTrue;
+        }
+    }
+
+    if (!_FDetermineIfSourceHD(sid, &fSourceIsOnHD))
+        return fFalse;
+    if (!fSourceIsOnHD)
+        *pfUseCache = fTrue;
+    else
+        *pfUseCache = _FGetFniHD(sid, &fniHD) && (fniHD.Grfvk() & fvkNetwork);
+
+    // _FDetermineIfSourceHD made sure there's an SFS for sid
+    for (isfs = 0; isfs < _pglsfs->IvMac(); isfs++)
+    {
+        _pglsfs->Get(isfs, &sfs);
+        if (sid == sfs.sid)
+        {
+            sfs.tCacheHD = (*pfUseCache ? tYes : tNo);
+            _pglsfs->Put(isfs, &sfs);
+            break;
+        }
+    }
+    return fTrue;
+}
+
+/***************************************************************************
+    Find (creating if need be) the HD cache directory.  The first time
+    through, get rid of whatever earlier sessions left over the bound.
+***************************************************************************/
+bool TAGM::_FEnsureCacheDir(void)
+{
+    AssertThis(0);
+
+    FNI fni;
+    STN stn;
+
+    if (kftgDir == _fniCache.Ftg())
+        return fTrue;
+
+    if (!fni.FGetTemp() || !fni.FSetLeaf(pvNil, kftgDir))
+        return fFalse;
+    stn = PszLit("3DMovie Cache");
+    if (!fni.FDownDir(&stn, ffniCreateDir | ffniMoveToDir))
+        return fFalse;
+    _fniCache = fni;
+    _TrimCacheHD();
+    return fTrue;
+}
+
+/***************************************************************************
+    Get the name of the cache file for pcflSource.  The name is a hash of
+    the sid and the source file's path, modification time and chunk
+    count, so a changed source file doesn't find an old cache file.
+***************************************************************************/
+bool TAGM::_FGetFniCache(long sid, PCFL pcflSource, PFNI pfni)
+{
+    AssertThis(0);
+    AssertPo(pcflSource, 0);
+    AssertVarMem(pfni);
+
+    TCH tch;
+    FNI fniSource;
+    STN stn;
+    ulong lu;
+
+    if (!_FGetTch(sid, pcflSource, &tch) || !_FEnsureCacheDir())
+        return fFalse;
+    pcflSource->GetFni(&fniSource);
+    fniSource.GetStnPath(&stn);
+    lu = _LuHashRgb(0x811C9DC5, &tch, size(TCH));
+    lu = _LuHashRgb(lu, stn.Psz(), stn.Cch() * size(achar));
+
+    *pfni = _fniCache;
+    stn.FFormatSz(PszLit("%08x"), lu);
+    return pfni->FSetLeaf(&stn, kftgTagCache);
+}
+
+/***************************************************************************
+    Get the CRF on pcflSource's cache file, opening the file if this is
+    the first time it's needed.  If there is no usable file and fCreate is
+    set, a new one is created.  *pitcf is set to the TCF for pcflSource
+    whenever there is one, even if pvNil is returned.
+***************************************************************************/
+PCRF TAGM::_PcrfCacheGet(long sid, PCFL pcflSource, bool fCreate, long *pitcf)
+{
+    AssertThis(0);
+    Assert(sid >= 0, "Invalid sid");
+    AssertPo(pcflSource, 0);
+    AssertVarMem(pitcf);
+
+    long itcf;
+    TCF tcf;
+    TCH tch;
+    FNI fni;
+    PCFL pcfl = pvNil;
+    PGL pglcki = pvNil;
+
+    for (itcf = 0; itcf < _pgltcf->IvMac(); itcf++)
+    {
+        _pgltcf->Get(itcf, &tcf);
+        if (pcflSource == tcf.pcflSource)
+            goto LHaveTcf;
+    }
+    ClearPb(&tcf, size(TCF));
+    tcf.sid = sid;
+    tcf.pcflSource = pcflSource;
+    if (!_pgltcf->FAdd(&tcf, &itcf))
+        return pvNil;
+LHaveTcf:
+    *pitcf = itcf;
+    if (pvNil != tcf.pcrfCache)
+        return tcf.pcrfCache;
+    if (tcf.fLooked && (!fCreate || tcf.fFailed))
+        return pvNil;
+
+    if (!_FGetFniCache(sid, pcflSource, &fni) || !_FGetTch(sid, pcflSource, &tch))
+        goto LFail;
+    if (!tcf.fLooked)
+    {
+        tcf.fLooked = fTrue;
+        if (tYes == fni.TExists() && pvNil != (pcfl = CFL::PcflOpen(&fni, fcflWriteEnable)))
+        {
+            if (!_FVerifyCache(pcfl, pcflSource, &tch, &pglcki))
+            {
+                // Left over from a different version of the source file
+                ReleasePpo(&pcfl);
+                fni.FDelete();
+            }
+        }
+    }
+    if (pvNil == pcfl)
+    {
+        if (!fCreate)
+        {
+            _pgltcf->Put(itcf, &tcf);
+            return pvNil;
+        }
+        pcfl = CFL::PcflCreate(&fni, fcflNil);
+        if (pvNil == pcfl || !pcfl->FPutPv(&tch, size(TCH), kctgTagCacheHead, 0) ||
+            pvNil == (pglcki = GL::PglNew(size(CKI))))
+        {
+            goto LFail;
+        }
+        tcf.fDirty = fTrue;
+    }
+    tcf.pcrfCache = CRF::PcrfNew(pcfl, _cbCache);
+    if (pvNil == tcf.pcrfCache)
+        goto LFail;
+    ReleasePpo(&pcfl);
+    tcf.pglckiTree = pglcki;
+    _pgltcf->Put(itcf, &tcf);
+    return tcf.pcrfCache;
+LFail:
+    if (pvNil != pcfl)
+    {
+        // don't leave a half made cache file behind
+        pcfl->SetTemp(fTrue);
+        ReleasePpo(&pcfl);
+    }
+    ReleasePpo(&pglcki);
+    tcf.fLooked = fTrue;
+    tcf.fFailed = fTrue;
+    _pgltcf->Put(itcf, &tcf);
+    return pvNil;
+}
+
+/***************************************************************************
+    Copy the chunk and all its descendents from the source file to the
+    cache file of TCF itcf.  PbacoFetch only serves chunks that are cached
+    along with all their descendents, so if fCacheChildChunks is fFalse and
+    the chunk has children, there's nothing worth copying.
+***************************************************************************/
+bool TAGM::_FCacheChunk(long itcf, CTG ctg, CNO cno, bool fCacheChildChunks)
+{
+    AssertThis(0);
+    AssertIn(itcf, 0, _pgltcf->IvMac());
+
+    TCF tcf;
+    PCFL pcfl;
+    CGE cge;
+    KID kid;
+    CKI cki;
+    long icki, ikid;
+    ulong grfcgeIn = fcgeNil;
+    ulong grfcgeOut;
+
+    _pgltcf->Get(itcf, &tcf);
+    AssertPo(tcf.pcrfCache, 0);
+    pcfl = tcf.pcrfCache->Pcfl();
+
+    cki.ctg = ctg;
+    cki.cno = cno;
+    if (_FFindCki(tcf.pglckiTree, &cki, &icki))
+        return fTrue; // already cached, children and all
+    if (!fCacheChildChunks && tcf.pcflSource->Ckid(ctg, cno) > 0)
+        return fTrue; // it could never be served from the cache
+
+    tcf.fDirty = fTrue;
+    _pgltcf->Put(itcf, &tcf);
+
+    // Cache the chunk specified by the tag and all its descendents, with
+    // the same links as in the source.  A chunk is marked complete on the
+    // way back up, once all its children are.
+    cge.Init(tcf.pcflSource, ctg, cno);
+    while (cge.FNextKid(&kid, &cki, &grfcgeOut, grfcgeIn))
+    {
+        grfcgeIn = fcgeNil;
+        if (grfcgeOut & fcgeError)
+            return fFalse;
+        if (grfcgeOut & fcgePre)
+        {
+            if (!pcfl->FFind(kid.cki.ctg, kid.cki.cno) && !_FCopyChunkData(tcf.pcflSource, pcfl, kid.cki.ctg, kid.cki.cno))
+            {
+                return fFalse;
+            }
+            if (!(grfcgeOut & fcgeRoot) &&
+                !pcfl->FGetIkid(cki.ctg, cki.cno, kid.cki.ctg, kid.cki.cno, kid.chid, &ikid) &&
+                !pcfl->FAdoptChild(cki.ctg, cki.cno, kid.cki.ctg, kid.cki.cno, kid.chid, fFalse))
+            {
+                return fFalse;
+            }
+            if (_FFindCki(tcf.pglckiTree, &kid.cki, &icki))
+            {
+                grfcgeIn = fcgeSkipToSib;
+                continue;
+            }
+        }
+        if ((grfcgeOut & fcgePost) && !_FFindCki(tcf.pglckiTree, &kid.cki, &icki) &&
+            !tcf.pglckiTree->FInsert(icki, &kid.cki))
+        {
+            return fFalse;
+        }
+    }
+    return fTrue;
+}
+
+/***************************************************************************
+    Write out the cache files for source sid (or all sources if sid is
+    sidNil) that have been changed or read from.  Saving a file that was
+    only read updates its modification time, which is what _TrimCacheHD
+    goes by.
+***************************************************************************/
+void TAGM::_SaveCacheHD(long sid)
+{
+    AssertThis(0);
+
+    long itcf;
+    TCF tcf;
+    PCFL pcfl;
+    BLCK blck;
+    long cerc = vpers->Cerc();
+
+    for (itcf = 0; itcf < _pgltcf->IvMac(); itcf++)
+    {
+        _pgltcf->Get(itcf, &tcf);
+        if ((sid != sidNil && tcf.sid != sid) || pvNil == tcf.pcrfCache || !(tcf.fDirty || tcf.fUsed))
+            continue;
+        pcfl = tcf.pcrfCache->Pcfl();
+        if (pcfl->FPut(tcf.pglckiTree->CbOnFile(), kctgTagCacheTree, 0, &blck) && tcf.pglckiTree->FWrite(&blck) &&
+            pcfl->FSave(kctgSoc))
+        {
+            tcf.fDirty = tcf.fUsed = fFalse;
+            _pgltcf->Put(itcf, &tcf);
+        }
+    }
+
+    // The cache is only an optimization, so failing to save isn't an error
+    while (vpers->Cerc() > cerc)
+        vpers->FPop();
+}
+
+/***************************************************************************
+    Delete the least recently used cache files until the cache directory
+    fits in kcbCacheHDMax.  Files that are open are left alone.
+***************************************************************************/
+void TAGM::_TrimCacheHD(void)
+{
+    AssertThis(0);
+
+    FNE fne;
+    FTG ftg = kftgTagCache;
+    PFIL pfil;
+    PGL pgltce = pvNil;
+    TCE tce, tceOld;
+    long itce, itceOld;
+    long cbTot = 0;
+    long cerc = vpers->Cerc();
+
+    if (kftgDir != _fniCache.Ftg())
+        return;
+    if (pvNil == (pgltce = GL::PglNew(size(TCE))) || !fne.FInit(&_fniCache, &ftg, 1))
+        goto LDone;
+    while (fne.FNextFni(&tce.fni))
+    {
+        if (!tce.fni.FGetModTime(&tce.tim))
+            continue;
+        pfil = FIL::PfilFromFni(&tce.fni);
+        tce.fOpen = (pvNil != pfil);
+        if (!tce.fOpen && pvNil == (pfil = FIL::PfilOpen(&tce.fni)))
+            continue;
+        tce.cb = pfil->FpMac();
+        if (!tce.fOpen)
+            ReleasePpo(&pfil);
+        if (!pgltce->FAdd(&tce))
+            goto LDone;
+        cbTot += tce.cb;
+    }
+
+    while (cbTot > kcbCacheHDMax)
+    {
+        itceOld = ivNil;
+        for (itce = 0; itce < pgltce->IvMac(); itce++)
+        {
+            pgltce->Get(itce, &tce);
+            if (!tce.fOpen && (ivNil == itceOld || tce.tim < tceOld.tim))
+            {
+                itceOld = itce;
+                tceOld = tce;
+            }
+        }
+        if (ivNil == itceOld)
+            break; // everything left is in use
+        tceOld.fni.FDelete();
+        cbTot -= tceOld.cb;
+        pgltce->Delete(itceOld);
+    }
+LDone:
+    ReleasePpo(&pgltce);
+    while (vpers->Cerc() > cerc)
+        vpers->FPop();
+}
+
 /***************************************************************************
     Put specified chunk in cache file, if it's not there yet
 ***************************************************************************/
@@ -819,18 +1379,17 @@ bool TAGM::FCacheTagToHD(PTAG ptag, bool fCacheChildChunks)
 
     PCRM pcrmSource;
     PCRF pcrfSource;
-    bool fSourceIsOnHD;
-    PCFL pcfl;
+    bool fUseCache;
+    long itcf;
+    long cerc;
 
     if (ksidUseCrf == ptag->sid)
         return fTrue;
 
-    // FOONE: Disable caching for now. It doesn't seem to be working properly.
-    return fTrue;
-    // Do nothing if the source itself is already on HD
-    if (!_FDetermineIfSourceHD(ptag->sid, &fSourceIsOnHD))
+    // Do nothing if the source itself is already on a local HD
+    if (!_FUseCacheHD(ptag->sid, &fUseCache))
         goto LFail;
-    if (fSourceIsOnHD)
+    if (!fUseCache)
         return fTrue;
 
     pcrmSource = _PcrmSourceGet(ptag->sid);
@@ -840,31 +1399,14 @@ bool TAGM::FCacheTagToHD(PTAG ptag, bool fCacheChildChunks)
     if (pvNil == pcrfSource)
         goto LFail; // chunk not found
 
-    pcfl = pcrfSource->Pcfl();
-    if (fCacheChildChunks)
+    cerc = vpers->Cerc();
+    if (pvNil == _PcrfCacheGet(ptag->sid, pcrfSource->Pcfl(), fTrue, &itcf) ||
+        !_FCacheChunk(itcf, ptag->ctg, ptag->cno, fCacheChildChunks))
     {
-        // Cache the chunk specified by the tag, and all its child
-        // chunks.
-        CGE cge;
-        KID kid;
-        ulong grfcgeIn = 0;
-        ulong grfcgeOut;
-
-        cge.Init(pcfl, ptag->ctg, ptag->cno);
-        while (cge.FNextKid(&kid, pvNil, &grfcgeOut, grfcgeIn))
-        {
-            if (grfcgeOut & fcgePre)
-            {
-                if (!pcfl->FEnsureOnExtra(kid.cki.ctg, kid.cki.cno))
-                    goto LFail;
-            }
-        }
-    }
-    else
-    {
-        // Just cache the chunk specified by the tag
-        if (!pcfl->FEnsureOnExtra(ptag->ctg, ptag->cno))
-            goto LFail;
+        // The chunk can still be read from the source, so this isn't
+        // worth reporting
+        while (vpers->Cerc() > cerc)
+            vpers->FPop();
     }
     return fTrue;
 LFail:
@@ -885,6 +1427,13 @@ PBACO TAGM::PbacoFetch(PTAG ptag, PFNRPO pfnrpo, bool fUseCD)
 
     PBACO pbaco = pvNil;
     PCRM pcrmSource;
+    PCRF pcrfSource;
+    PCRF pcrfCache;
+    bool fUseCache;
+    long itcf, icki;
+    TCF tcf;
+    CKI cki;
+    long cerc;
 
     if (ptag->sid == ksidUseCrf)
     {
@@ -899,12 +1448,118 @@ PBACO TAGM::PbacoFetch(PTAG ptag, PFNRPO pfnrpo, bool fUseCD)
     if (pvNil == pcrmSource)
         return pvNil;
 
+    // Use the HD cache if the chunk is there along with all its
+    // descendents.  The cache file may be from an earlier session.  Only
+    // sources that get cached are worth looking up the chunk in.
+    cerc = vpers->Cerc();
+    if (_FUseCacheHD(ptag->sid, &fUseCache) && fUseCache &&
+        pvNil != (pcrfSource = pcrmSource->PcrfFindChunk(ptag->ctg, ptag->cno)) &&
+        pvNil != (pcrfCache = _PcrfCacheGet(ptag->sid, pcrfSource->Pcfl(), fFalse, &itcf)))
+    {
+        _pgltcf->Get(itcf, &tcf);
+        cki.ctg = ptag->ctg;
+        cki.cno = ptag->cno;
+        if (_FFindCki(tcf.pglckiTree, &cki, &icki))
+        {
+            pbaco = pcrfCache->PbacoFetch(ptag->ctg, ptag->cno, pfnrpo);
+            if (pvNil != pbaco)
+            {
+                if (!tcf.fUsed)
+                {
+                    tcf.fUsed = fTrue;
+                    _pgltcf->Put(itcf, &tcf);
+                }
+                return pbaco;
+            }
+        }
+    }
+    // Fall back on the source
+    while (vpers->Cerc() > cerc)
+        vpers->FPop();
+
     pbaco = pcrmSource->PbacoFetch(ptag->ctg, ptag->cno, pfnrpo);
     return pbaco;
 }
 
+/***************************************************************************
+    Start reading the tag's chunk (and, if fPrefetchChildren, its
+    descendents) on the prefetch thread, from the same file PbacoFetch
+    will read it from.  This never hits the CD, and failure isn't an
+    error, since PbacoFetch just reads the chunk itself.
+***************************************************************************/
+void TAGM::PrefetchTag(PTAG ptag, bool fPrefetchChildren, long crep)
+{
+    AssertThis(0);
+    AssertVarMem(ptag);
+    Assert(ptag->sid >= 0, "Invalid sid");
+
+    PCRM pcrmSource;
+    PCRF pcrf;
+    PCRF pcrfCache;
+    bool fUseCache;
+    long itcf, icki;
+    TCF tcf;
+    CKI cki;
+    KID kid;
+    CGE cge;
+    ulong grfcge;
+    long cerc;
+
+    cerc = vpers->Cerc();
+    if (ptag->sid == ksidUseCrf)
+    {
+        // the tag may not be open yet
+        if (pvNil == (pcrf = ptag->pcrf))
+            goto LDone;
+    }
+    else
+    {
+        pcrmSource = _PcrmSourceGet(ptag->sid, fTrue);
+        if (pvNil == pcrmSource)
+            goto LDone;
+        pcrf = pcrmSource->PcrfFindChunk(ptag->ctg, ptag->cno);
+        if (pvNil == pcrf)
+            goto LDone;
+
+        // same choice as PbacoFetch: the HD cache, if the chunk is there
+        // along with all its descendents
+        if (_FUseCacheHD(ptag->sid, &fUseCache) && fUseCache &&
+            pvNil != (pcrfCache = _PcrfCacheGet(ptag->sid, pcrf->Pcfl(), fFalse, &itcf)))
+        {
+            _pgltcf->Get(itcf, &tcf);
+            cki.ctg = ptag->ctg;
+            cki.cno = ptag->cno;
+            if (_FFindCki(tcf.pglckiTree, &cki, &icki))
+                pcrf = pcrfCache;
+        }
+    }
+
+    if (!pcrf->FPrefetchAsync(ptag->ctg, ptag->cno, pvNil, rscNil, crep) || !fPrefetchChildren)
+        goto LDone;
+
+    // stop at the first chunk that can't be queued, since the queue is
+    // probably full
+    cge.Init(pcrf->Pcfl(), ptag->ctg, ptag->cno);
+    while (cge.FNextKid(&kid, &cki, &grfcge, fcgeNil))
+    {
+        if (grfcge & fcgeError)
+            break;
+        if ((grfcge & fcgePre) && !(grfcge & fcgeRoot) &&
+            !pcrf->FPrefetchAsync(kid.cki.ctg, kid.cki.cno, pvNil, rscNil, crep))
+        {
+            break;
+        }
+    }
+
+LDone:
+    while (vpers->Cerc() > cerc)
+        vpers->FPop();
+}
+
 /***************************************************************************
     Clear the cache for source sid.  If sid is sidNil, clear all caches.
+    Clearing the HD cache writes the cache files out and trims the cache
+    directory; what's in them is kept for later.
 ***************************************************************************/
 void TAGM::ClearCache(long sid, ulong grftagm)
 {
@@ -912,58 +1567,52 @@ void TAGM::ClearCache(long sid, ulong grftagm)
     Assert(sid >= 0, "Invalid sid");
 
     long isfs, isfsMac;
+    long itcf;
     long cbMax;
+    TCF tcf;
 
     vpappb->BeginLongOp();
 
-    isfsMac = _pglsfs->IvMac();
-    for (isfs = 0; isfs < isfsMac; isfs++)
+    if (grftagm & ftagmFile)
     {
-        long icrf, icrfMac;
-        SFS sfs;
-        PCRM pcrmSource;
+        _SaveCacheHD(sid);
+        _TrimCacheHD();
+    }
 
-        _pglsfs->Get(isfs, &sfs);
-        if ((sid != sidNil && sfs.sid != sid) || sfs.pcrmSource == pvNil)
-            continue;
-        if (grftagm & ftagmFile)
-        {
-            // The following line may seem silly, since we already have
-            // sfs.pcrmSource.  But it ensures that the crm's CD is inserted,
-            // since the FReopen() will need the CD to be in.
-            pcrmSource = _PcrmSourceGet(sfs.sid);
-            if (pvNil == pcrmSource)
-                continue;
-        }
-        else
-        {
-            // Just doing a memory purge, so sfs.pcrmSource is valid.
-            pcrmSource = sfs.pcrmSource;
-        }
-        icrfMac = pcrmSource->Ccrf();
-        for (icrf = 0; icrf < icrfMac; icrf++)
+    if (grftagm & ftagmMemory)
+    {
+        isfsMac = _pglsfs->IvMac();
+        for (isfs = 0; isfs < isfsMac; isfs++)
         {
-            PCRF pcrf;
+            long icrf, icrfMac;
+            SFS sfs;
 
-            pcrf = pcrmSource->PcrfGet(icrf);
-            AssertPo(pcrf->Pcfl(), 0);
-            if (pcrf->Pcfl() != pvNil)
+            _pglsfs->Get(isfs, &sfs);
+            if ((sid != sidNil && sfs.sid != sid) || sfs.pcrmSource == pvNil)
+                continue;
+            icrfMac = sfs.pcrmSource->Ccrf();
+            for (icrf = 0; icrf < icrfMac; icrf++)
             {
-                if (grftagm & ftagmFile)
-                {
-                    // Clear the HD cache by reopening the file
-                    pcrf->Pcfl()->FReopen(); // Ignore error
-                }
-                if (grftagm & ftagmMemory)
-                {
-                    // Clear RAM cache (for BACOs with 0 cactRef) by
-                    // temporarily setting the CRF's cbMax to 0
-                    cbMax = pcrf->CbMax();
-                    pcrf->SetCbMax(0);
-                    pcrf->SetCbMax(cbMax);
-                }
+                PCRF pcrf;
+
+                // Clear RAM cache (for BACOs with 0 cactRef) by
+                // temporarily setting the CRF's cbMax to 0
+                pcrf = sfs.pcrmSource->PcrfGet(icrf);
+                AssertPo(pcrf, 0);
+                cbMax = pcrf->CbMax();
+                pcrf->SetCbMax(0);
+                pcrf->SetCbMax(cbMax);
             }
         }
+        for (itcf = 0; itcf < _pgltcf->IvMac(); itcf++)
+        {
+            _pgltcf->Get(itcf, &tcf);
+            if ((sid != sidNil && tcf.sid != sid) || pvNil == tcf.pcrfCache)
+                continue;
+            cbMax = tcf.pcrfCache->CbMax();
+            tcf.pcrfCache->SetCbMax(0);
+            tcf.pcrfCache->SetCbMax(cbMax);
+        }
     }
 
     vpappb->EndLongOp();
@@ -1107,11 +1756,15 @@ void TAGM::AssertValid(ulong grf)
 {
     long isfs;
     SFS sfs;
+    long itcf;
+    TCF tcf;
 
     TAGM_PAR::AssertValid(fobjAllocated);
     AssertPo(_pglsfs, 0);
     AssertPo(_pgstSource, 0);
     Assert(pvNil != _pfninscd, "bad _pfninscd");
+    AssertPo(_pgltcf, 0);
+    AssertPo(&_fniCache, ffniDir | ffniEmpty);
 
     for (isfs = 0; isfs < _pglsfs->IvMac(); isfs++)
     {
@@ -1120,6 +1773,13 @@ void TAGM::AssertValid(ulong grf)
         AssertPo(&sfs.fniCD, ffniDir | ffniEmpty);
         AssertNilOrPo(sfs.pcrmSource, 0);
     }
+    for (itcf = 0; itcf < _pgltcf->IvMac(); itcf++)
+    {
+        _pgltcf->Get(itcf, &tcf);
+        AssertNilOrPo(tcf.pcrfCache, 0);
+        Assert((pvNil == tcf.pcrfCache) == (pvNil == tcf.pglckiTree), "cache file without chunk list");
+        AssertNilOrPo(tcf.pglckiTree, 0);
+    }
 }
 
 /***************************************************************************
@@ -1131,15 +1791,24 @@ void TAGM::MarkMem(void)
 
     long isfs;
     SFS sfs;
+    long itcf;
+    TCF tcf;
 
     TAGM_PAR::MarkMem();
     MarkMemObj(_pglsfs);
     MarkMemObj(_pgstSource);
+    MarkMemObj(_pgltcf);
     for (isfs = 0; isfs < _pglsfs->IvMac(); isfs++)
     {
         _pglsfs->Get(isfs, &sfs);
         MarkMemObj(sfs.pcrmSource);
     }
+    for (itcf = 0; itcf < _pgltcf->IvMac(); itcf++)
+    {
+        _pgltcf->Get(itcf, &tcf);
+        MarkMemObj(tcf.pcrfCache);
+        MarkMemObj(tcf.pglckiTree);
+    }
 }
 #endif // DEBUG
 
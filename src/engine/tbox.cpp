@@ -185,6 +185,8 @@ class TUND : public TUND_PAR
 
     virtual bool FDo(PDOCB pdocb);
     virtual bool FUndo(PDOCB pdocb);
+    virtual long CbMem(void);
+    virtual void Bury(PMUNB pmunbNext);
 };
 
 RTCLASS(TUND)
@@ -1838,7 +1840,8 @@ PTBOX TBOX::PtboxNew(PSCEN pscen, RC *prcRel, bool fStory)
     ptbox->_pscen = pscen;
     ptbox->_fStory = fStory;
     ptbox->SetAcrBack(kacrClear, fdocNil);
-    Assert(pscen == pvNil || pscen->Pmvie()->CundbMax() == 1, "TUND assumes there is one level of undo!");
+    // The text box's own undo list only holds the last edit, for
+    // combining typing.  The movie keeps the history (see TUND::Bury).
     ptbox->SetCundbMax(1);
 
     return ptbox;
@@ -3502,6 +3505,56 @@ LFail:
     return (fFalse);
 }
 
+/****************************************************
+ *
+ * Return roughly how much memory this undo holds.
+ *
+ * Parameters:
+ *	None.
+ *
+ * Returns:
+ *  Bytes held.
+ *
+ ****************************************************/
+long TUND::CbMem(void)
+{
+    AssertThis(0);
+
+    if (!_pundb->FIs(kclsRTUN))
+        return size(TUND);
+    return size(TUND) + ((PRTUN)_pundb)->CbMem();
+}
+
+/****************************************************
+ *
+ * Another undo is going on top of this one.  Clear the
+ * text box's own undo list so that more typing starts
+ * a new undo rather than growing this buried one.
+ *
+ * Parameters:
+ *	pmunbNext - The undo going on top.
+ *
+ * Returns:
+ *  None.
+ *
+ ****************************************************/
+void TUND::Bury(PMUNB pmunbNext)
+{
+    AssertThis(0);
+    AssertPo(pmunbNext, 0);
+
+    PTBOX ptbox;
+
+    if (_iscen != _pmvie->Iscen() || _pmvie->Pscen() == pvNil)
+        return;
+
+    ptbox = _pmvie->Pscen()->PtboxFromItbox(_itbox);
+    AssertNilOrPo(ptbox, 0);
+
+    if (ptbox != pvNil)
+        ptbox->ParClearUndo();
+}
+
 #ifdef DEBUG
 /****************************************************
  * Mark memory used by the TUND
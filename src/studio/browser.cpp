@@ -90,6 +90,7 @@ RTCLASS(BRWR)
 RTCLASS(BRWI)
 RTCLASS(BCL)
 RTCLASS(BCLS)
+RTCLASS(TIDX)
 RTCLASS(FNET)
 
 BEGIN_CMD_MAP(BRWD, GOK)
@@ -1207,23 +1208,87 @@ void BRWL::_CacheContext(void)
     }
 }
 
+/****************************************************
+ *
+ * Sort key for a THD
+ *
+ ****************************************************/
+struct THK
+{
+    long lwRun; // run of THDs from one product (0 if not sorting by sid)
+    long lwKey; // the chid or cno being sorted on
+    long ithd;  // index of the THD before sorting
+};
+
+/****************************************************
+ *
+ * Compare two sort keys.  Ties keep their original
+ * order, so the file enumerated first wins.
+ *
+ ****************************************************/
+static bool _FThkLe(THK *pthk1, THK *pthk2)
+{
+    if (pthk1->lwRun != pthk2->lwRun)
+        return pthk1->lwRun < pthk2->lwRun;
+    return pthk1->lwKey <= pthk2->lwKey;
+}
+
+/****************************************************
+ *
+ * Stable bottom up merge sort of cthk keys.  prgthkT
+ * is scratch space for another cthk keys.  Returns
+ * whichever of the two holds the sorted keys.
+ *
+ ****************************************************/
+static THK *_PrgthkSort(THK *prgthk, THK *prgthkT, long cthk)
+{
+    long cthkRun, ithkMin, ithk1, ithk2, ithk1Lim, ithk2Lim, ithkDst;
+    THK *prgthkSwap;
+
+    for (cthkRun = 1; cthkRun < cthk; cthkRun *= 2)
+    {
+        for (ithkMin = 0; ithkMin < cthk; ithkMin += 2 * cthkRun)
+        {
+            ithk1 = ithkDst = ithkMin;
+            ithk1Lim = ithk2 = LwMin(ithkMin + cthkRun, cthk);
+            ithk2Lim = LwMin(ithkMin + 2 * cthkRun, cthk);
+            while (ithk1 < ithk1Lim && ithk2 < ithk2Lim)
+            {
+                if (_FThkLe(&prgthk[ithk1], &prgthk[ithk2]))
+                    prgthkT[ithkDst++] = prgthk[ithk1++];
+                else
+                    prgthkT[ithkDst++] = prgthk[ithk2++];
+            }
+            while (ithk1 < ithk1Lim)
+                prgthkT[ithkDst++] = prgthk[ithk1++];
+            while (ithk2 < ithk2Lim)
+                prgthkT[ithkDst++] = prgthk[ithk2++];
+        }
+        prgthkSwap = prgthk;
+        prgthk = prgthkT;
+        prgthkT = prgthkSwap;
+    }
+    return prgthk;
+}
+
 /****************************************************
  *
  * Sort the Thd gl by _bws
- * Uses bubble sort
+ * Uses a merge sort, then drops all but the first
+ * of any THDs with equal keys
  *
  ****************************************************/
 void BRWL::_SortThd(void)
 {
     AssertThis(0);
 
-    long ithd;
-    long jthd;
-    long *plwJ, *plwI;
-    THD thdi;
-    THD thdj;
-    long sid;
-    long jthdMin = 0;
+    long ithd, ithdMac, ithk, cthdKeep;
+    long lwRun, sid;
+    THK *prgthk = pvNil;
+    THK *prgthkSort;
+    long *prgcthdDrop;
+    PGL pglthdOld = pvNil;
+    THD thd;
     bool fSortBySid;
 
     if (_bws == kbwsIndex)
@@ -1232,75 +1297,105 @@ void BRWL::_SortThd(void)
     switch (_bws)
     {
     case kbwsChid:
-        Assert(size(thdj.chidThum) == size(long), "Bad pointer cast");
-        plwJ = (long *)&thdj.chidThum;
-        plwI = (long *)&thdi.chidThum;
+        Assert(size(thd.chidThum) == size(long), "Bad key size");
         fSortBySid = fFalse;
         break;
     case kbwsCnoRoot:
-        Assert(size(thdj.tag.cno) == size(long), "Bad pointer cast");
-        plwJ = (long *)&thdj.tag.cno;
-        plwI = (long *)&thdi.tag.cno;
+        Assert(size(thd.tag.cno) == size(long), "Bad key size");
         fSortBySid = fTrue;
         break;
     default:
         Bug("Illegal _bws value");
+        return;
     }
 
-    if (fSortBySid && _pglthd->IvMac() > 0)
+    ithdMac = _pglthd->IvMac();
+    if (ithdMac < 2)
+        return;
+
+    // The keys, scratch space for the merge and a count of dropped THDs
+    if (!FAllocPv((void **)&prgthk, LwMul(ithdMac, 2 * size(THK) + size(long)), fmemNil, mprNormal))
+        goto LFail;
+    if (pvNil == (pglthdOld = _pglthd->PglDup()))
+        goto LFail;
+    prgcthdDrop = (long *)(prgthk + 2 * ithdMac);
+
+    lwRun = 0;
+    sid = 0;
+    for (ithd = 0; ithd < ithdMac; ithd++)
     {
-        _pglthd->Get(0, &thdi);
-        sid = thdi.tag.sid;
+        _pglthd->Get(ithd, &thd);
+        if (fSortBySid && ithd > 0 && thd.tag.sid != sid)
+            lwRun++;
+        sid = thd.tag.sid;
+        prgthk[ithd].lwRun = lwRun;
+        prgthk[ithd].lwKey = (_bws == kbwsChid) ? (long)thd.chidThum : (long)thd.tag.cno;
+        prgthk[ithd].ithd = ithd;
+        prgcthdDrop[ithd] = 0;
     }
-    for (ithd = 1; ithd < _pglthd->IvMac(); ithd++)
+    prgthkSort = _PrgthkSort(prgthk, prgthk + ithdMac, ithdMac);
+
+    // Allow products to share identical content but only view it once
+    for (ithk = 1; ithk < ithdMac; ithk++)
     {
-        _pglthd->Get(ithd, &thdi);
-        if (fSortBySid && thdi.tag.sid != sid)
+        if (prgthkSort[ithk].lwRun != prgthkSort[ithk - 1].lwRun ||
+            prgthkSort[ithk].lwKey != prgthkSort[ithk - 1].lwKey)
         {
-            sid = thdi.tag.sid;
-            jthdMin = ithd;
+            continue;
         }
+        prgcthdDrop[prgthkSort[ithk].ithd] = 1;
 
-        for (jthd = jthdMin; jthd < ithd; jthd++)
-        {
-            _pglthd->Get(jthd, &thdj);
-            if (*plwJ < *plwI)
-                continue;
-
-            // Allow products to share identical content
-            // but only view it once
-            if (*plwJ == *plwI)
-            {
-                long ithdT;
-                THD thdT;
-                if (pvNil != _pgst && thdi.ithd < _pgst->IvMac())
-                {
-                    Assert(thdi.ithd == ithd, "Logic error cleaning pgst");
-                    _pgst->Delete(thdi.ithd);
-                }
-
-                for (ithdT = ithd + 1; ithdT < _pglthd->IvMac(); ithdT++)
-                {
-                    _pglthd->Get(ithdT, &thdT);
-                    thdT.ithd--;
-                    _pglthd->Put(ithdT, &thdT);
-                }
 #ifdef DEBUG
-                // Note: Files for the current product was enumerated first.
-                // This determines precedence.
-                if (thdj.tag.sid == _sidDefault || thdi.tag.sid == _sidDefault)
-                    Assert(thdj.tag.sid == _sidDefault, "Browser deleting the wrong duplicate");
+        // Note: Files for the current product was enumerated first.
+        // This determines precedence.
+        THD thdKeep;
+        long ithkKeep;
+
+        for (ithkKeep = ithk - 1; prgcthdDrop[prgthkSort[ithkKeep].ithd]; ithkKeep--)
+            ;
+        pglthdOld->Get(prgthkSort[ithkKeep].ithd, &thdKeep);
+        pglthdOld->Get(prgthkSort[ithk].ithd, &thd);
+        if (thdKeep.tag.sid == _sidDefault || thd.tag.sid == _sidDefault)
+            Assert(thdKeep.tag.sid == _sidDefault, "Browser deleting the wrong duplicate");
 #endif // DEBUG
-                _pglthd->Delete(ithd);
-                ithd--;
-                break;
-            }
-            // Switch places
-            _pglthd->Put(ithd, &thdj);
-            _pglthd->Put(jthd, &thdi);
-            _pglthd->Get(ithd, &thdi);
+    }
+
+    // Remove the names of dropped THDs, last first so the indices hold
+    for (ithd = ithdMac; ithd-- > 0;)
+    {
+        if (!prgcthdDrop[ithd])
+            continue;
+        pglthdOld->Get(ithd, &thd);
+        if (pvNil != _pgst && thd.ithd < _pgst->IvMac())
+        {
+            Assert(thd.ithd == ithd, "Logic error cleaning pgst");
+            _pgst->Delete(thd.ithd);
+        }
+    }
+
+    // Turn the drop flags into the number dropped before each THD
+    for (ithd = 1; ithd < ithdMac; ithd++)
+        prgcthdDrop[ithd] += prgcthdDrop[ithd - 1];
+
+    cthdKeep = 0;
+    for (ithk = 0; ithk < ithdMac; ithk++)
+    {
+        ithd = prgthkSort[ithk].ithd;
+        if (ithk > 0 && prgthkSort[ithk].lwRun == prgthkSort[ithk - 1].lwRun &&
+            prgthkSort[ithk].lwKey == prgthkSort[ithk - 1].lwKey)
+        {
+            continue;
         }
+        pglthdOld->Get(ithd, &thd);
+        thd.ithd -= (ithd > 0) ? prgcthdDrop[ithd - 1] : 0;
+        _pglthd->Put(cthdKeep++, &thd);
     }
+    AssertDo(_pglthd->FSetIvMac(cthdKeep), "shrinking can't fail");
+
+LFail:
+    // On failure the list is simply left unsorted
+    ReleasePpo(&pglthdOld);
+    FreePpv((void **)&prgthk);
 }
 
 /****************************************************
@@ -1506,17 +1601,59 @@ bool BCL::_FBuildThd(PCRM pcrm)
     AssertNilOrPo(pcrm, 0);
 
     bool fRet = fTrue;
+    bool fIndexable, fInIndex;
     PCFL pcfl;
     long sid;
+    long itixe, ithdMin, istnMin, cerc;
     FNET fnet;
     FNI fniThd;
+    STN stnPath;
+    TIXE tixe;
+    PTIDX ptidx;
+    PGST pgst = _PgstNames();
 
     if (!fnet.FInit())
         return fFalse;
+
+    // The index only saves work; without it every file gets walked
+    ptidx = TIDX::PtidxRead();
+    ClearPb(&tixe, size(TIXE));
+    tixe.ctgRoot = _ctgRoot;
+    tixe.cnoRoot = _cnoRoot;
+    tixe.ctgContent = _ctgContent;
+    tixe.fNames = (pvNil != pgst);
+
     while (fnet.FNext(&fniThd, &sid) && fRet)
     {
         if (fniThd.Ftg() != kftgThumbDesc)
             continue;
+
+        fIndexable = fInIndex = fFalse;
+        if (pvNil != ptidx)
+        {
+            cerc = vpers->Cerc();
+            if (fniThd.FGetModTime(&tixe.tim))
+            {
+                fIndexable = fTrue;
+                fniThd.GetStnPath(&stnPath);
+                fInIndex = ptidx->FLookup(&tixe, &stnPath, &itixe);
+            }
+            else
+            {
+                // Can't tell whether the file changed, so just walk it
+                while (vpers->Cerc() > cerc)
+                    vpers->FPop();
+            }
+        }
+
+        if (fInIndex && (ptidx->Cthd(itixe) == 0 || pvNil == pcrm))
+        {
+            // Nothing to open the file for
+            if (!ptidx->FGetThds(itixe, sid, _pglthd, pgst))
+                fRet = fFalse;
+            continue;
+        }
+
         pcfl = CFL::PcflOpen(&fniThd, fcflNil);
         if (pvNil == pcfl)
         {
@@ -1524,9 +1661,14 @@ bool BCL::_FBuildThd(PCRM pcrm)
             continue;
         }
 
+        ithdMin = _pglthd->IvMac();
+        istnMin = (pvNil == pgst) ? 0 : pgst->IvMac();
+
         /* Don't use this file if it doesn't have what we're looking for */
-        if (_fDescend ? !pcfl->FFind(_ctgRoot, _cnoRoot) : pcfl->CckiCtg(_ctgRoot) == 0)
+        if (!fInIndex && (_fDescend ? !pcfl->FFind(_ctgRoot, _cnoRoot) : pcfl->CckiCtg(_ctgRoot) == 0))
         {
+            if (fIndexable)
+                ptidx->FPutThds(&tixe, &stnPath, _pglthd, ithdMin, pgst, istnMin);
             goto LContinue;
         }
 
@@ -1538,17 +1680,35 @@ bool BCL::_FBuildThd(PCRM pcrm)
             goto LContinue;
         }
 
+        if (fInIndex)
+        {
+            if (!ptidx->FGetThds(itixe, sid, _pglthd, pgst))
+                fRet = fFalse;
+            goto LContinue;
+        }
+
         if (!_FAddFileToThd(pcfl, sid))
         {
             // Error issued elsewhere
             fRet = fFalse;
             goto LContinue;
         }
+        if (fIndexable)
+            ptidx->FPutThds(&tixe, &stnPath, _pglthd, ithdMin, pgst, istnMin);
 
     LContinue:
         ReleasePpo(&pcfl);
     }
 
+    if (pvNil != ptidx)
+    {
+        // Forget files that have gone away, unless we stopped early
+        if (fRet)
+            ptidx->PruneUnused(&tixe);
+        ptidx->FSave();
+        ReleasePpo(&ptidx);
+    }
+
     return fRet;
 }
 
@@ -1737,6 +1897,391 @@ bool BCLS::_FSetNameGst(PCFL pcfl, CTG ctg, CNO cno)
     return fTrue;
 }
 
+/****************************************************
+ *
+ * Thumbnail index routines
+ *
+ * The index file is a TIXH followed by the GG of
+ * TIXEs.  Any problem reading it just means the
+ * thumbnail files get walked as if it weren't there.
+ *
+ ****************************************************/
+struct TIXH
+{
+    short bo;
+    short osk;
+    long lwVersion;
+};
+
+const long klwVersionTidx = 1;
+
+/****************************************************
+ *
+ * Compare the queries of two index entries
+ *
+ ****************************************************/
+static ulong _FcmpTixe(TIXE *ptixe1, TIXE *ptixe2)
+{
+    if (ptixe1->ctgRoot != ptixe2->ctgRoot)
+        return ptixe1->ctgRoot < ptixe2->ctgRoot ? fcmpLt : fcmpGt;
+    if (ptixe1->cnoRoot != ptixe2->cnoRoot)
+        return ptixe1->cnoRoot < ptixe2->cnoRoot ? fcmpLt : fcmpGt;
+    if (ptixe1->ctgContent != ptixe2->ctgContent)
+        return ptixe1->ctgContent < ptixe2->ctgContent ? fcmpLt : fcmpGt;
+    if (ptixe1->fNames != ptixe2->fNames)
+        return ptixe1->fNames < ptixe2->fNames ? fcmpLt : fcmpGt;
+    return fcmpEq;
+}
+
+/****************************************************
+ *
+ * Get the name of the index file
+ *
+ ****************************************************/
+bool TIDX::_FGetFni(FNI *pfni)
+{
+    AssertPo(pfni, 0);
+    STN stn;
+
+    vapp.GetFniUsers(pfni);
+    stn = PszLit("thumbs");
+    return pfni->FSetLeaf(&stn, kftgThumbIndex);
+}
+
+/****************************************************
+ *
+ * Read the index from the users directory.  Returns
+ * an empty index if there isn't a usable one on disk.
+ *
+ ****************************************************/
+PTIDX TIDX::PtidxRead(void)
+{
+    PTIDX ptidx;
+    PFIL pfil = pvNil;
+    FNI fni;
+    TIXH tixh;
+    TIXE tixe;
+    long itixe;
+    long cerc = vpers->Cerc();
+    short bo, osk;
+
+    if (pvNil == (ptidx = NewObj TIDX))
+        return pvNil;
+
+    if (_FGetFni(&fni) && tYes == fni.TExists() && pvNil != (pfil = FIL::PfilOpen(&fni)) &&
+        pfil->FpMac() > size(TIXH) && pfil->FReadRgb(&tixh, size(TIXH), 0) && kboCur == tixh.bo &&
+        koskCur == tixh.osk && klwVersionTidx == tixh.lwVersion)
+    {
+        ptidx->_pggtixe = GG::PggRead(pfil, size(TIXH), pfil->FpMac() - size(TIXH), &bo, &osk);
+        if (pvNil != ptidx->_pggtixe &&
+            (kboCur != bo || koskCur != osk || size(TIXE) != ptidx->_pggtixe->CbFixed()))
+        {
+            ReleasePpo(&ptidx->_pggtixe);
+        }
+    }
+    ReleasePpo(&pfil);
+
+    // A missing or damaged index isn't worth reporting
+    while (vpers->Cerc() > cerc)
+        vpers->FPop();
+
+    if (pvNil == ptidx->_pggtixe)
+    {
+        if (pvNil == (ptidx->_pggtixe = GG::PggNew(size(TIXE))))
+            ReleasePpo(&ptidx);
+        return ptidx;
+    }
+
+    for (itixe = 0; itixe < ptidx->_pggtixe->IvMac(); itixe++)
+    {
+        ptidx->_pggtixe->GetFixed(itixe, &tixe);
+        tixe.fUsed = fFalse;
+        ptidx->_pggtixe->PutFixed(itixe, &tixe);
+    }
+
+    AssertPo(ptidx, 0);
+    return ptidx;
+}
+
+/****************************************************
+ *
+ * Write the index back out, if it changed.  Failure
+ * isn't reported: the next build just does more work.
+ *
+ ****************************************************/
+bool TIDX::FSave(void)
+{
+    AssertThis(0);
+
+    PFIL pfil = pvNil;
+    FNI fni;
+    BLCK blck;
+    TIXH tixh;
+    long cb;
+    long cerc = vpers->Cerc();
+
+    if (!_fDirty)
+        return fTrue;
+
+    if (!_FGetFni(&fni))
+        goto LFail;
+    if (tYes == fni.TExists() && !fni.FDelete())
+        goto LFail;
+    if (pvNil == (pfil = FIL::PfilCreate(&fni)))
+        goto LFail;
+
+    cb = _pggtixe->CbOnFile();
+    tixh.bo = kboCur;
+    tixh.osk = koskCur;
+    tixh.lwVersion = klwVersionTidx;
+    if (!pfil->FSetFpMac(size(TIXH) + cb) || !pfil->FWriteRgb(&tixh, size(TIXH), 0))
+        goto LFail;
+    blck.Set(pfil, size(TIXH), cb);
+    if (!_pggtixe->FWrite(&blck))
+        goto LFail;
+    blck.Free(); // so it doesn't reference pfil anymore
+    ReleasePpo(&pfil);
+
+    _fDirty = fFalse;
+    return fTrue;
+
+LFail:
+    blck.Free();
+    if (pvNil != pfil)
+    {
+        // don't leave a partial index behind
+        pfil->SetTemp();
+        ReleasePpo(&pfil);
+    }
+    while (vpers->Cerc() > cerc)
+        vpers->FPop();
+    return fFalse;
+}
+
+/****************************************************
+ *
+ * Binary search for the entry with *ptixe's query
+ * and the given path.  Returns where it is, or where
+ * it would go.
+ *
+ ****************************************************/
+bool TIDX::_FFind(TIXE *ptixe, PSTN pstnPath, long *pitixe)
+{
+    AssertThis(0);
+    AssertVarMem(ptixe);
+    AssertPo(pstnPath, 0);
+    AssertVarMem(pitixe);
+
+    long itixe, itixeMin, itixeLim;
+    TIXE tixe;
+    ulong fcmp;
+
+    for (itixeMin = 0, itixeLim = _pggtixe->IvMac(); itixeMin < itixeLim;)
+    {
+        itixe = (itixeMin + itixeLim) / 2;
+        _pggtixe->GetFixed(itixe, &tixe);
+        fcmp = _FcmpTixe(&tixe, ptixe);
+        if (fcmpEq == fcmp)
+        {
+            fcmp = FcmpCompareRgch((achar *)_pggtixe->QvGet(itixe), tixe.cbPath / size(achar), pstnPath->Prgch(),
+                                   pstnPath->Cch());
+        }
+        if (fcmpEq == fcmp)
+        {
+            *pitixe = itixe;
+            return fTrue;
+        }
+        if (fcmpLt == fcmp)
+            itixeMin = itixe + 1;
+        else
+            itixeLim = itixe;
+    }
+
+    *pitixe = itixeMin;
+    return fFalse;
+}
+
+/****************************************************
+ *
+ * Look for an up to date entry for the file.  *ptixe
+ * gives the query and the file's modification time.
+ *
+ ****************************************************/
+bool TIDX::FLookup(TIXE *ptixe, PSTN pstnPath, long *pitixe)
+{
+    AssertThis(0);
+    AssertVarMem(ptixe);
+    AssertPo(pstnPath, 0);
+    AssertVarMem(pitixe);
+
+    TIXE tixe;
+
+    if (!_FFind(ptixe, pstnPath, pitixe))
+        return fFalse;
+    _pggtixe->GetFixed(*pitixe, &tixe);
+    if (tixe.tim != ptixe->tim)
+        return fFalse;
+
+    tixe.fUsed = fTrue;
+    _pggtixe->PutFixed(*pitixe, &tixe);
+    return fTrue;
+}
+
+/****************************************************
+ *
+ * Number of THDs the file contributes to the query
+ *
+ ****************************************************/
+long TIDX::Cthd(long itixe)
+{
+    AssertThis(0);
+    AssertIn(itixe, 0, _pggtixe->IvMac());
+    TIXE tixe;
+
+    _pggtixe->GetFixed(itixe, &tixe);
+    return tixe.cthd;
+}
+
+/****************************************************
+ *
+ * Append the entry's THDs (and names) to pglthd (and
+ * pgst), just as walking the file would have
+ *
+ ****************************************************/
+bool TIDX::FGetThds(long itixe, long sid, PGL pglthd, PGST pgst)
+{
+    AssertThis(0);
+    AssertIn(itixe, 0, _pggtixe->IvMac());
+    AssertPo(pglthd, 0);
+    AssertNilOrPo(pgst, 0);
+
+    TIXE tixe;
+    THD thd;
+    STN stn;
+    byte *pb;
+    long ithd, bvName, bvLim, cbRead;
+    bool fRet = fFalse;
+
+    _pggtixe->GetFixed(itixe, &tixe);
+    Assert(tixe.fNames == (pvNil != pgst), "entry is for another query");
+
+    pb = (byte *)_pggtixe->PvLock(itixe);
+    bvName = tixe.cbPath + LwMul(tixe.cthd, size(THD));
+    bvLim = bvName + tixe.cbNames;
+    for (ithd = 0; ithd < tixe.cthd; ithd++)
+    {
+        if (pvNil != pgst)
+        {
+            if (!stn.FSetData(pb + bvName, bvLim - bvName, &cbRead) || !pgst->FAddStn(&stn))
+                goto LFail;
+            bvName += cbRead;
+        }
+
+        CopyPb(pb + tixe.cbPath + LwMul(ithd, size(THD)), &thd, size(THD));
+        thd.tag.sid = sid;
+        thd.ithd = pglthd->IvMac();
+        if (!pglthd->FInsert(thd.ithd, &thd))
+            goto LFail;
+    }
+    fRet = fTrue;
+
+LFail:
+    _pggtixe->Unlock();
+    return fRet;
+}
+
+/****************************************************
+ *
+ * Record the THDs (and names) the file added to
+ * pglthd (and pgst), starting at ithdMin (istnMin)
+ *
+ ****************************************************/
+bool TIDX::FPutThds(TIXE *ptixe, PSTN pstnPath, PGL pglthd, long ithdMin, PGST pgst, long istnMin)
+{
+    AssertThis(0);
+    AssertVarMem(ptixe);
+    AssertPo(pstnPath, 0);
+    AssertPo(pglthd, 0);
+    AssertIn(ithdMin, 0, pglthd->IvMac() + 1);
+    AssertNilOrPo(pgst, 0);
+
+    TIXE tixe = *ptixe;
+    STN stn;
+    byte *pb;
+    long itixe, ithd, bv;
+
+    tixe.cbPath = pstnPath->Cch() * size(achar);
+    tixe.cthd = pglthd->IvMac() - ithdMin;
+    tixe.cbNames = 0;
+    tixe.fUsed = fTrue;
+    if (pvNil != pgst)
+    {
+        // A name without a THD (or vice versa) means a partial failure;
+        // don't remember that
+        if (pgst->IvMac() - istnMin != tixe.cthd)
+            return fFalse;
+        for (ithd = 0; ithd < tixe.cthd; ithd++)
+        {
+            pgst->GetStn(istnMin + ithd, &stn);
+            tixe.cbNames += stn.CbData();
+        }
+    }
+
+    if (_FFind(&tixe, pstnPath, &itixe))
+        _pggtixe->Delete(itixe);
+    if (!_pggtixe->FInsert(itixe, tixe.cbPath + LwMul(tixe.cthd, size(THD)) + tixe.cbNames, pvNil, &tixe))
+        return fFalse;
+    _fDirty = fTrue;
+
+    pb = (byte *)_pggtixe->PvLock(itixe);
+    CopyPb(pstnPath->Prgch(), pb, tixe.cbPath);
+    bv = tixe.cbPath;
+    for (ithd = 0; ithd < tixe.cthd; ithd++, bv += size(THD))
+        pglthd->Get(ithdMin + ithd, pb + bv);
+    for (ithd = 0; ithd < tixe.cthd && pvNil != pgst; ithd++)
+    {
+        pgst->GetStn(istnMin + ithd, &stn);
+        stn.GetData(pb + bv);
+        bv += stn.CbData();
+    }
+    Assert(bv == _pggtixe->Cb(itixe), "index entry size wrong");
+    _pggtixe->Unlock();
+
+    return fTrue;
+}
+
+/****************************************************
+ *
+ * Drop the entries for *ptixe's query that weren't
+ * seen this time (the files have gone away)
+ *
+ ****************************************************/
+void TIDX::PruneUnused(TIXE *ptixe)
+{
+    AssertThis(0);
+    AssertVarMem(ptixe);
+
+    TIXE tixe;
+    STN stn;
+    long itixe;
+
+    // The empty path sorts first, so this finds the start of the query
+    _FFind(ptixe, &stn, &itixe);
+    while (itixe < _pggtixe->IvMac())
+    {
+        _pggtixe->GetFixed(itixe, &tixe);
+        if (fcmpEq != _FcmpTixe(&tixe, ptixe))
+            break;
+        if (tixe.fUsed)
+        {
+            itixe++;
+            continue;
+        }
+        _pggtixe->Delete(itixe);
+        _fDirty = fTrue;
+    }
+}
+
 /****************************************************
  *
  * Enumerate thumbnail files
@@ -3557,6 +4102,12 @@ void BCLS::MarkMem(void)
     MarkMemObj(_pgst);
 }
 
+void TIDX::MarkMem(void)
+{
+    TIDX_PAR::MarkMem();
+    MarkMemObj(_pggtixe);
+}
+
 /****************************************************
 
     Assert the validity of the BRCN
@@ -3592,6 +4143,11 @@ void BCL::AssertValid(ulong grf)
     BCL_PAR::AssertValid(grf);
     AssertPo(_pglthd, 0);
 }
+void TIDX::AssertValid(ulong grf)
+{
+    TIDX_PAR::AssertValid(fobjAllocated);
+    AssertPo(_pggtixe, 0);
+}
 
 /****************************************************
 
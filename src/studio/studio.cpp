@@ -60,6 +60,12 @@ ON_CID_GEN(cidActorEaselOpen, &STDIO::FCmdActorEaselOpen, pvNil)
 ON_CID_GEN(cidListenerEaselOpen, &STDIO::FCmdListenerEaselOpen, pvNil)
 #ifdef DEBUG
 ON_CID_GEN(cidWriteBmps, &STDIO::FCmdWriteBmps, pvNil)
+ON_CID_GEN(cidBenchSeek, &STDIO::FCmdBenchSeek, pvNil)
+ON_CID_GEN(cidBenchRender, &STDIO::FCmdBenchRender, pvNil)
+ON_CID_GEN(cidBenchLoad, &STDIO::FCmdBenchLoad, pvNil)
+ON_CID_GEN(cidCmdStats, &STDIO::FCmdCmdStats, pvNil)
+ON_CID_GEN(cidScriptProfile, &STDIO::FCmdScriptProfile, pvNil)
+ON_CID_GEN(cidUndoStats, &STDIO::FCmdUndoStats, pvNil)
 #endif // DEBUG
 END_CMD_MAP_NIL()
 
@@ -2671,6 +2677,268 @@ bool STDIO::FCmdWriteBmps(PCMD pcmd)
     }
     return fTrue;
 }
+
+/******************************************************************************
+        Times actor seeks with and without state snapshots, using the
+        selected actor's template in the current scene.
+******************************************************************************/
+bool STDIO::FCmdBenchSeek(PCMD pcmd)
+{
+    const long kcfrmBench = 2000;
+    const long kcseekBench = 200;
+    PSCEN pscen;
+    PACTR pactr;
+    TAG tag;
+    ulong dtsAkf, dtsReplay;
+    STN stn;
+
+    if (_pmvie == pvNil || pvNil == (pscen = _pmvie->Pscen()) || pvNil == (pactr = pscen->PactrSelected()))
+        return fTrue;
+
+    pactr->GetTagTmpl(&tag);
+    if (!ACTR::FBenchSeek(pscen, &tag, kcfrmBench, kcseekBench, &dtsAkf, &dtsReplay))
+    {
+        vpappb->TGiveAlertSz("Seek benchmark failed", bkOk, cokExclamation);
+        return fTrue;
+    }
+    _pmvie->InvalViews();
+
+    stn.FFormatSz(PszLit("%d seeks over %d frames\n\nSnapshots: %d ms\nReplay: %d ms"), kcseekBench, kcfrmBench,
+                  dtsAkf, dtsReplay);
+    vpappb->TGiveAlertSz(stn.Psz(), bkOk, cokInformation);
+    return fTrue;
+}
+
+/******************************************************************************
+        Times rerendering the current scene with the working buffers
+        restored on 1, 2, 4... threads, up to one thread per processor.
+******************************************************************************/
+bool STDIO::FCmdBenchRender(PCMD pcmd)
+{
+    const long kcactBench = 200;
+    PBWLD pbwld;
+    long cth, cthMax, cthSave, iact;
+    ulong ts, dts;
+    BWCT bwct;
+    STN stn, stnT;
+
+    if (_pmvie == pvNil || pvNil == _pmvie->Pscen())
+        return fTrue;
+
+    pbwld = _pmvie->Pbwld();
+    cthSave = pbwld->CthRender();
+    pbwld->SetCthRender(0);
+    cthMax = pbwld->CthRender();
+
+    stn.FFormatSz(PszLit("%d frames\n"), kcactBench);
+    for (cth = 1; cth <= cthMax; cth *= 2)
+    {
+        pbwld->SetCthRender(cth);
+        pbwld->ResetBwct();
+        ts = TsCurrentSystem();
+        for (iact = 0; iact < kcactBench; iact++)
+        {
+            pbwld->MarkDirty();
+            pbwld->Render();
+        }
+        dts = LwMax(1, TsCurrentSystem() - ts);
+        pbwld->GetBwct(&bwct);
+        stnT.FFormatSz(PszLit("\n%d threads: %d fps (restore %d ms, scene %d ms)"), pbwld->CthRender(),
+                       LwMulDiv(kcactBench, kdtsSecond, dts), bwct.dtusClean / 1000, bwct.dtusScene / 1000);
+        stn.FAppendStn(&stnT);
+    }
+    pbwld->SetCthRender(cthSave);
+    _pmvie->InvalViews();
+
+    vpappb->TGiveAlertSz(stn.Psz(), bkOk, cokInformation);
+    return fTrue;
+}
+
+/******************************************************************************
+        Compares the size and read time of the actor routes and event
+        lists in the current movie's file, stored as plain GLs and GGs
+        versus the compact encoding.
+******************************************************************************/
+bool STDIO::FCmdBenchLoad(PCMD pcmd)
+{
+    const long kcactBench = 50;
+    FNI fni;
+    PCFL pcfl;
+    long cactr, cbOld, cbNew;
+    ulong dtsOld, dtsNew;
+    bool fRet;
+    STN stn;
+
+    if (_pmvie == pvNil || !_pmvie->FGetFni(&fni))
+        return fTrue;
+
+    if (pvNil == (pcfl = CFL::PcflOpen(&fni, fcflNil)))
+    {
+        vpappb->TGiveAlertSz("Couldn't open the movie file", bkOk, cokExclamation);
+        return fTrue;
+    }
+    fRet = ACTR::FBenchLoad(pcfl, kcactBench, &cactr, &cbOld, &cbNew, &dtsOld, &dtsNew);
+    ReleasePpo(&pcfl);
+    if (!fRet)
+    {
+        vpappb->TGiveAlertSz("Load benchmark failed", bkOk, cokExclamation);
+        return fTrue;
+    }
+
+    stn.FFormatSz(PszLit("%d actors, each read %d times\n\nGL/GG: %d bytes, %d ms\nCompact: %d bytes, %d ms"), cactr,
+                  kcactBench, cbOld, dtsOld, cbNew, dtsNew);
+    vpappb->TGiveAlertSz(stn.Psz(), bkOk, cokInformation);
+    return fTrue;
+}
+
+/******************************************************************************
+        Reports the command dispatch rate since the last report, the cids
+        that took the most dispatching time and how late the movie clock's
+        alarms went off.  Then resets the counters.
+******************************************************************************/
+bool STDIO::FCmdCmdStats(PCMD pcmd)
+{
+    const long kccidtReport = 8;
+    CXCT cxct;
+    ALJT aljt;
+    CIDT cidt;
+    CIDT rgcidt[kccidtReport];
+    long icidt, ccidt, icidtT;
+    STN stn, stnT;
+
+    vpcex->GetCxct(&cxct);
+    stn.FFormatSz(PszLit("%d commands in %d ms: %d per second, %d ms dispatching\n"), cxct.ccmd, cxct.dtsElapsed,
+                  LwMulDiv(cxct.ccmd, kdtsSecond, LwMax(1, cxct.dtsElapsed)), cxct.dtusDispatch / 1000);
+
+    // keep the slowest cids, slowest first
+    ccidt = 0;
+    for (icidt = 0; icidt < vpcex->Ccidt(); icidt++)
+    {
+        vpcex->GetCidt(icidt, &cidt);
+        for (icidtT = ccidt; icidtT > 0 && rgcidt[icidtT - 1].dtus < cidt.dtus; icidtT--)
+        {
+            if (icidtT < kccidtReport)
+                rgcidt[icidtT] = rgcidt[icidtT - 1];
+        }
+        if (icidtT < kccidtReport)
+        {
+            rgcidt[icidtT] = cidt;
+            ccidt = LwMin(ccidt + 1, kccidtReport);
+        }
+    }
+
+    for (icidt = 0; icidt < ccidt; icidt++)
+    {
+        stnT.FFormatSz(PszLit("\ncid %d: %d times, %d us"), rgcidt[icidt].cid, rgcidt[icidt].ccmd, rgcidt[icidt].dtus);
+        stn.FAppendStn(&stnT);
+    }
+
+    if (_pmvie != pvNil)
+    {
+        _pmvie->Pclok()->GetAljt(&aljt);
+        stnT.FFormatSz(PszLit("\n\n%d playback alarms: %d ms late on average, %d ms at worst"), aljt.calad,
+                       LwMulDiv(aljt.dtimLate, kdtsSecond, LwMax(1, aljt.calad) * kdtimSecond),
+                       LwMulDiv(aljt.dtimLateMax, kdtsSecond, kdtimSecond));
+        stn.FAppendStn(&stnT);
+        _pmvie->Pclok()->ResetAljt();
+    }
+
+    vpcex->ResetCxct();
+    vpappb->TGiveAlertSz(stn.Psz(), bkOk, cokInformation);
+    return fTrue;
+}
+
+/******************************************************************************
+        Turns script profiling on.  If it's already on, writes the profile
+        to ScrProf.txt in the temp directory, reports the scripts that took
+        the most time and turns profiling off.
+******************************************************************************/
+bool STDIO::FCmdScriptProfile(PCMD pcmd)
+{
+    const long kcscpfReport = 3;
+    SCPF scpf;
+    SCPF rgscpf[kcscpfReport];
+    long iscpf, cscpf, iscpfT;
+    FNI fni;
+    STN stn, stnT;
+
+    if (!SCEB::FProfile())
+    {
+        SCEB::ResetProfile();
+        SCEB::SetProfile(fTrue);
+        vpappb->TGiveAlertSz(PszLit("Script profiling is on"), bkOk, cokInformation);
+        return fTrue;
+    }
+    SCEB::SetProfile(fFalse);
+
+    stn = PszLit("ScrProf.txt");
+    if (fni.FGetTemp() && fni.FSetLeaf(&stn) && SCEB::FWriteProfile(&fni))
+    {
+        fni.GetStnPath(&stnT);
+        stn.FFormatSz(PszLit("Wrote %s\n"), &stnT);
+    }
+    else
+        stn = PszLit("Couldn't write the profile\n");
+
+    // keep the slowest scripts, slowest first
+    cscpf = 0;
+    for (iscpf = 0; iscpf < SCEB::Cscpf(); iscpf++)
+    {
+        SCEB::GetScpf(iscpf, &scpf);
+        for (iscpfT = cscpf; iscpfT > 0 && rgscpf[iscpfT - 1].dtus < scpf.dtus; iscpfT--)
+        {
+            if (iscpfT < kcscpfReport)
+                rgscpf[iscpfT] = rgscpf[iscpfT - 1];
+        }
+        if (iscpfT < kcscpfReport)
+        {
+            rgscpf[iscpfT] = scpf;
+            cscpf = LwMin(cscpf + 1, kcscpfReport);
+        }
+    }
+
+    for (iscpf = 0; iscpf < cscpf; iscpf++)
+    {
+        stnT.FFormatSz(PszLit("\n'%f' 0x%x: %d runs, %d instructions, %d us"), rgscpf[iscpf].ctg, rgscpf[iscpf].cno,
+                       rgscpf[iscpf].crun, rgscpf[iscpf].cop, rgscpf[iscpf].dtus);
+        stn.FAppendStn(&stnT);
+    }
+
+    SCEB::ResetProfile();
+    vpappb->TGiveAlertSz(stn.Psz(), bkOk, cokInformation);
+    return fTrue;
+}
+
+/******************************************************************************
+        Reports how much memory the movie's undo levels hold, newest level
+        first, and the peak since the last report.  Then resets the peak.
+******************************************************************************/
+bool STDIO::FCmdUndoStats(PCMD pcmd)
+{
+    const long kcundbReport = 8;
+    UNCT unct;
+    long iundb, iundbMin;
+    STN stn, stnT;
+
+    if (_pmvie == pvNil)
+        return fTrue;
+
+    _pmvie->GetUnct(&unct);
+    stn.FFormatSz(PszLit("%d of %d undo levels hold %d bytes, %d at most per level\n"
+                         "Peak %d bytes, %d levels dropped for memory\n"),
+                  unct.cundb, _pmvie->CundbMax(), unct.cbTot, unct.cbLevelMax, unct.cbPeak, unct.cundbTrim);
+
+    iundbMin = LwMax(0, unct.cundb - kcundbReport);
+    for (iundb = unct.cundb; iundb-- > iundbMin;)
+    {
+        stnT.FFormatSz(PszLit("\nlevel %d: %d bytes"), unct.cundb - iundb, _pmvie->CbUndoLevel(iundb));
+        stn.FAppendStn(&stnT);
+    }
+
+    _pmvie->ResetUnct();
+    vpappb->TGiveAlertSz(stn.Psz(), bkOk, cokInformation);
+    return fTrue;
+}
 #endif // DEBUG
 
 #ifdef DEBUG
@@ -174,8 +174,11 @@ bool APP::_FInit(ulong grfapp, ulong grfgob, long ginDef)
     FNI fniUserDoc;
     long fFirstTimeUser;
 
-    // Only allow one copy of 3DMM to run at a time:
-    if (_FAppAlreadyRunning())
+    _ParseCommandLine();
+
+    // Only allow one copy of 3DMM to run at a time, unless we're rendering
+    // in batch, which can run a copy per process:
+    if (!_fRender && _FAppAlreadyRunning())
     {
         _TryToActivateWindow();
         _fDontReportInitFailure = fTrue;
@@ -214,8 +217,6 @@ bool APP::_FInit(ulong grfapp, ulong grfgob, long ginDef)
         goto LFail;
     }
 
-    _ParseCommandLine();
-
     // If _ParseCommandLine doesn't set _stnProduct, set to 3dMovieMaker
     if (!_FEnsureProductNames())
     {
@@ -315,7 +316,7 @@ bool APP::_FInit(ulong grfapp, ulong grfgob, long ginDef)
         goto LFail;
     }
 
-    while (TsCurrent() - tsHomeLogo < kdtsHomeLogo)
+    while (!_fRender && TsCurrent() - tsHomeLogo < kdtsHomeLogo)
         ; // spin until home logo has been up long enough
 
     if (!_FShowSplashScreen())
@@ -326,7 +327,7 @@ bool APP::_FInit(ulong grfapp, ulong grfgob, long ginDef)
     }
     tsSplashScreen = TsCurrent();
 
-    if (!_FPlaySplashSound())
+    if (!_fRender && !_FPlaySplashSound())
     {
         _FGenericError(PszLit("_FPlaySplashSound"));
         _fDontReportInitFailure = fTrue;
@@ -361,6 +362,22 @@ bool APP::_FInit(ulong grfapp, ulong grfgob, long ginDef)
         goto LFail;
     }
 
+    if (_fRender)
+    {
+        // Batch rendering: write the frames and quit without ever going
+        // to the building or the studio
+        Pkwa()->SetMbmp(pvNil);
+        if (!_FRenderMovie())
+        {
+            Warn("couldn't render the movie");
+#ifdef WIN
+            vwig.wExitCode = 1;
+#endif // WIN
+        }
+        _fQuit = fTrue;
+        return fTrue;
+    }
+
     while (TsCurrent() - tsSplashScreen < kdtsSplashScreen)
         ;                   // spin until splash screen has been up long enough
     Pkwa()->SetMbmp(pvNil); // bring down splash screen
@@ -1755,6 +1772,116 @@ bool APP::_FPlaySplashSound(void)
     return fTrue;
 }
 
+/***************************************************************************
+    Render the movie named on the command line into _fniRender.  With
+    "/J", the scenes are split among that many copies of the app, each
+    run with "/C"; otherwise they're all rendered here.
+***************************************************************************/
+bool APP::_FRenderMovie(void)
+{
+    AssertBaseThis(0);
+
+    FNI fniMovie;
+    PMCC pmcc = pvNil;
+    PMVIE pmvie = pvNil;
+    long iscenLim, cfrm;
+    bool fRet = fFalse;
+
+    GetPortfolioDoc(&fniMovie);
+    if (fniMovie.Ftg() == ftgNil)
+    {
+        Warn("No movie to render");
+        return fFalse;
+    }
+
+    pmcc = NewObj MCC(kdxpWorkspace, kdypWorkspace, kcbStudioCache);
+    if (pvNil == pmcc)
+        goto LFail;
+    pmvie = MVIE::PmvieNew(fFalse, pmcc, &fniMovie, cnoNil);
+    if (pvNil == pmvie)
+        goto LFail;
+    pmvie->SetFSoundsEnabled(fFalse);
+
+    iscenLim = pmvie->Cscen();
+    if (_iscenLimRender > 0)
+        iscenLim = LwMin(iscenLim, _iscenLimRender);
+    if (_cprocRender > 1)
+    {
+        // the children load the movie for themselves
+        ReleasePpo(&pmvie);
+        fRet = _FRenderProcs(&fniMovie, _iscenFirstRender, iscenLim);
+    }
+    else
+        fRet = pmvie->FWriteFrames(&_fniRender, _iscenFirstRender, iscenLim, &cfrm);
+
+LFail:
+    ReleasePpo(&pmvie);
+    ReleasePpo(&pmcc);
+    return fRet;
+}
+
+/***************************************************************************
+    Render scenes iscenFirst to iscenLim - 1 of the movie on _cprocRender
+    copies of the app, each given an even share of the scenes, and wait
+    for them all to finish.  Returns fFalse if any of them failed.
+***************************************************************************/
+bool APP::_FRenderProcs(PFNI pfniMovie, long iscenFirst, long iscenLim)
+{
+    AssertBaseThis(0);
+    AssertPo(pfniMovie, ffniFile);
+
+#ifdef WIN
+    HANDLE rghproc[MAXIMUM_WAIT_OBJECTS];
+    STARTUPINFO si;
+    PROCESS_INFORMATION pi;
+    long iproc, cproc, cprocStarted;
+    ulong luExit;
+    STN stn, stnExe, stnDir, stnMovie;
+    bool fRet = fTrue;
+
+    cproc = LwMin(LwMin(_cprocRender, MAXIMUM_WAIT_OBJECTS), iscenLim - iscenFirst);
+    _fniExe.GetStnPath(&stnExe);
+    _fniRender.GetStnPath(&stnDir);
+    pfniMovie->GetStnPath(&stnMovie);
+
+    cprocStarted = 0;
+    for (iproc = 0; iproc < cproc; iproc++)
+    {
+        if (!stn.FFormatSz(PszLit("\"%s\" -r\"%s\" -c%d,%d \"%s\""), &stnExe, &stnDir,
+                           iscenFirst + LwMulDiv(iscenLim - iscenFirst, iproc, cproc),
+                           iscenFirst + LwMulDiv(iscenLim - iscenFirst, iproc + 1, cproc), &stnMovie))
+        {
+            fRet = fFalse;
+            break;
+        }
+
+        ClearPb(&si, size(si));
+        si.cb = size(si);
+        if (!CreateProcess(pvNil, stn.Psz(), pvNil, pvNil, fFalse, 0, pvNil, pvNil, &si, &pi))
+        {
+            Warn("couldn't start a render process");
+            fRet = fFalse;
+            break;
+        }
+        CloseHandle(pi.hThread);
+        rghproc[cprocStarted++] = pi.hProcess;
+    }
+
+    if (cprocStarted > 0)
+        WaitForMultipleObjects(cprocStarted, rghproc, fTrue, INFINITE);
+    for (iproc = 0; iproc < cprocStarted; iproc++)
+    {
+        if (!GetExitCodeProcess(rghproc[iproc], &luExit) || luExit != 0)
+            fRet = fFalse;
+        CloseHandle(rghproc[iproc]);
+    }
+    return fRet;
+#else  //! WIN
+    RawRtn();
+    return fFalse;
+#endif //! WIN
+}
+
 /***************************************************************************
     Read the chunky files specified by _pgstSharedFiles, _pgstBuildingFiles
     and _pgstStudioFiles and create the global CRM; indices to the Building
@@ -1855,14 +1982,14 @@ bool APP::_FAddToCrm(PGST pgstFiles, PCRM pcrm, PGL pglFiles)
             Pkwa()->SetCDPrompt(fAskForCDSav);
             if (fFoundFile)
             {
-                pcfl = CFL::PcflOpen(&fni, fcflNil);
+                pcfl = CFL::PcflOpen(&fni, fcflMapped);
             }
             else
             {
 #endif                                         // DEBUG
                 stn.FAppendSz(PszLit(".chk")); // REVIEW *****
                 if (Pkwa()->FFindFile(&stn, &fni))
-                    pcfl = CFL::PcflOpen(&fni, fcflNil);
+                    pcfl = CFL::PcflOpen(&fni, fcflMapped);
 #ifdef DEBUG
             }
         }
@@ -2108,6 +2235,9 @@ LFail:
     -p"longname": long productname
     -t"shortname": short productname
     -m: don't minimize window on deactivate
+    -r"directory": render the movie's frames into directory and quit
+    -jN: with -r, render on N processes
+    -cFIRST,LIM: with -r, render only scenes FIRST to LIM - 1
 
 ***************************************************************************/
 void APP::_ParseCommandLine(void)
@@ -2119,6 +2249,7 @@ void APP::_ParseCommandLine(void)
     STN stn;
     achar *pch;
     achar *pchT;
+    achar *pchComma;
     FNI fniT;
 
     // Get path to current directory
@@ -2176,6 +2307,48 @@ void APP::_ParseCommandLine(void)
                     _stnProductShort.SetRgch(pch, pchT - pch);
             }
             break;
+            case ChLit('R'): {
+                pch += 2; // skip "-r"
+                pchT = pch;
+                _SkipToSpace(&pchT);
+                // skip quotes
+                if (*pch == ChLit('"'))
+                    stn.SetRgch(pch + 1, pchT - pch - 2);
+                else
+                    stn.SetRgch(pch, pchT - pch);
+                if (_fniRender.FBuildFromPath(&stn, kftgDir))
+                    _fRender = fTrue;
+                else
+                    Warn("Bad render directory");
+            }
+            break;
+            case ChLit('J'): {
+                pch += 2; // skip "-j"
+                pchT = pch;
+                _SkipToSpace(&pchT);
+                stn.SetRgch(pch, pchT - pch);
+                if (!stn.FGetLw(&_cprocRender) || _cprocRender < 1)
+                    _cprocRender = 1;
+            }
+            break;
+            case ChLit('C'): {
+                pch += 2; // skip "-c"
+                pchT = pch;
+                _SkipToSpace(&pchT);
+                for (pchComma = pch; pchComma < pchT && *pchComma != ChLit(','); pchComma++)
+                    ;
+                stn.SetRgch(pch, pchComma - pch);
+                if (!stn.FGetLw(&_iscenFirstRender) || _iscenFirstRender < 0)
+                    _iscenFirstRender = 0;
+                _iscenLimRender = 0;
+                if (pchComma < pchT)
+                {
+                    stn.SetRgch(pchComma + 1, pchT - pchComma - 1);
+                    if (!stn.FGetLw(&_iscenLimRender) || _iscenLimRender <= _iscenFirstRender)
+                        _iscenLimRender = 0;
+                }
+            }
+            break;
             default:
                 Warn("Bad command-line switch");
                 break;